@@ -11,13 +11,13 @@
 // ###### VERTEX SHADER/PIPELINE INPUT DATA ##############
 // Several vertex attributes (These are the buffers passed
 // to command_buffer_t::draw_indexed in the same order):
+// Note: the vertex data is already skinned (in object space) by skinning.comp
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec2 aTexCoords;
 layout (location = 2) in vec3 aNormal;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
-layout (location = 5) in vec4 aBoneWeights;
-layout (location = 6) in uvec4 aBoneIndices;
+layout (location = 5) in vec3 aPrevPosition;	// skinned with the previous frame's bone matrices
 
 // push constants
 layout(push_constant) PUSHCONSTANTSDEF_DII;
@@ -27,9 +27,6 @@ layout(push_constant) PUSHCONSTANTSDEF_DII;
 // It is updated every frame.
 layout(set = 1, binding = 0) UNIFORMDEF_MatricesAndUserInput uboMatUsr;
 
-layout(set = 3, binding = 0, std430) readonly buffer BoneMatricesBuffer     { mat4 mat[]; } boneMatrices;
-layout(set = 3, binding = 1, std430) readonly buffer BoneMatricesPrevBuffer { mat4 mat[]; } boneMatricesPrev;
-
 // -------------------------------------------------------
 
 // ###### DATA PASSED ON ALONG THE PIPELINE ##############
@@ -59,36 +56,19 @@ void main()
 	mat4 prev_modelMatrix = uboMatUsr.mMover_additionalModelMatrix_prev * mMover_baseModelMatrix;
 	v_out.movingObjectId  = -mDrawType;
 
-	vec4 boneWeights = aBoneWeights;
-	// boneWeights.w = 1.0 - boneWeights.x - boneWeights.y - boneWeights.z; // no longer necessary to "normalize", this is now done at model loading
-
-	uint bonesBaseIndex = mMover_meshIndex * MAX_BONES;
-
-	// weighted sum of the four bone matrices
-	mat4 boneMat =      boneMatrices.mat    [bonesBaseIndex + aBoneIndices[0]] * boneWeights[0]
-				      + boneMatrices.mat    [bonesBaseIndex + aBoneIndices[1]] * boneWeights[1]
-				      + boneMatrices.mat    [bonesBaseIndex + aBoneIndices[2]] * boneWeights[2]
-				      + boneMatrices.mat    [bonesBaseIndex + aBoneIndices[3]] * boneWeights[3];
-
-	mat4 prev_boneMat = boneMatricesPrev.mat[bonesBaseIndex + aBoneIndices[0]] * boneWeights[0]
-					  + boneMatricesPrev.mat[bonesBaseIndex + aBoneIndices[1]] * boneWeights[1]
-					  + boneMatricesPrev.mat[bonesBaseIndex + aBoneIndices[2]] * boneWeights[2]
-					  + boneMatricesPrev.mat[bonesBaseIndex + aBoneIndices[3]] * boneWeights[3];
-
 	mat4 mMatrix = v_out.modelMatrix;
 	mat4 vMatrix = uboMatUsr.mViewMatrix;
 	mat4 pMatrix = uboMatUsr.mProjMatrix;
 	mat4 vmMatrix = vMatrix * mMatrix;
 	mat4 pvmMatrix = pMatrix * vmMatrix;
 
-	vec4 positionOS  = boneMat * vec4(aPosition, 1.0);
+	vec4 positionOS  = vec4(aPosition, 1.0);
 	vec4 positionVS  = vmMatrix * positionOS;
 	vec4 positionCS  = pMatrix * positionVS;
 
-	mat3 normalMatrix = mat3(inverse(transpose(boneMat)));				// TODO: can we do inverse(transpose(mat3(M))) instead? could be faster
-	vec3 normalOS     = normalize(normalMatrix * normalize(aNormal));	// TODO: (1) first normalize() necessary?   (2) aNormal should be normalized already... (really?)
-	vec3 tangentOS    = normalize(normalMatrix * normalize(aTangent));
-	vec3 bitangentOS  = normalize(normalMatrix * normalize(aBitangent));
+	vec3 normalOS     = aNormal;	// normalized by skinning.comp
+	vec3 tangentOS    = aTangent;
+	vec3 bitangentOS  = aBitangent;
 
 	v_out.positionWS  = mMatrix * positionOS;
 	v_out.positionVS  = positionVS.xyz;
@@ -97,7 +77,7 @@ void main()
 	v_out.tangentOS   = tangentOS;
 	v_out.bitangentOS = bitangentOS;
 	v_out.positionCS  = positionCS;	// TODO: recheck - is it ok to interpolate clip space vars?
-	v_out.positionCS_prev = uboMatUsr.mPrevFrameProjViewMatrix * prev_modelMatrix * prev_boneMat * vec4(aPosition, 1.0);
+	v_out.positionCS_prev = uboMatUsr.mPrevFrameProjViewMatrix * prev_modelMatrix * vec4(aPrevPosition, 1.0);
 
 	gl_Position = positionCS;
 }
@@ -0,0 +1,98 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+// -------------------------------------------------------
+
+#include "shader_common_main.glsl"
+#include "shader_cpu_common.h"
+
+// instanced moving objects ("crowd"): one instanced draw per mesh, skinned here with the per-instance bone palette
+
+
+// ###### VERTEX SHADER/PIPELINE INPUT DATA ##############
+// Several vertex attributes (These are the buffers passed
+// to the draw call in the same order):
+layout (location = 0) in vec3  aPosition;
+layout (location = 1) in vec2  aTexCoords;
+layout (location = 2) in vec3  aNormal;
+layout (location = 3) in vec3  aTangent;
+layout (location = 4) in vec3  aBitangent;
+layout (location = 5) in vec4  aBoneWeights;
+layout (location = 6) in uvec4 aBoneIndices;
+
+// push constants
+layout(push_constant) PUSHCONSTANTSDEF_DII;
+
+
+// "mMatrices" uniform buffer containing camera matrices:
+// It is updated every frame.
+layout(set = 1, binding = 0) UNIFORMDEF_MatricesAndUserInput uboMatUsr;
+
+// per-instance data and bone palettes
+layout(set = 3, binding = 0) readonly BUFFERDEF_CrowdInstances;
+layout(set = 3, binding = 1) readonly BUFFERDEF_CrowdBones;
+layout(set = 3, binding = 2) readonly BUFFERDEF_CrowdBonesPrev;
+
+// -------------------------------------------------------
+
+// ###### DATA PASSED ON ALONG THE PIPELINE ##############
+// Data from vert -> tesc or frag:
+layout (location = 0) out VertexData {
+	vec4 positionWS;
+	vec3 positionVS;
+	vec2 texCoords;
+	vec3 normalOS;
+	vec3 tangentOS;
+	vec3 bitangentOS;
+	vec4 positionCS;		// TODO: don't really need this!
+	vec4 positionCS_prev;	// position in previous frame
+
+	flat uint materialIndex;
+	flat mat4 modelMatrix;
+	flat int movingObjectId;
+} v_out;
+// -------------------------------------------------------
+
+// ###### VERTEX SHADER MAIN #############################
+void main()
+{
+	CrowdInstanceData inst = crowdInstances[gl_InstanceIndex];
+
+	mat4 boneMat      = mat4(1.0);
+	mat4 prev_boneMat = mat4(1.0);
+	if (inst.mBoneBase != CROWD_NO_BONES) {
+		uvec4 bi = aBoneIndices + uvec4(inst.mBoneBase + uint(mMover_meshIndex) * MAX_BONES);
+		boneMat      = crowdBones    [bi[0]] * aBoneWeights[0] + crowdBones    [bi[1]] * aBoneWeights[1] + crowdBones    [bi[2]] * aBoneWeights[2] + crowdBones    [bi[3]] * aBoneWeights[3];
+		prev_boneMat = crowdBonesPrev[bi[0]] * aBoneWeights[0] + crowdBonesPrev[bi[1]] * aBoneWeights[1] + crowdBonesPrev[bi[2]] * aBoneWeights[2] + crowdBonesPrev[bi[3]] * aBoneWeights[3];
+	}
+
+	// moving object
+	v_out.materialIndex   = mMover_materialIndex;
+	v_out.modelMatrix     = inst.mModelMatrix * mMover_baseModelMatrix;
+	mat4 prev_modelMatrix = inst.mModelMatrixPrev * mMover_baseModelMatrix;
+	v_out.movingObjectId  = -mDrawType;
+
+	mat4 mMatrix = v_out.modelMatrix;
+	mat4 vMatrix = uboMatUsr.mViewMatrix;
+	mat4 pMatrix = uboMatUsr.mProjMatrix;
+	mat4 vmMatrix = vMatrix * mMatrix;
+
+	vec4 positionOS  = boneMat * vec4(aPosition, 1.0);
+	vec4 positionVS  = vmMatrix * positionOS;
+	vec4 positionCS  = pMatrix * positionVS;
+
+	// normal matrix: cofactor of the bone matrix (= inverse transpose up to scale)
+	vec3 c0 = boneMat[0].xyz, c1 = boneMat[1].xyz, c2 = boneMat[2].xyz;
+	mat3 normalMatrix = mat3(cross(c1, c2), cross(c2, c0), cross(c0, c1));
+
+	v_out.positionWS  = mMatrix * positionOS;
+	v_out.positionVS  = positionVS.xyz;
+	v_out.texCoords   = aTexCoords;
+	v_out.normalOS    = normalize(normalMatrix * aNormal);
+	v_out.tangentOS   = normalize(normalMatrix * aTangent);
+	v_out.bitangentOS = normalize(normalMatrix * aBitangent);
+	v_out.positionCS  = positionCS;
+	v_out.positionCS_prev = uboMatUsr.mPrevFrameProjViewMatrix * prev_modelMatrix * prev_boneMat * vec4(aPosition, 1.0);
+
+	gl_Position = positionCS;
+}
+// -------------------------------------------------------
@@ -0,0 +1,42 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+// -------------------------------------------------------
+
+#include "shader_common_main.glsl"
+#include "shader_cpu_common.h"
+
+// shadowmap generation for instanced moving objects ("crowd"), see crowd.vert (no frag shader)
+
+// ###### VERTEX SHADER/PIPELINE INPUT DATA ##############
+layout (location = 0) in vec3  aPosition;
+layout (location = 1) in vec4  aBoneWeights;
+layout (location = 2) in uvec4 aBoneIndices;
+
+// push constants
+layout(push_constant) PUSHCONSTANTSDEF_DII;
+
+// matrices
+layout(set = 1, binding = 0) UNIFORMDEF_MatricesAndUserInput uboMatUsr;
+
+// per-instance data and bone palette
+layout(set = 3, binding = 0) readonly BUFFERDEF_CrowdInstances;
+layout(set = 3, binding = 1) readonly BUFFERDEF_CrowdBones;
+
+// -------------------------------------------------------
+
+// ###### VERTEX SHADER MAIN #############################
+void main()
+{
+	CrowdInstanceData inst = crowdInstances[gl_InstanceIndex];
+
+	mat4 boneMat = mat4(1.0);
+	if (inst.mBoneBase != CROWD_NO_BONES) {
+		uvec4 bi = aBoneIndices + uvec4(inst.mBoneBase + uint(mMover_meshIndex) * MAX_BONES);
+		boneMat = crowdBones[bi[0]] * aBoneWeights[0] + crowdBones[bi[1]] * aBoneWeights[1] + crowdBones[bi[2]] * aBoneWeights[2] + crowdBones[bi[3]] * aBoneWeights[3];
+	}
+
+	mat4 modelMatrix = inst.mModelMatrix * mMover_baseModelMatrix;
+	gl_Position = uboMatUsr.mShadowmapProjViewMatrix[mShadowMapCascadeToBuild] * modelMatrix * boneMat * vec4(aPosition, 1.0);
+	if (uboMatUsr.mShadowPancaking) gl_Position.z = max(gl_Position.z, 0.0);	// pancaking: flatten casters in front of the near plane onto it (ortho -> w = 1)
+}
+// -------------------------------------------------------
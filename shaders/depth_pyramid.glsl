@@ -0,0 +1,37 @@
+//? #version 460
+// above line is just for the VS GLSL language integration plugin
+
+// linear depth pyramid, built by depth_pyramid.comp after the geometry pass: view space depth (as linearize_depth in taa.comp);
+// level 0 = the depth attachment at render resolution (min = max), each further level min (.x) / max (.y) of 2x2 texels of the
+// level below; background pixels (depth 1) are at the far plane
+// all levels are allocated for the full attachment size, width/height are the valid part this frame (dynamic resolution)
+// (the including shader needs shader_cpu_common.h and defines DEPTH_PYRAMID_SET, DEPTH_PYRAMID_BINDING, optionally
+// DEPTH_PYRAMID_ACCESS - readonly if not defined)
+
+#ifndef DEPTH_PYRAMID_INCLUDED
+#define DEPTH_PYRAMID_INCLUDED 1
+
+#ifndef DEPTH_PYRAMID_ACCESS
+#define DEPTH_PYRAMID_ACCESS readonly
+#endif
+
+struct DepthPyramidLevel {
+	uint offset;	// first texel
+	uint stride;	// texels per row
+	uint width;		// valid texels this frame
+	uint height;
+};
+
+layout(std430, set = DEPTH_PYRAMID_SET, binding = DEPTH_PYRAMID_BINDING) DEPTH_PYRAMID_ACCESS buffer DepthPyramid {
+	DepthPyramidLevel levels[DEPTH_PYRAMID_MAX_LEVELS];
+	uvec4 range;	// x, y: min/max depth of the geometry (without background) as floatBitsToUint, z: number of levels, w: -
+	vec2  texels[];
+} uDepthPyramid;
+
+vec2 depth_pyramid_fetch(uint level, ivec2 tc) {
+	DepthPyramidLevel l = uDepthPyramid.levels[level];
+	tc = clamp(tc, ivec2(0), ivec2(l.width, l.height) - 1);
+	return uDepthPyramid.texels[l.offset + uint(tc.y) * l.stride + uint(tc.x)];
+}
+
+#endif
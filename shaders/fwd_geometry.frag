@@ -6,6 +6,7 @@
 
 #include "shader_common_main.glsl"
 #include "shader_cpu_common.h"
+#include "shader_gbuffer.glsl"
 
 // ac: specialization constant to differentiate between opaque pass (0) and transparent pass (1)
 layout(constant_id = SPECCONST_ID_TRANSPARENCY) const uint transparentPass = SPECCONST_VAL_OPAQUE;
@@ -277,13 +278,10 @@ void main()
 	}
 
 	// write normals (and also uv coords, to be consistent with deferred shading variant) - we need those for RT-assisted TAA
-	float l = length(normalVS.xy);
-	vec2 sphericalVS = vec2((l == 0) ? 0 : acos(clamp(normalVS.x / l, -1, 1)), asin(normalVS.z));
-	if (normalVS.y < 0) sphericalVS.x = TAU - sphericalVS.x;
-	oFragUvNrm = vec4(fs_in.texCoords, sphericalVS);
+	oFragUvNrm = gbuffer_encode_uv_normal(fs_in.texCoords, normalVS);
 
 	// write material // TODO: better flag specific/problematic materials that require different TAA handling
-	oFragMatId = (fs_in.materialIndex + 1) | (fs_in.movingObjectId != 0 ? 0x80000000 : 0);
+	oFragMatId = gbuffer_encode_material(fs_in.materialIndex, fs_in.movingObjectId != 0);
 
 	// calculate and write velocity
 	vec3 positionNDC      = fs_in.positionCS.xyz      / fs_in.positionCS.w;
@@ -292,7 +290,7 @@ void main()
 	positionNDC.xy      -= uboMatUsr.mJitterCurrentPrev.xy;
 	positionNDC_prev.xy -= uboMatUsr.mJitterCurrentPrev.zw;
 	vec3 motionVector = (positionNDC - positionNDC_prev) * vec3(0.5, 0.5, 1.0); // TODO: check if z scale is ok
-	oFragVelocity = vec4(motionVector, fs_in.movingObjectId);
+	oFragVelocity = vec4(motionVector, fs_in.movingObjectId);	// compact G-buffer: only .xy is stored
 
 	// Initialize all the colors:
 	vec3 ambient    = materialsBuffer.materials[matIndex].mAmbientReflectivity.rgb  * diffTexColorRGBA.rgb;
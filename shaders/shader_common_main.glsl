@@ -83,7 +83,8 @@
 	bool mUseShadowMap;																								\
 	float mShadowBias;																								\
 	int mShadowNumCascades;																							\
-	float pad1, pad2;																								\
+	bool mShadowPancaking;	/* clamp casters in front of the shadow near plane onto it */							\
+	float pad2;																										\
 }
 
 // "mLightsources" uniform buffer containing all the light source data:
@@ -101,6 +102,17 @@
 	MaterialGpuData materials[];				\
 }
 
+// Instanced moving objects ("crowd"): per-instance data and bone palettes (instance.mBoneBase + meshIndex * MAX_BONES + boneIndex)
+#define BUFFERDEF_CrowdInstances buffer CrowdInstances {	\
+	CrowdInstanceData crowdInstances[];						\
+}
+#define BUFFERDEF_CrowdBones buffer CrowdBones {			\
+	mat4 crowdBones[];										\
+}
+#define BUFFERDEF_CrowdBonesPrev buffer CrowdBonesPrev {	\
+	mat4 crowdBonesPrev[];									\
+}
+
 // ----- uniform structure definitions
 
 struct LightsourceGpuData
@@ -174,4 +186,11 @@ struct MaterialGpuData {
 	vec4 mExtraTexOffsetTiling;
 };
 
+struct CrowdInstanceData {
+	mat4 mModelMatrix;			// additional model matrix (like uboMatUsr.mMover_additionalModelMatrix)
+	mat4 mModelMatrixPrev;
+	uint mBoneBase;				// first bone matrix of this instance, CROWD_NO_BONES if not animated
+	uint pad0, pad1, pad2;
+};
+
 #endif
@@ -6,6 +6,30 @@
 #define SPECCONST_VAL_OPAQUE			0u
 #define SPECCONST_VAL_TRANSPARENT		1u
 
+// taa.comp pipeline variants: bitmask of the settings compiled into the shader; 0 = generic, everything is read from the ubo
+#define SPECCONST_ID_TAA_VARIANT		2u
+#define TAA_VARIANT_SPECIALIZED			0x0001u
+#define TAA_VARIANT_YCOCG				0x0002u
+#define TAA_VARIANT_VARIANCE_CLIP		0x0004u
+#define TAA_VARIANT_SHAPED_NBH			0x0008u
+#define TAA_VARIANT_DYN_ANTIGHOST		0x0010u
+#define TAA_VARIANT_RT_AUGMENT			0x0020u
+#define TAA_VARIANT_DEBUG				0x0040u		// write uDebug (only needed if the debug image is shown)
+#define TAA_VARIANT_INTERP_SHIFT		8			// 2 bits: mInterpolationMode
+#define TAA_VARIANT_VELSAMPLE_SHIFT		10			// 2 bits: mVelocitySampleMode
+#define TAA_VARIANT_DEBUGMODE_SHIFT		12			// 4 bits: mDebugMode
+#define TAA_VARIANT_FUSED_SHIFT			16			// 2 bits: fused resolve (TAA_FUSED_*), independent of TAA_VARIANT_SPECIALIZED
+#define TAA_FUSED_OFF					0u
+#define TAA_FUSED_COPY					1u			// fused resolve without sharpening
+#define TAA_FUSED_SHARPEN				2u			// ... with sharpen.comp
+#define TAA_FUSED_CAS					3u			// ... with sharpen_cas.comp
+#define TAA_VARIANT_STATIC_TILE			0x0080u		// kernel for static tiles: bilinear history, center velocity (also for the generic pipeline)
+#define TAA_VARIANT_FP16				0x40000u	// taa_fp16.comp module (half precision color math) instead of taa.comp, not a specialization
+#define TAA_VARIANT_NBH_SHIFT			20			// 2 bits: neighbourhood min/max and moments (TAA_NBH_*), independent of TAA_VARIANT_SPECIALIZED
+#define TAA_NBH_LDS						0u			// from the shared memory color tile
+#define TAA_NBH_SUBGROUP				1u			// subgroup shuffles (taa_subgroup.comp/taa_fp16_subgroup.comp module), the tile as fallback
+#define TAA_NBH_NAIVE					2u			// 9 texture samples per pixel, no tile
+
 // use a shadowmap?
 #define ENABLE_SHADOWMAP 1
 #define SHADOWMAP_SIZE 2048
@@ -41,10 +65,21 @@
 
 // max. bones for animations
 #define MAX_BONES	114
+#define SKINNING_WORKGROUP_SIZE 64	// compute shader skinning of animated objects
+
+// instanced moving objects ("crowd")
+#define MAX_CROWD_INSTANCES 1024
+#define CROWD_NO_BONES 0xFFFFFFFFu	// bone base for non-animated crowd objects
 
 // GPU frustum culling
 #define ENABLE_GPU_FRUSTUM_CULLING 1
 #define GPU_FRUSTUM_CULLING_WORKGROUP_SIZE 32	// TODO: Test!
+#define CULLING_PLANES_PER_FRUSTUM 10			// main camera uses 6; shadow cascades use the extruded cascade volume (up to 10); unused planes are (0,0,0,-1)
+
+// linear depth pyramid (depth_pyramid.comp, see depth_pyramid.glsl): min/max view space depth, level 0 = render resolution
+#define DEPTH_PYRAMID_MAX_LEVELS		16
+#define DEPTH_PYRAMID_HEADER_BYTES		(DEPTH_PYRAMID_MAX_LEVELS * 16 + 16)	// levels (offset, stride, width, height) + range
+#define DEPTH_PYRAMID_WORKGROUP_SIZE	16
 
 // don't have transparent movers (yet)
 
@@ -68,13 +103,44 @@
 
 #define TAA_IMAGE_FORMAT_SEGMASK		vk::Format::eR32Uint
 #define TAA_SHADER_FORMAT_SEGMASK		r32ui
+// segmask layout: bits 0..1 = 0: TAA, 1: FXAA, 2: ray trace; bit 2 = ray traced history valid; bits 8..15 = ray trace priority; bits 16..31 = history counter
+#define TAA_SEGMASK_PRIORITY_SHIFT		8
+#define TAA_SEGMASK_PRIORITY_MASK		0xff
+#define TAA_SEGMASK_RT_HISTORY			0x04	// temporal ray tracing: the history of this pixel was accumulated from ray traced samples
+#define TAA_RT_BUDGET_NUM_BUCKETS		256		// = priority levels
+
+// tile classification for taa.comp (taa_classify.comp): one list of workgroups per class, each dispatched indirectly
+#define TAA_TILE_STATIC					0u		// no motion in the tile and its 1 pixel apron -> TAA_VARIANT_STATIC_TILE kernel
+#define TAA_TILE_MOVING					1u
+#define TAA_TILE_DISOCCLUDED			2u		// material differs from the reprojected previous material somewhere
+#define TAA_TILE_EDGE					3u		// moving, with many depth edges or pixels marked for FXAA/ray tracing
+#define TAA_TILE_NUM_CLASSES			4u
+#define TAA_TILE_MAX_DISPATCHES			2u		// split screen with pipeline variants: one taa.comp dispatch per half
+#define TAA_TILE_HEADER_UINTS			(TAA_TILE_MAX_DISPATCHES * TAA_TILE_NUM_CLASSES * 4u)	// VkDispatchIndirectCommand + pad, per dispatch and class
 
 
 #define	IMAGE_FORMAT_COLOR				vk::Format::eR16G16B16A16Sfloat
 #define	IMAGE_FORMAT_DEPTH				vk::Format::eD32Sfloat
-#define	IMAGE_FORMAT_NORMAL				vk::Format::eR32G32B32A32Sfloat
-#define	IMAGE_FORMAT_MATERIAL			vk::Format::eR32Uint
-#define IMAGE_FORMAT_VELOCITY			vk::Format::eR16G16B16A16Sfloat
+
+// compact G-buffer for the TAA inputs? (forward rendering only, there is no uv for the deferred lighting pass); see shader_gbuffer.glsl
+#define COMPACT_GBUFFER 1
+#define GBUFFER_BYTES_PER_PIXEL_FULL	28	// normal + material + velocity
+#define GBUFFER_BYTES_PER_PIXEL_COMPACT	10
+#if COMPACT_GBUFFER
+#define	IMAGE_FORMAT_NORMAL				vk::Format::eR16G16Snorm			// octahedral view space normal
+#define	IMAGE_FORMAT_MATERIAL			vk::Format::eR16Uint				// material index + 1 | MATERIAL_ID_MOVER
+#define SHADER_FORMAT_MATERIAL			r16ui
+#define MATERIAL_ID_MOVER				0x8000u
+#define IMAGE_FORMAT_VELOCITY			vk::Format::eR16G16Sfloat			// xy only (uv units), the mover flag is in the material id
+#define GBUFFER_BYTES_PER_PIXEL			GBUFFER_BYTES_PER_PIXEL_COMPACT
+#else
+#define	IMAGE_FORMAT_NORMAL				vk::Format::eR32G32B32A32Sfloat		// uv, spherical view space normal
+#define	IMAGE_FORMAT_MATERIAL			vk::Format::eR32Uint				// material index + 1 | MATERIAL_ID_MOVER
+#define SHADER_FORMAT_MATERIAL			r32ui
+#define MATERIAL_ID_MOVER				0x80000000u
+#define IMAGE_FORMAT_VELOCITY			vk::Format::eR16G16B16A16Sfloat		// xy (uv units), z (ndc depth difference), w: moving object
+#define GBUFFER_BYTES_PER_PIXEL			GBUFFER_BYTES_PER_PIXEL_FULL
+#endif
 
 #define IMAGE_FORMAT_SHADOWMAP			vk::Format::eD32Sfloat
 #define SHADOWMAP_BINDING_SET			0
@@ -0,0 +1,54 @@
+//? #version 460
+// above line is just for the VS GLSL language integration plugin
+
+// encoding of the G-buffer attachments read by TAA (uvNrm, material id), for both layouts (COMPACT_GBUFFER in shader_cpu_common.h)
+// (the including shader needs shader_cpu_common.h)
+
+#ifndef SHADER_GBUFFER_INCLUDED
+#define SHADER_GBUFFER_INCLUDED 1
+
+// octahedral normal encoding, unit vector <-> [-1,1]^2
+vec2 oct_wrap(vec2 v) {
+	return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 oct_encode(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	return (n.z >= 0.0) ? n.xy : oct_wrap(n.xy);
+}
+
+vec3 oct_decode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+// uvNrm attachment
+// full layout:    uv, view space normal in spherical coordinates
+// compact layout: octahedral view space normal only (no uv -> forward rendering only)
+vec4 gbuffer_encode_uv_normal(vec2 uv, vec3 normalVS) {
+#if COMPACT_GBUFFER
+	return vec4(oct_encode(normalVS), 0, 0);
+#else
+	float l = length(normalVS.xy);
+	vec2 sphericalVS = vec2((l == 0) ? 0 : acos(clamp(normalVS.x / l, -1, 1)), asin(normalVS.z));
+	if (normalVS.y < 0) sphericalVS.x = 6.28318530718 - sphericalVS.x;
+	return vec4(uv, sphericalVS);
+#endif
+}
+
+vec3 gbuffer_decode_normal(vec4 uvNormal) {
+#if COMPACT_GBUFFER
+	return oct_decode(uvNormal.xy);
+#else
+	return vec3(cos(uvNormal.z) * cos(uvNormal.w), sin(uvNormal.z) * cos(uvNormal.w), sin(uvNormal.w));
+#endif
+}
+
+// material id attachment: material index + 1 (0 = background), MATERIAL_ID_MOVER set for moving objects
+uint gbuffer_encode_material(uint materialIndex, bool moving) {
+	return (materialIndex + 1) | (moving ? MATERIAL_ID_MOVER : 0u);
+}
+
+#endif
@@ -6,7 +6,7 @@
 
 void calc_ray(in vec2 pixelUV, in mat4 camTransform, float aspectRatio, out vec3 origin, out vec3 direction) {
 	// pixelUV: target location in uv screen space (range [0,1])
-	// aspectRatio = float(gl_LaunchSizeEXT.x) / float(gl_LaunchSizeEXT.y);
+	// aspectRatio = float(resolution.x) / float(resolution.y);
 
 	vec2 d = pixelUV * 2.0 - 1.0;
     origin = vec3(0.0, 0.0, 0.0);
@@ -35,14 +35,17 @@ void calc_ray(in vec2 pixelUV, in mat4 camTransform, float aspectRatio, out vec3
 	float mNormalMappingStrength;																					\
 	float mMaxRayLength;																							\
 	int  mNumSamples;																								\
-	int  mAnimObjFirstMeshId;																						\
-	int  mAnimObjNumMeshes;																							\
 	uint mDoShadows;		/* bit 0: general shadows, bit 1: shadows of transp. objs */							\
 	bool mAugmentTAA;																								\
 	bool mAugmentTAADebug;																							\
 	bool mApproximateLod;																							\
 	int mApproximateLodMaxAnisotropy;																				\
-	float pad1, pad2;																								\
+	ivec2 mResolution;		/* target image resolution (launch size is the pixel count when tracing a list) */		\
+	bool mAugmentTAAList;	/* trace only the pixels in the compacted list */										\
+	float mShadowRayLength;																							\
+	vec2 mJitterNdc;		/* TAA jitter of the current frame, for mTemporalSampling */							\
+	bool mTemporalSampling;	/* sample at the TAA jitter offset (mirrored for the 2nd sample) */						\
+	uint pad0;																										\
 }
 
 // ----- uniform structure definitions
@@ -0,0 +1,41 @@
+//? #version 460
+// above line is just for the VS GLSL language integration plugin
+
+// scene geometry for the hit shaders, accessed via buffer device addresses
+// (the including shader needs #extension GL_EXT_buffer_reference : require)
+// one RtGeometryInfo per ray tracing custom index (= per meshgroup / per mesh of a dynamic object), see rt_geometry_info in main.cpp
+
+#ifndef SHADER_RAYTRACE_GEOMETRY_INCLUDED
+#define SHADER_RAYTRACE_GEOMETRY_INCLUDED 1
+
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer RtUintArray  { uint  v[]; };
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer RtFloatArray { float v[]; };
+
+struct RtGeometryInfo {
+	RtUintArray  indices;		// 3 per triangle
+	RtFloatArray positions;		// 3 per vertex, object space (animated objects: skinned, of the current frame in flight)
+	RtFloatArray texCoords;		// 2 per vertex
+	RtFloatArray normals;		// 3 per vertex, ditto
+	RtFloatArray tangents;		// 3 per vertex, ditto
+	RtFloatArray bitangents;	// 3 per vertex, ditto
+	uint materialIndex;
+	uint pad0, pad1, pad2;
+};
+
+#define BUFFERDEF_RtGeometryInfo readonly buffer RtGeometryInfoBuffer {	\
+	RtGeometryInfo geometryInfos[];										\
+}
+
+ivec3 rt_fetch_indices(RtGeometryInfo g, int primitiveId) {
+	return ivec3(g.indices.v[3 * primitiveId], g.indices.v[3 * primitiveId + 1], g.indices.v[3 * primitiveId + 2]);
+}
+
+vec2 rt_fetch_vec2(RtFloatArray a, int i) {
+	return vec2(a.v[2 * i], a.v[2 * i + 1]);
+}
+
+vec3 rt_fetch_vec3(RtFloatArray a, int i) {
+	return vec3(a.v[3 * i], a.v[3 * i + 1], a.v[3 * i + 2]);
+}
+
+#endif
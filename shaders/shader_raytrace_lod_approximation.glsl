@@ -69,7 +69,7 @@ bool intersect_triangle(in vec3 Ray_Origin, in vec3 Ray_Dir, in vec3 A, in vec3
 #define RAYTRACE_LOD_APPROXIMATION_OBJECT_TO_WORLD_MATRIX gl_ObjectToWorldEXT
 #endif
 #ifndef RAYTRACE_LOD_APPROXIMATION_LAUNCHSIZE
-#define RAYTRACE_LOD_APPROXIMATION_LAUNCHSIZE gl_LaunchSizeEXT
+#define RAYTRACE_LOD_APPROXIMATION_LAUNCHSIZE pushConstants.mResolution
 #endif
 #ifndef RAYTRACE_LOD_APPROXIMATION_PIXELCENTERUV
 #define RAYTRACE_LOD_APPROXIMATION_PIXELCENTERUV hitValue.pixelCenterUV
@@ -43,6 +43,7 @@ void main()
 	}
 
 	gl_Position = uboMatUsr.mShadowmapProjViewMatrix[mShadowMapCascadeToBuild] * modelMatrix * vec4(aPosition, 1.0);
+	if (uboMatUsr.mShadowPancaking) gl_Position.z = max(gl_Position.z, 0.0);	// pancaking: flatten casters in front of the near plane onto it (ortho -> w = 1)
 }
 // -------------------------------------------------------
 
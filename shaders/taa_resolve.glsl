@@ -0,0 +1,1377 @@
+//? #version 460
+// above line is just for the VS GLSL language integration plugin
+
+// the TAA resolve, included by taa.comp (fp32) and taa_fp16.comp (TAA_FP16: color math in half precision),
+// and by taa_subgroup.comp/taa_fp16_subgroup.comp (TAA_SUBGROUP: subgroup neighbourhood, see subgroup_neighbourhood)
+
+#include "shader_cpu_common.h"
+#include "shader_gbuffer.glsl"
+
+// NOTE: This shader is totally NOT optimized for performance, but instead designed to experimant with different settings!
+
+// ATTENTION:
+// with upsampling enabled, the texture sizes are different:
+// lo-res: uCurrentFrame, uCurrentDepth, uCurrentVelocity, *uHistoryDepth*
+// hi-res: uHistoryFrame, uResult, uDebug
+// with dynamic resolution, only the top left ubo.mInputSize texels of the lo-res inputs are valid (ubo.mPrevInputSize for the
+// previous frame's inputs: uHistoryDepth, uPreviousMaterial); lo-res uvs are relative to that sub-rect, see input_uv()
+//
+// FIXME: decide res for uHistoryDepth (?)
+// FIXME: hist depth sampling is problematic
+
+// TODO upsampling:
+// unjittering ?
+
+
+// NOTE: if tonemapping is used: history buffer always contains tonemapped samples
+
+// ###### SRC/DST IMAGES #################################
+layout(set = 0, binding =  0) uniform sampler uSampler;
+layout(set = 0, binding =  1) uniform texture2D uCurrentFrame;
+layout(set = 0, binding =  2) uniform texture2D uCurrentDepth;
+layout(set = 0, binding =  7) uniform texture2D uCurrentVelocity;
+layout(set = 0, binding = 13) uniform texture2D uCurrentUvNrm;
+//layout(set = 0, binding = 10) uniform texture2D uCurrentMaterial;
+layout(set = 0, binding = 10, SHADER_FORMAT_MATERIAL) readonly uniform restrict uimage2D uCurrentMaterial;
+layout(set = 0, binding = 11, SHADER_FORMAT_MATERIAL) readonly uniform restrict uimage2D uPreviousMaterial;
+layout(set = 0, binding =  3) uniform texture2D uHistoryFrame;
+layout(set = 0, binding =  4) uniform texture2D uHistoryDepth;
+layout(set = 0, binding =  5, TAA_SHADER_OUTPUT_FORMAT) writeonly uniform restrict image2D uResultScreen;
+layout(set = 0, binding =  8, TAA_SHADER_OUTPUT_FORMAT) writeonly uniform restrict image2D uResultHistory;
+layout(set = 0, binding =  9, TAA_SHADER_FORMAT_SEGMASK) writeonly uniform restrict uimage2D uSegMask;
+layout(set = 0, binding = 12, TAA_SHADER_FORMAT_SEGMASK) readonly uniform restrict uimage2D uPreviousSegMask;
+layout(set = 0, binding =  6, rgba16f) writeonly uniform restrict image2D uDebug;
+layout(set = 0, binding = 14, TAA_SHADER_FORMAT_POSTPROCESS) writeonly uniform restrict image2D uFusedOutput;	// fused resolve: final image (instead of uResultScreen)
+layout(std430, set = 0, binding = 15) readonly buffer TileClasses {	// tile classification, see taa_classify.comp
+	uvec4 header[TAA_TILE_HEADER_UINTS / 4];
+	uint  tiles[];
+} uTileClasses;
+#define DEPTH_PYRAMID_SET		0
+#define DEPTH_PYRAMID_BINDING	16
+#include "depth_pyramid.glsl"	// linear depth, level 0 = uCurrentDepth (only if ubo.mUseDepthPyramid)
+// -------------------------------------------------------
+
+// texelFetch is undefined when sampling outside the texture, so always clamp (to the rendered sub-rect of the lo-res inputs)
+#define CLAMP_TO_TEX(v) clamp((v), ivec2(0), textureSize_loRes-1)
+
+// shortcut to texture(sampler2D(texture, uSampler), uv)
+#define SAMPLE_TEX(tex_,uv_) texture(sampler2D((tex_),uSampler), uv_)
+
+// same for the current lo-res inputs (uCurrentFrame, uCurrentDepth, uCurrentVelocity), uv relative to the rendered sub-rect
+#define SAMPLE_INPUT(tex_,uv_) texture(sampler2D((tex_),uSampler), input_uv(uv_))
+
+#define JITTER_UV (ubo.mJitterNdc.xy * 0.5 * params.mUnjitterFactor)
+
+// ###### PUSH CONSTANTS AND UBOs ########################
+struct Parameters {
+	float mAlpha;
+	int  mColorClampingOrClipping;
+	bool mDepthCulling;
+	bool mUnjitterNeighbourhood;
+	bool mUnjitterCurrentSample;	// TODO: anything for depth/history depth??
+	float mUnjitterFactor;			// -1 or +1, for debugging
+	bool mPassThrough;				// effectively disables TAA: history <- input, result <- input,
+	bool mUseYCoCg;
+	bool mShrinkChromaAxis;			// ony used if mUseYCoCg - reduce Chroma influence on clip box
+	bool mVarianceClipping;
+	bool mShapedNeighbourhood;
+	bool mLumaWeightingLottes;
+	float mVarClipGamma;
+	float mMinAlpha;				// used for luminance-based weighting (Lottes)
+	float mMaxAlpha;				// used for luminance-based weighting (Lottes)
+	float mRejectionAlpha;
+	bool mRejectOutside;
+	int mUseVelocityVectors;		// 0=off 1=for movers only 2=for everything
+	int mVelocitySampleMode;		// 0=simple 1=3x3_max 2=3x3_closest
+	int mInterpolationMode;			// 0=bilinear 1=bicubic b-spline 2=bicubic catmull-rom
+	bool mToneMapLumaKaris;			// "tone mapping" by luma weighting (Karis)
+	bool mAddNoise;
+	float mNoiseFactor;				// small, way less than 1, e.g. 1/512
+	bool mReduceBlendNearClamp;		// reduce blend factor when near clamping (Karis14)
+	bool mDynamicAntiGhosting;		// dynamic anti-ghosting, inspired by Unreal Engine
+	bool  mVelBasedAlpha;			// let velocity influence alpha
+	float mVelBasedAlphaMax;
+	float mVelBasedAlphaFactor;		// final alpha = lerp(intermed.alpha, max, pixelvel*factor)
+	bool mRayTraceAugment;			// ray tracing augmentation
+	uint mRayTraceAugmentFlags;
+	float mRayTraceAugment_WNrm;	// weight for normals
+	float mRayTraceAugment_WDpt;	// weight for depth
+	float mRayTraceAugment_WMId;	// weight for material
+	float mRayTraceAugment_WLum;	// weight for luminance
+	float mRayTraceAugment_Thresh;	// threshold for sum of weighted indicators
+	int   mRayTraceHistoryCount;	// how long to keep ray trace flag around
+//	float pad1;
+
+	// -- aligned again here
+	vec4 mDebugMask;
+	int  mDebugMode;
+	float mDebugScale;
+	bool mDebugCenter;
+	bool mDebugToScreenOutput;
+};
+
+layout(push_constant) uniform PushConstants {
+	ivec2 mOffset;		// first pixel of this dispatch (split screen with pipeline variants: one dispatch per half)
+	int   mEndX;		// pixels at x >= mEndX are done by another dispatch
+	int   mParamsIdx;	// parameter set for the whole dispatch; -1: by split screen position
+	// fused resolve only:
+	int   mFusedSplitX;	// split screen line, drawn black (as in post_process.comp); -1: none
+	float mFusedSharpen;	// sharpening factor (as in sharpen.comp)
+	int   mTileList;	// tile classification: >= 0: workgroups are read from uTileClasses.tiles[mTileList + gl_WorkGroupID.x] (indirect dispatch)
+	int   pad;
+	uvec4 mCasConst0;	// CAS constants (as in sharpen_cas.comp)
+	uvec4 mCasConst1;
+} pushConstants;
+
+// pipeline variant, see TAA_VARIANT_* in shader_cpu_common.h: the settings in the mask replace the ubo parameters,
+// so the unused paths are compiled out; 0 = generic
+layout(constant_id = SPECCONST_ID_TAA_VARIANT) const uint taaVariant = 0u;
+#define IS_SPECIALIZED	((taaVariant & TAA_VARIANT_SPECIALIZED) != 0)
+#define WRITE_DEBUG		(!IS_SPECIALIZED || (taaVariant & TAA_VARIANT_DEBUG) != 0)
+
+// fused resolve: sharpening and post processing are done here and written to uFusedOutput, instead of running sharpen(_cas).comp and
+// post_process.comp on uResultScreen (only without FXAA, debug views and zoom - see taa::fused_resolve_mode)
+// with sharpening, workgroups overlap by one pixel: the outer ring of invocations resolves the neighbourhood of the inner 14x14 pixels
+#define FUSED_MODE		((taaVariant >> TAA_VARIANT_FUSED_SHIFT) & 0x3u)
+#define FUSED			(FUSED_MODE != TAA_FUSED_OFF)
+#define FUSED_OVERLAP	(FUSED_MODE == TAA_FUSED_SHARPEN || FUSED_MODE == TAA_FUSED_CAS)
+
+// neighbourhood min/max and moments (TAA_NBH_*): from the shared memory tile, subgroup operations (only in the TAA_SUBGROUP modules,
+// the tile is the fallback) or from texture samples of every invocation
+#define NBH_MODE		((taaVariant >> TAA_VARIANT_NBH_SHIFT) & 0x3u)
+
+Parameters params;
+
+layout(set = 1, binding = 0) uniform Matrices {
+	mat4 mHistoryViewProjMatrix;
+	mat4 mInverseViewProjMatrix;
+
+	Parameters	param[2];
+	vec4        mJitterNdc;		// only .xy used; jitter is in NDC units, NOT UV units!
+	vec4		mSinTime;		// sin(t/8), sin(t/4), sin(t/2), sin(t)
+	bool		splitScreen;
+	int			splitX;
+	bool        mUpsampling;
+	bool        mBypassHistoryUpdate;
+	bool        mResetHistory;
+	float		mCamNearPlane;
+	float		mCamFarPlane;
+
+	bool		mRayTraceTemporal;	// ray traced pixels accumulate ray traced samples in the history (see rt_temporal.comp)
+	bool		mUseTile;			// use the shared memory neighbourhood tile (see load_tile)
+
+	float		pad1;
+	ivec2		mInputSize;			// dynamic resolution: rendered sub-rect of the lo-res inputs, this frame
+	ivec2		mPrevInputSize;		// ... and previous frame (uHistoryDepth, uPreviousMaterial)
+	vec2		mInputUvScale;		// mInputSize / size of the lo-res input images
+	bool		mUseDepthPyramid;	// linear depth from uDepthPyramid instead of linearizing uCurrentDepth
+	float		pad2, pad3, pad4;
+} ubo;
+// -------------------------------------------------------
+
+// color arithmetic: half precision in taa_fp16.comp (the inputs and the history are RGBA16F anyway); uv/reprojection math,
+// depth and the history filter positions stay fp32
+#if TAA_FP16
+	#define cfloat	float16_t
+	#define cvec2	f16vec2
+	#define cvec3	f16vec3
+	#define cvec4	f16vec4
+	#define CEPS	1e-4		// 1e-7 is below the half precision range
+#else
+	#define cfloat	float
+	#define cvec2	vec2
+	#define cvec3	vec3
+	#define cvec4	vec4
+	#define CEPS	1e-7
+#endif
+
+#ifndef TAA_SUBGROUP
+#define TAA_SUBGROUP 0
+#endif
+
+// Globals
+ivec2 textureSize_loRes;
+ivec2 textureSize_hiRes;
+
+// Just for debugging:
+vec4 gDebugValue = vec4(0);
+
+void specialize_params() {
+	if ((taaVariant & TAA_VARIANT_STATIC_TILE) != 0) {
+		// static tile (see taa_classify.comp): the history position is (nearly) the pixel center (a specialized static variant has these bits cleared)
+		params.mInterpolationMode  = 0;
+		params.mVelocitySampleMode = 0;
+	}
+	if (!IS_SPECIALIZED) return;
+	params.mUseYCoCg            = (taaVariant & TAA_VARIANT_YCOCG)          != 0;
+	params.mVarianceClipping    = (taaVariant & TAA_VARIANT_VARIANCE_CLIP)  != 0;
+	params.mShapedNeighbourhood = (taaVariant & TAA_VARIANT_SHAPED_NBH)     != 0;
+	params.mDynamicAntiGhosting = (taaVariant & TAA_VARIANT_DYN_ANTIGHOST)  != 0;
+	params.mRayTraceAugment     = (taaVariant & TAA_VARIANT_RT_AUGMENT)     != 0;
+	params.mInterpolationMode   = int((taaVariant >> TAA_VARIANT_INTERP_SHIFT)    & 0x3u);
+	params.mVelocitySampleMode  = int((taaVariant >> TAA_VARIANT_VELSAMPLE_SHIFT) & 0x3u);
+	params.mDebugMode           = int((taaVariant >> TAA_VARIANT_DEBUGMODE_SHIFT) & 0xfu);
+}
+
+// Neighbourhood tile: 16x16 pixels of the workgroup plus a 1 texel apron, loaded once into shared memory (see load_tile)
+#define TILE_SIZE	16
+#define TILE_APRON	1
+#define TILE_DIM	(TILE_SIZE + 2 * TILE_APRON)
+shared cvec3 sTileColor [TILE_DIM * TILE_DIM];	// tonemapped, YCoCg if enabled (as in getNeighbourhood)
+shared float sTileLuma  [TILE_DIM * TILE_DIM];	// luminance of the input color (as in sample_luminance)
+shared float sTileDepth [TILE_DIM * TILE_DIM];	// linear depth
+shared vec3  sTileNormal[TILE_DIM * TILE_DIM];
+shared uint  sTileMatId [TILE_DIM * TILE_DIM];
+bool  gTile      = false;	// luma/depth/normal/material tiles are valid (as far as needed by the params)
+bool  gTileColor = false;	// color tile is valid
+ivec2 gTileOrigin;			// texel coords of the top left tile element
+ivec2 gLocal;				// pixel of this invocation in the workgroup (subgroup neighbourhood: 2D swizzle, see subgroup_blocks)
+
+// subgroup neighbourhood (see subgroup_neighbourhood): 3x3 min/max, 5-tap cross min/max and moments of the pixel gNbhTc
+bool  gNbh = false;
+ivec2 gNbhTc;
+cvec3 gNbhMin, gNbhMax, gNbhCrossMin, gNbhCrossMax;
+vec3  gNbhM1, gNbhM2;
+
+// fused resolve: screen output of the workgroup's pixels (see FUSED)
+shared vec3  sFused[TILE_SIZE * TILE_SIZE];
+ivec2 gFusedOrigin;			// texel coords of sFused[0]
+ivec2 gFusedMin, gFusedMax;	// pixels resolved by this dispatch (sharpening clamps to them, like to the image border)
+
+// ###### HELPER FUNCTIONS ###############################
+
+// texel coords <-> uv conversion
+vec2  tc_to_uv(ivec2 tc, ivec2 texSize) { return (vec2(tc) + 0.5) / texSize; }
+ivec2 uv_to_tc(vec2 uv,  ivec2 texSize) { return ivec2(uv * texSize); }
+
+// uv relative to the rendered sub-rect -> uv of the lo-res input images; clamped to the sub-rect (bilinear filtering must
+// not pick up texels outside of it - same result as the clamp-to-edge sampler when the whole image is rendered)
+vec2 input_uv(vec2 uv) {
+	vec2 halfTexel = 0.5 / vec2(textureSize_loRes);
+	return clamp(uv, halfTexel, 1.0 - halfTexel) * ubo.mInputUvScale;
+}
+
+ivec2 hiRes_to_loRes_Tc(ivec2 hires_tc) {
+	return uv_to_tc(tc_to_uv(hires_tc, textureSize_hiRes), textureSize_loRes);
+}
+
+// lo-res texel coords -> neighbourhood tile index; tc must be within the 3x3 neighbourhood of a pixel of this workgroup
+int tile_index(ivec2 tc) {
+	ivec2 t = tc - gTileOrigin;
+	return t.y * TILE_DIM + t.x;
+}
+
+
+//// convert from RGB to YCoCg-R ; see https://en.wikipedia.org/wiki/YCoCg
+//vec3 rgb_to_ycocg(vec3 c) {
+//	float co  = c.r - c.b;
+//	float tmp = c.b + co * .5;
+//	float cg  = c.g - tmp;
+//	float y   = tmp + cg * .5;
+//	return vec3(y,co,cg);
+//}
+//
+//// convert from YCoCg-R to RGB
+//vec3 ycocg_to_rgb(vec3 c) {
+//	float tmp = c.x - c.z * .5;
+//	float g   = c.z + tmp;
+//	float b   = tmp - c.y * .5;
+//	float r   = b + c.y;
+//	return vec3(r,g,b);
+//}
+
+// convert from RGB to YCoCg ; see https://en.wikipedia.org/wiki/YCoCg
+cvec3 rgb_to_ycocg(cvec3 c) {
+	return cvec3(
+		dot(c, cvec3( .25, .5,  .25)),
+		dot(c, cvec3( .5,  0., -.5 )),
+		dot(c, cvec3(-.25, .5, -.25))
+	);
+}
+
+// convert from YCoCg to RGB
+cvec3 ycocg_to_rgb(cvec3 c) {
+	cfloat tmp = c.x - c.z;	// tmp = Y   - Cg;
+	return cvec3(
+		tmp + c.y,	// R   = tmp + Co;
+		c.x + c.z,	// G   = Y   + Cg;
+		tmp - c.y	// B   = tmp - Co;
+	);
+}
+
+
+cvec3 maybe_rgb_to_ycocg(cvec3 c) { return params.mUseYCoCg ? rgb_to_ycocg(c) : c; }
+cvec3 maybe_ycocg_to_rgb(cvec3 c) { return params.mUseYCoCg ? ycocg_to_rgb(c) : c; }
+cfloat luminance(cvec3 c) { return params.mUseYCoCg ? c.x : rgb_to_ycocg(c).x; }
+
+// luma-weighted "tone mapping" (Karis); see http://graphicrants.blogspot.com/2013/12/tone-mapping.html
+cvec3 tonemap_rgb(cvec3 hdr) {
+	if (params.mToneMapLumaKaris) {
+		cfloat luma = max(max(hdr.r, hdr.g), hdr.b);
+		return hdr / (cfloat(1) + luma);
+	} else {
+		return hdr;
+	}
+}
+// always fp32: 1 - luma cancels out for bright colors
+vec3 un_tonemap_rgb(vec3 ldr) {
+	if (params.mToneMapLumaKaris) {
+		float luma = max(max(ldr.r, ldr.g), ldr.b);
+		return ldr / (1.0 - luma);
+	} else {
+		return ldr;
+	}
+}
+
+void getNeighbourhood(in ivec2 iuv, out cvec3 cC, out cvec3 c1, out cvec3 c2, out cvec3 c3, out cvec3 c4, out cvec3 c5, out cvec3 c6, out cvec3 c7, out cvec3 c8) {
+	if (gTileColor) {
+		int i = tile_index(iuv);
+		cC = sTileColor[i];
+		c1 = sTileColor[i - TILE_DIM - 1];
+		c2 = sTileColor[i - TILE_DIM    ];
+		c3 = sTileColor[i - TILE_DIM + 1];
+		c4 = sTileColor[i            - 1];
+		c5 = sTileColor[i            + 1];
+		c6 = sTileColor[i + TILE_DIM - 1];
+		c7 = sTileColor[i + TILE_DIM    ];
+		c8 = sTileColor[i + TILE_DIM + 1];
+		return;
+	}
+
+	vec2 offset = params.mUnjitterNeighbourhood ? JITTER_UV : vec2(0);
+
+	vec2 invsize = vec2(1) / textureSize_loRes;
+
+	cC = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv                 + 0.5) * invsize).rgb)));
+	c1 = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + ivec2(-1, -1) + 0.5) * invsize).rgb)));
+	c2 = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + ivec2( 0, -1) + 0.5) * invsize).rgb)));
+	c3 = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + ivec2( 1, -1) + 0.5) * invsize).rgb)));
+	c4 = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + ivec2(-1,  0) + 0.5) * invsize).rgb)));
+	c5 = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + ivec2( 1,  0) + 0.5) * invsize).rgb)));
+	c6 = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + ivec2(-1,  1) + 0.5) * invsize).rgb)));
+	c7 = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + ivec2( 0,  1) + 0.5) * invsize).rgb)));
+	c8 = maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + ivec2( 1,  1) + 0.5) * invsize).rgb)));
+}
+
+// may have different unjitter settings than getNeighbourhood
+cvec3 getCurrentColor(in ivec2 iuv) {
+	if (gTileColor && !params.mUnjitterCurrentSample) return sTileColor[tile_index(iuv)];
+	vec2 offset = params.mUnjitterCurrentSample ? JITTER_UV : vec2(0);
+	vec2 invsize = vec2(1) / textureSize_loRes;
+	return maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, offset + vec2(iuv + 0.5) * invsize).rgb)));
+}
+
+cvec3 getCurrentUpsampledColor(in ivec2 currentTc, in vec2 currentUv, out float beta) {
+	// non-upsampling behaviour was:
+	//beta = 1.0; return getCurrentColor(hiRes_to_loRes_Tc(currentTc));
+
+	// only consider input samples that fall into the current texel after upscaling
+
+	// example: hi-res = 2 x lores, consider input at center of texels 100, 101 -> = tc 100.5 (with non-normalized texture-coords tc); jitter is in texel units
+	// jitter 0   : input 100.50 -> output 201.0 (203.0)
+	// jitter -.25: input 100.25 -> output 200.5 (202.5)
+	// jitter +.25: input 100.75 -> output 201.5 (203.5)
+	// jitter -.40: input 100.10 -> output 200.2 (202.2), so update output tc [200-201) and [202-203), but not [201-202)
+	// jitter J   : input I+J    -> output scale * (I + J)
+	// O = s * (I + J) -> O/s - J = I
+
+	vec2 scale = vec2(textureSize_hiRes) / vec2(textureSize_loRes);
+
+	vec2 texelJitter = JITTER_UV * textureSize_loRes * -1;	// * -1 works... but WHY subtract jitter instead of adding?
+	vec2 inTcSample;
+	vec2 foundTc = vec2(-1,-1);
+	const float almostOne = 0.999999;
+	inTcSample = floor(textureSize_loRes * vec2(currentTc + vec2(0,        0        )) / textureSize_hiRes) + 0.5 + texelJitter; if (ivec2(inTcSample * scale) == currentTc) foundTc = inTcSample;
+	inTcSample = floor(textureSize_loRes * vec2(currentTc + vec2(almostOne,0        )) / textureSize_hiRes) + 0.5 + texelJitter; if (ivec2(inTcSample * scale) == currentTc) foundTc = inTcSample;
+	inTcSample = floor(textureSize_loRes * vec2(currentTc + vec2(0,        almostOne)) / textureSize_hiRes) + 0.5 + texelJitter; if (ivec2(inTcSample * scale) == currentTc) foundTc = inTcSample;
+	inTcSample = floor(textureSize_loRes * vec2(currentTc + vec2(almostOne,almostOne)) / textureSize_hiRes) + 0.5 + texelJitter; if (ivec2(inTcSample * scale) == currentTc) foundTc = inTcSample;
+
+	//gDebugValue = foundTc.x >= 0.0 ? vec4(1, foundTc, 0) : vec4(0);	
+
+	if (foundTc.x >= 0.0) {
+		beta = 1.0;
+		vec2 texUv = (floor(foundTc) + 0.5) / textureSize_loRes;
+		return maybe_rgb_to_ycocg(tonemap_rgb(cvec3(SAMPLE_INPUT(uCurrentFrame, texUv).rgb)));
+	} else {
+		beta = 0.0;
+		return cvec3(0);
+	}
+}
+
+void getColorAndAabb(in ivec2 iuv, out cvec3 centerCol, out cvec3 minCol, out cvec3 maxCol, out cvec3 cliptowardsCol)
+{
+	const float N = 9.0; // number of samples
+	cvec3 c1,c2,c3,c4,c5,c6,c7,c8;
+	bool subgroup = gNbh && iuv == gNbhTc;	// min/max and moments are already there
+	if (subgroup) centerCol = sTileColor[tile_index(iuv)];
+	else          getNeighbourhood(iuv, centerCol,c1,c2,c3,c4,c5,c6,c7,c8);
+
+	// variance clipping?
+	if (params.mVarianceClipping) {
+		// moments in fp32 (the squares of HDR colors without tone mapping overflow half precision)
+		vec3 m1 = gNbhM1, m2 = gNbhM2;
+		if (!subgroup) {
+			vec3 v0 = vec3(centerCol), v1 = vec3(c1), v2 = vec3(c2), v3 = vec3(c3), v4 = vec3(c4), v5 = vec3(c5), v6 = vec3(c6), v7 = vec3(c7), v8 = vec3(c8);
+			m1 = v0 + v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8;
+			m2 = v0*v0 + v1*v1 + v2*v2 + v3*v3 + v4*v4 + v5*v5 + v6*v6 + v7*v7 + v8*v8;
+		}
+		vec3 mean = m1 / N;
+		vec3 sigma = sqrt(max(vec3(0), m2 / N - mean * mean));	// !! Here be dragons! (due to precision? - without the max(), some sigma components can get NaN!)
+		minCol = cvec3(mean - params.mVarClipGamma * sigma);
+		maxCol = cvec3(mean + params.mVarClipGamma * sigma);
+
+		// NOTE: it is NOT guaranteed that centerCol is inside the AABB !
+		// so clip towards the mean
+		cliptowardsCol = cvec3(mean);
+
+		// TODO: we can even clip the other AABB against this one
+	} else if (params.mShapedNeighbourhood) {
+		cvec3 minCol_3x3  = subgroup ? gNbhMin      : min(min(min(min(min(min(min(min(centerCol, c1), c2), c3), c4), c5), c6), c7), c8);
+		cvec3 maxCol_3x3  = subgroup ? gNbhMax      : max(max(max(max(max(max(max(max(centerCol, c1), c2), c3), c4), c5), c6), c7), c8);
+		cvec3 minCol_5tap = subgroup ? gNbhCrossMin : min(min(min(min(centerCol, c2), c4), c5), c7);
+		cvec3 maxCol_5tap = subgroup ? gNbhCrossMax : max(max(max(max(centerCol, c2), c4), c5), c7);
+		minCol = (minCol_3x3 + minCol_5tap) * cfloat(0.5);
+		maxCol = (maxCol_3x3 + maxCol_5tap) * cfloat(0.5);
+		cliptowardsCol = centerCol;
+
+	} else if (subgroup) {
+		minCol = gNbhMin;
+		maxCol = gNbhMax;
+		cliptowardsCol = centerCol;
+	} else {
+		minCol = min(min(min(min(min(min(min(min(centerCol, c1), c2), c3), c4), c5), c6), c7), c8);
+		maxCol = max(max(max(max(max(max(max(max(centerCol, c1), c2), c3), c4), c5), c6), c7), c8);
+		cliptowardsCol = centerCol; // here centerCol is always inside the AABB; note: playdead still clip towards average color 
+	}
+
+	if (params.mUseYCoCg && params.mShrinkChromaAxis) {
+		// shrink clip-box in the two chroma axes (see Inside-code from playdead, and [Karis14])
+		// .r = Y = luma, .gb = CoCg = Chroma (chroma orange, chroma green)
+		// NOTE:
+		// This is differen from "Inside".
+		// "Inside" calcs chroma box size directly from Luma (.r) size, but that doesn't make any sense... does it?
+		// And Inside sets box center to current texel color.
+
+		//vec2 halfSize = 0.25 * 0.5 * vec2(maxCol.gb - minCol.gb);
+		//vec2 center = centerCol.gb;
+		//minCol.gb = center - halfSize;
+		//maxCol.gb = center + halfSize;
+		//cliptowardsCol.gb = center;
+
+		const cvec3 scaleYCoCg = cvec3(1.0, 0.5, 0.5);
+		cvec3 halfSize = cfloat(0.5) * scaleYCoCg * (maxCol - minCol);
+		cvec3 center = (minCol + maxCol) * cfloat(0.5);
+		minCol = center - halfSize;
+		maxCol = center + halfSize;
+		if (any(lessThan(cliptowardsCol, minCol)) || any(greaterThan(cliptowardsCol, maxCol))) cliptowardsCol = center;
+	}
+
+	// TODO: optionally unjitter differently: neighbourhood samples, current color -> need to make sure cliptowardsCol stays inside AABB
+
+	//if (any(lessThan(centerCol, minCol)) || any(greaterThan(centerCol, maxCol))) gDebugValue = vec4(1,0,0,0);
+}
+
+// Code from Temporal Reprojection Anti-Aliasing in INSIDE: https://youtu.be/2XXS5UyNjjU?t=939
+// note: clips towards aabb center + p.w
+cvec4 clipAabb(
+	cvec3 aabbMin, // cn_min
+	cvec3 aabbMax, // cn_max
+	cvec4 p,       // c_in'		// only p.w is used (and typically is 1)
+	cvec4 q)       // c_hist
+{
+	const cfloat eps = cfloat(CEPS);
+
+	cvec3 pClip = cfloat(0.5) * (aabbMax + aabbMin);
+	cvec3 eClip = cfloat(0.5) * (aabbMax - aabbMin) + eps; // ac: added epsilon
+
+	cvec4 vClip = q - cvec4(pClip, p.w);
+	cvec3 vUnit = vClip.xyz / eClip;
+	cvec3 aUnit = abs(vUnit);
+	cfloat maUnit = max(aUnit.x, max(aUnit.y, aUnit.z));
+
+	if (maUnit > cfloat(1)) {
+		return cvec4(pClip, p.w) + vClip / maUnit;
+	}
+	else {
+		return q; // point inside aabb
+	}
+}
+
+// slow clipping, but not only towards centre; code from playdead -- DOES NOT WORK PROPERLY!
+cvec4 clipAabbSlow(
+	cvec3 aabbMin, // cn_min
+	cvec3 aabbMax, // cn_max
+	cvec4 p,       // c_in'
+	cvec4 q)       // c_hist
+{
+		cvec4 r = q - p;
+		cvec3 rmax = aabbMax - p.xyz;
+		cvec3 rmin = aabbMin - p.xyz;
+
+		const cfloat eps = cfloat(CEPS);
+
+		// !! BEWARE !! divs by zero happen here !!
+		if (r.x > rmax.x + eps) r *= (rmax.x / r.x);
+		if (r.y > rmax.y + eps) r *= (rmax.y / r.y);
+		if (r.z > rmax.z + eps) r *= (rmax.z / r.z);
+		if (r.x < rmin.x - eps) r *= (rmin.x / r.x);
+		if (r.y < rmin.y - eps) r *= (rmin.y / r.y);
+		if (r.z < rmin.z - eps) r *= (rmin.z / r.z);
+
+		return p + r;
+}
+
+float sample_linear_depth(ivec2 iuv);	// below
+
+vec3 findClosestUvAndZ_3x3(vec2 uv) {
+	// uv should be dead-center on a texel, we don't want to interpolate the depth buffer!
+
+	vec2 toUv = vec2(1,1) / textureSize_loRes;
+
+	if (gTile) {
+		// same search on the (linear) depth tile - linearizing keeps the order; NOTE: .z is linear depth here
+		ivec2 tc = uv_to_tc(uv, textureSize_loRes);
+		ivec2 closest = ivec2(-1,-1);
+		float dMin = sample_linear_depth(CLAMP_TO_TEX(tc + closest));
+		for (int y = -1; y <= 1; ++y) {
+			for (int x = -1; x <= 1; ++x) {
+				float d = sample_linear_depth(CLAMP_TO_TEX(tc + ivec2(x, y)));
+				if (d < dMin) { closest = ivec2(x, y); dMin = d; }
+			}
+		}
+		return vec3(uv + toUv * vec2(closest), dMin);
+	}
+
+	vec2 offset, closestOffset;
+	float d, dClosest;
+	offset = toUv * vec2(-1,-1); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r;                     closestOffset = offset; dClosest = d;
+	offset = toUv * vec2( 0,-1); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r; if (d < dClosest) { closestOffset = offset; dClosest = d; }
+	offset = toUv * vec2( 1,-1); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r; if (d < dClosest) { closestOffset = offset; dClosest = d; }
+	offset = toUv * vec2(-1, 0); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r; if (d < dClosest) { closestOffset = offset; dClosest = d; }
+	offset = toUv * vec2( 0, 0); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r; if (d < dClosest) { closestOffset = offset; dClosest = d; }
+	offset = toUv * vec2( 1, 0); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r; if (d < dClosest) { closestOffset = offset; dClosest = d; }
+	offset = toUv * vec2(-1, 1); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r; if (d < dClosest) { closestOffset = offset; dClosest = d; }
+	offset = toUv * vec2( 0, 1); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r; if (d < dClosest) { closestOffset = offset; dClosest = d; }
+	offset = toUv * vec2( 1, 1); d = SAMPLE_INPUT(uCurrentDepth, uv + offset).r; if (d < dClosest) { closestOffset = offset; dClosest = d; }
+
+	return vec3(uv + closestOffset, dClosest);
+}
+
+// velocity: .xy in uv units, .z raw (ndc) depth difference, .w = 1 for moving objects
+// compact G-buffer: only .xy is stored, the mover flag comes from the material id, .z is 0
+vec4 sample_velocity(vec2 uv) {
+#if COMPACT_GBUFFER
+	uint matId = imageLoad(uCurrentMaterial, CLAMP_TO_TEX(uv_to_tc(uv, textureSize_loRes))).r;
+	return vec4(SAMPLE_INPUT(uCurrentVelocity, uv).xy, 0, (matId & MATERIAL_ID_MOVER) != 0 ? 1 : 0);
+#else
+	return SAMPLE_INPUT(uCurrentVelocity, uv);
+#endif
+}
+
+void getHistoryPosition(in vec2 currentUv, in float currentDepth, out vec2 historyUv, out float historyDepth, out float outputPixelSpeed /* in pixel units*/) {
+	vec4 velocitySample = sample_velocity(currentUv);
+
+	bool canUseVelocity = true;
+	if (params.mUseVelocityVectors == 0 || (params.mUseVelocityVectors == 1 && velocitySample.w < 0.5)) canUseVelocity = false;
+
+	if (canUseVelocity) {
+		if (params.mVelocitySampleMode == 1) {
+			// 3x3 longest
+			// sample 3x3 neighbourhood, take longest vector
+			vec2 toUv = vec2(1,1) / textureSize_loRes;
+			vec2 maxVel = velocitySample.xy;
+			vec2 sam;
+			sam = SAMPLE_INPUT(uCurrentVelocity, currentUv + toUv * vec2( 1, -1)).xy; if (dot(sam,sam) > dot(maxVel,maxVel)) maxVel = sam;
+			sam = SAMPLE_INPUT(uCurrentVelocity, currentUv + toUv * vec2(-1,  0)).xy; if (dot(sam,sam) > dot(maxVel,maxVel)) maxVel = sam;
+			sam = SAMPLE_INPUT(uCurrentVelocity, currentUv + toUv * vec2(-1, -1)).xy; if (dot(sam,sam) > dot(maxVel,maxVel)) maxVel = sam;
+			sam = SAMPLE_INPUT(uCurrentVelocity, currentUv + toUv * vec2( 0, -1)).xy; if (dot(sam,sam) > dot(maxVel,maxVel)) maxVel = sam;
+			sam = SAMPLE_INPUT(uCurrentVelocity, currentUv + toUv * vec2(-1,  1)).xy; if (dot(sam,sam) > dot(maxVel,maxVel)) maxVel = sam;
+			sam = SAMPLE_INPUT(uCurrentVelocity, currentUv + toUv * vec2( 0,  1)).xy; if (dot(sam,sam) > dot(maxVel,maxVel)) maxVel = sam;
+			sam = SAMPLE_INPUT(uCurrentVelocity, currentUv + toUv * vec2( 1,  0)).xy; if (dot(sam,sam) > dot(maxVel,maxVel)) maxVel = sam;
+			sam = SAMPLE_INPUT(uCurrentVelocity, currentUv + toUv * vec2( 1,  1)).xy; if (dot(sam,sam) > dot(maxVel,maxVel)) maxVel = sam;
+			velocitySample.xy = sam;
+		} else if (params.mVelocitySampleMode == 2) {
+			// 3x3 closest
+			// find closest fragment in 3x3 neighbourhood from depth buffer, sample velocity from that location
+			vec3 closestUvAndZ = findClosestUvAndZ_3x3(currentUv);
+			velocitySample = sample_velocity(closestUvAndZ.xy);
+		} // else: we already have the simple velocity sample
+
+		// velocity sample is already scaled from ndc to uv in .xy, .z holds the raw (ndc) depth difference
+		historyUv    = currentUv    - velocitySample.xy;
+#if COMPACT_GBUFFER
+		// no depth difference in the compact velocity buffer: reproject the depth (camera motion only)
+		vec4 historyClipSpace = ubo.mHistoryViewProjMatrix * (ubo.mInverseViewProjMatrix * vec4(currentUv * 2.0 - 1.0, currentDepth, 1));
+		historyDepth = historyClipSpace.z / historyClipSpace.w;
+#else
+		historyDepth = currentDepth - velocitySample.z;
+#endif
+		// TODO: check if material history is same object and set canUseVelocity = false otherwise
+	} else {
+		// not using the velocity buffer but doing reprojection instead
+		vec4 clipSpace = vec4(currentUv * 2.0 - 1.0, currentDepth, 1);
+		vec4 worldSpace = ubo.mInverseViewProjMatrix * clipSpace;
+		vec4 historyClipSpace = ubo.mHistoryViewProjMatrix * worldSpace;
+		historyUv = (historyClipSpace.xy / historyClipSpace.w) * 0.5 + 0.5;
+		historyDepth = historyClipSpace.z / historyClipSpace.w;
+	}
+
+	// set outputPixelSpeed (magnitude of velocity vector in output pixel units)
+	vec2 velUv = currentUv - historyUv;
+	outputPixelSpeed = sqrt(dot(velUv, velUv));
+
+	// TODO: need to adjust for current jitter if history buf is considered unjittered?
+}
+
+// see https://vec3.ca/bicubic-filtering-in-fewer-taps/
+cvec4 sample_history_bicubic_catmullrom(vec2 uv) {
+	vec2 texSize = textureSize(uHistoryFrame, 0);
+	vec2 invTexSize = 1.0 / texSize;
+
+	vec2 iTc = uv * texSize;
+	vec2 tc = floor(iTc - 0.5) + 0.5;	// round *down* to nearest texel center
+	cvec2 f = cvec2(iTc - tc);
+	cvec2 f2 = f * f;
+	cvec2 f3 = f2 * f;
+
+	// Calculate weights:
+	//                   9|d|^3 - 15|d|^2         +  6   for 0 <= |d| <= 1
+	// w(d) = (1/6) * { -3|d|^3 + 15|d|^2 - 24|d| + 12   for 1 <  |d| <= 2
+	//                   0                               otherwise
+	//
+	// |d0|=f+1   |d1|=f   |d2|=1-f   |d3|=2-f
+	//
+	// expands to:
+	//  w0 = (-3 * f^3 +  6 * f^2 - 3 * f     ) / 6
+	//  w1 = ( 9 * f^3 - 15 * f^2         + 6 ) / 6	      ! there is a typo in the linked article! coefficient for f^3 is 9, not 6 !
+	//  w2 = (-9 * f^3 + 12 * f^2 + 3 * f     ) / 6
+	//  w3 = ( 3 * f^3 -  3 * f^2             ) / 6
+
+	cvec2 w0 = cfloat(-0.5) * f3 +                f2 - cfloat(0.5) * f               ;
+	cvec2 w1 = cfloat( 1.5) * f3 - cfloat(2.5) * f2                   + cfloat(1.0) ;
+	cvec2 w2 = cfloat(-1.5) * f3 + cfloat(2.0) * f2 + cfloat(0.5) * f               ;
+	cvec2 w3 = cfloat( 0.5) * f3 - cfloat(0.5) * f2                                 ;
+
+	#if 0
+		// naive implementation, slow (16 taps!), just for comparison
+
+		// Note: there is *no* linear interpolation going on, we sample the texture at exact texel centers.
+		//       Works equally well with texture() or texelFetch() (which needs manual clamping)
+		//       Tests showed the texelFetch-variant is minusculely faster, but the difference is barely noticeable 
+		ivec2 tc0 = clamp(ivec2(tc - 1), ivec2(0), ivec2(texSize));
+		ivec2 tc1 = clamp(ivec2(tc 	  ), ivec2(0), ivec2(texSize));
+		ivec2 tc2 = clamp(ivec2(tc + 1), ivec2(0), ivec2(texSize));
+		ivec2 tc3 = clamp(ivec2(tc + 2), ivec2(0), ivec2(texSize));
+		return
+		  texelFetch(uHistoryFrame, ivec2(tc0.x, tc0.y), 0) * w0.x * w0.y
+		+ texelFetch(uHistoryFrame, ivec2(tc1.x, tc0.y), 0) * w1.x * w0.y
+		+ texelFetch(uHistoryFrame, ivec2(tc2.x, tc0.y), 0) * w2.x * w0.y
+		+ texelFetch(uHistoryFrame, ivec2(tc3.x, tc0.y), 0) * w3.x * w0.y
+		+ texelFetch(uHistoryFrame, ivec2(tc0.x, tc1.y), 0) * w0.x * w1.y
+		+ texelFetch(uHistoryFrame, ivec2(tc1.x, tc1.y), 0) * w1.x * w1.y
+		+ texelFetch(uHistoryFrame, ivec2(tc2.x, tc1.y), 0) * w2.x * w1.y
+		+ texelFetch(uHistoryFrame, ivec2(tc3.x, tc1.y), 0) * w3.x * w1.y
+		+ texelFetch(uHistoryFrame, ivec2(tc0.x, tc2.y), 0) * w0.x * w2.y
+		+ texelFetch(uHistoryFrame, ivec2(tc1.x, tc2.y), 0) * w1.x * w2.y
+		+ texelFetch(uHistoryFrame, ivec2(tc2.x, tc2.y), 0) * w2.x * w2.y
+		+ texelFetch(uHistoryFrame, ivec2(tc3.x, tc2.y), 0) * w3.x * w2.y
+		+ texelFetch(uHistoryFrame, ivec2(tc0.x, tc3.y), 0) * w0.x * w3.y
+		+ texelFetch(uHistoryFrame, ivec2(tc1.x, tc3.y), 0) * w1.x * w3.y
+		+ texelFetch(uHistoryFrame, ivec2(tc2.x, tc3.y), 0) * w2.x * w3.y
+		+ texelFetch(uHistoryFrame, ivec2(tc3.x, tc3.y), 0) * w3.x * w3.y;
+	#else
+		// optimized version, 9 taps only
+		// Note: this exploits bilinear filtering, so no texelFetch'ing here!
+		cvec2 wC = w1 + w2;
+		vec2 tc0 = (tc - 1           ) * invTexSize;
+		vec2 tcC = (tc + vec2(w2/wC)) * invTexSize;
+		vec2 tc3 = (tc + 2           ) * invTexSize;
+		return
+		  cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tc0.x, tc0.y))) * (w0.x * w0.y)
+		+ cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tcC.x, tc0.y))) * (wC.x * w0.y)
+		+ cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tc3.x, tc0.y))) * (w3.x * w0.y)
+		+ cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tc0.x, tcC.y))) * (w0.x * wC.y)
+		+ cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tcC.x, tcC.y))) * (wC.x * wC.y)
+		+ cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tc3.x, tcC.y))) * (w3.x * wC.y)
+		+ cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tc0.x, tc3.y))) * (w0.x * w3.y)
+		+ cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tcC.x, tc3.y))) * (wC.x * w3.y)
+		+ cvec4(SAMPLE_TEX(uHistoryFrame, vec2(tc3.x, tc3.y))) * (w3.x * w3.y);
+	#endif
+}
+
+// see https://vec3.ca/bicubic-filtering-in-fewer-taps/
+cvec4 sample_history_bicubic_b_spline(vec2 uv) {
+	vec2 texSize = textureSize(uHistoryFrame, 0);
+	vec2 invTexSize = 1.0 / texSize;
+
+	vec2 iTc = uv * texSize;
+	vec2 tc = floor(iTc - 0.5) + 0.5;	// round *down* to nearest texel center
+	cvec2 f = cvec2(iTc - tc);
+	cvec2 f2 = f * f;
+	cvec2 f3 = f2 * f;
+
+	cvec2 w0 = f2 - cfloat(0.5) * (f3 + f);
+	cvec2 w1 = cfloat(1.5) * f3 - cfloat(2.5) * f2 + cfloat(1.0);
+	cvec2 w3 = cfloat(0.5) * (f3 - f2);
+	cvec2 w2 = cfloat(1.0) - w0 - w1 - w3;
+
+	cvec2 s0 = w0 + w1;
+	cvec2 s1 = w2 + w3;
+	vec2 f0 = vec2(w1 / (w0 + w1));
+	vec2 f1 = vec2(w3 / (w2 + w3));
+	vec2 t0 = (tc - 1 + f0) * invTexSize;
+	vec2 t1 = (tc + 1 + f1) * invTexSize;
+
+	return (cvec4(SAMPLE_TEX(uHistoryFrame, vec2(t0.x, t0.y))) * s0.x
+	     +  cvec4(SAMPLE_TEX(uHistoryFrame, vec2(t1.x, t0.y))) * s1.x) * s0.y
+	     + (cvec4(SAMPLE_TEX(uHistoryFrame, vec2(t0.x, t1.y))) * s0.x
+	     +  cvec4(SAMPLE_TEX(uHistoryFrame, vec2(t1.x, t1.y))) * s1.x) * s1.y;
+}
+
+cvec4 sample_history_rgba(vec2 uv) {
+	if      (params.mInterpolationMode == 0)	return cvec4(SAMPLE_TEX(uHistoryFrame, uv));
+	else if (params.mInterpolationMode == 1)	return sample_history_bicubic_b_spline(uv);
+	else										return sample_history_bicubic_catmullrom(uv);
+}
+
+vec4 noise(vec2 uv) {
+	vec2 seed = uv + ubo.mSinTime.x + 0.6959174;
+	vec4 nRand = fract( sin(dot(seed, vec2(12.9898, 78.233))) * vec4(43758.5453, 28001.8384, 50849.4141, 12996.89) ); // normalized [0,1)
+	vec4 sRand = nRand * 2.0 - 1.0; // [-1,1)
+	return sRand * params.mNoiseFactor;
+}
+
+// linearize depth - from https://stackoverflow.com/questions/51108596/linearize-depth
+float linearize_depth(float d,float zNear,float zFar) {
+    return zNear * zFar / (zFar + d * (zNear - zFar));
+}
+float linearize_depth(float d) {
+	return linearize_depth(d, ubo.mCamNearPlane, ubo.mCamFarPlane);
+}
+
+// linear depth of the current frame
+float current_linear_depth(ivec2 iuv) {
+	if (ubo.mUseDepthPyramid) return depth_pyramid_fetch(0, iuv).x;
+	return linearize_depth(texelFetch(uCurrentDepth, iuv, 0).r);
+}
+
+float sample_linear_depth(ivec2 iuv) {
+	if (gTile) return sTileDepth[tile_index(iuv)];
+	return current_linear_depth(iuv);
+}
+
+float sample_luminance(ivec2 iuv) {
+	if (gTile) return sTileLuma[tile_index(iuv)];
+	return rgb_to_ycocg(cvec3(texelFetch(uCurrentFrame, iuv, 0).rgb)).x;
+}
+
+vec3 unpack_normal(vec4 uvNormal) {
+	return gbuffer_decode_normal(uvNormal);
+}
+
+vec3 sample_normal(ivec2 iuv) {
+	if (gTile) return sTileNormal[tile_index(iuv)];
+	return unpack_normal(texelFetch(uCurrentUvNrm, iuv, 0));
+}
+
+uint sample_material(ivec2 iuv) {
+	if (gTile) return sTileMatId[tile_index(iuv)];
+	return imageLoad(uCurrentMaterial, iuv).r;
+}
+
+// first pixel of this workgroup
+ivec2 group_origin() {
+	ivec2 groupId = ivec2(gl_WorkGroupID.xy);
+	if (pushConstants.mTileList >= 0) {
+		uint t  = uTileClasses.tiles[pushConstants.mTileList + int(gl_WorkGroupID.x)];
+		groupId = ivec2(t & 0xffffu, t >> 16);
+	}
+	if (FUSED_OVERLAP) return groupId * (TILE_SIZE - 2) - 1 + pushConstants.mOffset;
+	return groupId * TILE_SIZE + pushConstants.mOffset;
+}
+
+// fused resolve with sharpening: the outer ring of invocations only resolves the neighbourhood, the pixel is written by another workgroup
+bool owns_pixel() {
+	if (!FUSED_OVERLAP) return true;
+	return all(greaterThanEqual(gLocal, ivec2(1))) && all(lessThan(gLocal, ivec2(TILE_SIZE - 1)));
+}
+
+// store the resolved pixel; fused resolve: the screen output stays in shared memory for fused_output
+void store_result(ivec2 iuv, vec4 toScreen, vec4 toHistory) {
+	if (FUSED) sFused[gLocal.y * TILE_SIZE + gLocal.x] = toScreen.rgb;
+	if (!owns_pixel()) return;
+	if (!FUSED) imageStore(uResultScreen, iuv, toScreen);
+	imageStore(uResultHistory, iuv, toHistory);
+}
+
+// Load the neighbourhood tile of this workgroup into shared memory: each input texel is fetched and converted once, instead of
+// once per neighbouring pixel (up to 9x). Must be called by all invocations (barrier!). Only what the params need is loaded.
+// Not used with upsampling (input texels do not map 1:1 to the workgroup), if the workgroup straddles the split screen line
+// (conversions depend on the params); the color tile is not used with mUnjitterNeighbourhood (samples in between texels).
+void load_tile() {
+	ivec2 group0 = group_origin();
+	bool straddle = pushConstants.mParamsIdx < 0 && ubo.splitScreen && ubo.splitX >= group0.x && ubo.splitX < group0.x + TILE_SIZE - 1;
+	if (!ubo.mUseTile || ubo.mUpsampling || straddle) return;	// uniform for the workgroup
+
+	gTile       = true;
+	gTileColor  = !params.mUnjitterNeighbourhood && NBH_MODE != TAA_NBH_NAIVE;
+	gTileOrigin = group0 - TILE_APRON;
+
+	bool segmentation = params.mRayTraceAugment;
+	bool needLuma     = segmentation && (params.mRayTraceAugmentFlags & TAA_RTFLAG_LUM) != 0;
+	bool needDepth    = (segmentation && (params.mRayTraceAugmentFlags & TAA_RTFLAG_DPT) != 0) || (params.mUseVelocityVectors != 0 && params.mVelocitySampleMode == 2);
+	bool needNormal   = segmentation && (params.mRayTraceAugmentFlags & TAA_RTFLAG_NRM) != 0;
+
+	for (int i = int(gl_LocalInvocationIndex); i < TILE_DIM * TILE_DIM; i += TILE_SIZE * TILE_SIZE) {
+		ivec2 tc = CLAMP_TO_TEX(gTileOrigin + ivec2(i % TILE_DIM, i / TILE_DIM));
+		if (gTileColor || needLuma) {
+			cvec3 c = cvec3(texelFetch(uCurrentFrame, tc, 0).rgb);
+			sTileColor[i] = maybe_rgb_to_ycocg(tonemap_rgb(c));
+			sTileLuma[i]  = rgb_to_ycocg(c).x;
+		}
+		if (needDepth)    sTileDepth[i]  = current_linear_depth(tc);
+		if (needNormal)   sTileNormal[i] = unpack_normal(texelFetch(uCurrentUvNrm, tc, 0));
+		if (segmentation) sTileMatId[i]  = imageLoad(uCurrentMaterial, tc).r;
+	}
+	barrier();
+}
+
+#if TAA_SUBGROUP
+// subgroup neighbourhood: the lanes of a subgroup cover an 8 x (size/8) pixel block of the workgroup (instead of whole rows), so most
+// neighbours are in other lanes of the same subgroup; only if the workgroup is made of full subgroups of 8..128 lanes (uniform)
+bool subgroup_blocks() {
+	return gl_SubgroupSize >= 8 && gl_SubgroupSize <= 128 && gl_SubgroupSize * gl_NumSubgroups == TILE_SIZE * TILE_SIZE;
+}
+
+ivec2 subgroup_block_pixel() {
+	int h = int(gl_SubgroupSize) / 8;
+	ivec2 block = ivec2(gl_SubgroupID & 1, gl_SubgroupID >> 1);
+	return block * ivec2(8, h) + ivec2(gl_SubgroupInvocationID & 7, gl_SubgroupInvocationID >> 3);
+}
+
+// row partials of a tile element and its horizontal neighbours
+void nbh_row(int i, out cvec3 rMin, out cvec3 rMax, out vec3 rS1, out vec3 rS2) {
+	cvec3 a = sTileColor[i - 1], b = sTileColor[i], c = sTileColor[i + 1];
+	rMin = min(min(a, b), c);
+	rMax = max(max(a, b), c);
+	rS1  = vec3(a) + vec3(b) + vec3(c);
+	rS2  = vec3(a) * vec3(a) + vec3(b) * vec3(b) + vec3(c) * vec3(c);
+}
+
+// separable 3x3 min/max and moments: row partials over the horizontal neighbours (shuffled, from the tile at the left/right block
+// border), combined with the row partials of the vertical neighbours (shuffled, recomputed from the tile at the top/bottom border);
+// values are shuffled as fp32 (16 bit subgroup types are another feature). Needs the color tile; must be called by all invocations.
+void subgroup_neighbourhood(ivec2 iuv) {
+	bool wantMoments = params.mVarianceClipping;
+	bool wantCross   = params.mShapedNeighbourhood && !wantMoments;
+	uint lane = gl_SubgroupInvocationID;
+	uint last = gl_SubgroupSize - 1;
+	uint bx   = lane & 7;
+	uint by   = lane >> 3;
+	int  i    = tile_index(iuv);
+
+	vec3  C = vec3(sTileColor[i]);
+	cvec3 L = cvec3(subgroupShuffle(C, max(lane, 1) - 1));
+	cvec3 R = cvec3(subgroupShuffle(C, min(lane + 1, last)));
+	if (bx == 0) L = sTileColor[i - 1];
+	if (bx == 7) R = sTileColor[i + 1];
+
+	cvec3 c    = cvec3(C);
+	cvec3 rMin = min(min(L, c), R);
+	cvec3 rMax = max(max(L, c), R);
+	vec3  rS1  = vec3(L) + C + vec3(R);
+	vec3  rS2  = vec3(L) * vec3(L) + C * C + vec3(R) * vec3(R);
+
+	// row above (-8 lanes) and below (+8 lanes)
+	cvec3 uMin = rMin, uMax = rMax, dMin = rMin, dMax = rMax;
+	vec3  uS1 = rS1, uS2 = rS2, dS1 = rS1, dS2 = rS2;
+	if (wantMoments) {
+		uS1 = subgroupShuffle(rS1, max(lane, 8) - 8);  dS1 = subgroupShuffle(rS1, min(lane + 8, last));
+		uS2 = subgroupShuffle(rS2, max(lane, 8) - 8);  dS2 = subgroupShuffle(rS2, min(lane + 8, last));
+	} else {
+		uMin = cvec3(subgroupShuffle(vec3(rMin), max(lane, 8) - 8));  dMin = cvec3(subgroupShuffle(vec3(rMin), min(lane + 8, last)));
+		uMax = cvec3(subgroupShuffle(vec3(rMax), max(lane, 8) - 8));  dMax = cvec3(subgroupShuffle(vec3(rMax), min(lane + 8, last)));
+	}
+	cvec3 T = cvec3(subgroupShuffle(C, max(lane, 8) - 8));
+	cvec3 B = cvec3(subgroupShuffle(C, min(lane + 8, last)));
+	if (by == 0) {
+		nbh_row(i - TILE_DIM, uMin, uMax, uS1, uS2);
+		T = sTileColor[i - TILE_DIM];
+	}
+	if (by == last >> 3) {
+		nbh_row(i + TILE_DIM, dMin, dMax, dS1, dS2);
+		B = sTileColor[i + TILE_DIM];
+	}
+
+	gNbhMin      = min(min(uMin, rMin), dMin);
+	gNbhMax      = max(max(uMax, rMax), dMax);
+	gNbhM1       = uS1 + rS1 + dS1;
+	gNbhM2       = uS2 + rS2 + dS2;
+	if (wantCross) {
+		gNbhCrossMin = min(min(min(min(c, T), L), R), B);
+		gNbhCrossMax = max(max(max(max(c, T), L), R), B);
+	}
+	gNbhTc = iuv;
+	gNbh   = true;
+}
+#endif
+
+vec2 sobel(float c00, float c01, float c02, float c10, /* float c11, */ float c12, float c20, float c21, float c22) {
+	vec2 g;
+	g.x = c00 - c20 + 2 * c01 - 2 * c21 + c02 - c22;
+	g.y = c00 - c02 + 2 * c10 - 2 * c12 + c20 - c22;
+	return g;
+}
+
+// ray trace priority (0..1) -> segmask bits, used to trim the marked pixels to the ray budget
+uint rt_priority(float prio) {
+	return uint(clamp(prio, 0.0, 1.0) * float(TAA_SEGMASK_PRIORITY_MASK) + 0.5) << TAA_SEGMASK_PRIORITY_SHIFT;
+}
+
+uint calc_segmentation_value(ivec2 iuv, vec2 uv, vec2 historyUv, float historyDepth) {
+	//gDebugValue = vec4(linearize_depth(texelFetch(uCurrentDepth, iuv, 0).r), 0, 0, 0);
+
+	// debug setting - fixed size border for FXAA?
+	if ((params.mRayTraceAugmentFlags & TAA_RTFLAG_FXD) != 0) {
+		const int b = 100;
+		if (any(lessThan(iuv, ivec2(b))) || any(greaterThanEqual(iuv, ivec2(textureSize_loRes-b))))
+			return 1;
+	}
+
+	// debug setting - ray trace everything?
+	if ((params.mRayTraceAugmentFlags & TAA_RTFLAG_ALL) != 0) {
+		return 2 | rt_priority(0.5);
+	}
+
+	// use history counter?
+	bool useHistoryCount = ((params.mRayTraceAugmentFlags & TAA_RTFLAG_CNT) != 0);
+	uint newCountValue = useHistoryCount ? params.mRayTraceHistoryCount << 16 : 0;
+
+	// out of screen disocclusion?
+	if ((params.mRayTraceAugmentFlags & TAA_RTFLAG_OUT) != 0) {
+		if (any(lessThan(historyUv, vec2(0))) || any(greaterThanEqual(historyUv, vec2(1)))) {
+			return 1;
+		}
+	}
+
+	// TODO: make sure velocity samples are all valid!
+	// should we just use the pixel speed value from getHistoryPosition? or better save the vel vector calculated there in a global?
+
+	uint matId = sample_material(iuv);
+
+	// determine disocclusions by moving or animated objects
+	if ((params.mRayTraceAugmentFlags & TAA_RTFLAG_DIS) != 0) {
+		ivec2 tcPrev = uv_to_tc(historyUv, ubo.mPrevInputSize);
+		if (all(greaterThanEqual(tcPrev, ivec2(0))) && all(lessThan(tcPrev, ubo.mPrevInputSize))) {
+			uint prevMatId = imageLoad(uPreviousMaterial, tcPrev).r;
+			if (prevMatId != matId && (prevMatId & MATERIAL_ID_MOVER) != 0) // MSB indicates moving object
+				return 2 | newCountValue | rt_priority(1.0);
+		}
+	}
+
+	// TODO: use mesh ids instead of material ids ?
+	// TODO: precalc derivatives in a separate compute pass, instead of sampling neighbourhood for every pixel here?
+
+	// calc derivatives
+	float nrmValue = 0.0;
+	float dptValue = 0.0;
+	float matValue = 0.0;
+	float lumValue = 0.0;
+
+	// normals "derivative" - we just dot the normals
+	if ((params.mRayTraceAugmentFlags & TAA_RTFLAG_NRM) != 0) {
+		vec3 nC = sample_normal(iuv);
+		vec3 nL = sample_normal(CLAMP_TO_TEX(iuv + ivec2(-1,  0)));
+		vec3 nR = sample_normal(CLAMP_TO_TEX(iuv + ivec2( 1,  0)));
+		vec3 nT = sample_normal(CLAMP_TO_TEX(iuv + ivec2( 0, -1)));
+		vec3 nB = sample_normal(CLAMP_TO_TEX(iuv + ivec2( 0,  1)));
+		float mind = max(0, min(min(min(dot(nC, nL), dot(nC, nR)), dot(nC, nT)), dot(nC, nB)));
+		nrmValue = 1.0 - mind;
+	}
+
+	// depth dervative
+	if ((params.mRayTraceAugmentFlags & TAA_RTFLAG_DPT) != 0) {
+		dptValue = length( sobel( sample_linear_depth(CLAMP_TO_TEX(iuv + ivec2(-1, -1))),
+			                      sample_linear_depth(CLAMP_TO_TEX(iuv + ivec2( 0, -1))),
+			                      sample_linear_depth(CLAMP_TO_TEX(iuv + ivec2( 1, -1))),
+			                      sample_linear_depth(CLAMP_TO_TEX(iuv + ivec2(-1,  0))),
+			                      sample_linear_depth(CLAMP_TO_TEX(iuv + ivec2( 1,  0))),
+			                      sample_linear_depth(CLAMP_TO_TEX(iuv + ivec2(-1,  1))),
+			                      sample_linear_depth(CLAMP_TO_TEX(iuv + ivec2( 0,  1))),
+			                      sample_linear_depth(CLAMP_TO_TEX(iuv + ivec2( 1,  1))) ) );
+	}
+
+	// normals - TODO - do we even have them in forward shading?
+
+	// material id "derivative"
+	if ((params.mRayTraceAugmentFlags & TAA_RTFLAG_MID) != 0) {
+		if ((matId != sample_material(CLAMP_TO_TEX(iuv + ivec2(-1,0)))) || (matId != sample_material(CLAMP_TO_TEX(iuv + ivec2(1,0)))) ||
+			(matId != sample_material(CLAMP_TO_TEX(iuv + ivec2(0,-1)))) || (matId != sample_material(CLAMP_TO_TEX(iuv + ivec2(0,1))))) {
+			matValue = 1.0;
+		}
+	}
+
+	// luminance derivative
+	if ((params.mRayTraceAugmentFlags & TAA_RTFLAG_LUM) != 0) {
+		lumValue = length( sobel( sample_luminance(CLAMP_TO_TEX(iuv + ivec2(-1, -1))),
+			                      sample_luminance(CLAMP_TO_TEX(iuv + ivec2( 0, -1))),
+			                      sample_luminance(CLAMP_TO_TEX(iuv + ivec2( 1, -1))),
+			                      sample_luminance(CLAMP_TO_TEX(iuv + ivec2(-1,  0))),
+			                      sample_luminance(CLAMP_TO_TEX(iuv + ivec2( 1,  0))),
+			                      sample_luminance(CLAMP_TO_TEX(iuv + ivec2(-1,  1))),
+			                      sample_luminance(CLAMP_TO_TEX(iuv + ivec2( 0,  1))),
+			                      sample_luminance(CLAMP_TO_TEX(iuv + ivec2( 1,  1))) ) );
+	}
+
+	float total = nrmValue * params.mRayTraceAugment_WNrm
+	            + dptValue * params.mRayTraceAugment_WDpt
+	            + matValue * params.mRayTraceAugment_WMId
+	            + lumValue * params.mRayTraceAugment_WLum;
+	if (total >= params.mRayTraceAugment_Thresh) return 2 | newCountValue | rt_priority(0.5 + 0.45 * (total - params.mRayTraceAugment_Thresh) / max(params.mRayTraceAugment_Thresh, 1e-3));
+
+	// TODO: take care of bootstrapping - when are the prevframe buffers valid?!
+	// TODO: consider prevoid frame's segmask ("segmask history")
+
+	// pixel is not marked for ray tracing now, but check if it still has an active history count
+	if (useHistoryCount) {
+		// TODO: should we add the velocity vector here?
+		uint oldCnt = (imageLoad(uPreviousSegMask, iuv).r & 0xffff0000) >> 16;
+		if (oldCnt > 0) {
+			return 2 | ((oldCnt - 1) << 16) | rt_priority(0.4 * float(oldCnt) / float(max(params.mRayTraceHistoryCount, 1)));
+		}
+	}
+	return 0;
+}
+
+// -------------------------------------------------------
+
+// ################## RESOLVE ONE PIXEL ###################
+void resolve_pixel(ivec2 iuv)
+{
+	vec2 uv = tc_to_uv(iuv, textureSize_hiRes);
+
+	// generate segmentation mask if any of the params require it
+	//bool generateSegmentationMask = ubo.param[0].mRayTraceAugment || ubo.param[1].mRayTraceAugment;
+	bool generateSegmentationMask = params.mRayTraceAugment;
+
+	ivec2 iuv_lores = uv_to_tc(uv, textureSize_loRes);
+
+	if (params.mPassThrough) {
+		store_result(iuv, vec4(texelFetch(uCurrentFrame, iuv_lores, 0).rgb, 1), vec4(texelFetch(uHistoryFrame, iuv, 0).rgb, 1));
+		if (WRITE_DEBUG && owns_pixel()) imageStore(uDebug,  iuv, vec4(0));
+		return;
+	}
+	if (ubo.mBypassHistoryUpdate) {
+		store_result(iuv, vec4(texelFetch(uHistoryFrame, iuv, 0).rgb, 1), vec4(texelFetch(uHistoryFrame, iuv, 0).rgb, 1));	// FIXME - un-tonemap?; (low priority, only used for debugging anyway)
+		if (WRITE_DEBUG && owns_pixel()) imageStore(uDebug,  iuv, vec4(0));
+		return;
+	}
+
+	bool rejected  = false;
+	bool rectified = false;
+	cvec3 rectified_diff;
+	
+	cvec3 currentColor;
+	cvec3 colMin;
+	cvec3 colMax;
+	cvec3 colClipTowards;
+	float beta;
+	getColorAndAabb(iuv_lores, currentColor, colMin, colMax, colClipTowards);		// colors are in YCoGg (if enabled)
+	// may have different unjitter settings than neighbourhood, so get current color separately
+	if (ubo.mUpsampling) {
+		currentColor = getCurrentUpsampledColor(iuv, uv, beta); 
+	} else {
+		currentColor = getCurrentColor(iuv_lores); 
+		beta = 1.0;
+	}
+	float depth = texelFetch(uCurrentDepth, iuv_lores, 0).r;
+	
+//	vec4 clipSpace = vec4(uv * 2.0 - 1.0, depth, 1);
+//	vec4 worldSpace = ubo.mInverseViewProjMatrix * clipSpace;
+//	vec4 historyClipSpace = ubo.mHistoryViewProjMatrix * worldSpace;
+//	vec2 historyUv = (historyClipSpace.xy / historyClipSpace.w) * 0.5 + 0.5;
+//	float expectedHistoryDepth = historyClipSpace.z / historyClipSpace.w;
+	vec2 historyUv;
+	float expectedHistoryDepth;
+	float pixelSpeed;
+	getHistoryPosition(uv, depth, historyUv, expectedHistoryDepth, pixelSpeed);
+	
+	cvec4 historyRaw = sample_history_rgba(historyUv);	// .a contains dynamic mask if dynamic anti-ghosting is used
+	cvec3 historyColor = maybe_rgb_to_ycocg(historyRaw.rgb);
+
+	float alpha = params.mAlpha;
+
+	// build segmentation mask
+	uint segMaskValue;
+	if (generateSegmentationMask) {
+		segMaskValue = calc_segmentation_value(iuv, uv, historyUv, expectedHistoryDepth);	// TODO: check! iuv vs iuvLoRes !!
+
+		if ((segMaskValue & 3) != 0) { // experimenting!
+			alpha = params.mRejectionAlpha;
+			rejected = true;
+		}
+	} else {
+		segMaskValue = 0;
+	}
+
+
+	// ---- history rejection ----
+	// reject out-of-texture history samples
+	if (params.mRejectOutside) {
+		if (any(lessThan(historyUv, vec2(0))) || any(greaterThanEqual(historyUv, vec2(1)))) {
+			alpha = params.mRejectionAlpha;
+			rejected = true;
+		}
+	}
+	float writeDynamicMask = 0;
+	if (params.mDynamicAntiGhosting) {
+		// 5-tap sample velocity
+		// Only consider movement for real dynamic objects (velocity.w == 1)! (Not usable for static scenery -> results in ugly history-reset flash after changing the camera)
+		vec2 toUv = vec2(1,1) / textureSize_loRes;
+		const float eps = 1e-5;
+		vec4 v;
+		v = abs(sample_velocity(uv + toUv * vec2(-1,  0)));	bool movL = (v.x > eps || v.y > eps) && (v.w >= 0.5);
+		v = abs(sample_velocity(uv + toUv * vec2( 1,  0)));	bool movR = (v.x > eps || v.y > eps) && (v.w >= 0.5);
+		v = abs(sample_velocity(uv + toUv * vec2( 0, -1)));	bool movT = (v.x > eps || v.y > eps) && (v.w >= 0.5);
+		v = abs(sample_velocity(uv + toUv * vec2( 0,  1)));	bool movB = (v.x > eps || v.y > eps) && (v.w >= 0.5);
+		v = abs(sample_velocity(uv                      ));	bool movC = (v.x > eps || v.y > eps) && (v.w >= 0.5);
+		bool movement = movL || movR || movT || movB || movC;
+		if (!movement && historyRaw.a > 0.0) rejected = true;
+		writeDynamicMask = movC ? 1.0 : 0.0; // this is historyRaw.a in the next frame
+		//gDebugValue = vec4(historyRaw.a, writeDynamicMask, 0, 0);
+	}
+
+	// cull by depth
+	if (params.mDepthCulling) {
+		// FIXME - shouldn't we better compare LINEAR depth?
+
+		// problem with upsampling: cannot use texture() (can't lerp depth buffer), but historyUv is probably not a texel center; so: WHERE to sample uHistoryDepth (lores) ?
+		float historyDepth = texelFetch(uHistoryDepth, uv_to_tc(historyUv, ubo.mPrevInputSize), 0).r;
+		float depthEpsilon = 0.1 * (1.0 - historyDepth);
+		if (abs(historyDepth - expectedHistoryDepth) > depthEpsilon) {
+			rejected = true;
+		}
+	}
+
+	// ---- history rectification ----
+	cvec3 origHistorColor = historyColor;
+
+	// clip/clamp color
+	switch (params.mColorClampingOrClipping) {
+		case 1:
+			historyColor = clamp(historyColor, colMin, colMax);
+			break;
+		case 2:
+			historyColor = clipAabb(colMin, colMax, cvec4(0,0,0,1), cvec4(historyColor, 1.0)).rgb;
+			break;
+		case 3:
+			//historyColor = clipAabbSlow(colMin, colMax, vec4(currentColor, 1.0), vec4(historyColor, 1.0)).rgb;	// this one has "fireflies" or "blackout"-problems with var clipping (even after fixing sigma-NaNs)
+			//historyColor = clipAabbSlow(colMin, colMax, vec4(colAvg, 1.0), vec4(historyColor, 1.0)).rgb;			// not this... WHY NOT?	===> see getNeighbourhood, currentColor may NOT be inside AABB!
+			historyColor = clipAabbSlow(colMin, colMax, cvec4(colClipTowards, 1.0), cvec4(historyColor, 1.0)).rgb;
+			break;
+
+	}
+
+	rectified_diff = historyColor - origHistorColor;
+	rectified = any(greaterThan(abs(rectified_diff), cvec3(0.001)));
+
+
+	// ---- blending ----
+
+	if (rejected) {
+		alpha = params.mRejectionAlpha; // typically = 1
+		beta  = 1.0;
+	} else {
+		// velocity-influence on alpha
+		if (params.mVelBasedAlpha) {
+			float oldAlpha = alpha;
+			alpha = max(alpha, mix(alpha, params.mVelBasedAlphaMax, clamp(pixelSpeed * params.mVelBasedAlphaFactor, 0, 1)));
+			//gDebugValue = vec4(alpha, oldAlpha, abs(alpha - oldAlpha), 0);
+		}
+
+		// dynamic luma weighting - see Timothy Lottes https://www.youtube.com/watch?v=WzpLWzGvFK4&t=18m
+		if (params.mLumaWeightingLottes) {
+			cfloat lumaCurrent = luminance(currentColor);
+			cfloat lumaHistory = luminance(historyColor);
+			cfloat diff = abs(lumaCurrent - lumaHistory) / max(max(lumaCurrent, lumaHistory), cfloat(0.2));
+			cfloat w = cfloat(1) - diff;
+			cfloat ww = w * w;
+			// ww=0: bad history, use max alpha ; ww=1: good history, use min alpha
+			alpha = mix(params.mMaxAlpha, params.mMinAlpha, float(ww));
+		}
+
+		// Anti-flicker: Reduce blend factor when history is near clamping [Karis14]
+		if (params.mReduceBlendNearClamp) {
+			// calculation adapted from NVidia's Falcor / Unreal Engine
+			float colMin_lum  = float(luminance(colMin));
+			float colMax_lum  = float(luminance(colMax));
+			float history_lum = float(luminance(origHistorColor));
+			#if 0
+				// Falcor-based
+				float distToClamp = min(abs(colMin_lum - history_lum), abs(colMax_lum - history_lum));
+				float factor = distToClamp / (distToClamp + colMax_lum - colMin_lum);
+				float alpha = clamp(alpha * factor, 0.0, 1.0);
+				//gDebugValue = vec4(factor, alpha, distToClamp, 0);
+			#else
+				// Unreal Engine-based (modified)
+				float distToClamp = 2.0 * abs(min(history_lum - colMin_lum, colMax_lum - history_lum)) / (colMax_lum - colMin_lum);	// what if max == min ?
+				if (colMax_lum - colMin_lum < 0.001) distToClamp = 1.0; // just testing
+				float alphaOrig = alpha;
+				alpha *= clamp(4 * distToClamp, 0, 1);
+				//alpha += 0.8 * clamp(0.02 * history_lum / abs(luminance(currentColor) - history_lum), 0, 1);
+				//alpha = clamp(alpha, 0, 1);
+				//gDebugValue = vec4(alphaOrig, alpha, distToClamp, 0);
+			#endif
+		}
+	}
+
+	if (ubo.mResetHistory) { alpha = 1.0; beta = 1.0; }
+
+	//vec3 antiAliased = mix(maybe_ycocg_to_rgb(historyColor), maybe_ycocg_to_rgb(currentColor), alpha * beta);	// current * ab + history * (1-ab)
+	cvec3 antiAliased = maybe_ycocg_to_rgb(mix(historyColor, currentColor, cfloat(alpha * beta)));	// current * ab + history * (1-ab)
+
+	// add noise
+	if (params.mAddNoise) {
+		vec4 n = noise(uv);
+		antiAliased += cvec3(n.rgb);
+	}
+
+	vec4 output_to_history = vec4(antiAliased, writeDynamicMask);
+	vec4 output_to_screen  = vec4(un_tonemap_rgb(vec3(antiAliased)), 1.0);
+
+	// temporal ray tracing: pixels marked for ray tracing keep their reprojected (not rectified) history, the ray traced sample is blended in
+	// afterwards by rt_temporal.comp; only valid if the history pixel was ray traced as well and shows the same material, else it restarts
+	if (ubo.mRayTraceTemporal && (segMaskValue & 3) == 2 && !ubo.mResetHistory) {
+		ivec2 tcPrev = uv_to_tc(historyUv, ubo.mPrevInputSize);
+		if (all(greaterThanEqual(historyUv, vec2(0))) && all(lessThan(historyUv, vec2(1)))
+			&& (imageLoad(uPreviousSegMask, uv_to_tc(historyUv, textureSize_hiRes)).r & 3) == 2
+			&& imageLoad(uPreviousMaterial, tcPrev).r == sample_material(iuv_lores)) {
+			output_to_history.rgb = vec3(maybe_ycocg_to_rgb(origHistorColor));
+			segMaskValue |= TAA_SEGMASK_RT_HISTORY;
+		}
+	}
+
+	// --- debugging -----------------------------------------
+	if (!WRITE_DEBUG) {
+		// debug image is not shown
+	} else if (params.mDebugMode == 0) {
+		// colour bounding box, individual
+		vec3 tmp = vec3(colMax - colMin);
+		gDebugValue = vec4(tmp, 0);
+	} else if (params.mDebugMode == 1) {
+		// colour bounding box, size
+		vec3 tmp = vec3(colMax - colMin);
+		gDebugValue = vec4(vec3(tmp.x * tmp.y * tmp.z), 0);
+	} else if (params.mDebugMode == 2) {
+		gDebugValue = vec4(rejected ? 1 : 0, length(vec3(rectified_diff)), 0, 0);
+	} else if (params.mDebugMode == 3) {
+		gDebugValue = vec4(vec3(alpha), 0);
+	} else if (params.mDebugMode == 4) {
+		gDebugValue = texelFetch(uCurrentVelocity, iuv, 0);
+	} else if (params.mDebugMode == 5) {
+		gDebugValue = vec4(pixelSpeed, 0, 0, 0);
+	} else if (params.mDebugMode == 6) {
+		gDebugValue = output_to_screen;
+	} else if (params.mDebugMode == 7) {
+		gDebugValue = output_to_history;
+	} else if (params.mDebugMode == 8) {
+		switch (segMaskValue & 3) {
+			case 0:	gDebugValue = vec4(0,0,1,0); break;	// use TAA
+			case 1:	gDebugValue = vec4(1,0,0,0); break;	// use FXAA
+			case 2:	gDebugValue = vec4(1,1,0,0); break;	// use Ray Tracing
+		}
+	}
+	// else keep current gDebugValue
+
+	gDebugValue *= params.mDebugScale * params.mDebugMask;
+	if (params.mDebugCenter) gDebugValue = gDebugValue * 0.5 + 0.5;
+
+	// debug-to-screen display is now handled in post_process shader
+//	if (params.mDebugToScreenOutput) {
+//		output_to_screen = vec4(gDebugValue.rgb, 1);
+//		// make alpha channel visible
+//		if (params.mDebugMask.a > 0) {
+//			output_to_screen.rb += gDebugValue.a;
+//		}
+//	}
+	// -------------------------------------------------------
+
+	// store outputs
+	store_result(iuv, output_to_screen, output_to_history);
+	if (WRITE_DEBUG && owns_pixel()) imageStore(uDebug,  iuv, gDebugValue);
+
+	if (generateSegmentationMask && owns_pixel()) imageStore(uSegMask, iuv, uvec4(segMaskValue,0,0,0));
+}
+
+// ################## FUSED SHARPENING + POST PROCESSING ###################
+
+vec3 fused_load(ivec2 p) {
+	ivec2 t = clamp(p, gFusedMin, gFusedMax) - gFusedOrigin;
+	return sFused[t.y * TILE_SIZE + t.x];
+}
+
+#define A_GPU 1
+#define A_GLSL 1
+#include "ffx_a.h"
+AF3 CasLoad(ASU2 p) { return fused_load(p); }
+void CasInput(inout AF1 r, inout AF1 g, inout AF1 b) {}
+#include "ffx_cas.h"
+
+// the rest of the chain for a pixel of the fused resolve; must be called by all invocations (barrier!)
+void fused_output(ivec2 iuv, bool inside) {
+	barrier();	// sFused is complete
+	if (!inside || !owns_pixel()) return;
+
+	gFusedOrigin = group_origin();
+	gFusedMin    = ivec2(max(pushConstants.mOffset.x, 0), 0);
+	gFusedMax    = ivec2(min(textureSize_hiRes.x, pushConstants.mEndX), textureSize_hiRes.y) - 1;
+
+	vec3 val;
+	if (FUSED_MODE == TAA_FUSED_SHARPEN) {
+		// as in sharpen.comp
+		vec3 C = fused_load(iuv);
+		vec3 L = fused_load(iuv + ivec2(-1, 0));
+		vec3 R = fused_load(iuv + ivec2( 1, 0));
+		vec3 T = fused_load(iuv + ivec2( 0,-1));
+		vec3 B = fused_load(iuv + ivec2( 0, 1));
+		val = clamp(C + (4.0 * C - L - R - T - B) * pushConstants.mFusedSharpen, vec3(0), vec3(1));
+	} else if (FUSED_MODE == TAA_FUSED_CAS) {
+		// as in sharpen_cas.comp
+		CasFilter(val.r, val.g, val.b, uvec2(iuv), pushConstants.mCasConst0, pushConstants.mCasConst1, true);
+	} else {
+		val = fused_load(iuv);
+	}
+
+	// post processing: without debug views and zoom, only the split screen line is left (as in post_process.comp)
+	imageStore(uFusedOutput, iuv, (iuv.x == pushConstants.mFusedSplitX) ? vec4(0) : vec4(val, 1));
+}
+
+// ################## COMPUTE SHADER MAIN ###################
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+void main()
+{
+	textureSize_hiRes = textureSize(uHistoryFrame, 0);
+	textureSize_loRes = ubo.mInputSize;
+
+	gLocal = ivec2(gl_LocalInvocationID.xy);
+#if TAA_SUBGROUP
+	bool subgroupNbh = NBH_MODE == TAA_NBH_SUBGROUP && subgroup_blocks();
+	if (subgroupNbh) gLocal = subgroup_block_pixel();
+#endif
+	ivec2 iuv = group_origin() + gLocal;
+
+	int paramsIdx = (pushConstants.mParamsIdx >= 0) ? pushConstants.mParamsIdx : ((ubo.splitScreen && iuv.x > ubo.splitX) ? 1 : 0);
+	params = ubo.param[paramsIdx];
+	specialize_params();
+
+	load_tile();	// before any return
+#if TAA_SUBGROUP
+	if (subgroupNbh && gTileColor) subgroup_neighbourhood(iuv);	// uniform control flow
+#endif
+
+	bool inside = all(greaterThanEqual(iuv, ivec2(pushConstants.mOffset.x, 0))) && all(lessThan(iuv, textureSize_hiRes)) && iuv.x < pushConstants.mEndX;
+	if (inside) resolve_pixel(iuv);
+
+	if (FUSED) fused_output(iuv, inside);
+}
+
@@ -0,0 +1,564 @@
+#include "CpuRayTracer.hpp"
+
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "shader_cpu_common.h"
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define CPU_RAYTRACER_USE_SSE 1
+#include <immintrin.h>
+#else
+#define CPU_RAYTRACER_USE_SSE 0
+#endif
+
+namespace {
+	constexpr int   BVH_NUM_BINS     = 16;
+	constexpr int   BVH_MAX_LEAF     = 8;		// SAH may stop splitting up to this many triangles
+	constexpr int   BVH_MIN_LEAF     = 2;		// ... and always stops at this many
+	constexpr int   TRAVERSAL_STACK  = 256;
+	constexpr float COST_TRAVERSAL   = 1.0f;
+	constexpr float COST_INTERSECT   = 1.0f;
+	constexpr float INF              = std::numeric_limits<float>::infinity();
+
+	inline float halfArea(const glm::vec3 &bmin, const glm::vec3 &bmax)
+	{
+		glm::vec3 d = glm::max(bmax - bmin, glm::vec3(0.f));
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	inline float safeInv(float x)
+	{
+		return 1.f / (std::abs(x) > 1e-12f ? x : std::copysign(1e-12f, x));
+	}
+}
+
+CpuRayTracer::CpuRayTracer(int numThreads)
+{
+	if (numThreads <= 0) numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	// the calling thread also works on the jobs
+	for (int i = 1; i < numThreads; i++) {
+		mWorkers.emplace_back(&CpuRayTracer::workerLoop, this);
+	}
+}
+
+CpuRayTracer::~CpuRayTracer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mCvWork.notify_all();
+	for (auto &t : mWorkers) t.join();
+}
+
+// ---------- build
+
+void CpuRayTracer::build(const std::vector<MeshInstance> &instances, std::vector<Material> materials, std::vector<Texture> textures)
+{
+	using clock = std::chrono::high_resolution_clock;
+	auto t0 = clock::now();
+
+	mMaterials = std::move(materials);
+	mTextures  = std::move(textures);
+	mInstances.clear();
+	mTris.clear();
+	mNodes.clear();
+
+	// flatten all instances to world space triangles
+	for (uint32_t iInst = 0; iInst < instances.size(); iInst++) {
+		const auto &mi = instances[iInst];
+		glm::mat3 m3 = glm::mat3(mi.transform);
+		mInstances.push_back({ mi, glm::transpose(glm::inverse(m3)) });
+
+		uint32_t flags = 0;
+		if (mi.transparent)           flags |= TRI_TRANSPARENT;
+		if (!mi.twoSided)             flags |= TRI_CULL;
+		if (glm::determinant(m3) < 0) flags |= TRI_FLIP;	// mirroring transform swaps the winding
+
+		size_t numTris = mi.numIndices / 3;
+		for (size_t p = 0; p < numTris; p++) {
+			glm::vec3 v0 = glm::vec3(mi.transform * glm::vec4(mi.positions[mi.indices[3 * p    ]], 1.f));
+			glm::vec3 v1 = glm::vec3(mi.transform * glm::vec4(mi.positions[mi.indices[3 * p + 1]], 1.f));
+			glm::vec3 v2 = glm::vec3(mi.transform * glm::vec4(mi.positions[mi.indices[3 * p + 2]], 1.f));
+			mTris.push_back({ v0, v1 - v0, v2 - v0, iInst, static_cast<uint32_t>(p), flags });
+		}
+	}
+
+	mStats = Stats();
+	mStats.numTriangles = mTris.size();
+	if (mTris.empty()) return;
+
+	std::vector<glm::vec3> centroids(mTris.size()), triMin(mTris.size()), triMax(mTris.size());
+	std::vector<uint32_t>  order(mTris.size());
+	for (size_t i = 0; i < mTris.size(); i++) {
+		const auto &t = mTris[i];
+		glm::vec3 v1 = t.v0 + t.e1, v2 = t.v0 + t.e2;
+		triMin[i]    = glm::min(t.v0, glm::min(v1, v2));
+		triMax[i]    = glm::max(t.v0, glm::max(v1, v2));
+		centroids[i] = (triMin[i] + triMax[i]) * 0.5f;
+		order[i]     = static_cast<uint32_t>(i);
+	}
+
+	std::vector<BuildNode> bin;
+	bin.reserve(2 * mTris.size());
+	int root = buildBinary(bin, order, centroids, triMin, triMax, 0, static_cast<uint32_t>(mTris.size()));
+
+	// leaves refer to ranges of the permutation; bring the triangles into that order
+	std::vector<Tri> sorted(mTris.size());
+	for (size_t i = 0; i < order.size(); i++) sorted[i] = mTris[order[i]];
+	mTris = std::move(sorted);
+
+	mNodes.reserve(bin.size() / 2 + 1);
+	collapse(bin, root);
+
+	mStats.numNodes = mNodes.size();
+	mStats.buildMs  = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+}
+
+int CpuRayTracer::buildBinary(std::vector<BuildNode> &nodes, std::vector<uint32_t> &order, const std::vector<glm::vec3> &centroids, const std::vector<glm::vec3> &triMin, const std::vector<glm::vec3> &triMax, uint32_t first, uint32_t count)
+{
+	int index = static_cast<int>(nodes.size());
+	nodes.push_back({ glm::vec3(INF), glm::vec3(-INF), -1, -1, first, count });
+
+	glm::vec3 bmin(INF), bmax(-INF), cmin(INF), cmax(-INF);
+	for (uint32_t i = first; i < first + count; i++) {
+		uint32_t t = order[i];
+		bmin = glm::min(bmin, triMin[t]);    bmax = glm::max(bmax, triMax[t]);
+		cmin = glm::min(cmin, centroids[t]); cmax = glm::max(cmax, centroids[t]);
+	}
+	nodes[index].bmin = bmin;
+	nodes[index].bmax = bmax;
+	if (count <= BVH_MIN_LEAF) return index;
+
+	// binned SAH over all three axes
+	float bestCost = INF;
+	int   bestAxis = -1, bestSplit = -1;
+	for (int axis = 0; axis < 3; axis++) {
+		float extent = cmax[axis] - cmin[axis];
+		if (extent <= 0.f) continue;
+		float scale = BVH_NUM_BINS / extent;
+
+		glm::vec3 binMin[BVH_NUM_BINS], binMax[BVH_NUM_BINS];
+		uint32_t  binCount[BVH_NUM_BINS] = {};
+		std::fill(binMin, binMin + BVH_NUM_BINS, glm::vec3(INF));
+		std::fill(binMax, binMax + BVH_NUM_BINS, glm::vec3(-INF));
+		for (uint32_t i = first; i < first + count; i++) {
+			uint32_t t = order[i];
+			int b = std::min(BVH_NUM_BINS - 1, static_cast<int>((centroids[t][axis] - cmin[axis]) * scale));
+			binCount[b]++;
+			binMin[b] = glm::min(binMin[b], triMin[t]);
+			binMax[b] = glm::max(binMax[b], triMax[t]);
+		}
+
+		// sweep from the right, then from the left
+		float    rightArea[BVH_NUM_BINS];
+		uint32_t rightCount[BVH_NUM_BINS];
+		glm::vec3 accMin(INF), accMax(-INF);
+		uint32_t acc = 0;
+		for (int b = BVH_NUM_BINS - 1; b > 0; b--) {
+			accMin = glm::min(accMin, binMin[b]); accMax = glm::max(accMax, binMax[b]); acc += binCount[b];
+			rightArea[b] = halfArea(accMin, accMax); rightCount[b] = acc;
+		}
+		accMin = glm::vec3(INF); accMax = glm::vec3(-INF); acc = 0;
+		for (int b = 0; b < BVH_NUM_BINS - 1; b++) {
+			accMin = glm::min(accMin, binMin[b]); accMax = glm::max(accMax, binMax[b]); acc += binCount[b];
+			if (acc == 0 || rightCount[b + 1] == 0) continue;
+			float cost = halfArea(accMin, accMax) * acc + rightArea[b + 1] * rightCount[b + 1];
+			if (cost < bestCost) { bestCost = cost; bestAxis = axis; bestSplit = b; }
+		}
+	}
+
+	uint32_t mid;
+	if (bestAxis < 0) {
+		// all centroids coincide: split in the middle
+		mid = first + count / 2;
+	} else {
+		float leafCost  = COST_INTERSECT * count;
+		float splitCost = COST_TRAVERSAL + COST_INTERSECT * bestCost / std::max(halfArea(bmin, bmax), 1e-20f);
+		if (count <= BVH_MAX_LEAF && leafCost <= splitCost) return index;
+
+		float scale = BVH_NUM_BINS / (cmax[bestAxis] - cmin[bestAxis]);
+		auto it = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t t) {
+			return std::min(BVH_NUM_BINS - 1, static_cast<int>((centroids[t][bestAxis] - cmin[bestAxis]) * scale)) <= bestSplit;
+		});
+		mid = static_cast<uint32_t>(it - order.begin());
+		if (mid == first || mid == first + count) mid = first + count / 2;
+	}
+
+	int left  = buildBinary(nodes, order, centroids, triMin, triMax, first, mid - first);
+	int right = buildBinary(nodes, order, centroids, triMin, triMax, mid, first + count - mid);
+	nodes[index].left  = left;
+	nodes[index].right = right;
+	return index;
+}
+
+int CpuRayTracer::collapse(const std::vector<BuildNode> &bin, int binIndex)
+{
+	// gather up to 4 children by repeatedly opening the inner child with the largest surface area
+	int children[4] = { bin[binIndex].left, bin[binIndex].right, -1, -1 };
+	int numChildren = 2;
+	if (bin[binIndex].left < 0) {
+		// tiny scene, the root is a leaf
+		children[0] = binIndex;
+		numChildren = 1;
+	}
+	while (numChildren < 4) {
+		int   best = -1;
+		float bestArea = -1.f;
+		for (int c = 0; c < numChildren; c++) {
+			const auto &n = bin[children[c]];
+			if (n.left < 0) continue;
+			float a = halfArea(n.bmin, n.bmax);
+			if (a > bestArea) { bestArea = a; best = c; }
+		}
+		if (best < 0) break;
+		int opened = children[best];
+		children[best]          = bin[opened].left;
+		children[numChildren++] = bin[opened].right;
+	}
+
+	int index = static_cast<int>(mNodes.size());
+	mNodes.emplace_back();
+	for (int c = 0; c < 4; c++) {
+		Node &node = mNodes[index];
+		if (c >= numChildren) {
+			for (int a = 0; a < 3; a++) { node.bmin[a][c] = 0.f; node.bmax[a][c] = 0.f; }
+			node.child[c] = 0;	// the root is nobody's child
+			node.count[c] = 0;
+			continue;
+		}
+		const auto &n = bin[children[c]];
+		for (int a = 0; a < 3; a++) { node.bmin[a][c] = n.bmin[a]; node.bmax[a][c] = n.bmax[a]; }
+		if (n.left < 0) {
+			node.child[c] = ~static_cast<int32_t>(n.first);
+			node.count[c] = n.count;
+		} else {
+			int childIndex = collapse(bin, children[c]);	// may reallocate mNodes
+			mNodes[index].child[c] = childIndex;
+			mNodes[index].count[c] = 0;
+		}
+	}
+	return index;
+}
+
+// ---------- trace
+
+bool CpuRayTracer::intersectTri(const Tri &tri, const Ray &ray, float &t, float &u, float &v) const
+{
+	// Moeller-Trumbore; front faces are counter-clockwise, as in the raster pipelines
+	glm::vec3 p   = glm::cross(ray.dir, tri.e2);
+	float     det = glm::dot(tri.e1, p);
+	if (tri.flags & TRI_CULL) {
+		float d = (tri.flags & TRI_FLIP) ? -det : det;
+		if (d <= 1e-12f) return false;
+	} else if (std::abs(det) <= 1e-12f) {
+		return false;
+	}
+	float     invDet = 1.f / det;
+	glm::vec3 s = ray.org - tri.v0;
+	u = glm::dot(s, p) * invDet;
+	if (u < 0.f || u > 1.f) return false;
+	glm::vec3 q = glm::cross(s, tri.e1);
+	v = glm::dot(ray.dir, q) * invDet;
+	if (v < 0.f || u + v > 1.f) return false;
+	t = glm::dot(tri.e2, q) * invDet;
+	return t > ray.tmin && t < ray.tmax;
+}
+
+glm::vec2 CpuRayTracer::texCoordAt(const Tri &tri, float u, float v) const
+{
+	const auto &m = mInstances[tri.instance].mesh;
+	const uint32_t *idx = m.indices + 3 * static_cast<size_t>(tri.prim);
+	return (1.f - u - v) * m.texCoords[idx[0]] + u * m.texCoords[idx[1]] + v * m.texCoords[idx[2]];
+}
+
+bool CpuRayTracer::alphaTest(const Tri &tri, float u, float v, float alphaThreshold) const
+{
+	const Material &mat = mMaterials[mInstances[tri.instance].mesh.materialIndex];
+	return sample(mat.diffuseTex, texCoordAt(tri, u, v), mat.diffuseTexOffsetTiling).a >= alphaThreshold;
+}
+
+glm::vec4 CpuRayTracer::sample(int tex, glm::vec2 uv, const glm::vec4 &offsetTiling) const
+{
+	if (tex < 0 || tex >= static_cast<int>(mTextures.size()) || mTextures[tex].texels.empty()) return glm::vec4(1.f);
+	const Texture &t = mTextures[tex];
+
+	// bilinear, repeat
+	uv = uv * glm::vec2(offsetTiling.z, offsetTiling.w) + glm::vec2(offsetTiling.x, offsetTiling.y);
+	uv = uv - glm::floor(uv);
+	float x = uv.x * t.width - 0.5f, y = uv.y * t.height - 0.5f;
+	float fx = std::floor(x), fy = std::floor(y);
+	float ax = x - fx, ay = y - fy;
+	auto wrap = [](int i, int n) { i %= n; return i < 0 ? i + n : i; };
+	int x0 = wrap(static_cast<int>(fx), t.width),  x1 = wrap(x0 + 1, t.width);
+	int y0 = wrap(static_cast<int>(fy), t.height), y1 = wrap(y0 + 1, t.height);
+	auto texel = [&](int xx, int yy) { return glm::vec4(t.texels[static_cast<size_t>(yy) * t.width + xx]); };
+	glm::vec4 c = glm::mix(glm::mix(texel(x0, y0), texel(x1, y0), ax), glm::mix(texel(x0, y1), texel(x1, y1), ax), ay);
+	return c * (1.f / 255.f);
+}
+
+bool CpuRayTracer::intersect(Ray &ray, uint32_t cullMask, bool anyHit, float alphaThreshold, Hit &hit) const
+{
+	if (mNodes.empty()) return false;
+	bool found = false;
+
+	auto testLeaf = [&](uint32_t first, uint32_t count) {
+		for (uint32_t i = first; i < first + count; i++) {
+			const Tri &tri = mTris[i];
+			uint32_t mask = (tri.flags & TRI_TRANSPARENT) ? RAYTRACING_CULLMASK_TRANSPARENT : RAYTRACING_CULLMASK_OPAQUE;
+			if ((mask & cullMask) == 0) continue;
+			float t, u, v;
+			if (!intersectTri(tri, ray, t, u, v)) continue;
+			if ((tri.flags & TRI_TRANSPARENT) && !alphaTest(tri, u, v, alphaThreshold)) continue;
+			ray.tmax = t;
+			hit.t = t; hit.u = u; hit.v = v; hit.tri = i;
+			found = true;
+			if (anyHit) return true;
+		}
+		return false;
+	};
+
+	int32_t stack[TRAVERSAL_STACK];
+	int     sp = 0;
+	stack[sp++] = 0;
+
+#if CPU_RAYTRACER_USE_SSE
+	const __m128 ox = _mm_set1_ps(ray.org.x),    oy = _mm_set1_ps(ray.org.y),    oz = _mm_set1_ps(ray.org.z);
+	const __m128 ix = _mm_set1_ps(ray.invDir.x), iy = _mm_set1_ps(ray.invDir.y), iz = _mm_set1_ps(ray.invDir.z);
+	const __m128 tminV = _mm_set1_ps(ray.tmin);
+#endif
+
+	while (sp > 0) {
+		const Node &node = mNodes[stack[--sp]];
+
+		// slab test of all four child boxes
+		alignas(16) float tNear[4];
+		int hitMask;
+#if CPU_RAYTRACER_USE_SSE
+		__m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bmin[0]), ox), ix), t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bmax[0]), ox), ix);
+		__m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bmin[1]), oy), iy), t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bmax[1]), oy), iy);
+		__m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bmin[2]), oz), iz), t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bmax[2]), oz), iz);
+		__m128 tn = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), tminV));
+		__m128 tf = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_min_ps(_mm_max_ps(t0z, t1z), _mm_set1_ps(ray.tmax)));
+		hitMask = _mm_movemask_ps(_mm_cmple_ps(tn, tf));
+		_mm_store_ps(tNear, tn);
+#else
+		hitMask = 0;
+		for (int c = 0; c < 4; c++) {
+			float tn = ray.tmin, tf = ray.tmax;
+			for (int a = 0; a < 3; a++) {
+				float t0 = (node.bmin[a][c] - ray.org[a]) * ray.invDir[a];
+				float t1 = (node.bmax[a][c] - ray.org[a]) * ray.invDir[a];
+				tn = std::max(tn, std::min(t0, t1));
+				tf = std::min(tf, std::max(t0, t1));
+			}
+			tNear[c] = tn;
+			if (tn <= tf) hitMask |= 1 << c;
+		}
+#endif
+		if (hitMask == 0) continue;
+
+		// leaves right away, inner nodes onto the stack (farthest first, so the nearest is popped next)
+		int   inner[4];
+		float innerT[4];
+		int   numInner = 0;
+		for (int c = 0; c < 4; c++) {
+			if (!(hitMask & (1 << c)) || node.child[c] == 0) continue;
+			if (node.child[c] < 0) {
+				if (testLeaf(static_cast<uint32_t>(~node.child[c]), node.count[c])) return true;
+			} else {
+				int k = numInner++;
+				while (k > 0 && innerT[k - 1] < tNear[c]) { inner[k] = inner[k - 1]; innerT[k] = innerT[k - 1]; k--; }
+				inner[k] = node.child[c]; innerT[k] = tNear[c];
+			}
+		}
+		for (int k = 0; k < numInner && sp < TRAVERSAL_STACK; k++) {
+			if (innerT[k] > ray.tmax) continue;	// a leaf of this node may already have shortened the ray
+			stack[sp++] = inner[k];
+		}
+	}
+	return found;
+}
+
+glm::vec3 CpuRayTracer::sky(const glm::vec3 &dir)
+{
+	// as rt_test.rmiss
+	const float pi = 3.1415926535897932384626433832795f;
+	const float half_pi = pi * 0.5f;
+	glm::vec3 nc = dir;
+
+	float latitude  = std::acos(glm::clamp(nc.y, -1.f, 1.f));
+	float longitude = std::atan2(nc.z, nc.x);
+	float s = std::cos(std::abs(longitude)) * 0.5f + 0.5f;
+	float t = glm::mix(1.f - nc.y, 0.5f + std::cos((nc.y + 0.5f) * 0.5f * pi), 0.5f);
+	glm::vec3 color = glm::mix(glm::vec3(0.1f, 0.26f, 0.4f), glm::vec3(1.f, 0.68f, 0.28f), t*t*t*t);
+	float tf = glm::clamp(latitude, 0.f, 1.f);
+	color = glm::mix(glm::vec3(0.1f, 0.26f, 0.4f), color, s*s*s*s * tf);
+	color = glm::mix(color, glm::vec3(0.f, 0.f, 0.5f), std::sin(glm::clamp(-nc.y, 0.f, 1.f) * half_pi));
+	return color;
+}
+
+glm::vec3 CpuRayTracer::shade(const FrameParams &params, const Ray &ray, const Hit &hit, uint64_t &numRays) const
+{
+	// as rt_test.rchit, minus normal mapping and LOD
+	const Tri      &tri  = mTris[hit.tri];
+	const Instance &inst = mInstances[tri.instance];
+	const auto     &m    = inst.mesh;
+	const Material &mat  = mMaterials[m.materialIndex];
+
+	const uint32_t *idx = m.indices + 3 * static_cast<size_t>(tri.prim);
+	float b0 = 1.f - hit.u - hit.v;
+	glm::vec2 uv       = b0 * m.texCoords[idx[0]] + hit.u * m.texCoords[idx[1]] + hit.v * m.texCoords[idx[2]];
+	glm::vec3 normalOS = glm::normalize(b0 * m.normals[idx[0]] + hit.u * m.normals[idx[1]] + hit.v * m.normals[idx[2]]);
+	glm::vec3 normalWS = glm::normalize(inst.normalMatrix * normalOS);
+
+	if (params.lightingMode >= 3 && params.lightingMode < 5) return normalWS;	// normals / geometry normals are the same here
+	if (params.lightingMode == 2 || params.lightingMode >= 5) return glm::vec3(0.f);
+
+	glm::vec4 diffTexColorRGBA = sample(mat.diffuseTex,  uv, mat.diffuseTexOffsetTiling);
+	glm::vec3 diff             = mat.diffuse * glm::vec3(diffTexColorRGBA);
+	if (params.lightingMode == 1) return diff;
+
+	float     specTexValue     = sample(mat.specularTex, uv, mat.specularTexOffsetTiling).r;
+	glm::vec3 emissiveTexColor = glm::vec3(sample(mat.emissiveTex, uv, mat.emissiveTexOffsetTiling));
+	glm::vec3 ambient  = mat.ambient  * glm::vec3(diffTexColorRGBA);
+	glm::vec3 emissive = mat.emissive * emissiveTexColor;
+	glm::vec3 spec     = mat.specular * specTexValue;
+
+	glm::vec3 toLight = glm::normalize(-params.lightDir);
+
+	// shadow ray: cull back faces, terminate on first hit
+	float shadowFactor = 1.f;
+	if (params.shadows) {
+		Ray sr;
+		sr.org    = ray.org + ray.dir * hit.t;
+		sr.dir    = toLight;
+		sr.invDir = glm::vec3(safeInv(sr.dir.x), safeInv(sr.dir.y), safeInv(sr.dir.z));
+		sr.tmin   = 0.001f;
+		sr.tmax   = params.maxRayLength;
+		uint32_t cullMask = params.shadowsOfTransparent ? RAYTRACING_CULLMASK_OPAQUE | RAYTRACING_CULLMASK_TRANSPARENT : RAYTRACING_CULLMASK_OPAQUE;
+		Hit sh;
+		numRays++;
+		if (intersect(sr, cullMask, true, params.alphaThreshold, sh)) shadowFactor = 1.f - SHADOW_OPACITY;
+	}
+
+	// Blinn-Phong, one directional light (+ ambient)
+	glm::vec3 normal = normalWS;
+	glm::vec3 toEye  = -ray.dir;
+	if (mat.twoSided && glm::dot(normal, toEye) < 0.f) normal = -normal;
+	float nDotL = std::max(0.f, glm::dot(normal, toLight));
+	float nDotH = std::max(0.f, glm::dot(normal, glm::normalize(toLight + toEye)));
+	float specPower = (nDotH == 0.f && mat.shininess == 0.f) ? 1.f : std::pow(nDotH, mat.shininess);
+	glm::vec3 diffAndSpec = params.dirLightIntensity * (diff * nDotL + spec * specPower);
+
+	return params.ambientLightIntensity * ambient + emissive + shadowFactor * diffAndSpec;
+}
+
+void CpuRayTracer::render(const FrameParams &params, int width, int height, const uint32_t *pixels, size_t numPixels, glm::vec4 *out)
+{
+	using clock = std::chrono::high_resolution_clock;
+	auto t0 = clock::now();
+	mStats.numRays = 0;
+	if (!isBuilt() || numPixels == 0 || width <= 0 || height <= 0) { mStats.traceMs = 0.0; return; }
+
+	const float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+	const int   numSamples  = glm::clamp(params.numSamples, 1, RAYTRACING_MAX_SAMPLES_PER_PIXEL);
+	const uint32_t primaryMask = RAYTRACING_CULLMASK_OPAQUE | RAYTRACING_CULLMASK_TRANSPARENT;
+	std::atomic<uint64_t> numRays{0};
+
+	std::function<void(size_t)> func = [&](size_t iJob) {
+		uint64_t localRays = 0;
+		size_t end = std::min(numPixels, (iJob + 1) * pixelsPerJob);
+		for (size_t k = iJob * pixelsPerJob; k < end; k++) {
+			int x = static_cast<int>(pixels[k] & 0xffff), y = static_cast<int>(pixels[k] >> 16);
+			if (x >= width || y >= height) continue;
+
+			glm::vec3 accumulated(0.f);
+			for (int iSample = 0; iSample < numSamples; iSample++) {
+				glm::vec2 offset = params.pixelOffsets ? glm::vec2(0.5f) + params.pixelOffsets[iSample] : glm::vec2(0.5f);
+				glm::vec2 uv = (glm::vec2(x, y) + offset) / glm::vec2(width, height);
+
+				// as calc_ray in shader_raytrace_common.glsl
+				glm::vec2 d = uv * 2.f - 1.f;
+				glm::vec3 dir = glm::normalize(glm::vec3(d.x * aspectRatio, -d.y, -std::sqrt(3.f)));
+				glm::vec3 p1  = glm::vec3(params.cameraTransform * glm::vec4(0.f, 0.f, 0.f, 1.f));
+				glm::vec3 p2  = glm::vec3(params.cameraTransform * glm::vec4(dir, 1.f));
+
+				Ray ray;
+				ray.org    = p1;
+				ray.dir    = glm::normalize(p2 - p1);
+				ray.invDir = glm::vec3(safeInv(ray.dir.x), safeInv(ray.dir.y), safeInv(ray.dir.z));
+				ray.tmin   = 0.001f;
+				ray.tmax   = params.maxRayLength;
+
+				Hit hit;
+				localRays++;
+				accumulated += intersect(ray, primaryMask, false, params.alphaThreshold, hit) ? shade(params, ray, hit, localRays) : sky(ray.dir);
+			}
+			out[static_cast<size_t>(y) * width + x] = glm::vec4(accumulated / static_cast<float>(numSamples), 1.f);
+		}
+		numRays += localRays;
+	};
+	runJobs((numPixels + pixelsPerJob - 1) / pixelsPerJob, func);
+
+	mStats.numRays = numRays;
+	mStats.traceMs = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+}
+
+// ---------- worker pool
+
+void CpuRayTracer::workerLoop()
+{
+	uint64_t seenGeneration = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCvWork.wait(lock, [&]() { return mQuit || mGeneration != seenGeneration; });
+			if (mQuit) return;
+			seenGeneration = mGeneration;
+			mActiveWorkers++;
+		}
+		drainJobs();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mActiveWorkers--;
+		}
+		mCvDone.notify_all();
+	}
+}
+
+void CpuRayTracer::drainJobs()
+{
+	size_t numJobs = mNumJobs;
+	size_t iJob;
+	while ((iJob = mNextJob.fetch_add(1)) < numJobs) {
+		(*mJobFunc)(iJob);
+		if (mJobsDone.fetch_add(1) + 1 == numJobs) {
+			std::lock_guard<std::mutex> lock(mMutex);
+			mCvDone.notify_all();
+		}
+	}
+}
+
+void CpuRayTracer::runJobs(size_t numJobs, const std::function<void(size_t)> &func)
+{
+	if (numJobs == 0) return;
+	{
+		// don't touch the job state while a worker is still leaving the previous round
+		std::unique_lock<std::mutex> lock(mMutex);
+		mCvDone.wait(lock, [&]() { return mActiveWorkers == 0; });
+		mJobFunc  = &func;
+		mNumJobs  = numJobs;
+		mJobsDone = 0;
+		mNextJob  = 0;
+		mGeneration++;
+	}
+	mCvWork.notify_all();
+	drainJobs();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCvDone.wait(lock, [&]() { return mJobsDone == mNumJobs; });
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// CPU ray tracer: software backend for the ray traced test image and the TAA augmentation (also a performance reference for the hardware path)
+// - static triangle meshes with instance transforms, flattened to world space
+// - BVH: binned SAH build (binary), collapsed into a 4-wide BVH; SSE: the 4 child boxes of a node are tested at once
+// - shading follows rt_test.rchit (Blinn-Phong, one directional light + ambient, shadow rays, alpha test of transparent geometry),
+//   but without normal mapping and texture LOD (textures are sampled bilinearly from the full resolution image)
+// - pixels are split into chunks, which are processed by a small persistent worker pool (like CpuSkinning)
+class CpuRayTracer {
+public:
+	struct Texture {
+		int width  = 0;
+		int height = 0;
+		std::vector<glm::u8vec4> texels;	// RGBA8, row by row
+	};
+
+	struct Material {
+		glm::vec3 ambient, diffuse, specular, emissive;
+		float shininess = 0.f;
+		bool  twoSided  = false;
+		int   diffuseTex = -1, specularTex = -1, emissiveTex = -1;	// -1: white
+		glm::vec4 diffuseTexOffsetTiling  = glm::vec4(0, 0, 1, 1);
+		glm::vec4 specularTexOffsetTiling = glm::vec4(0, 0, 1, 1);
+		glm::vec4 emissiveTexOffsetTiling = glm::vec4(0, 0, 1, 1);
+	};
+
+	struct MeshInstance {
+		const uint32_t  *indices;		// 3 per triangle, relative to the vertex arrays below
+		size_t           numIndices;
+		const glm::vec3 *positions;
+		const glm::vec3 *normals;
+		const glm::vec2 *texCoords;
+		glm::mat4 transform;
+		int  materialIndex;
+		bool transparent;				// alpha tested, only hit with the transparent cull mask (like RAYTRACING_CULLMASK_TRANSPARENT)
+		bool twoSided;					// no backface culling
+	};
+
+	struct FrameParams {
+		glm::mat4 cameraTransform;		// camera -> world (as mCameraTransform for the ray generation shader)
+		glm::vec3 lightDir;				// direction FROM the light source
+		glm::vec3 dirLightIntensity;
+		glm::vec3 ambientLightIntensity;
+		float maxRayLength;
+		float alphaThreshold;
+		bool  shadows;
+		bool  shadowsOfTransparent;
+		int   lightingMode;				// as mUserInput.z in the shaders: 0 lit, 1 diffuse only, 3 normals, 4 geometry normals
+		int   numSamples;
+		const glm::vec2 *pixelOffsets;	// offsets from the pixel center, numSamples of them; nullptr: pixel center
+	};
+
+	struct Stats {
+		size_t   numTriangles = 0;
+		size_t   numNodes     = 0;
+		double   buildMs      = 0.0;
+		double   traceMs      = 0.0;	// last render()
+		uint64_t numRays      = 0;		// primary + shadow rays of the last render()
+	};
+
+	explicit CpuRayTracer(int numThreads = 0);	// 0: use hardware concurrency
+	~CpuRayTracer();
+
+	// (re-)build the BVH; the mesh data must stay valid (it is referenced for shading)
+	void build(const std::vector<MeshInstance> &instances, std::vector<Material> materials, std::vector<Texture> textures);
+	bool isBuilt() const { return !mNodes.empty(); }
+
+	// trace the given pixels (packed x | (y << 16)) of a width x height image; writes out[y * width + x] = vec4(color, 1)
+	void render(const FrameParams &params, int width, int height, const uint32_t *pixels, size_t numPixels, glm::vec4 *out);
+
+	const Stats & stats() const { return mStats; }
+	int numThreads() const { return static_cast<int>(mWorkers.size()) + 1; }
+
+	size_t pixelsPerJob = 256;
+
+private:
+	enum : uint32_t { TRI_TRANSPARENT = 1, TRI_CULL = 2, TRI_FLIP = 4 };
+
+	struct Tri {						// world space, for the intersection test
+		glm::vec3 v0, e1, e2;
+		uint32_t  instance;
+		uint32_t  prim;
+		uint32_t  flags;
+	};
+
+	struct Instance {					// for shading
+		MeshInstance mesh;
+		glm::mat3 normalMatrix;
+	};
+
+	struct alignas(16) Node {			// 4-wide node, child bounds as SoA
+		float   bmin[3][4];
+		float   bmax[3][4];
+		int32_t child[4];				// > 0: node index; < 0: leaf, first triangle = ~child; 0: empty slot
+		uint32_t count[4];				// leaf: number of triangles; 0 for inner nodes and empty slots
+	};
+
+	struct Ray {
+		glm::vec3 org, dir, invDir;
+		float tmin, tmax;
+	};
+
+	struct Hit {
+		float t = 0.f, u = 0.f, v = 0.f;
+		uint32_t tri = 0;
+	};
+
+	std::vector<Instance> mInstances;
+	std::vector<Material> mMaterials;
+	std::vector<Texture>  mTextures;
+	std::vector<Tri>      mTris;
+	std::vector<Node>     mNodes;
+	Stats                 mStats;
+
+	// build
+	struct BuildNode { glm::vec3 bmin, bmax; int left, right; uint32_t first, count; };
+	int  buildBinary(std::vector<BuildNode> &nodes, std::vector<uint32_t> &order, const std::vector<glm::vec3> &centroids, const std::vector<glm::vec3> &triMin, const std::vector<glm::vec3> &triMax, uint32_t first, uint32_t count);
+	int  collapse(const std::vector<BuildNode> &bin, int binIndex);
+
+	// trace
+	bool intersect(Ray &ray, uint32_t cullMask, bool anyHit, float alphaThreshold, Hit &hit) const;
+	bool intersectTri(const Tri &tri, const Ray &ray, float &t, float &u, float &v) const;
+	bool alphaTest(const Tri &tri, float u, float v, float alphaThreshold) const;
+	glm::vec2 texCoordAt(const Tri &tri, float u, float v) const;
+	glm::vec4 sample(int tex, glm::vec2 uv, const glm::vec4 &offsetTiling) const;
+	glm::vec3 shade(const FrameParams &params, const Ray &ray, const Hit &hit, uint64_t &numRays) const;
+	static glm::vec3 sky(const glm::vec3 &dir);
+
+	// worker pool
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mCvWork, mCvDone;
+	uint64_t mGeneration = 0;
+	bool mQuit = false;
+	int  mActiveWorkers = 0;
+	const std::function<void(size_t)> *mJobFunc = nullptr;
+	std::atomic<size_t> mNumJobs{0}, mNextJob{0}, mJobsDone{0};
+
+	void workerLoop();
+	void drainJobs();
+	void runJobs(size_t numJobs, const std::function<void(size_t)> &func);
+};
@@ -0,0 +1,262 @@
+#include "CpuSkinning.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define CPU_SKINNING_USE_SSE 1
+#include <immintrin.h>
+#else
+#define CPU_SKINNING_USE_SSE 0
+#endif
+
+CpuSkinning::CpuSkinning(int numThreads)
+{
+	if (numThreads <= 0) numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	// the calling thread also works on the jobs
+	for (int i = 1; i < numThreads; i++) {
+		mWorkers.emplace_back(&CpuSkinning::workerLoop, this);
+	}
+}
+
+CpuSkinning::~CpuSkinning()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mCvWork.notify_all();
+	for (auto &t : mWorkers) t.join();
+}
+
+void CpuSkinning::setMeshes(const std::vector<MeshInput> &meshes)
+{
+	mMeshes = meshes;
+	mOutputs.resize(mMeshes.size());
+	mJobs.clear();
+	for (size_t m = 0; m < mMeshes.size(); m++) {
+		size_t n = mMeshes[m].numVertices;
+		auto &out = mOutputs[m];
+		out.positions    .resize(n);
+		out.prevPositions.resize(n);
+		out.normals      .resize(n);
+		out.tangents     .resize(n);
+		out.bitangents   .resize(n);
+		for (size_t begin = 0; begin < n; begin += chunkSize) {
+			mJobs.push_back({ m, begin, std::min(n, begin + chunkSize) });
+		}
+	}
+}
+
+void CpuSkinning::skin(const glm::mat4 *boneMatrices, const glm::mat4 *boneMatricesPrev, size_t bonesPerMesh)
+{
+	std::function<void(size_t)> func = [&](size_t iJob) { skinRange(mJobs[iJob], boneMatrices, boneMatricesPrev, bonesPerMesh); };
+	runJobs(mJobs.size(), func);
+}
+
+#if CPU_SKINNING_USE_SSE
+static inline __m128 blendColumn(const glm::mat4 *m0, const glm::mat4 *m1, const glm::mat4 *m2, const glm::mat4 *m3, int col, __m128 w0, __m128 w1, __m128 w2, __m128 w3)
+{
+	__m128 r =            _mm_mul_ps(_mm_loadu_ps(&(*m0)[col][0]), w0);
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&(*m1)[col][0]), w1));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&(*m2)[col][0]), w2));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&(*m3)[col][0]), w3));
+	return r;
+}
+
+static inline __m128 transform3(__m128 c0, __m128 c1, __m128 c2, const glm::vec3 &v)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(v.x)), _mm_mul_ps(c1, _mm_set1_ps(v.y))), _mm_mul_ps(c2, _mm_set1_ps(v.z)));
+}
+
+static inline __m128 cross3(__m128 a, __m128 b)
+{
+	__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c    = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+static inline __m128 normalize3(__m128 v)
+{
+	// v.w is zero here
+	__m128 sq  = _mm_mul_ps(v, v);
+	__m128 sum = _mm_add_ps(sq,  _mm_shuffle_ps(sq,  sq,  _MM_SHUFFLE(2, 3, 0, 1)));
+	sum        = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_div_ps(v, _mm_sqrt_ps(_mm_max_ps(sum, _mm_set1_ps(1e-30f))));
+}
+
+static inline void store3(glm::vec3 &dst, __m128 v)
+{
+	alignas(16) float t[4];
+	_mm_store_ps(t, v);
+	dst = glm::vec3(t[0], t[1], t[2]);
+}
+#endif
+
+void CpuSkinning::skinRange(const Job &job, const glm::mat4 *boneMatrices, const glm::mat4 *boneMatricesPrev, size_t bonesPerMesh)
+{
+	const auto &in  = mMeshes[job.mesh];
+	auto       &out = mOutputs[job.mesh];
+	const glm::mat4 *bones     = boneMatrices     + job.mesh * bonesPerMesh;
+	const glm::mat4 *bonesPrev = boneMatricesPrev + job.mesh * bonesPerMesh;
+
+	for (size_t v = job.begin; v < job.end; v++) {
+		const glm::uvec4 &bi = in.boneIndices[v];
+		const glm::vec4  &bw = in.boneWeights[v];
+		const glm::vec3  &p  = in.positions[v];
+
+#if CPU_SKINNING_USE_SSE
+		__m128 w0 = _mm_set1_ps(bw.x), w1 = _mm_set1_ps(bw.y), w2 = _mm_set1_ps(bw.z), w3 = _mm_set1_ps(bw.w);
+
+		const glm::mat4 *b0 = bones + bi.x, *b1 = bones + bi.y, *b2 = bones + bi.z, *b3 = bones + bi.w;
+		__m128 c0 = blendColumn(b0, b1, b2, b3, 0, w0, w1, w2, w3);
+		__m128 c1 = blendColumn(b0, b1, b2, b3, 1, w0, w1, w2, w3);
+		__m128 c2 = blendColumn(b0, b1, b2, b3, 2, w0, w1, w2, w3);
+		__m128 c3 = blendColumn(b0, b1, b2, b3, 3, w0, w1, w2, w3);
+
+		b0 = bonesPrev + bi.x; b1 = bonesPrev + bi.y; b2 = bonesPrev + bi.z; b3 = bonesPrev + bi.w;
+		__m128 prevPos = _mm_add_ps(transform3(blendColumn(b0, b1, b2, b3, 0, w0, w1, w2, w3), blendColumn(b0, b1, b2, b3, 1, w0, w1, w2, w3), blendColumn(b0, b1, b2, b3, 2, w0, w1, w2, w3), p), blendColumn(b0, b1, b2, b3, 3, w0, w1, w2, w3));
+
+		// normal matrix = cofactor matrix of the upper 3x3 (= det * inverse transpose, the scale goes away with the normalization)
+		__m128 n0 = cross3(c1, c2), n1 = cross3(c2, c0), n2 = cross3(c0, c1);
+
+		store3(out.positions    [v], _mm_add_ps(transform3(c0, c1, c2, p), c3));
+		store3(out.prevPositions[v], prevPos);
+		store3(out.normals      [v], normalize3(transform3(n0, n1, n2, in.normals   [v])));
+		store3(out.tangents     [v], normalize3(transform3(n0, n1, n2, in.tangents  [v])));
+		store3(out.bitangents   [v], normalize3(transform3(n0, n1, n2, in.bitangents[v])));
+#else
+		glm::mat4 boneMat     = bones    [bi.x] * bw.x + bones    [bi.y] * bw.y + bones    [bi.z] * bw.z + bones    [bi.w] * bw.w;
+		glm::mat4 prevBoneMat = bonesPrev[bi.x] * bw.x + bonesPrev[bi.y] * bw.y + bonesPrev[bi.z] * bw.z + bonesPrev[bi.w] * bw.w;
+		glm::vec3 c0 = boneMat[0], c1 = boneMat[1], c2 = boneMat[2];
+		glm::mat3 nrmMat      = glm::mat3(glm::cross(c1, c2), glm::cross(c2, c0), glm::cross(c0, c1));
+
+		out.positions    [v] = glm::vec3(boneMat     * glm::vec4(p, 1.0f));
+		out.prevPositions[v] = glm::vec3(prevBoneMat * glm::vec4(p, 1.0f));
+		out.normals      [v] = glm::normalize(nrmMat * in.normals   [v]);
+		out.tangents     [v] = glm::normalize(nrmMat * in.tangents  [v]);
+		out.bitangents   [v] = glm::normalize(nrmMat * in.bitangents[v]);
+#endif
+	}
+}
+
+void CpuSkinning::skinReference(size_t meshIndex, const glm::mat4 *boneMatrices, size_t bonesPerMesh, MeshOutput &out)
+{
+	// the original per-vertex algorithm (formerly calc_new_mesh_positions_and_ntb_for_animated_object), kept for benchmarking
+	const auto &mesh = mMeshes[meshIndex];
+	size_t bonesBaseIndex = meshIndex * bonesPerMesh;
+	const size_t numVertices = mesh.numVertices;
+
+	std::vector<glm::vec3> posNew(numVertices), nrmNew(numVertices), tanNew(numVertices), bitNew(numVertices);
+
+	for (size_t i = 0; i < numVertices; ++i) {
+		auto &aBoneIndices = mesh.boneIndices[i];
+		auto &aBoneWeights = mesh.boneWeights[i];
+		glm::mat4 boneMat =
+			boneMatrices[bonesBaseIndex + aBoneIndices[0]] * aBoneWeights[0] +
+			boneMatrices[bonesBaseIndex + aBoneIndices[1]] * aBoneWeights[1] +
+			boneMatrices[bonesBaseIndex + aBoneIndices[2]] * aBoneWeights[2] +
+			boneMatrices[bonesBaseIndex + aBoneIndices[3]] * aBoneWeights[3];
+
+		posNew[i] = glm::vec3(boneMat * glm::vec4(mesh.positions[i], 1.0f));
+
+		glm::mat4 nrmMatrix = glm::inverse(glm::transpose(boneMat));
+		nrmNew[i] = glm::normalize(glm::vec3(nrmMatrix * glm::vec4(glm::normalize(mesh.normals   [i]), 0)));
+		tanNew[i] = glm::normalize(glm::vec3(nrmMatrix * glm::vec4(glm::normalize(mesh.tangents  [i]), 0)));
+		bitNew[i] = glm::normalize(glm::vec3(nrmMatrix * glm::vec4(glm::normalize(mesh.bitangents[i]), 0)));
+	}
+
+	out.positions  = std::move(posNew);
+	out.normals    = std::move(nrmNew);
+	out.tangents   = std::move(tanNew);
+	out.bitangents = std::move(bitNew);
+}
+
+CpuSkinning::BenchmarkResult CpuSkinning::benchmark(const glm::mat4 *boneMatrices, const glm::mat4 *boneMatricesPrev, size_t bonesPerMesh, int iterations)
+{
+	using clock = std::chrono::high_resolution_clock;
+	BenchmarkResult res;
+	res.numThreads = numThreads();
+	for (auto &m : mMeshes) res.numVertices += m.numVertices;
+	if (iterations < 1 || mMeshes.empty()) return res;
+
+	std::vector<MeshOutput> refOut(mMeshes.size());
+	auto t0 = clock::now();
+	for (int it = 0; it < iterations; it++) {
+		for (size_t m = 0; m < mMeshes.size(); m++) skinReference(m, boneMatrices, bonesPerMesh, refOut[m]);
+	}
+	auto t1 = clock::now();
+	for (int it = 0; it < iterations; it++) {
+		skin(boneMatrices, boneMatricesPrev, bonesPerMesh);
+	}
+	auto t2 = clock::now();
+
+	res.msReference = std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations;
+	res.msOptimized = std::chrono::duration<double, std::milli>(t2 - t1).count() / iterations;
+
+	for (size_t m = 0; m < mMeshes.size(); m++) {
+		for (size_t v = 0; v < mMeshes[m].numVertices; v++) {
+			glm::vec3 dp = glm::abs(refOut[m].positions[v] - mOutputs[m].positions[v]);
+			glm::vec3 dn = glm::abs(refOut[m].normals  [v] - mOutputs[m].normals  [v]);
+			res.maxPosError = std::max(res.maxPosError, std::max(dp.x, std::max(dp.y, dp.z)));
+			res.maxNrmError = std::max(res.maxNrmError, std::max(dn.x, std::max(dn.y, dn.z)));
+		}
+	}
+	return res;
+}
+
+// ---------- worker pool
+
+void CpuSkinning::workerLoop()
+{
+	uint64_t seenGeneration = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCvWork.wait(lock, [&]() { return mQuit || mGeneration != seenGeneration; });
+			if (mQuit) return;
+			seenGeneration = mGeneration;
+			mActiveWorkers++;
+		}
+		drainJobs();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mActiveWorkers--;
+		}
+		mCvDone.notify_all();
+	}
+}
+
+void CpuSkinning::drainJobs()
+{
+	size_t numJobs = mNumJobs;
+	size_t iJob;
+	while ((iJob = mNextJob.fetch_add(1)) < numJobs) {
+		(*mJobFunc)(iJob);
+		if (mJobsDone.fetch_add(1) + 1 == numJobs) {
+			std::lock_guard<std::mutex> lock(mMutex);
+			mCvDone.notify_all();
+		}
+	}
+}
+
+void CpuSkinning::runJobs(size_t numJobs, const std::function<void(size_t)> &func)
+{
+	if (numJobs == 0) return;
+	{
+		// don't touch the job state while a worker is still leaving the previous round
+		std::unique_lock<std::mutex> lock(mMutex);
+		mCvDone.wait(lock, [&]() { return mActiveWorkers == 0; });
+		mJobFunc  = &func;
+		mNumJobs  = numJobs;
+		mJobsDone = 0;
+		mNextJob  = 0;
+		mGeneration++;
+	}
+	mCvWork.notify_all();
+	drainJobs();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCvDone.wait(lock, [&]() { return mJobsDone == mNumJobs; });
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <glm/glm.hpp>
+
+// CPU skinning of an animated object (alternative to skinning.comp, also used for benchmarking)
+// - the normal matrix is the cofactor matrix of the blended bone matrix (three cross products, no per-vertex inverse)
+// - SSE: the bone matrix columns are blended and applied as 4-wide vectors
+// - vertices are split into chunks, which are processed by a small persistent worker pool
+// - results go into persistent per-mesh output vectors (no allocations per frame)
+class CpuSkinning {
+public:
+	struct MeshInput {
+		const glm::vec3  *positions;
+		const glm::vec3  *normals;
+		const glm::vec3  *tangents;
+		const glm::vec3  *bitangents;
+		const glm::vec4  *boneWeights;
+		const glm::uvec4 *boneIndices;
+		size_t numVertices;
+	};
+
+	struct MeshOutput {
+		std::vector<glm::vec3> positions, prevPositions, normals, tangents, bitangents;
+	};
+
+	struct BenchmarkResult {
+		double msReference = 0.0;		// avg. time per frame of the original (naive, single threaded) algorithm
+		double msOptimized = 0.0;		// avg. time per frame of skin()
+		float  maxPosError = 0.f;		// max. abs. difference between both results
+		float  maxNrmError = 0.f;
+		size_t numVertices = 0;
+		int    numThreads  = 0;
+	};
+
+	explicit CpuSkinning(int numThreads = 0);	// 0: use hardware concurrency
+	~CpuSkinning();
+
+	// set the meshes to skin; input data must stay valid; (re-)allocates the outputs
+	void setMeshes(const std::vector<MeshInput> &meshes);
+	size_t numMeshes() const { return mMeshes.size(); }
+	const MeshOutput & output(size_t meshIndex) const { return mOutputs[meshIndex]; }
+	int numThreads() const { return static_cast<int>(mWorkers.size()) + 1; }
+
+	// skin all meshes; bone matrices are laid out as [meshIndex * bonesPerMesh + boneIndex]
+	void skin(const glm::mat4 *boneMatrices, const glm::mat4 *boneMatricesPrev, size_t bonesPerMesh);
+
+	// compare skin() against the original per-vertex algorithm
+	BenchmarkResult benchmark(const glm::mat4 *boneMatrices, const glm::mat4 *boneMatricesPrev, size_t bonesPerMesh, int iterations);
+
+	size_t chunkSize = 4096;	// vertices per job
+
+private:
+	struct Job { size_t mesh, begin, end; };
+
+	std::vector<MeshInput>  mMeshes;
+	std::vector<MeshOutput> mOutputs;
+	std::vector<Job>        mJobs;
+
+	void skinRange(const Job &job, const glm::mat4 *boneMatrices, const glm::mat4 *boneMatricesPrev, size_t bonesPerMesh);
+	void skinReference(size_t meshIndex, const glm::mat4 *boneMatrices, size_t bonesPerMesh, MeshOutput &out);
+
+	// worker pool
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mCvWork, mCvDone;
+	uint64_t mGeneration = 0;
+	bool mQuit = false;
+	int  mActiveWorkers = 0;
+	const std::function<void(size_t)> *mJobFunc = nullptr;
+	std::atomic<size_t> mNumJobs{0}, mNextJob{0}, mJobsDone{0};
+
+	void workerLoop();
+	void drainJobs();
+	void runJobs(size_t numJobs, const std::function<void(size_t)> &func);
+};
@@ -50,12 +50,17 @@ public:
 	//          INSIDE : 1 
 	//          OUTSIDE : 2 
 	TestResult FrustumAABBIntersect(const glm::vec3 &mins, const glm::vec3 &maxs) const { 
+		return PlanesAABBIntersect(mPlanes, 6, mins, maxs);
+	}
+
+	// same test against an arbitrary convex volume given by (outward facing) planes
+	static TestResult PlanesAABBIntersect(const glm::vec4 *planes, int numPlanes, const glm::vec3 &mins, const glm::vec3 &maxs) { 
 		TestResult ret = TestResult::inside;
 		glm::vec3  vmin, vmax; 
 
-		for(int i = 0; i < 6; ++i) { 
+		for(int i = 0; i < numPlanes; ++i) { 
 			// X axis 
-			if(mPlanes[i].x > 0) { 
+			if(planes[i].x > 0) { 
 				vmin.x = mins.x; 
 				vmax.x = maxs.x; 
 			} else { 
@@ -63,7 +68,7 @@ public:
 				vmax.x = mins.x; 
 			} 
 			// Y axis 
-			if(mPlanes[i].y > 0) { 
+			if(planes[i].y > 0) { 
 				vmin.y = mins.y; 
 				vmax.y = maxs.y; 
 			} else { 
@@ -71,15 +76,15 @@ public:
 				vmax.y = mins.y; 
 			} 
 			// Z axis 
-			if(mPlanes[i].z > 0) { 
+			if(planes[i].z > 0) { 
 				vmin.z = mins.z; 
 				vmax.z = maxs.z; 
 			} else { 
 				vmin.z = maxs.z; 
 				vmax.z = mins.z; 
 			} 
-			if(glm::dot(glm::vec3(mPlanes[i]), vmin) + mPlanes[i].w >  0.f) return TestResult::outside;
-			if(glm::dot(glm::vec3(mPlanes[i]), vmax) + mPlanes[i].w >= 0.f) ret = TestResult::intersect;
+			if(glm::dot(glm::vec3(planes[i]), vmin) + planes[i].w >  0.f) return TestResult::outside;
+			if(glm::dot(glm::vec3(planes[i]), vmax) + planes[i].w >= 0.f) ret = TestResult::intersect;
 		} 
 		return ret;
 	}
@@ -88,5 +93,9 @@ public:
 		return TestResult::outside == FrustumAABBIntersect(bb.min, bb.max);
 	}
 
+	static bool CanCull(const glm::vec4 *planes, int numPlanes, const BoundingBox &bb) {
+		return TestResult::outside == PlanesAABBIntersect(planes, numPlanes, bb.min, bb.max);
+	}
+
 	glm::vec4 Plane(int index) { return mPlanes[index]; }
 };
@@ -9,4 +9,5 @@ public:
 	virtual void setNumRayTraceSamples(int aNumSamples) = 0;
 	virtual bool getRayTraceAugmentTaaDebug() = 0;
 	virtual void setRayTraceAugmentTaaDebug(bool aDebug) = 0;
+	virtual bool hasHardwareRayTracing() = 0;	// false: the CPU ray tracer writes the results from a compute pass
 };
\ No newline at end of file
@@ -11,7 +11,7 @@ void ShadowMap::init(const BoundingBox & aSceneBoundingBox, float camNear, float
 	mTextureSize = aShadowMapTextureSize;
 
 	for (int i = 0; i < MAX_CASCADES; i++) {
-		mCascadeProjMatrix[i] = mCascadeVPMatrix[i] = glm::mat4(1);
+		mCascadeProjMatrix[i] = mCascadeVPMatrix[i] = mCascadeCullProjMatrix[i] = glm::mat4(1);
 	}
 
 	if (autoCalcCascades) calc_cascade_ends();
@@ -19,16 +19,34 @@ void ShadowMap::init(const BoundingBox & aSceneBoundingBox, float camNear, float
 
 void ShadowMap::calc_cascade_ends() {
 	// see article "Cascaded Shadow Maps" by Rouslan Dimitrov for NVIDIA OpenGL SDK sample about CSM
+	// (split the fitted depth range, see set_depth_range)
 	float lambda = .75f;
-	float ratio = mCamFar / mCamNear;
+	float zNear = mCamNear + mRangeBegin * (mCamFar - mCamNear);
+	float zFar  = mCamNear + mRangeEnd   * (mCamFar - mCamNear);
 	for (int i = 1; i < mNumCascades; i++) {
-		float z = lambda * mCamNear * powf(mCamFar / mCamNear, (float)i / mNumCascades) + (1.0f - lambda)*(mCamNear + ((float)i / mNumCascades)*(mCamFar - mCamNear));
-		cascadeEnd[i - 1] = (z - mCamNear) / (mCamFar - mCamNear);
+		float z = lambda * zNear * powf(zFar / zNear, (float)i / mNumCascades) + (1.0f - lambda)*(zNear + ((float)i / mNumCascades)*(zFar - zNear));
+		cascadeEnd[i - 1] = (z - zNear) / (zFar - zNear);
 		//PRINTOUT("z(" << i << ")=" << z << ", cascadeEnd[" << i-1 << "]=" << cascadeEnd[i-1]);
 	}
 	cascadeEnd[mNumCascades - 1] = 1.0f;
 }
 
+void ShadowMap::set_depth_range(float minDepth, float maxDepth)
+{
+	if (minDepth > maxDepth) {
+		mRangeBegin = 0.f;
+		mRangeEnd   = 1.f;
+		return;
+	}
+	// a little margin: the range is from an earlier frame
+	minDepth *= 0.95f;
+	maxDepth *= 1.05f;
+	mRangeBegin = glm::clamp((minDepth - mCamNear) / (mCamFar - mCamNear), 0.f, 1.f);
+	mRangeEnd   = glm::clamp((maxDepth - mCamNear) / (mCamFar - mCamNear), 0.f, 1.f);
+	if (mRangeEnd - mRangeBegin < 1e-4f) mRangeEnd = glm::min(mRangeBegin + 1e-4f, 1.f);
+	if (mRangeEnd - mRangeBegin < 1e-4f) mRangeBegin = mRangeEnd - 1e-4f;
+}
+
 void ShadowMap::calc(const glm::vec3 & aLightDirection, const glm::mat4 & aCamViewMatrix, const glm::mat4 & aCamProjMatrix, std::optional<glm::vec3> aIncludeThisPoint)
 {
 	mCamViewMatrix = aCamViewMatrix;
@@ -61,13 +79,25 @@ void ShadowMap::calcLightView()
 	for (int iCasc = 0; iCasc < mNumCascades; iCasc++) {
 		// get the camera view frustum for the current cascade (in world space)
 		glm::vec4 camFrustPtWS[8];
+		// cascade begin/end as fractions of camera near..far (cascadeEnd is relative to the fitted depth range)
+		auto toCam = [this](float f) { return mRangeBegin + f * (mRangeEnd - mRangeBegin); };
 		float cascBegin;
 		if (cascadeFitMode == CascadeFitMode::fitCascade) {
 			cascBegin = (iCasc == 0) ? 0.0f : cascadeEnd[iCasc - 1];	// new cascade begins where previous cascade ended
 		} else {
 			cascBegin = 0.0f;	// all cascades start at zero
 		}
-		calcPartialCamFrustum(cascBegin, cascadeEnd[iCasc], camFrustPtWS);
+		calcPartialCamFrustum(toCam(cascBegin), toCam(cascadeEnd[iCasc]), camFrustPtWS);
+
+		// caster culling volume: the camera slice of this cascade, extruded towards the light
+		// (always use the slice of this cascade, even with fitScene - anything else is covered by lower cascades)
+		if (cascadeFitMode == CascadeFitMode::fitCascade) {
+			calcCasterCullingPlanes(iCasc, camFrustPtWS);
+		} else {
+			glm::vec4 slicePtWS[8];
+			calcPartialCamFrustum(toCam((iCasc == 0) ? 0.0f : cascadeEnd[iCasc - 1]), toCam(cascadeEnd[iCasc]), slicePtWS);
+			calcCasterCullingPlanes(iCasc, slicePtWS);
+		}
 
 		// convert cam frustum points from world space to light space
 		glm::vec4 camFrustPtLS[8];
@@ -106,18 +136,30 @@ void ShadowMap::calcLightView()
 		// --- now fit the near and far plane
 
 		float nearPlane, farPlane;
+		float cullNearPlane;	// near plane before pancaking
 		if (nearfarFitMode == NearFarFitMode::nffFrustumOnly) {
 			nearPlane = -bb.max.z;
 			farPlane  = -bb.min.z;
+			cullNearPlane = nearPlane;
 		} else {
 			// intersect scene box with light frustum -> gets tighter fit
 			calcNearFar(glm::vec2(bb.min), glm::vec2(bb.max), /* out */ nearPlane, /* out */ farPlane, scenePtLS);
-			// TODO... implement pancaking?
+			cullNearPlane = nearPlane;
+
+			if (nearfarFitMode == NearFarFitMode::nffIntersectAndPancake) {
+				// pancaking: only the receivers (= the cam frustum slice) need to be inside near/far;
+				// casters in front of the near plane are flattened onto it by the shadowmap vertex shaders
+				nearPlane = glm::max(nearPlane, -bb.max.z);
+				farPlane  = glm::min(farPlane,  -bb.min.z);
+				if (nearPlane >= farPlane) { nearPlane = -bb.max.z; farPlane = -bb.min.z; }	// no scene intersection -> just use the slice
+			}
 		}
 
 		// create light projection matrix
 		mCascadeProjMatrix[iCasc] = glm::ortho(bb.min.x, bb.max.x, bb.min.y, bb.max.y, nearPlane, farPlane);
 		mCascadeVPMatrix[iCasc] = mCascadeProjMatrix[iCasc] * mViewMatrix;
+		// for caster culling against the ortho box: casters between the light and a pancaked near plane still cast shadows
+		mCascadeCullProjMatrix[iCasc] = glm::ortho(bb.min.x, bb.max.x, bb.min.y, bb.max.y, glm::min(cullNearPlane, nearPlane), farPlane);
 
 		// calc cascade depth bounds	- TODO: move this out further (init?); when does cam proj change? on screen resize for instance..
 		// TODO: improve performance!
@@ -126,7 +168,7 @@ void ShadowMap::calcLightView()
 		//mCascadeDepthBounds[iCasc] = (p.z / p.w) * .5f + .5f;
 
 		// Vulkan:
-		glm::vec4 p = mCamProjMatrix * glm::vec4(0.0f, 0.0f, mCamNear + cascadeEnd[iCasc] * (mCamFar - mCamNear), 1.0f);
+		glm::vec4 p = mCamProjMatrix * glm::vec4(0.0f, 0.0f, mCamNear + toCam(cascadeEnd[iCasc]) * (mCamFar - mCamNear), 1.0f);
 		mCascadeDepthBounds[iCasc] = (p.z / p.w);
 	}
 
@@ -297,3 +339,63 @@ void ShadowMap::calcPartialCamFrustum(float beginFactor, float endFactor, glm::v
 		out_frustumPoints[i+4] = pts[i] + v * endFactor;
 	}
 }
+
+// calculate the planes of the convex volume swept by the camera frustum slice when extruded (infinitely) towards the light
+// this is the volume that may contain shadow casters for receivers inside the slice; planes are in world space
+void ShadowMap::calcCasterCullingPlanes(int iCasc, const glm::vec4 * camFrustPtWS) {
+	// corner index bits (see getCamFrustum): bit 0 = x (left/right), bit 1 = y (bottom/top), bit 2 = z (near/far)
+	// face index = 2 * axis + bit value of that axis, i.e. 0 = left, 1 = right, 2 = bottom, 3 = top, 4 = near, 5 = far
+	const static int faceIdx[6][3] = {
+		{ 0, 2, 4 }, { 1, 3, 5 },	// left, right
+		{ 0, 1, 4 }, { 2, 3, 6 },	// bottom, top
+		{ 0, 1, 2 }, { 4, 5, 6 },	// near, far
+	};
+
+	glm::vec3 pts[8];
+	glm::vec3 center = glm::vec3(0);
+	for (int i = 0; i < 8; i++) {
+		pts[i] = glm::vec3(camFrustPtWS[i]);
+		center += pts[i] / 8.0f;
+	}
+
+	// orient planes such that the slice center is inside (convention as in FrustumCulling: outside if dot(n,p) + w > 0)
+	auto makePlane = [&center](const glm::vec3 &n, const glm::vec3 &p) {
+		glm::vec4 plane = glm::vec4(n, -glm::dot(n, p));
+		if (glm::dot(n, center) + plane.w > 0.f) plane = -plane;
+		return plane;
+	};
+
+	const glm::vec3 toLight = -mLightDirection;
+	glm::vec4 facePlane[6];
+	bool faceKept[6];
+	int &n = mCascadeNumCasterPlanes[iCasc];
+	n = 0;
+
+	// faces turned away from the light bound the extruded volume, faces towards the light are swept away
+	for (int f = 0; f < 6; f++) {
+		const glm::vec3 &p0 = pts[faceIdx[f][0]];
+		glm::vec3 nrm = glm::normalize(glm::cross(pts[faceIdx[f][1]] - p0, pts[faceIdx[f][2]] - p0));
+		facePlane[f] = makePlane(nrm, p0);
+		faceKept[f] = glm::dot(glm::vec3(facePlane[f]), toLight) <= 0.f;
+		if (faceKept[f]) mCascadeCasterPlanes[iCasc][n++] = facePlane[f];
+	}
+
+	// silhouette edges (between a kept and a swept face) are extruded into planes parallel to the light direction
+	for (int a = 0; a < 8; a++) {
+		for (int axis = 0; axis < 3; axis++) {
+			if (a & (1 << axis)) continue;
+			int b = a | (1 << axis);
+			int adjFace[2], k = 0;
+			for (int j = 0; j < 3; j++) {
+				if (j != axis) adjFace[k++] = 2 * j + ((a >> j) & 1);
+			}
+			if (faceKept[adjFace[0]] == faceKept[adjFace[1]]) continue;
+
+			glm::vec3 nrm = glm::cross(pts[b] - pts[a], toLight);
+			float len = glm::length(nrm);
+			if (len < 1e-6f) continue;	// edge parallel to light direction -> adjacent faces already cover it
+			assert(n < MAX_CASTER_PLANES);
+			mCascadeCasterPlanes[iCasc][n++] = makePlane(nrm / len, pts[a]);
+		}
+	}
+}
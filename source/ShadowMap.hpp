@@ -5,6 +5,7 @@
 class ShadowMap {
 public:
 	static const int MAX_CASCADES = 4;
+	static const int MAX_CASTER_PLANES = 10;	// planes of the extruded cascade volume (kept slice faces + silhouette planes)
 private:
 	glm::mat4 mViewMatrix;
 	int mNumCascades;
@@ -12,8 +13,12 @@ private:
 	int mTextureSize;
 
 	glm::mat4 mCascadeProjMatrix[MAX_CASCADES];
+	glm::mat4 mCascadeCullProjMatrix[MAX_CASCADES];	// = mCascadeProjMatrix, but with the near plane before pancaking
 	glm::mat4 mCascadeVPMatrix[MAX_CASCADES];
 	float mCascadeDepthBounds[MAX_CASCADES];
+	glm::vec4 mCascadeCasterPlanes[MAX_CASCADES][MAX_CASTER_PLANES];	// world space, .xyz = outward normal, .w = distance
+	int mCascadeNumCasterPlanes[MAX_CASCADES];
+	float mRangeBegin = 0.f, mRangeEnd = 1.f;	// fitted depth range, as fractions of camera near..far (see set_depth_range)
 
 	BoundingBox mSceneBoundingBox;
 
@@ -26,22 +31,31 @@ private:
 	void calcNearFar(glm::vec2 lightMin, glm::vec2 lightMax, float &out_near, float &out_far, glm::vec4 *scenePtsLS);
 	void getCamFrustum(glm::vec4 *out_frustumPoints);
 	void calcPartialCamFrustum(float beginFactor, float endFactor, glm::vec4 *out_frustumPoints);
+	void calcCasterCullingPlanes(int iCasc, const glm::vec4 *camFrustPtWS);
 
 public:
 	enum class CascadeFitMode {fitCascade, fitScene};
-	enum class NearFarFitMode {nffFrustumOnly, nffIntersect, /* nffIntersectAndPancake */};
+	enum class NearFarFitMode {nffFrustumOnly, nffIntersect, nffIntersectAndPancake};
 
 	// params
 	float cascadeEnd[MAX_CASCADES] = {0.005f, 0.02f, 0.10f, 1.0f};	// only used if autoCalcCascades is false in init()
 	CascadeFitMode cascadeFitMode = CascadeFitMode::fitCascade;
 	bool restrictLightViewToScene = false; // clip frustum to scene? tighter bound, but other problems... not generally recommended by resources
-	NearFarFitMode nearfarFitMode = NearFarFitMode::nffIntersect;
+	NearFarFitMode nearfarFitMode = NearFarFitMode::nffIntersectAndPancake;	// when pancaking, the shadow vertex shaders must clamp casters in front of the near plane
 	bool texelSnapping = true;
 
 	void init(const BoundingBox &aSceneBoundingBox, float camNear, float camFar, int aShadowMapTextureSize, int numCascades, bool autoCalcCascades);
 	void calc(const glm::vec3 &aLightDirection, const glm::mat4 &aCamViewMatrix, const glm::mat4 &aCamProjMatrix, std::optional<glm::vec3> aIncludeThisPoint = std::nullopt);
 	void calc_cascade_ends();
+	// fit the cascades to the visible depth range (view space depth, e.g. from the depth pyramid) instead of the whole camera frustum;
+	// cascadeEnd is relative to that range then; minDepth > maxDepth: whole frustum
+	void set_depth_range(float minDepth, float maxDepth);
 	glm::mat4 view_matrix() { return mViewMatrix; }
 	glm::mat4 projection_matrix(int cascade = 0) { return mCascadeProjMatrix[cascade]; }
+	// light ortho box for caster culling (not pancaked)
+	glm::mat4 culling_projection_matrix(int cascade = 0) { return mCascadeCullProjMatrix[cascade]; }
 	float max_depth(int cascade) { return mCascadeDepthBounds[cascade]; }
+	bool pancaking() { return nearfarFitMode == NearFarFitMode::nffIntersectAndPancake; }
+	// planes of the cascade's camera slice, extruded towards the light - casters outside can't shadow anything visible in that cascade
+	int caster_culling_planes(int cascade, const glm::vec4 **out_planes) { *out_planes = mCascadeCasterPlanes[cascade]; return mCascadeNumCasterPlanes[cascade]; }
 };
@@ -367,17 +367,18 @@ namespace helpers
 		return *std::get<0>(iter->second);
 	}
 
-	static void record_timing_interval_start(const vk::CommandBuffer& aCommandBuffer, const std::string& aName)
+	// aStage: eAllGraphics is not supported on compute-only queues, use eAllCommands there
+	static void record_timing_interval_start(const vk::CommandBuffer& aCommandBuffer, const std::string& aName, vk::PipelineStageFlagBits aStage = vk::PipelineStageFlagBits::eAllGraphics)
 	{
 		auto& queryPool = add_timing_interval_and_get_query_pool(aName);
 		aCommandBuffer.resetQueryPool(queryPool, 0u, 2u);
-		aCommandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eAllGraphics, queryPool, 0u);
+		aCommandBuffer.writeTimestamp(aStage, queryPool, 0u);
 	}
 
-	static void record_timing_interval_end(const vk::CommandBuffer& aCommandBuffer, const std::string& aName)
+	static void record_timing_interval_end(const vk::CommandBuffer& aCommandBuffer, const std::string& aName, vk::PipelineStageFlagBits aStage = vk::PipelineStageFlagBits::eAllGraphics)
 	{
 		auto& queryPool = add_timing_interval_and_get_query_pool(aName);
-		aCommandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eAllGraphics, queryPool, 1u);
+		aCommandBuffer.writeTimestamp(aStage, queryPool, 1u);
 	}
 
 	// request last timing interval from GPU and return averaged interval from previous measurements (in ms)
@@ -2,6 +2,8 @@
 #include <imgui_impl_vulkan.h>
 #include <portable-file-dialogs.h>
 #include <string>
+#include <fstream>
+#include <glm/gtc/packing.hpp>
 
 #include "rdoc_helper.hpp"
 #include "imgui_helper.hpp"
@@ -14,6 +16,8 @@
 #include "BoundingBox.hpp"
 #include "ShadowMap.hpp"
 #include "FrustumCulling.hpp"
+#include "CpuSkinning.hpp"
+#include "CpuRayTracer.hpp"
 #include "RayTraceCallback.h"
 
 // for implementing/testing new features in gvk/avk, which are not yet merged to master
@@ -30,6 +34,10 @@
 #error "Variable rate shading only supported for forward rendering for now"
 #endif
 
+#if (!FORWARD_RENDERING) && COMPACT_GBUFFER
+#error "The compact G-buffer has no uv coordinates for the deferred lighting pass, set COMPACT_GBUFFER to 0 in shader_cpu_common.h"
+#endif
+
 // use the gvk updater for shader hot reloading and window resizing ?
 #define USE_GVK_UPDATER 1
 
@@ -62,20 +70,9 @@
 #if ENABLE_RAYTRACING
 #define RAYTRACING_DESCRIPTOR_BINDINGS(fif_)		descriptor_binding(0,  0, mMaterialBuffer),													\
 													descriptor_binding(0,  1, mImageSamplers),													\
-													descriptor_binding(0,  2, avk::as_uniform_texel_buffer_views(mRtIndexBuffersArray)),		\
-													descriptor_binding(0,  3, avk::as_uniform_texel_buffer_views(mRtTexCoordBuffersArray)),		\
-													descriptor_binding(0,  4, mRtMaterialIndexBuffer),											\
+													descriptor_binding(0,  2, mRtGeometryInfoBuffer[fif_]),										\
 													descriptor_binding(0,  5, mMatricesUserInputBuffer[fif_]),									\
-													descriptor_binding(0,  6, avk::as_uniform_texel_buffer_views(mRtNormalsBuffersArray)),		\
 													descriptor_binding(0,  7, mRtPixelOffsetBuffer),											\
-													descriptor_binding(0,  8, mRtAnimObjNormalsBufferView[fif_]),								\
-													descriptor_binding(0,  9, mRtAnimObjNTBOffsetBuffer[fif_]),									\
-													descriptor_binding(0, 10, avk::as_uniform_texel_buffer_views(mRtTangentsBuffersArray)),		\
-													descriptor_binding(0, 11, avk::as_uniform_texel_buffer_views(mRtBitangentsBuffersArray)),	\
-													descriptor_binding(0, 12, mRtAnimObjTangentsBufferView[fif_]),								\
-													descriptor_binding(0, 13, mRtAnimObjBitangentsBufferView[fif_]),							\
-													descriptor_binding(0, 14, avk::as_uniform_texel_buffer_views(mRtPositionsBuffersArray)),	\
-													descriptor_binding(0, 15, mRtAnimObjPositionsBufferView[fif_]),								\
 													descriptor_binding(1,  0, mRtImageViews[fif_]->as_storage_image()),							\
 													descriptor_binding(2,  0, mSceneData.mTLASs[fif_])
 #endif
@@ -97,6 +94,13 @@
 
 class wookiee : public gvk::invokee, public RayTraceCallback
 {
+public:
+	static const uint32_t cConcurrentFrames = 3u;
+	static const uint32_t cSwapchainImages  = 3u;
+	static const uint32_t cBakedAnimMagic   = 0x32414254u;	// "TBA2", baked animation cache files
+	static constexpr const char *cBakedAnimCacheDir = "cache/bonecache";	// relative to the working directory, created on demand
+
+private:
 	// Struct definition for data used as UBO across different pipelines, containing matrices and user input
 	struct matrices_and_user_input
 	{
@@ -125,7 +129,8 @@ class wookiee : public gvk::invokee, public RayTraceCallback
 		VkBool32 mUseShadowMap;
 		float mShadowBias;
 		int mShadowNumCascades;
-		float pad1, pad2;
+		VkBool32 mShadowPancaking;
+		float pad2;
 	};
 
 	// Struct definition for data used as UBO across different pipelines, containing lightsource data
@@ -169,8 +174,17 @@ class wookiee : public gvk::invokee, public RayTraceCallback
 
 		int mMaterialIndex;
 
+		// animated objects only: vertex data in object space, skinned by skinning.comp; used for raster, shadowmap and BLAS building
+		std::array<avk::buffer, cConcurrentFrames> mSkinnedPositionsBuffer;
+		std::array<avk::buffer, cConcurrentFrames> mSkinnedPrevPositionsBuffer;	// skinned with previous frame's bone matrices (for velocity)
+		std::array<avk::buffer, cConcurrentFrames> mSkinnedNormalsBuffer;
+		std::array<avk::buffer, cConcurrentFrames> mSkinnedTangentsBuffer;
+		std::array<avk::buffer, cConcurrentFrames> mSkinnedBitangentsBuffer;
+
 #if ENABLE_RAYTRACING
-		avk::bottom_level_acceleration_structure mBLAS;
+		std::array<avk::bottom_level_acceleration_structure, cConcurrentFrames> mBLAS;	// animated objects: one per frame in flight, refitted in place; static objects: all share the same
+		avk::buffer mBlasIndexBuffer;		// BLAS build inputs, uploaded once
+		avk::buffer mBlasPositionsBuffer;	// unskinned positions (initial build); animated objects are refitted from mSkinnedPositionsBuffer
 #endif
 	};
 
@@ -196,12 +210,49 @@ class wookiee : public gvk::invokee, public RayTraceCallback
 		std::vector<glm::mat4> mBoneMatrices;				// [(mesh0,mat0),...(mesh0,matMAX_BONES-1),(mesh1,mat0),...]		// TODO: is this really per mesh, or should it be per "part" ?
 		std::vector<glm::mat4> mBoneMatricesPrev;
 
+		// optional baked animations: bone matrices sampled at a fixed rate, [frame * mBoneMatrices.size() + i]
+		struct baked_animation {
+			float  fps       = 0.f;
+			double startTime = 0.0;
+			int    numFrames = 0;
+			std::vector<glm::mat4> matrices;
+		};
+		std::vector<baked_animation> mBakedAnimations;		// per animation; numFrames == 0 -> not baked yet
+		std::vector<uint64_t> mBakeCacheKeys;				// per animation: model file (path, size, mtime) + clip, see bake_cache_key
+		std::string mBakeCacheBaseName;						// disk cache file name prefix (model file name)
+
+		// bone matrices of the current/previous frame: point into mBoneMatrices(Prev) or into a baked table
+		const glm::mat4 *mCurBoneMatrices  = nullptr;
+		const glm::mat4 *mPrevBoneMatrices = nullptr;
+
 		float mAnimTime = 0.f;				// set by application
 
 		bool mIsInAccelerationStructure = false;	// is this included in the current acceleration structure?
 		glm::mat4 mMovementMatrix_in_AS;
 		uint32_t mRtCustomIndexBase;				// geometry indices custom index base value for this dynObj, actual custom indices = base + meshIndex
+
+		// BLAS refit/rebuild bookkeeping (animated objects), per frame in flight
+		std::array<int, cConcurrentFrames> mBlasRefitsSinceRebuild = {};
+		std::array<std::vector<glm::mat4>, cConcurrentFrames> mBlasRebuildPose;	// bone matrices the BLAS was last fully built for
+		float mBoundingRadius = 0.f;				// max. distance of a vertex from the object origin (unskinned)
+	};
+
+#if ENABLE_RAYTRACING
+	// BLAS without an avk object (static scene geometry, compacted - see build_static_blases)
+	struct static_blas {
+		avk::buffer mStorage;
+		vk::UniqueHandle<vk::AccelerationStructureKHR, vk::DispatchLoaderDynamic> mHandle;
+		vk::DeviceAddress mDeviceAddress = 0;
+	};
+
+	// geometry addresses for the hit shaders, one per ray tracing custom index (see RtGeometryInfo in shader_raytrace_geometry.glsl)
+	struct rt_geometry_info {
+		vk::DeviceAddress mIndices, mPositions, mTexCoords, mNormals, mTangents, mBitangents;
+		uint32_t mMaterialIndex;
+		uint32_t pad0, pad1, pad2;
 	};
+	static_assert(sizeof(rt_geometry_info) == 64, "rt_geometry_info must match the GLSL struct");
+#endif
 
 	// push constants for DrawIndexedIndirect (also used for single dynamic models)
 	struct push_constant_data_for_dii {
@@ -213,6 +264,17 @@ class wookiee : public gvk::invokee, public RayTraceCallback
 		int       mShadowMapCascadeToBuild;
 	};
 
+	struct push_constant_data_for_skinning {
+		uint32_t mMeshIndex;	// mesh index within the animated object (-> bone matrices base index)
+		uint32_t mNumVertices;
+	};
+
+	struct push_constant_data_for_rt_cpu_merge {
+		glm::ivec2 mResolution;
+		uint32_t   mMode;		// 0 = full ray trace test, 1 = TAA augmentation (full-screen), 2 = TAA augmentation (pixel list)
+		uint32_t   pad;
+	};
+
 	struct push_constant_data_for_rt {
 		glm::mat4 mCameraTransform;
 		glm::mat4 mCameraViewProjMatrix;
@@ -222,14 +284,17 @@ class wookiee : public gvk::invokee, public RayTraceCallback
 		float mNormalMappingStrength;
 		float mMaxRayLength;
 		int  mNumSamples;
-		int  mAnimObjFirstMeshId;
-		int  mAnimObjNumMeshes;
 		uint32_t mDoShadows;		// bit 0: general shadows, bit 1: shadows of transp. objs
 		VkBool32 mAugmentTAA;
 		VkBool32 mAugmentTAADebug;
 		VkBool32 mApproximateLod;
 		int mApproximateLodMaxAnisotropy;
-		float pad1, pad2;
+		glm::ivec2 mResolution;		// target image resolution (the launch size is the pixel count when tracing a pixel list)
+		VkBool32 mAugmentTAAList;	// trace the pixels in the compacted list (set 3, binding 2) only
+		float mShadowRayLength;		// = mMaxRayLength, unless shortened for the reduced TLAS
+		glm::vec2 mJitterNdc;		// TAA jitter of the current frame, for mTemporalSampling
+		VkBool32 mTemporalSampling;	// sample at the TAA jitter offset (mirrored for the 2nd sample) instead of the supersampling offsets
+		uint32_t pad0;
 	};
 
 	struct CullingBoundingBox {
@@ -241,13 +306,25 @@ class wookiee : public gvk::invokee, public RayTraceCallback
 		uint32_t  numInstances;
 		uint32_t  numFrusta;
 		uint32_t  drawcmdbuf_FirstTransparentIndex;  // index (not offset!) where transparent draw commands shall start in the produced DrawCommandsBuffer
-		glm::vec4 frustumPlanes[5*6];	             // frustum planes, 6 per frustum (frustum #0 = main camera, #1 - #5 = shadow cascades)
+		glm::vec4 frustumPlanes[5*CULLING_PLANES_PER_FRUSTUM];	// frustum planes, CULLING_PLANES_PER_FRUSTUM per frustum (frustum #0 = main camera, #1 - #5 = shadow cascades)
+		glm::mat4 pyramidProjViewMatrix;	// occlusion culling: camera of the depth pyramid (previous frame)
+		uint32_t  occlusionCulling;
+		float     pyramidNearPlane;
+		float     occlusionBias;
+		float     pad1;
 	} ubo;
 
 	struct BuildSceneBuffersPushConstants {
 		uint32_t frustum;	// 0 = main camera, 1 - 5 = shadow cascades
 	};
 
+	struct DepthPyramidPushConstants {	// see depth_pyramid.comp
+		uint32_t mLevel;
+		float    mCamNearPlane;
+		float    mCamFarPlane;
+		float    pad1;
+	};
+
 	struct MeshgroupBasicInfoGpu {
 		uint32_t materialIndex;
 		uint32_t numInstances;
@@ -282,7 +359,7 @@ class wookiee : public gvk::invokee, public RayTraceCallback
 		BoundingBox boundingBox_untransformed;
 
 		struct {
-			avk::buffer rtIndexBuffer, rtPositionBuffer;
+			vk::DeviceSize rtFirstIndex, rtFirstVertex;		// offsets into the scene-wide ray tracing geometry buffers
 			std::vector<uint32_t>  rtIndexData;
 			std::vector<glm::vec3> rtPositionData;
 			std::vector<glm::vec2> rtTexCoordData;
@@ -338,9 +415,6 @@ class wookiee : public gvk::invokee, public RayTraceCallback
 
 
 public: // v== cgb::cg_element overrides which will be invoked by the framework ==v
-	static const uint32_t cConcurrentFrames = 3u;
-	static const uint32_t cSwapchainImages  = 3u;
-
 	std::string mSceneFileName = "assets/sponza_with_plants_and_terrain.fscene";
 	bool mDisableMip = false;
 	bool mUseAlphaBlending = false;
@@ -360,9 +434,9 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 
 	bool mHideWindowOnLoad = false;
 
-	wookiee(avk::queue& aQueue)
+	wookiee(avk::queue& aQueue, avk::queue* aComputeQueue = nullptr)
 		: mQueue{ &aQueue }
-		, mAntiAliasing{ &aQueue }
+		, mAntiAliasing{ &aQueue, aComputeQueue }
 	{}
 
 	void ray_trace_callback(avk::command_buffer &cmd) {
@@ -377,6 +451,11 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 	virtual void setNumRayTraceSamples(int aNumSamples) { mRtSamplesPerPixel = glm::clamp(aNumSamples, 1, RAYTRACING_MAX_SAMPLES_PER_PIXEL); };
 	virtual bool getRayTraceAugmentTaaDebug() { return mRtDebugSparse; };
 	virtual void setRayTraceAugmentTaaDebug(bool aDebug) { mRtDebugSparse = aDebug; };
+#if ENABLE_RAYTRACING
+	virtual bool hasHardwareRayTracing() { return mHardwareRayTracing; };
+#else
+	virtual bool hasHardwareRayTracing() { return false; };
+#endif
 
 
 	void prepare_matrices_ubo()
@@ -414,6 +493,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		mMatricesAndUserInput.mUseShadowMap			= mShadowMap.enable;
 		mMatricesAndUserInput.mShadowBias			= mShadowMap.bias;
 		mMatricesAndUserInput.mShadowNumCascades	= mShadowMap.numCascades;
+		mMatricesAndUserInput.mShadowPancaking		= mShadowMap.shadowMapUtil.pancaking();
 
 		mMatricesAndUserInput.mDebugCamProjViewMatrix = effectiveCam_proj_matrix() * effectiveCam_view_matrix(); // for drawing frustum
 
@@ -509,36 +589,420 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		}
 	}
 
+	// identifies the source of a baked animation: a cache file is only used if the model file and the clip are unchanged
+	static uint64_t bake_cache_key(const std::string &modelFile, int animId, const gvk::animation_clip_data &clip, size_t matricesPerFrame)
+	{
+		uint64_t h = 0xcbf29ce484222325ull;	// FNV-1a
+		auto add = [&h](const void *data, size_t size) {
+			for (size_t i = 0; i < size; ++i) { h ^= static_cast<const uint8_t*>(data)[i]; h *= 0x100000001b3ull; }
+		};
+		std::error_code ec;
+		auto absPath = std::filesystem::absolute(modelFile, ec).generic_string();
+		auto size    = static_cast<uint64_t>(std::filesystem::file_size(modelFile, ec));
+		auto mtime   = static_cast<int64_t>(std::filesystem::last_write_time(modelFile, ec).time_since_epoch().count());
+		add(absPath.data(), absPath.size());
+		add(&size,  sizeof(size));
+		add(&mtime, sizeof(mtime));
+		add(&animId, sizeof(animId));
+		add(&clip.mStartTicks,     sizeof(clip.mStartTicks));
+		add(&clip.mEndTicks,       sizeof(clip.mEndTicks));
+		add(&clip.mTicksPerSecond, sizeof(clip.mTicksPerSecond));
+		add(&matricesPerFrame,     sizeof(matricesPerFrame));
+		return h;
+	}
+
+	bool load_baked_animation(const std::string &filename, dynamic_object::baked_animation &baked, float fps, size_t matricesPerFrame, uint64_t key)
+	{
+		std::ifstream f(filename, std::ios::binary);
+		if (!f) return false;
+		uint32_t magic = 0, numFrames = 0; uint64_t numMat = 0, fileKey = 0; float fileFps = 0.f; double startTime = 0.0;
+		f.read(reinterpret_cast<char*>(&magic),     sizeof(magic));
+		f.read(reinterpret_cast<char*>(&fileKey),   sizeof(fileKey));
+		f.read(reinterpret_cast<char*>(&fileFps),   sizeof(fileFps));
+		f.read(reinterpret_cast<char*>(&startTime), sizeof(startTime));
+		f.read(reinterpret_cast<char*>(&numFrames), sizeof(numFrames));
+		f.read(reinterpret_cast<char*>(&numMat),    sizeof(numMat));
+		if (!f || magic != cBakedAnimMagic || fileKey != key || fileFps != fps || numMat != matricesPerFrame || numFrames == 0) return false;
+		std::vector<glm::mat4> matrices(size_t{numFrames} * matricesPerFrame);
+		f.read(reinterpret_cast<char*>(matrices.data()), matrices.size() * sizeof(glm::mat4));
+		if (!f) return false;
+		baked.fps       = fps;
+		baked.startTime = startTime;
+		baked.numFrames = static_cast<int>(numFrames);
+		baked.matrices  = std::move(matrices);
+		return true;
+	}
+
+	void save_baked_animation(const std::string &filename, const dynamic_object::baked_animation &baked, size_t matricesPerFrame, uint64_t key)
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), ec);
+		std::ofstream f(filename, std::ios::binary | std::ios::trunc);
+		if (!f) { LOG_WARNING("Could not write baked animation cache \"" + filename + "\""); return; }
+		uint32_t magic = cBakedAnimMagic, numFrames = static_cast<uint32_t>(baked.numFrames); uint64_t numMat = matricesPerFrame;
+		f.write(reinterpret_cast<const char*>(&magic),           sizeof(magic));
+		f.write(reinterpret_cast<const char*>(&key),             sizeof(key));
+		f.write(reinterpret_cast<const char*>(&baked.fps),       sizeof(baked.fps));
+		f.write(reinterpret_cast<const char*>(&baked.startTime), sizeof(baked.startTime));
+		f.write(reinterpret_cast<const char*>(&numFrames),       sizeof(numFrames));
+		f.write(reinterpret_cast<const char*>(&numMat),          sizeof(numMat));
+		f.write(reinterpret_cast<const char*>(baked.matrices.data()), baked.matrices.size() * sizeof(glm::mat4));
+	}
+
+	const dynamic_object::baked_animation & get_baked_animation(dynamic_object &dynObj, int animIndex)
+	{
+		// bake on first use (or load from the disk cache)
+		if (dynObj.mBakedAnimations.size() <= static_cast<size_t>(animIndex)) dynObj.mBakedAnimations.resize(animIndex + 1);
+		auto &baked = dynObj.mBakedAnimations[animIndex];
+		const float fps = std::max(1.f, mMovingObject.bakeFps);
+		if (baked.numFrames > 0 && baked.fps == fps) return baked;
+
+		dynObj.mCurBoneMatrices = dynObj.mPrevBoneMatrices = nullptr;	// might point into the old table
+		const size_t n = dynObj.mBoneMatrices.size();
+		const uint64_t key = dynObj.mBakeCacheKeys[animIndex];
+		std::string cacheFile = fmt::format("{}/{}.{:016x}.{}fps.bonecache", cBakedAnimCacheDir, dynObj.mBakeCacheBaseName, key, static_cast<int>(fps));
+		if (mMovingObject.bakeDiskCache && load_baked_animation(cacheFile, baked, fps, n, key)) {
+			std::cout << "Loaded baked animation from \"" << cacheFile << "\"" << std::endl;
+			return baked;
+		}
+
+		auto &clip = dynObj.mAnimClips[animIndex];
+		double tStart = clip.mStartTicks / clip.mTicksPerSecond;
+		double tEnd   = clip.mEndTicks   / clip.mTicksPerSecond;
+		baked.fps       = fps;
+		baked.startTime = tStart;
+		baked.numFrames = static_cast<int>(std::ceil((tEnd - tStart) * fps)) + 1;
+		baked.matrices.assign(static_cast<size_t>(baked.numFrames) * n, glm::mat4(0));
+		for (int iFrame = 0; iFrame < baked.numFrames; ++iFrame) {
+			dynObj.mAnimations[animIndex].animate_into_strided_target_per_mesh(
+				clip,
+				std::min(tStart + iFrame / static_cast<double>(fps), tEnd),
+				gvk::bone_matrices_space::model_space,
+				baked.matrices.data() + iFrame * n,
+				size_t{MAX_BONES} * sizeof(glm::mat4)
+			);
+		}
+		std::cout << "Baked animation: " << baked.numFrames << " frames at " << fps << " fps" << std::endl;
+		if (mMovingObject.bakeDiskCache) save_baked_animation(cacheFile, baked, n, key);
+		return baked;
+	}
+
 	void update_bone_matrices()
 	{
 		if (!mMovingObject.enabled) return;
 		auto &dynObj = mDynObjects[mMovingObject.moverId];
 		if (!dynObj.mIsAnimated) return;
-		auto anim = dynObj.mAnimations[dynObj.mActiveAnimation];
 
-		// keep matrices of previous frame
-		dynObj.mBoneMatricesPrev = dynObj.mBoneMatrices;
-		
-		for (auto &m : dynObj.mBoneMatrices) m = glm::mat4(0);
-		anim.animate_into_strided_target_per_mesh(
-			dynObj.mAnimClips[dynObj.mActiveAnimation], 
-			static_cast<double>(dynObj.mAnimTime), 
-			gvk::bone_matrices_space::model_space,
-			dynObj.mBoneMatrices.data(),
-			size_t{MAX_BONES} * sizeof(glm::mat4) // Stride between two consecutive sets of bonem atrices
-		); // fill bone matrix data (-> dc.mBoneMatrices) in object space
-
-		static bool firstTime = true;
-		if (firstTime) {
-			// first time init	// FIXME_DYNOBJ - this check is not sufficient
-			dynObj.mBoneMatricesPrev = dynObj.mBoneMatrices;
-			firstTime = false;
-		};
+		const size_t n = dynObj.mBoneMatrices.size();
+
+		// the previous frame's matrices stay where they are; only swap vectors if we wrote into mBoneMatrices last frame (no copy)
+		if (dynObj.mCurBoneMatrices == dynObj.mBoneMatrices.data()) {
+			std::swap(dynObj.mBoneMatrices, dynObj.mBoneMatricesPrev);
+			dynObj.mCurBoneMatrices = dynObj.mBoneMatricesPrev.data();
+		}
+		const glm::mat4 *lastBoneMatrices = dynObj.mCurBoneMatrices;
+
+		if (mMovingObject.bakedAnimation) {
+			auto &baked = get_baked_animation(dynObj, dynObj.mActiveAnimation);
+			lastBoneMatrices = dynObj.mCurBoneMatrices;	// reset if (re-)baked
+			float frame = glm::clamp(static_cast<float>((dynObj.mAnimTime - baked.startTime) * baked.fps), 0.f, static_cast<float>(baked.numFrames - 1));
+			int   f0    = static_cast<int>(frame);
+			int   f1    = std::min(f0 + 1, baked.numFrames - 1);
+			float alpha = frame - static_cast<float>(f0);
+			if (mMovingObject.bakeSnapToFrame || alpha == 0.f) {
+				// deterministic: use the baked frame directly
+				int f = mMovingObject.bakeSnapToFrame ? static_cast<int>(std::round(frame)) : f0;
+				dynObj.mCurBoneMatrices = baked.matrices.data() + f * n;
+			} else {
+				const glm::mat4 *m0 = baked.matrices.data() + f0 * n;
+				const glm::mat4 *m1 = baked.matrices.data() + f1 * n;
+				for (size_t i = 0; i < n; ++i) dynObj.mBoneMatrices[i] = m0[i] * (1.f - alpha) + m1[i] * alpha;
+				dynObj.mCurBoneMatrices = dynObj.mBoneMatrices.data();
+			}
+		} else {
+			auto &anim = dynObj.mAnimations[dynObj.mActiveAnimation];
+			for (auto &m : dynObj.mBoneMatrices) m = glm::mat4(0);
+			anim.animate_into_strided_target_per_mesh(
+				dynObj.mAnimClips[dynObj.mActiveAnimation], 
+				static_cast<double>(dynObj.mAnimTime), 
+				gvk::bone_matrices_space::model_space,
+				dynObj.mBoneMatrices.data(),
+				size_t{MAX_BONES} * sizeof(glm::mat4) // Stride between two consecutive sets of bonem atrices
+			); // fill bone matrix data (-> dc.mBoneMatrices) in object space
+			dynObj.mCurBoneMatrices = dynObj.mBoneMatrices.data();
+		}
+
+		// first time init	// FIXME_DYNOBJ - this check is not sufficient (object was inactive)
+		dynObj.mPrevBoneMatrices = lastBoneMatrices ? lastBoneMatrices : dynObj.mCurBoneMatrices;
 
 		const auto inFlightIndex = gvk::context().main_window()->in_flight_index_for_frame();
 		// must use the overloaded fill method and specify size, because the bone matrix vectors are differently sized for different dynObjects !
-		mBoneMatricesBuffer    [inFlightIndex]->fill(dynObj.mBoneMatrices.    data(), 0, 0, dynObj.mBoneMatrices.size()     * sizeof(glm::mat4), avk::sync::not_required());
-		mBoneMatricesPrevBuffer[inFlightIndex]->fill(dynObj.mBoneMatricesPrev.data(), 0, 0, dynObj.mBoneMatricesPrev.size() * sizeof(glm::mat4), avk::sync::not_required());
+		mBoneMatricesBuffer    [inFlightIndex]->fill(dynObj.mCurBoneMatrices,  0, 0, n * sizeof(glm::mat4), avk::sync::not_required());
+		mBoneMatricesPrevBuffer[inFlightIndex]->fill(dynObj.mPrevBoneMatrices, 0, 0, n * sizeof(glm::mat4), avk::sync::not_required());
+	}
+
+	void prepare_cpu_skinning()
+	{
+		// point the CPU skinning at the current mover's meshes (the outputs are allocated once here)
+		auto &dynObj = mDynObjects[mMovingObject.moverId];
+		std::vector<CpuSkinning::MeshInput> meshes;
+		for (auto &md : dynObj.mMeshData) {
+			meshes.push_back({ md.mPositions.data(), md.mNormals.data(), md.mTangents.data(), md.mBitangents.data(), md.mBoneWeights.data(), md.mBoneIndices.data(), md.mPositions.size() });
+		}
+		mCpuSkinning.setMeshes(meshes);
+		mCpuSkinningMoverId = mMovingObject.moverId;
+	}
+
+	void compute_skinning()
+	{
+		// skin the animated object once per frame; the results are used by the raster passes (incl. shadows), the BLAS update and the ray tracer's NTB buffers
+		if (!mMovingObject.enabled) return;
+		auto &dynObj = mDynObjects[mMovingObject.moverId];
+		if (!dynObj.mIsAnimated) return;
+		if (!mPipelineSkinning.has_value()) return;
+
+		using namespace avk;
+		using namespace gvk;
+
+		auto mainWnd = context().main_window();
+		auto fif = mainWnd->in_flight_index_for_frame();
+
+		// optionally skin on the CPU and upload the results
+		if (mMovingObject.cpuSkinning) {
+			if (mCpuSkinningMoverId != mMovingObject.moverId) prepare_cpu_skinning();
+			double t0 = context().get_time();
+			mCpuSkinning.skin(dynObj.mCurBoneMatrices, dynObj.mPrevBoneMatrices, MAX_BONES);
+			mCpuSkinningStats.lastMs = static_cast<float>((context().get_time() - t0) * 1000.0);
+			for (int iMesh = 0; iMesh < dynObj.mMeshData.size(); ++iMesh) {
+				auto &md  = dynObj.mMeshData[iMesh];
+				auto &out = mCpuSkinning.output(iMesh);
+				md.mSkinnedPositionsBuffer    [fif]->fill(out.positions.    data(), 0, sync::with_barriers(mainWnd->command_buffer_lifetime_handler()));
+				md.mSkinnedPrevPositionsBuffer[fif]->fill(out.prevPositions.data(), 0, sync::with_barriers(mainWnd->command_buffer_lifetime_handler()));
+				md.mSkinnedNormalsBuffer      [fif]->fill(out.normals.      data(), 0, sync::with_barriers(mainWnd->command_buffer_lifetime_handler()));
+				md.mSkinnedTangentsBuffer     [fif]->fill(out.tangents.     data(), 0, sync::with_barriers(mainWnd->command_buffer_lifetime_handler()));
+				md.mSkinnedBitangentsBuffer   [fif]->fill(out.bitangents.   data(), 0, sync::with_barriers(mainWnd->command_buffer_lifetime_handler()));
+			}
+		}
+
+		auto& commandPool = context().get_command_pool_for_single_use_command_buffers(*mQueue);
+		auto cmd = commandPool->alloc_command_buffer(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+		cmd->begin_recording();
+		rdoc::beginSection(cmd->handle(), "Skinning", fif);
+
+		// the skinned buffers were written either by the compute shader or by the uploads above
+		auto srcStage  = mMovingObject.cpuSkinning ? pipeline_stage::transfer              : pipeline_stage::compute_shader;
+		auto srcAccess = mMovingObject.cpuSkinning ? memory_access::transfer_write_access  : memory_access::shader_buffers_and_images_write_access;
+
+		if (!mMovingObject.cpuSkinning) cmd->bind_pipeline(const_referenced(mPipelineSkinning));
+		for (int iMesh = 0; !mMovingObject.cpuSkinning && iMesh < dynObj.mMeshData.size(); ++iMesh) {
+			auto &md = dynObj.mMeshData[iMesh];
+			cmd->bind_descriptors(mPipelineSkinning->layout(), mDescriptorCache.get_or_create_descriptor_sets({
+				descriptor_binding(0, 0, mBoneMatricesBuffer[fif]),
+				descriptor_binding(0, 1, mBoneMatricesPrevBuffer[fif]),
+				descriptor_binding(1, 0, md.mPositionsBuffer  ->as_storage_buffer()),
+				descriptor_binding(1, 1, md.mNormalsBuffer    ->as_storage_buffer()),
+				descriptor_binding(1, 2, md.mTangentsBuffer   ->as_storage_buffer()),
+				descriptor_binding(1, 3, md.mBitangentsBuffer ->as_storage_buffer()),
+				descriptor_binding(1, 4, md.mBoneWeightsBuffer->as_storage_buffer()),
+				descriptor_binding(1, 5, md.mBoneIndicesBuffer->as_storage_buffer()),
+				descriptor_binding(2, 0, md.mSkinnedPositionsBuffer    [fif]->as_storage_buffer()),
+				descriptor_binding(2, 1, md.mSkinnedPrevPositionsBuffer[fif]->as_storage_buffer()),
+				descriptor_binding(2, 2, md.mSkinnedNormalsBuffer      [fif]->as_storage_buffer()),
+				descriptor_binding(2, 3, md.mSkinnedTangentsBuffer     [fif]->as_storage_buffer()),
+				descriptor_binding(2, 4, md.mSkinnedBitangentsBuffer   [fif]->as_storage_buffer()),
+				}));
+
+			push_constant_data_for_skinning pushc;
+			pushc.mMeshIndex   = static_cast<uint32_t>(iMesh);
+			pushc.mNumVertices = static_cast<uint32_t>(md.mPositions.size());
+			cmd->push_constants(mPipelineSkinning->layout(), pushc);
+			cmd->handle().dispatch((pushc.mNumVertices + SKINNING_WORKGROUP_SIZE - 1) / SKINNING_WORKGROUP_SIZE, 1u, 1u);
+		}
+
+		// skinned buffers are read as vertex attributes, as BLAS build input and (via device address) by the hit shaders
+		cmd->establish_global_memory_barrier(
+			srcStage,  /* -> */ pipeline_stage::vertex_input,
+			srcAccess, /* -> */ memory_access::vertex_attribute_read_access
+		);
+#if ENABLE_RAYTRACING
+		if (mHardwareRayTracing) {
+			cmd->establish_global_memory_barrier(
+				srcStage,  /* -> */ pipeline_stage::acceleration_structure_build | pipeline_stage::ray_tracing_shaders,
+				srcAccess, /* -> */ memory_access::acceleration_structure_read_access | memory_access::shader_buffers_and_images_read_access
+			);
+		}
+#endif
+
+		rdoc::endSection(cmd->handle());
+		cmd->end_recording();
+		mQueue->submit(cmd, std::optional<avk::resource_reference<avk::semaphore_t>>{});
+		mainWnd->handle_lifetime(avk::owned(cmd));
+	}
+
+	size_t crowd_bones_per_instance(const dynamic_object &dynObj) {
+		return dynObj.mIsAnimated ? dynObj.mBoneMatrices.size() : 0;
+	}
+
+	void prepare_crowd_buffers()
+	{
+		// (re)allocate the per-frame crowd buffers for the current count and mover; the bone palettes hold mCrowd.count * bones-per-instance matrices
+		auto &dynObj = mDynObjects[mMovingObject.moverId];
+		size_t numBones = std::max(size_t{1}, static_cast<size_t>(mCrowd.count) * crowd_bones_per_instance(dynObj));
+
+		auto fif = gvk::context().main_window()->number_of_frames_in_flight();
+		for (decltype(fif) i = 0; i < fif; ++i) {
+			if (!mCrowdInstancesBuffer[i].has_value()) {
+				mCrowdInstancesBuffer[i] = gvk::context().create_buffer(avk::memory_usage::host_coherent, {}, avk::storage_buffer_meta::create_from_size(MAX_CROWD_INSTANCES * sizeof(CrowdInstanceGpuData)));
+				rdoc::labelBuffer(mCrowdInstancesBuffer[i]->handle(), "mCrowdInstancesBuffer", i);
+			}
+			mCrowdBonesBuffer    [i] = gvk::context().create_buffer(avk::memory_usage::host_coherent, {}, avk::storage_buffer_meta::create_from_size(numBones * sizeof(glm::mat4)));
+			mCrowdBonesPrevBuffer[i] = gvk::context().create_buffer(avk::memory_usage::host_coherent, {}, avk::storage_buffer_meta::create_from_size(numBones * sizeof(glm::mat4)));
+			rdoc::labelBuffer(mCrowdBonesBuffer    [i]->handle(), "mCrowdBonesBuffer", i);
+			rdoc::labelBuffer(mCrowdBonesPrevBuffer[i]->handle(), "mCrowdBonesPrevBuffer", i);
+		}
+		// the descriptor sets of the old bone buffers must not be reused (a new buffer may even get the old handle): start a new cache;
+		// the old sets are only referenced by command buffers which are re-recorded (callers wait idle and invalidate them)
+		mCrowdDescriptorCache = gvk::context().create_descriptor_cache();
+
+		mCrowdBones    .assign(numBones, glm::mat4(0));
+		mCrowdBonesPrev.assign(numBones, glm::mat4(0));
+		mCrowdInstances.resize(mCrowd.count);
+
+		// random animation phases, reproducible
+		std::default_random_engine rng(12345);
+		std::uniform_real_distribution<float> dist(0.f, 1.f);
+		mCrowdPhases.resize(mCrowd.count);
+		for (auto &ph : mCrowdPhases) ph = dist(rng);
+
+		mCrowdBuffersFor = { mMovingObject.moverId, mCrowd.count };
+		mCrowdFirstFrame = true;
+	}
+
+	// dynamic resolution: every mDynRes.interval frames, scale the render resolution (a sub-rect of the mLoResolution sized
+	// attachments) so that the GPU time of the passes that scale with it (skybox, models) plus TAA/post processing (at the output
+	// resolution) hits the target frame time; their time is assumed to be proportional to the pixel count
+	void update_dynamic_resolution()
+	{
+		auto &d = mDynRes;
+		auto *wnd = gvk::context().main_window();
+		// not with: the RT test and the TAA ray tracing assist (traced at the full input size), no TAA (presents the input image as is),
+		// pre-recorded command buffers
+		const bool active = d.enabled && RERECORD_CMDBUFFERS_ALWAYS && mAntiAliasing.taa_enabled() && !mDoRayTraceTest && !mAntiAliasing.needRayTraceAssist();
+		if (!active) {
+			d.scale  = 1.f;
+			d.frames = 0;
+		} else if (++d.frames >= glm::max(d.interval, 1)) {
+			d.frames = 0;
+			auto fif = wnd->in_flight_index_for_frame();
+			float scaledMs = helpers::get_timing_interval_in_ms(fmt::format("mSkyboxCommandBuffer{} time", fif))
+			               + helpers::get_timing_interval_in_ms(fmt::format("mModelsCommandBuffer{} time", fif));
+			float fixedMs  = mAntiAliasing.duration();
+			d.lastScaledMs = scaledMs;
+			d.lastFixedMs  = fixedMs;
+			if (scaledMs > 0.f) {
+				float pixelRatio = glm::clamp((d.targetMs - fixedMs) / scaledMs, 0.25f, 4.f);
+				float newScale   = glm::clamp(d.scale * glm::mix(1.f, sqrt(pixelRatio), d.damping), glm::clamp(d.minScale, 0.1f, 1.f), 1.f);
+				if (abs(newScale - d.scale) > d.hysteresis || newScale == 1.f) d.scale = newScale;
+			}
+		}
+
+		// even sizes, so the upsampling ratio stays the same in x and y
+		auto res = glm::uvec2(glm::round(glm::vec2(mLoResolution) * d.scale * 0.5f)) * 2u;
+		mRenderResolution = glm::clamp(res, glm::min(glm::uvec2(64), mLoResolution), mLoResolution);
+		mAntiAliasing.set_render_resolution(mRenderResolution, wnd->current_frame());
+	}
+
+	void update_crowd_measurement()
+	{
+		// step through mCrowd.measureCounts, let each count settle, then average frame time and GPU time of the models command buffer
+		auto &m = mCrowdMeasure;
+		if (!m.active) return;
+		const int warmupFrames = 30, measureFrames = 120;
+		double t = gvk::context().get_time();
+		auto fif = gvk::context().main_window()->in_flight_index_for_frame();
+
+		if (m.frame == 0) {
+			mCrowd.enabled = true;
+			mCrowd.count   = m.counts[m.stage];
+			m.sumFrameMs = m.sumGpuMs = m.sumPaletteMs = 0.0;
+		} else if (m.frame > warmupFrames) {
+			m.sumFrameMs   += (t - m.tLast) * 1000.0;
+			m.sumGpuMs     += helpers::get_timing_interval_in_ms(fmt::format("mModelsCommandBuffer{} time", fif));
+			m.sumPaletteMs += mCrowdStats.paletteMs;
+		}
+		m.tLast = t;
+
+		if (++m.frame > warmupFrames + measureFrames) {
+			m.results.push_back({ m.counts[m.stage], static_cast<float>(m.sumFrameMs / measureFrames), static_cast<float>(m.sumGpuMs / measureFrames), static_cast<float>(m.sumPaletteMs / measureFrames) });
+			auto &r = m.results.back();
+			printf("Crowd %4d instances: frame %.3f ms, models cmdbfr (GPU) %.3f ms, bone palettes (CPU) %.3f ms\n", r.count, r.frameMs, r.gpuMs, r.paletteMs);
+			m.frame = 0;
+			if (++m.stage >= static_cast<int>(m.counts.size())) m.active = false;
+		}
+	}
+
+	void update_crowd()
+	{
+		update_crowd_measurement();
+		if (!mCrowd.enabled || !mMovingObject.enabled) return;
+
+		mCrowd.count = glm::clamp(mCrowd.count, 1, MAX_CROWD_INSTANCES);
+		if (mCrowdBuffersFor != std::make_pair(mMovingObject.moverId, mCrowd.count)) {
+			gvk::context().device().waitIdle(); // buffers are in use by frames in flight; ok in THIS application (only on user input)
+			prepare_crowd_buffers();
+			invalidate_command_buffers();
+		}
+
+		auto &dynObj = mDynObjects[mMovingObject.moverId];
+		const size_t n = crowd_bones_per_instance(dynObj);
+		const int cols = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(mCrowd.count))));
+
+		// bone palettes; keep the previous frame's by swapping
+		double t0 = gvk::context().get_time();
+		if (n > 0) {
+			std::swap(mCrowdBones, mCrowdBonesPrev);
+			auto &clip = dynObj.mAnimClips[dynObj.mActiveAnimation];
+			double tMin = clip.mStartTicks / clip.mTicksPerSecond;
+			double tLen = std::max(1e-6, clip.mEndTicks / clip.mTicksPerSecond - tMin);
+			const dynamic_object::baked_animation *baked = mMovingObject.bakedAnimation ? &get_baked_animation(dynObj, dynObj.mActiveAnimation) : nullptr;
+			for (int i = 0; i < mCrowd.count; ++i) {
+				double animTime = tMin + std::fmod(dynObj.mAnimTime - tMin + (mCrowd.randomPhase ? mCrowdPhases[i] * tLen : 0.0), tLen);
+				glm::mat4 *dst = mCrowdBones.data() + i * n;
+				if (baked) {
+					float frame = glm::clamp(static_cast<float>((animTime - baked->startTime) * baked->fps), 0.f, static_cast<float>(baked->numFrames - 1));
+					int   f0    = mMovingObject.bakeSnapToFrame ? static_cast<int>(std::round(frame)) : static_cast<int>(frame);
+					int   f1    = std::min(f0 + 1, baked->numFrames - 1);
+					float alpha = mMovingObject.bakeSnapToFrame ? 0.f : frame - static_cast<float>(f0);
+					const glm::mat4 *m0 = baked->matrices.data() + f0 * n;
+					const glm::mat4 *m1 = baked->matrices.data() + f1 * n;
+					if (alpha == 0.f) std::copy(m0, m0 + n, dst);
+					else for (size_t b = 0; b < n; ++b) dst[b] = m0[b] * (1.f - alpha) + m1[b] * alpha;
+				} else {
+					std::fill(dst, dst + n, glm::mat4(0));
+					dynObj.mAnimations[dynObj.mActiveAnimation].animate_into_strided_target_per_mesh(clip, animTime, gvk::bone_matrices_space::model_space, dst, size_t{MAX_BONES} * sizeof(glm::mat4));
+				}
+			}
+			if (mCrowdFirstFrame) mCrowdBonesPrev = mCrowdBones;
+		}
+		mCrowdStats.paletteMs = static_cast<float>((gvk::context().get_time() - t0) * 1000.0);
+
+		// instances on a grid around the mover, all following its movement
+		for (int i = 0; i < mCrowd.count; ++i) {
+			glm::vec3 offset = mCrowd.spacing * glm::vec3(static_cast<float>(i % cols) - 0.5f * (cols - 1), 0.f, static_cast<float>(i / cols) - 0.5f * (cols - 1));
+			glm::mat4 tr = glm::translate(glm::mat4(1), offset);
+			auto &inst = mCrowdInstances[i];
+			inst.mModelMatrix     = tr * dynObj.mMovementMatrix_current;
+			inst.mModelMatrixPrev = mCrowdFirstFrame ? inst.mModelMatrix : tr * dynObj.mMovementMatrix_prev;
+			inst.mBoneBase        = n > 0 ? static_cast<uint32_t>(i * n) : CROWD_NO_BONES;
+		}
+		mCrowdFirstFrame = false;
+
+		auto fif = gvk::context().main_window()->in_flight_index_for_frame();
+		mCrowdInstancesBuffer[fif]->fill(mCrowdInstances.data(), 0, 0, mCrowdInstances.size() * sizeof(CrowdInstanceGpuData), avk::sync::not_required());
+		if (n > 0) {
+			mCrowdBonesBuffer    [fif]->fill(mCrowdBones.    data(), 0, 0, mCrowdBones.    size() * sizeof(glm::mat4), avk::sync::not_required());
+			mCrowdBonesPrevBuffer[fif]->fill(mCrowdBonesPrev.data(), 0, 0, mCrowdBonesPrev.size() * sizeof(glm::mat4), avk::sync::not_required());
+		}
 	}
 
 	void update_camera_path_draw_buffer() {
@@ -582,19 +1046,65 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		if (!mSceneData.mCullViewFrustum) ubo.numFrusta = 0;
 
 		// calc frustum planes
+		static_assert(ShadowMap::MAX_CASTER_PLANES <= CULLING_PLANES_PER_FRUSTUM, "CULLING_PLANES_PER_FRUSTUM too small");
 		for (uint32_t frustum = 0; frustum < ubo.numFrusta; ++frustum) {
-			glm::mat4 pvMatrix = (frustum == 0) ? effectiveCam_proj_matrix() * effectiveCam_view_matrix()
-				                                : mShadowMap.shadowMapUtil.projection_matrix(frustum - 1) * mShadowMap.shadowMapUtil.view_matrix();
-			FrustumCulling fc(pvMatrix);
-			for (int i = 0; i < 6; ++i) {
-				ubo.frustumPlanes[6 * frustum + i] = fc.Plane(i);
+			glm::vec4 *planes = &ubo.frustumPlanes[CULLING_PLANES_PER_FRUSTUM * frustum];
+			int numPlanes = 6;
+			if (frustum > 0 && mShadowMap.extrudedCasterCulling) {
+				// shadow casters: use the cascade's cam frustum slice, extruded towards the light
+				const glm::vec4 *casterPlanes;
+				numPlanes = mShadowMap.shadowMapUtil.caster_culling_planes(frustum - 1, &casterPlanes);
+				for (int i = 0; i < numPlanes; ++i) planes[i] = casterPlanes[i];
+			} else {
+				glm::mat4 pvMatrix = (frustum == 0) ? effectiveCam_proj_matrix() * effectiveCam_view_matrix()
+					                                : mShadowMap.shadowMapUtil.culling_projection_matrix(frustum - 1) * mShadowMap.shadowMapUtil.view_matrix();
+				FrustumCulling fc(pvMatrix);
+				for (int i = 0; i < 6; ++i) planes[i] = fc.Plane(i);
 			}
+			for (int i = numPlanes; i < CULLING_PLANES_PER_FRUSTUM; ++i) planes[i] = glm::vec4(0, 0, 0, -1);	// never culls
 		}
 
-		const auto fif = gvk::context().main_window()->in_flight_index_for_frame();
+		// occlusion culling (main camera only) against the depth pyramid of the previous frame, with that frame's camera
+		const auto fif     = gvk::context().main_window()->in_flight_index_for_frame();
+		const auto prevFif = (fif + cConcurrentFrames - 1) % cConcurrentFrames;
+		auto &dp = mDepthPyramid;
+		ubo.occlusionCulling      = (dp.enabled && dp.occlusionCulling && dp.built[prevFif] && !mEffectiveCamera.detached) ? 1u : 0u;
+		ubo.pyramidProjViewMatrix = dp.projViewMatrix[prevFif];
+		ubo.pyramidNearPlane      = mQuakeCam.near_plane_distance();
+		ubo.occlusionBias         = dp.occlusionBias;
+		ubo.pad1                  = 0.f;
+		dp.projViewMatrix[fif]    = mQuakeCam.projection_matrix() * mQuakeCam.view_matrix();
+
+		if (mShadowMap.collectCullingStats) collect_caster_culling_stats(ubo);
+
 		mSceneData.mCullingUniformsBuffer[fif]->fill(&ubo, 0, avk::sync::not_required());
 	}
 
+	// count instances passing the culling test per frustum (on the CPU, just for stats) - for shadow cascades, count both the
+	// light's ortho box (old method) and the extruded cascade volume that is actually in the ubo (if enabled)
+	void collect_caster_culling_stats(const CullingUniforms &ubo) {
+		auto &stats = mShadowMap.cullingStats;
+		stats = {};
+		std::vector<FrustumCulling> orthoFrusta;
+		for (int c = 0; c < mShadowMap.numCascades; ++c) {
+			orthoFrusta.emplace_back(mShadowMap.shadowMapUtil.culling_projection_matrix(c) * mShadowMap.shadowMapUtil.view_matrix());
+		}
+
+		for (auto &mg : mSceneData.mMeshgroups) {
+			for (auto &insDat : mg.perInstanceData) {
+				glm::vec4 p[8];
+				mg.boundingBox_untransformed.getTransformedPointsV4(insDat.modelMatrix, p);
+				BoundingBox bb;
+				bb.calcFromPoints(8, p);
+				stats.numInstances++;
+				for (uint32_t frustum = 0; frustum < ubo.numFrusta; ++frustum) {
+					if (!FrustumCulling::CanCull(&ubo.frustumPlanes[CULLING_PLANES_PER_FRUSTUM * frustum], CULLING_PLANES_PER_FRUSTUM, bb)) stats.numVisible[frustum]++;
+					if (frustum > 0 && !orthoFrusta[frustum - 1].CanCull(bb)) stats.numVisibleOrtho[frustum]++;
+				}
+			}
+		}
+	}
+
 	void rebuild_scene_buffers(gvk::window::frame_id_t fif) {
 		rebuild_scene_buffers(fif, fif);
 	}
@@ -802,6 +1312,44 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		}
 	}
 
+	// linear depth pyramid (see depth_pyramid.comp), one per frame in flight; needs the framebuffers
+	void prepare_depth_pyramid()
+	{
+		using namespace avk;
+		using namespace gvk;
+
+		auto &dp = mDepthPyramid;
+
+		// levels for the full attachment size, down to 1x1 (the valid part of each level is set per frame, see compute_depth_pyramid)
+		glm::uvec2 size = mLoResolution;
+		uint32_t numTexels = 0;
+		dp.numLevels = 0;
+		while (dp.numLevels < DEPTH_PYRAMID_MAX_LEVELS) {
+			dp.levels[dp.numLevels++] = glm::uvec2(numTexels, size.x);
+			numTexels += size.x * size.y;
+			if (size.x == 1u && size.y == 1u) break;
+			size = glm::max(size / 2u, glm::uvec2(1u));
+		}
+
+		auto fif = context().main_window()->number_of_frames_in_flight();
+		for (decltype(fif) i = 0; i < fif; ++i) {
+			dp.buffers[i] = context().create_buffer(memory_usage::device, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+				storage_buffer_meta::create_from_size(DEPTH_PYRAMID_HEADER_BYTES + size_t(numTexels) * sizeof(glm::vec2)));
+			rdoc::labelBuffer(dp.buffers[i]->handle(), "mDepthPyramid.buffers", i);
+			dp.readback[i] = context().create_buffer(memory_usage::host_coherent, vk::BufferUsageFlagBits::eTransferDst,
+				generic_buffer_meta::create_from_size(sizeof(glm::uvec4)));
+			dp.built[i] = false;
+			dp.readbackValid[i] = false;
+		}
+
+		dp.pipeline = context().create_compute_pipeline_for(
+			compute_shader("shaders/depth_pyramid.comp.spv"),
+			descriptor_binding(0, 0, mFramebuffer[0]->image_view_at(1).get()),
+			descriptor_binding(0, 1, dp.buffers[0]->as_storage_buffer()),
+			push_constant_binding_data{ shader_type::compute, 0, sizeof(DepthPyramidPushConstants) }
+		);
+	}
+
 	void prepare_skybox()
 	{
 		using namespace avk;
@@ -848,36 +1396,58 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			cfg::culling_mode::disabled,	// No backface culling required
 			cfg::depth_test::disabled(),	// No depth test required
 			cfg::depth_write::disabled(),	// Don't write depth values
-					cfg::viewport_depth_scissors_config::from_framebuffer(avk::const_referenced(wnd->backbuffer_at_index(0))), // Set to the dimensions of the main window
+					cfg::viewport_depth_scissors_config::from_framebuffer(avk::const_referenced(wnd->backbuffer_at_index(0))).enable_dynamic_viewport().enable_dynamic_scissor(), // set per frame, see set_render_viewport
 			descriptor_binding(0, 0, mMatricesUserInputBuffer[0])
 		);
 
 		auto& commandPool = gvk::context().get_command_pool_for_reusable_command_buffers(*mQueue);
 		
 		// Create a command buffer and record the commands for rendering the skybox into it:
-		// (We will record the drawing commands once, and use/"replay" it every frame.)
+		// (We will record the drawing commands once, and use/"replay" it every frame - re-recorded only when the render resolution changes.)
 		auto fif = wnd->number_of_frames_in_flight();
 		for (decltype(fif) i=0; i < fif; ++i) {
 			mSkyboxCommandBuffer[i] = commandPool->alloc_command_buffer();	
-			mSkyboxCommandBuffer[i]->begin_recording(); // Start recording commands into the command buffer
-			rdoc::beginSection(mSkyboxCommandBuffer[i]->handle(), "Skybox", i);
-			helpers::record_timing_interval_start(mSkyboxCommandBuffer[i]->handle(), fmt::format("mSkyboxCommandBuffer{} time", i));
-			mSkyboxCommandBuffer[i]->bind_pipeline(const_referenced(mSkyboxPipeline));
-			mSkyboxCommandBuffer[i]->begin_render_pass_for_framebuffer( // Start the renderpass defined for the attachments (in fact, the renderpass is created FROM the attachments, see renderpass_t::create)
-				mSkyboxPipeline->get_renderpass(),                   // <-- We'll use the pipeline's renderpass, where we have defined load/store operations.
-				mSkyboxFramebuffer[i]
-			);
-			mSkyboxCommandBuffer[i]->bind_descriptors(mSkyboxPipeline->layout(), mDescriptorCache.get_or_create_descriptor_sets({  // Bind the descriptors which describe resources used by shaders.
-				descriptor_binding(0, 0, mMatricesUserInputBuffer[i])                                  // In this case, we have one uniform buffer as resource (we have also declared that during mSkyboxPipeline creation).
-			}));
-			mSkyboxCommandBuffer[i]->draw_indexed(avk::const_referenced(mSphereIndexBuffer), avk::const_referenced(mSphereVertexBuffer)); // Record the draw call
-			mSkyboxCommandBuffer[i]->end_render_pass();
-			helpers::record_timing_interval_end(mSkyboxCommandBuffer[i]->handle(), fmt::format("mSkyboxCommandBuffer{} time", i));
-			rdoc::endSection(mSkyboxCommandBuffer[i]->handle());
-			mSkyboxCommandBuffer[i]->end_recording(); // Done recording. We're not going to modify this command buffer anymore.
+			record_skybox_command_buffer(i);
 		}
 	}
 
+	void record_skybox_command_buffer(gvk::window::frame_id_t i)
+	{
+		using namespace avk;
+
+		mSkyboxCommandBuffer[i]->begin_recording(); // Start recording commands into the command buffer
+		rdoc::beginSection(mSkyboxCommandBuffer[i]->handle(), "Skybox", i);
+		helpers::record_timing_interval_start(mSkyboxCommandBuffer[i]->handle(), fmt::format("mSkyboxCommandBuffer{} time", i));
+		mSkyboxCommandBuffer[i]->bind_pipeline(const_referenced(mSkyboxPipeline));
+		mSkyboxCommandBuffer[i]->begin_render_pass_for_framebuffer( // Start the renderpass defined for the attachments (in fact, the renderpass is created FROM the attachments, see renderpass_t::create)
+			mSkyboxPipeline->get_renderpass(),                   // <-- We'll use the pipeline's renderpass, where we have defined load/store operations.
+			mSkyboxFramebuffer[i]
+		);
+		set_render_viewport(mSkyboxCommandBuffer[i]);
+		mSkyboxCommandBuffer[i]->bind_descriptors(mSkyboxPipeline->layout(), mDescriptorCache.get_or_create_descriptor_sets({  // Bind the descriptors which describe resources used by shaders.
+			descriptor_binding(0, 0, mMatricesUserInputBuffer[i])                                  // In this case, we have one uniform buffer as resource (we have also declared that during mSkyboxPipeline creation).
+		}));
+		mSkyboxCommandBuffer[i]->draw_indexed(avk::const_referenced(mSphereIndexBuffer), avk::const_referenced(mSphereVertexBuffer)); // Record the draw call
+		mSkyboxCommandBuffer[i]->end_render_pass();
+		helpers::record_timing_interval_end(mSkyboxCommandBuffer[i]->handle(), fmt::format("mSkyboxCommandBuffer{} time", i));
+		rdoc::endSection(mSkyboxCommandBuffer[i]->handle());
+		mSkyboxCommandBuffer[i]->end_recording(); // Done recording. We're not going to modify this command buffer anymore.
+		mSkyboxRecordedResolution[i] = mRenderResolution;
+	}
+
+	// dynamic resolution: draw into the top left mRenderResolution pixels of the (mLoResolution sized) attachments;
+	// the pipelines rendering into mFramebuffer have a dynamic viewport and scissor (see render_viewport_config)
+	void set_render_viewport(avk::command_buffer &cmd)
+	{
+		cmd->handle().setViewport(0, vk::Viewport{ 0.f, 0.f, static_cast<float>(mRenderResolution.x), static_cast<float>(mRenderResolution.y), 0.f, 1.f });
+		cmd->handle().setScissor (0, vk::Rect2D{ { 0, 0 }, { mRenderResolution.x, mRenderResolution.y } });
+	}
+
+	avk::cfg::viewport_depth_scissors_config render_viewport_config()
+	{
+		return avk::cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]).enable_dynamic_viewport().enable_dynamic_scissor();
+	}
+
 	void prepare_shadowmap() {
 #if ENABLE_SHADOWMAP
 		using namespace avk;
@@ -1190,7 +1760,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		auto bufferUsageFlags = vk::BufferUsageFlags{};
 #if ENABLE_RAYTRACING
 		//assert(cgb::settings::gEnableBufferDeviceAddress);
-		bufferUsageFlags |= vk::BufferUsageFlagBits::eShaderDeviceAddressKHR;	// TODO: need this for raytracing ?
+		if (mHardwareRayTracing) bufferUsageFlags |= vk::BufferUsageFlagBits::eShaderDeviceAddressKHR;	// for the geometry table of the hit shaders
 #endif
 
 		std::cout << "Parsing scene\r"; std::cout.flush();
@@ -1383,6 +1953,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 
 			auto &dynObj = mDynObjects.emplace_back(dynamic_object{});
 			dynObj.mIsAnimated = objdef.animId >= 0;
+			dynObj.mBakeCacheBaseName = std::filesystem::path(objdef.filename).filename().string();
 			dynObj.mBaseTransform = objdef.modelMatrix;
 
 			// iterate through all the model's meshes (TODO: combine materials first? ( model->distinct_material_configs() ) - probably should do that in a real-life app to avoid loading duplicate textures etc...)
@@ -1439,20 +2010,53 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				if (dynObj.mIsAnimated) {
 					boneWeights = get_bone_weights(selection, true /* normalize */);
 					boneIndices = get_bone_indices(selection);
+				} else {
+					// a single identity "bone", so the crowd pipelines can draw any object
+					boneWeights.resize(vertices.size(), glm::vec4(1, 0, 0, 0));
+					boneIndices.resize(vertices.size(), glm::uvec4(0));
 				}
 
 				// Create all the GPU buffers, but don't fill yet:
-				meshData.mIndexBuffer			= context().create_buffer(memory_usage::device, bufferUsageFlags, index_buffer_meta::        create_from_data(indices),
-																												  uniform_texel_buffer_meta::create_from_data(indices).set_format<glm::uvec3>());
-				meshData.mPositionsBuffer		= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::       create_from_data(vertices).describe_only_member(vertices[0], content_description::position),
-																												  uniform_texel_buffer_meta::create_from_data(vertices).describe_only_member(vertices[0], content_description::position));
+				meshData.mIndexBuffer			= context().create_buffer(memory_usage::device, bufferUsageFlags, index_buffer_meta::        create_from_data(indices));
 				meshData.mTexCoordsBuffer		= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(texCoords));
-				meshData.mNormalsBuffer			= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(normals));
-				meshData.mTangentsBuffer		= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(tangents));
-				meshData.mBitangentsBuffer		= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(bitangents));
-				if (dynObj.mIsAnimated) {
+				if (!dynObj.mIsAnimated) {
+					meshData.mPositionsBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::       create_from_data(vertices).describe_only_member(vertices[0], content_description::position));
+					meshData.mNormalsBuffer		= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(normals));
+					meshData.mTangentsBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(tangents));
+					meshData.mBitangentsBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(bitangents));
 					meshData.mBoneWeightsBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(boneWeights));
 					meshData.mBoneIndicesBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(boneIndices));
+				} else {
+					// the skinning compute shader reads the vertex data from storage buffers
+					meshData.mPositionsBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::       create_from_data(vertices).describe_only_member(vertices[0], content_description::position),
+																												  storage_buffer_meta::      create_from_data(vertices));
+					meshData.mNormalsBuffer		= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(normals),     storage_buffer_meta::create_from_data(normals));
+					meshData.mTangentsBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(tangents),    storage_buffer_meta::create_from_data(tangents));
+					meshData.mBitangentsBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(bitangents),  storage_buffer_meta::create_from_data(bitangents));
+					meshData.mBoneWeightsBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(boneWeights), storage_buffer_meta::create_from_data(boneWeights));
+					meshData.mBoneIndicesBuffer	= context().create_buffer(memory_usage::device, bufferUsageFlags, vertex_buffer_meta::create_from_data(boneIndices), storage_buffer_meta::create_from_data(boneIndices));
+
+					// skinning results, per frame in flight
+					auto skinnedUsageFlags = bufferUsageFlags;
+					auto numFif = context().main_window()->number_of_frames_in_flight();
+					for (decltype(numFif) i = 0; i < numFif; ++i) {
+#if ENABLE_RAYTRACING
+						if (mHardwareRayTracing) {	// also the BLAS build input
+							meshData.mSkinnedPositionsBuffer[i] = context().create_buffer(memory_usage::device, skinnedUsageFlags, vertex_buffer_meta::create_from_data(vertices).describe_only_member(vertices[0], content_description::position), storage_buffer_meta::create_from_data(vertices),
+																						  read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(vertices));
+						} else
+#endif
+						meshData.mSkinnedPositionsBuffer    [i] = context().create_buffer(memory_usage::device, skinnedUsageFlags, vertex_buffer_meta::create_from_data(vertices).describe_only_member(vertices[0], content_description::position), storage_buffer_meta::create_from_data(vertices));
+						meshData.mSkinnedPrevPositionsBuffer[i] = context().create_buffer(memory_usage::device, skinnedUsageFlags, vertex_buffer_meta::create_from_data(vertices),   storage_buffer_meta::create_from_data(vertices));
+						meshData.mSkinnedNormalsBuffer      [i] = context().create_buffer(memory_usage::device, skinnedUsageFlags, vertex_buffer_meta::create_from_data(normals),    storage_buffer_meta::create_from_data(normals));
+						meshData.mSkinnedTangentsBuffer     [i] = context().create_buffer(memory_usage::device, skinnedUsageFlags, vertex_buffer_meta::create_from_data(tangents),   storage_buffer_meta::create_from_data(tangents));
+						meshData.mSkinnedBitangentsBuffer   [i] = context().create_buffer(memory_usage::device, skinnedUsageFlags, vertex_buffer_meta::create_from_data(bitangents), storage_buffer_meta::create_from_data(bitangents));
+						rdoc::labelBuffer(meshData.mSkinnedPositionsBuffer    [i]->handle(), "dynObj_SkinnedPositionsBuffer", i);
+						rdoc::labelBuffer(meshData.mSkinnedPrevPositionsBuffer[i]->handle(), "dynObj_SkinnedPrevPositionsBuffer", i);
+						rdoc::labelBuffer(meshData.mSkinnedNormalsBuffer      [i]->handle(), "dynObj_SkinnedNormalsBuffer", i);
+						rdoc::labelBuffer(meshData.mSkinnedTangentsBuffer     [i]->handle(), "dynObj_SkinnedTangentsBuffer", i);
+						rdoc::labelBuffer(meshData.mSkinnedBitangentsBuffer   [i]->handle(), "dynObj_SkinnedBitangentsBuffer", i);
+					}
 				}
 
 				// store mesh data for later upload
@@ -1491,10 +2095,12 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				//printf("Loaded anim clip, start ticks=%f, end ticks=%f, tps=%f\n", anim_clip.mStartTicks, anim_clip.mEndTicks, anim_clip.mTicksPerSecond);
 				assert(anim_clip.mTicksPerSecond > 0.0 && anim_clip.mEndTicks > anim_clip.mStartTicks);
 
-				dynObj.mBoneMatrices.resize(MAX_BONES * allMeshIndices.size(), glm::mat4(0));
+				dynObj.mBoneMatrices    .resize(MAX_BONES * allMeshIndices.size(), glm::mat4(0));
+				dynObj.mBoneMatricesPrev.resize(MAX_BONES * allMeshIndices.size(), glm::mat4(0));
 				totalNumBoneMatrices += dynObj.mBoneMatrices.size();
 				dynObj.mAnimations.push_back(model->prepare_animation(objdef.animId, allMeshIndices));
 				dynObj.mAnimClips.push_back(anim_clip);
+				dynObj.mBakeCacheKeys.push_back(bake_cache_key(objdef.filename, objdef.animId, anim_clip, dynObj.mBoneMatrices.size()));
 			}
 		}
 		prepare_bone_matrices_buffer(totalNumBoneMatrices);
@@ -1514,6 +2120,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		// "GPU-compatible format" in this sense means that we'll get two things out of the call to `convert_for_gpu_usage`:
 		//   1) Material data in a properly aligned format, suitable for being uploaded into a GPU buffer (but not uploaded into a buffer yet!)
 		//   2) Image samplers (which contain images and samplers) of all the used textures, already uploaded to the GPU.
+		mMaterialConfigs = distinctMaterialConfigs;	// the CPU ray tracer loads its own copies of the textures
 		std::tie(mMaterialData, mImageSamplers) = convert_for_gpu_usage<material_gpu_data>(
 			distinctMaterialConfigs, false,
 			mFlipTexturesInLoader,
@@ -1561,6 +2168,193 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 	}
 
 #if ENABLE_RAYTRACING
+	void build_static_blases() {
+		// build the meshgroup BLASs with allow-compaction, query their compacted sizes, copy them into compacted BLASs and release the originals
+		// avk has no support for compaction, so this is done with plain Vulkan calls; processed in batches to limit scratch and peak memory
+		using namespace avk;
+		using namespace gvk;
+
+		auto &dev      = context().device();
+		auto &dispatch = context().dynamic_dispatch();
+		const vk::BufferUsageFlags asUsage      = vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR | vk::BufferUsageFlagBits::eShaderDeviceAddressKHR;
+		const vk::BufferUsageFlags scratchUsage = vk::BufferUsageFlagBits::eStorageBuffer                   | vk::BufferUsageFlagBits::eShaderDeviceAddressKHR;
+		const vk::DeviceSize scratchAlign = context().physical_device().getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceAccelerationStructurePropertiesKHR>(dispatch)
+		                                      .get<vk::PhysicalDeviceAccelerationStructurePropertiesKHR>().minAccelerationStructureScratchOffsetAlignment;
+		const vk::DeviceSize maxScratchPerBatch = 256ull * 1024 * 1024;
+		auto alignUp = [](vk::DeviceSize v, vk::DeviceSize a) { return (v + a - 1) / a * a; };
+
+		auto submitAndWait = [this](avk::command_buffer &cmd) {
+			std::vector<avk::resource_reference<avk::command_buffer_t>> cmdRefs = { avk::referenced(*cmd) };
+			auto fen = mQueue->submit_with_fence(cmdRefs);
+			fen->wait_until_signalled();
+		};
+
+		const size_t numBlas = mSceneData.mMeshgroups.size();
+		mSceneData.mBLASs.clear();
+		mSceneData.mBLASs.resize(numBlas);
+		mSceneData.mBlasMemoryUncompacted = mSceneData.mBlasMemoryCompacted = 0;
+
+		size_t batchBegin = 0;
+		while (batchBegin < numBlas) {
+			// gather a batch: geometry descriptions and sizes
+			std::vector<vk::AccelerationStructureGeometryKHR>       geometries;
+			std::vector<vk::AccelerationStructureBuildRangeInfoKHR> ranges;
+			std::vector<vk::AccelerationStructureBuildSizesInfoKHR> sizes;
+			std::vector<vk::DeviceSize> scratchOffsets;
+			vk::DeviceSize scratchSize = 0;
+			size_t batchEnd = batchBegin;
+			for (; batchEnd < numBlas; ++batchEnd) {
+				auto &mg = mSceneData.mMeshgroups[batchEnd];
+				auto triangles = vk::AccelerationStructureGeometryTrianglesDataKHR{}
+					.setVertexFormat(vk::Format::eR32G32B32Sfloat)
+					.setVertexData(mRtScenePositionsBuffer->device_address() + mg.rayTracingTmp.rtFirstVertex * sizeof(glm::vec3))
+					.setVertexStride(sizeof(glm::vec3))
+					.setMaxVertex(static_cast<uint32_t>(mg.rayTracingTmp.rtPositionData.size() - 1))
+					.setIndexType(vk::IndexType::eUint32)
+					.setIndexData(mRtSceneIndexBuffer->device_address() + mg.rayTracingTmp.rtFirstIndex * sizeof(uint32_t));
+				auto geometry = vk::AccelerationStructureGeometryKHR{}
+					.setGeometryType(vk::GeometryTypeKHR::eTriangles)
+					.setGeometry(triangles)
+					.setFlags(mg.hasTransparency ? vk::GeometryFlagsKHR{} : vk::GeometryFlagBitsKHR::eOpaque);
+				uint32_t numTriangles = static_cast<uint32_t>(mg.rayTracingTmp.rtIndexData.size() / 3);
+
+				auto info = vk::AccelerationStructureBuildGeometryInfoKHR{}
+					.setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+					.setFlags(vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace | vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction)
+					.setMode(vk::BuildAccelerationStructureModeKHR::eBuild)
+					.setGeometries(geometry);
+				auto sz = dev.getAccelerationStructureBuildSizesKHR(vk::AccelerationStructureBuildTypeKHR::eDevice, info, numTriangles, dispatch);
+
+				vk::DeviceSize offset = alignUp(scratchSize, scratchAlign);
+				if (batchEnd > batchBegin && offset + sz.buildScratchSize > maxScratchPerBatch) break;
+				geometries.push_back(geometry);
+				ranges.push_back(vk::AccelerationStructureBuildRangeInfoKHR{ numTriangles, 0, 0, 0 });
+				sizes.push_back(sz);
+				scratchOffsets.push_back(offset);
+				scratchSize = offset + sz.buildScratchSize;
+			}
+			const size_t n = batchEnd - batchBegin;
+
+			// create the uncompacted BLASs + one scratch buffer for the batch
+			std::vector<static_blas> uncompacted(n);
+			for (size_t i = 0; i < n; ++i) {
+				auto &b = uncompacted[i];
+				b.mStorage = context().create_buffer(memory_usage::device, asUsage, generic_buffer_meta::create_from_size(sizes[i].accelerationStructureSize));
+				b.mHandle  = dev.createAccelerationStructureKHRUnique(vk::AccelerationStructureCreateInfoKHR{ {}, b.mStorage->handle(), 0, sizes[i].accelerationStructureSize, vk::AccelerationStructureTypeKHR::eBottomLevel }, nullptr, dispatch);
+				mSceneData.mBlasMemoryUncompacted += sizes[i].accelerationStructureSize;
+			}
+			auto scratch = context().create_buffer(memory_usage::device, scratchUsage, generic_buffer_meta::create_from_size(scratchSize + scratchAlign));
+			vk::DeviceAddress scratchBase = alignUp(scratch->device_address(), scratchAlign);
+
+			std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> infos(n);
+			std::vector<const vk::AccelerationStructureBuildRangeInfoKHR *> rangePtrs(n);
+			std::vector<vk::AccelerationStructureKHR> handles(n);
+			for (size_t i = 0; i < n; ++i) {
+				infos[i] = vk::AccelerationStructureBuildGeometryInfoKHR{}
+					.setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+					.setFlags(vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace | vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction)
+					.setMode(vk::BuildAccelerationStructureModeKHR::eBuild)
+					.setDstAccelerationStructure(uncompacted[i].mHandle.get())
+					.setGeometryCount(1)
+					.setPGeometries(&geometries[i])
+					.setScratchData(scratchBase + scratchOffsets[i]);
+				rangePtrs[i] = &ranges[i];
+				handles[i]   = uncompacted[i].mHandle.get();
+			}
+
+			auto queryPool = dev.createQueryPoolUnique(vk::QueryPoolCreateInfo{ {}, vk::QueryType::eAccelerationStructureCompactedSizeKHR, static_cast<uint32_t>(n) });
+
+			// build + query compacted sizes
+			auto cmd = context().get_command_pool_for_single_use_command_buffers(*mQueue)->alloc_command_buffer(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+			cmd->begin_recording();
+			cmd->establish_global_memory_barrier_rw(
+				pipeline_stage::transfer, pipeline_stage::acceleration_structure_build,	// inputs were uploaded by fill()
+				memory_access::transfer_write_access, memory_access::shader_buffers_and_images_read_access
+			);
+			cmd->handle().resetQueryPool(queryPool.get(), 0, static_cast<uint32_t>(n));
+			cmd->handle().buildAccelerationStructuresKHR(static_cast<uint32_t>(n), infos.data(), rangePtrs.data(), dispatch);
+			cmd->establish_global_memory_barrier_rw(
+				pipeline_stage::acceleration_structure_build, pipeline_stage::acceleration_structure_build,
+				memory_access::acceleration_structure_write_access, memory_access::acceleration_structure_read_access
+			);
+			cmd->handle().writeAccelerationStructuresPropertiesKHR(static_cast<uint32_t>(n), handles.data(), vk::QueryType::eAccelerationStructureCompactedSizeKHR, queryPool.get(), 0, dispatch);
+			cmd->end_recording();
+			submitAndWait(cmd);
+
+			std::vector<vk::DeviceSize> compactedSizes(n);
+			auto res = dev.getQueryPoolResults(queryPool.get(), 0, static_cast<uint32_t>(n), n * sizeof(vk::DeviceSize), compactedSizes.data(), sizeof(vk::DeviceSize), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+			if (res != vk::Result::eSuccess) throw avk::runtime_error("Failed to query compacted BLAS sizes");
+
+			// create the compacted BLASs and copy
+			auto cmdCopy = context().get_command_pool_for_single_use_command_buffers(*mQueue)->alloc_command_buffer(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+			cmdCopy->begin_recording();
+			for (size_t i = 0; i < n; ++i) {
+				auto &b = mSceneData.mBLASs[batchBegin + i];
+				b.mStorage = context().create_buffer(memory_usage::device, asUsage, generic_buffer_meta::create_from_size(compactedSizes[i]));
+				b.mHandle  = dev.createAccelerationStructureKHRUnique(vk::AccelerationStructureCreateInfoKHR{ {}, b.mStorage->handle(), 0, compactedSizes[i], vk::AccelerationStructureTypeKHR::eBottomLevel }, nullptr, dispatch);
+				cmdCopy->handle().copyAccelerationStructureKHR(vk::CopyAccelerationStructureInfoKHR{ uncompacted[i].mHandle.get(), b.mHandle.get(), vk::CopyAccelerationStructureModeKHR::eCompact }, dispatch);
+				b.mDeviceAddress = dev.getAccelerationStructureAddressKHR(vk::AccelerationStructureDeviceAddressInfoKHR{ b.mHandle.get() }, dispatch);
+				mSceneData.mBlasMemoryCompacted += compactedSizes[i];
+			}
+			cmdCopy->establish_global_memory_barrier_rw(
+				pipeline_stage::acceleration_structure_build, pipeline_stage::acceleration_structure_build,	// TLAS build comes next
+				memory_access::acceleration_structure_write_access, memory_access::acceleration_structure_read_access
+			);
+			cmdCopy->end_recording();
+			submitAndWait(cmdCopy);
+
+			// uncompacted BLASs, scratch buffer and query pool are released here
+			batchBegin = batchEnd;
+		}
+
+		mSceneData.print_stats();
+	}
+
+	// target images for ray tracing, dummy bindings and the merge pipeline of the CPU ray tracer; needed without hardware ray tracing too
+	void init_raytracing_images() {
+		using namespace avk;
+		using namespace gvk;
+
+		auto numFif = context().main_window()->number_of_frames_in_flight();
+
+		// create images to render into
+		std::vector<avk::command_buffer> layoutTransitions;
+		auto win = context().main_window();
+		//const auto wdth = win->resolution().x;
+		//const auto hght = win->resolution().y;
+		//const auto frmt = format_from_window_color_buffer(win);
+		const auto wdth = mLoResolution.x;
+		const auto hght = mLoResolution.y;
+		const auto frmt = IMAGE_FORMAT_RAYTRACE;
+		for (decltype(numFif) i = 0; i < numFif; ++i) {
+			auto offscreenImage = context().create_image(wdth, hght, frmt, 1, memory_usage::device, image_usage::general_storage_image);
+			offscreenImage->transition_to_layout({}, sync::with_barriers(win->command_buffer_lifetime_handler()));
+			mRtImageViews[i] = context().create_image_view(owned(offscreenImage));
+			assert((mRtImageViews[i]->create_info().subresourceRange.aspectMask & vk::ImageAspectFlagBits::eColor) == vk::ImageAspectFlagBits::eColor);
+		}
+		mRtDummyPixelList = context().create_buffer(memory_usage::device, {}, storage_buffer_meta::create_from_size(sizeof(glm::uvec4) + sizeof(uint32_t)));
+		{
+			auto dummySegMask = context().create_image(1, 1, TAA_IMAGE_FORMAT_SEGMASK, 1, memory_usage::device, image_usage::general_storage_image);
+			mRtDummySegMask = context().create_image_view(owned(dummySegMask));
+			layoutTransitions.emplace_back(std::move(mRtDummySegMask->get_image().transition_to_layout({}, avk::sync::with_barriers_by_return({}, {})).value()));
+		}
+		std::vector<avk::resource_reference<avk::command_buffer_t>> commandBufferReferences;
+		std::transform(std::begin(layoutTransitions), std::end(layoutTransitions), std::back_inserter(commandBufferReferences), [](avk::command_buffer& cb) { return avk::referenced(*cb); });
+		auto fen = mQueue->submit_with_fence(commandBufferReferences);
+		fen->wait_until_signalled();
+
+		// CPU ray tracing backend: merges the CPU result into the RT image / TAA result (buffers are created on first use)
+		mPipelineRtCpuMerge = context().create_compute_pipeline_for(
+			compute_shader("shaders/rt_cpu_merge.comp.spv"),
+			descriptor_binding(0, 0, mRtDummyPixelList->as_storage_buffer()),
+			descriptor_binding(0, 1, mRtImageViews[0]->as_storage_image()),
+			descriptor_binding(0, 2, mRtImageViews[0]->as_storage_image()),
+			descriptor_binding(0, 3, mRtDummySegMask->as_storage_image()),
+			descriptor_binding(0, 4, mRtDummyPixelList->as_storage_buffer()),
+			push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constant_data_for_rt_cpu_merge) }
+		);
+	}
+
 	void init_raytracing() {
 		using namespace avk;
 		using namespace gvk;
@@ -1569,100 +2363,99 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 
 		vk::BufferUsageFlags bufferUsage = { vk::BufferUsageFlagBits::eShaderDeviceAddressKHR };
 
-		// create temp buffers for indices, vertices - FIXME!
-		std::vector<uint32_t> materialIndices;
+		// concatenate the geometry of all meshgroups into scene-wide buffers (indices stay relative to the meshgroup's first vertex)
+		std::vector<uint32_t>  sceneIndices;
+		std::vector<glm::vec3> scenePositions, sceneNormals, sceneTangents, sceneBitangents;
+		std::vector<glm::vec2> sceneTexCoords;
+		for (auto &mg : mSceneData.mMeshgroups) {
+			mg.rayTracingTmp.rtFirstIndex  = sceneIndices.size();
+			mg.rayTracingTmp.rtFirstVertex = scenePositions.size();
+			sceneIndices   .insert(sceneIndices   .end(), mg.rayTracingTmp.rtIndexData     .begin(), mg.rayTracingTmp.rtIndexData     .end());
+			scenePositions .insert(scenePositions .end(), mg.rayTracingTmp.rtPositionData  .begin(), mg.rayTracingTmp.rtPositionData  .end());
+			sceneTexCoords .insert(sceneTexCoords .end(), mg.rayTracingTmp.rtTexCoordData  .begin(), mg.rayTracingTmp.rtTexCoordData  .end());
+			sceneNormals   .insert(sceneNormals   .end(), mg.rayTracingTmp.rtNormalsData   .begin(), mg.rayTracingTmp.rtNormalsData   .end());
+			sceneTangents  .insert(sceneTangents  .end(), mg.rayTracingTmp.rtTangentsData  .begin(), mg.rayTracingTmp.rtTangentsData  .end());
+			sceneBitangents.insert(sceneBitangents.end(), mg.rayTracingTmp.rtBitangentsData.begin(), mg.rayTracingTmp.rtBitangentsData.end());
+		}
+		mRtSceneIndexBuffer			= context().create_buffer(memory_usage::device, bufferUsage, index_buffer_meta::create_from_data(sceneIndices), read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(sceneIndices));
+		mRtScenePositionsBuffer		= context().create_buffer(memory_usage::device, bufferUsage, vertex_buffer_meta::create_from_data(scenePositions).describe_only_member(scenePositions[0], content_description::position), read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(scenePositions));
+		mRtSceneTexCoordsBuffer		= context().create_buffer(memory_usage::device, bufferUsage, storage_buffer_meta::create_from_data(sceneTexCoords));
+		mRtSceneNormalsBuffer		= context().create_buffer(memory_usage::device, bufferUsage, storage_buffer_meta::create_from_data(sceneNormals));
+		mRtSceneTangentsBuffer		= context().create_buffer(memory_usage::device, bufferUsage, storage_buffer_meta::create_from_data(sceneTangents));
+		mRtSceneBitangentsBuffer	= context().create_buffer(memory_usage::device, bufferUsage, storage_buffer_meta::create_from_data(sceneBitangents));
+		mRtSceneIndexBuffer			->fill(sceneIndices   .data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+		mRtScenePositionsBuffer		->fill(scenePositions .data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+		mRtSceneTexCoordsBuffer		->fill(sceneTexCoords .data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+		mRtSceneNormalsBuffer		->fill(sceneNormals   .data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+		mRtSceneTangentsBuffer		->fill(sceneTangents  .data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+		mRtSceneBitangentsBuffer	->fill(sceneBitangents.data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+		rdoc::labelBuffer(mRtSceneIndexBuffer     ->handle(), "rt_SceneIndexBuffer");
+		rdoc::labelBuffer(mRtScenePositionsBuffer ->handle(), "rt_ScenePositionsBuffer");
+		rdoc::labelBuffer(mRtSceneTexCoordsBuffer ->handle(), "rt_SceneTexCoordsBuffer");
+		rdoc::labelBuffer(mRtSceneNormalsBuffer   ->handle(), "rt_SceneNormalsBuffer");
+		rdoc::labelBuffer(mRtSceneTangentsBuffer  ->handle(), "rt_SceneTangentsBuffer");
+		rdoc::labelBuffer(mRtSceneBitangentsBuffer->handle(), "rt_SceneBitangentsBuffer");
+
+		// one geometry info per custom index, first the meshgroups ...
+		auto numFif = context().main_window()->number_of_frames_in_flight();
+		std::vector<std::vector<rt_geometry_info>> geometryInfos(numFif);
 		for (auto &mg : mSceneData.mMeshgroups) {
-			mg.rayTracingTmp.rtIndexBuffer		= context().create_buffer(memory_usage::device, bufferUsage,
-																		  index_buffer_meta::                                           create_from_data(mg.rayTracingTmp.rtIndexData),
-																		  read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(mg.rayTracingTmp.rtIndexData),
-																		  uniform_texel_buffer_meta::                                   create_from_data(mg.rayTracingTmp.rtIndexData).set_format<glm::uvec3>());
-			mg.rayTracingTmp.rtPositionBuffer	= context().create_buffer(memory_usage::device, bufferUsage,
-																		  vertex_buffer_meta::                                          create_from_data(mg.rayTracingTmp.rtPositionData).describe_only_member(mg.rayTracingTmp.rtPositionData[0], content_description::position),
-																		  read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(mg.rayTracingTmp.rtPositionData),
-																		  uniform_texel_buffer_meta::                                   create_from_data(mg.rayTracingTmp.rtPositionData).describe_only_member(mg.rayTracingTmp.rtPositionData[0], content_description::position));
-			mg.rayTracingTmp.rtIndexBuffer.enable_shared_ownership();
-			mg.rayTracingTmp.rtPositionBuffer.enable_shared_ownership();
-			mg.rayTracingTmp.rtIndexBuffer		->fill(mg.rayTracingTmp.rtIndexData.data(),    0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // FIXME - sync ok?
-			mg.rayTracingTmp.rtPositionBuffer	->fill(mg.rayTracingTmp.rtPositionData.data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // FIXME - sync ok?
-
-			// add buffers to arrays of buffer-views (to be indexed via meshgroup id in the shader)
-			mRtIndexBuffersArray.push_back( context().create_buffer_view(shared(mg.rayTracingTmp.rtIndexBuffer)) );
-
-			// add texture coords in the same way
-			auto tbuf = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mg.rayTracingTmp.rtTexCoordData).describe_only_member(mg.rayTracingTmp.rtTexCoordData[0]));
-			tbuf->fill(mg.rayTracingTmp.rtTexCoordData.data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-			mRtTexCoordBuffersArray.push_back( context().create_buffer_view(owned(tbuf)) );
-
-			// and normals, tangents, bitangents ...
-			auto nbufN = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mg.rayTracingTmp.rtNormalsData   ).describe_only_member(mg.rayTracingTmp.rtNormalsData   [0]));
-			auto nbufT = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mg.rayTracingTmp.rtTangentsData  ).describe_only_member(mg.rayTracingTmp.rtTangentsData  [0]));
-			auto nbufB = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mg.rayTracingTmp.rtBitangentsData).describe_only_member(mg.rayTracingTmp.rtBitangentsData[0]));
-			nbufN->fill(mg.rayTracingTmp.rtNormalsData   .data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-			nbufT->fill(mg.rayTracingTmp.rtTangentsData  .data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-			nbufB->fill(mg.rayTracingTmp.rtBitangentsData.data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-			mRtNormalsBuffersArray   .push_back( context().create_buffer_view(owned(nbufN)) );
-			mRtTangentsBuffersArray  .push_back( context().create_buffer_view(owned(nbufT)) );
-			mRtBitangentsBuffersArray.push_back( context().create_buffer_view(owned(nbufB)) );
-
-			// and positions too (for LOD approximation)
-			mRtPositionsBuffersArray.push_back( context().create_buffer_view(shared(mg.rayTracingTmp.rtPositionBuffer)) );
-
-			// and store material index
-			materialIndices.push_back(mg.materialIndex);
-		}
-
-		// do the same for dynamic objects (and set their mRtCustomIndexBase property)
+			rt_geometry_info gi = {};
+			gi.mIndices    = mRtSceneIndexBuffer     ->device_address() + mg.rayTracingTmp.rtFirstIndex  * sizeof(uint32_t);
+			gi.mPositions  = mRtScenePositionsBuffer ->device_address() + mg.rayTracingTmp.rtFirstVertex * sizeof(glm::vec3);
+			gi.mTexCoords  = mRtSceneTexCoordsBuffer ->device_address() + mg.rayTracingTmp.rtFirstVertex * sizeof(glm::vec2);
+			gi.mNormals    = mRtSceneNormalsBuffer   ->device_address() + mg.rayTracingTmp.rtFirstVertex * sizeof(glm::vec3);
+			gi.mTangents   = mRtSceneTangentsBuffer  ->device_address() + mg.rayTracingTmp.rtFirstVertex * sizeof(glm::vec3);
+			gi.mBitangents = mRtSceneBitangentsBuffer->device_address() + mg.rayTracingTmp.rtFirstVertex * sizeof(glm::vec3);
+			gi.mMaterialIndex = static_cast<uint32_t>(mg.materialIndex);
+			for (auto &v : geometryInfos) v.push_back(gi);
+		}
+
+		// ... then each mesh of the dynamic objects (and set their mRtCustomIndexBase property)
+		// animated objects point to the skinned data of the respective frame in flight, so nothing needs to be copied per frame
 		uint32_t dynObj_nextCustomIndex = static_cast<uint32_t>(mSceneData.mMeshgroups.size());
 		for (auto &dynObj : mDynObjects) {
 			dynObj.mRtCustomIndexBase = dynObj_nextCustomIndex;
 			dynObj_nextCustomIndex += static_cast<uint32_t>(dynObj.mMeshData.size());	// each *mesh* of the dynObj needs its own custom index (to index texcoords,normals,indexbufs etc.)
-			assert(dynObj.mRtCustomIndexBase == mRtIndexBuffersArray.size());
+			assert(dynObj.mRtCustomIndexBase == geometryInfos[0].size());
 
 			for (auto &mesh : dynObj.mMeshData) {
-				mesh.mIndexBuffer.enable_shared_ownership();
-				mesh.mPositionsBuffer.enable_shared_ownership();
-
-				//auto ibuf = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mesh.mIndices).set_format<glm::uvec3>());
-				//ibuf->fill(mesh.mIndices.data(),     0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-				//mRtIndexBuffersArray.push_back( context().create_buffer_view(owned(ibuf)) );
-				mRtIndexBuffersArray.push_back( context().create_buffer_view(shared(mesh.mIndexBuffer)) );
-
-				auto tbuf = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mesh.mTexCoords).describe_only_member(mesh.mTexCoords[0]));
-				tbuf->fill(mesh.mTexCoords.data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-				mRtTexCoordBuffersArray.push_back( context().create_buffer_view(owned(tbuf)) );
-
-				auto nbufN = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mesh.mNormals   ).describe_only_member(mesh.mNormals   [0]));
-				auto nbufT = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mesh.mTangents  ).describe_only_member(mesh.mTangents  [0]));
-				auto nbufB = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(mesh.mBitangents).describe_only_member(mesh.mBitangents[0]));
-				nbufN->fill(mesh.mNormals   .data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-				nbufT->fill(mesh.mTangents  .data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-				nbufB->fill(mesh.mBitangents.data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
-				mRtNormalsBuffersArray   .push_back( context().create_buffer_view(owned(nbufN)) );
-				mRtTangentsBuffersArray  .push_back( context().create_buffer_view(owned(nbufT)) );
-				mRtBitangentsBuffersArray.push_back( context().create_buffer_view(owned(nbufB)) );
-
-				mRtPositionsBuffersArray.push_back( context().create_buffer_view(shared(mesh.mPositionsBuffer)) );
-
-				materialIndices.push_back(mesh.mMaterialIndex);
+				for (decltype(numFif) i = 0; i < numFif; ++i) {
+					rt_geometry_info gi = {};
+					gi.mIndices       = mesh.mIndexBuffer    ->device_address();
+					gi.mTexCoords     = mesh.mTexCoordsBuffer->device_address();
+					if (dynObj.mIsAnimated) {
+						gi.mPositions  = mesh.mSkinnedPositionsBuffer [i]->device_address();
+						gi.mNormals    = mesh.mSkinnedNormalsBuffer   [i]->device_address();
+						gi.mTangents   = mesh.mSkinnedTangentsBuffer  [i]->device_address();
+						gi.mBitangents = mesh.mSkinnedBitangentsBuffer[i]->device_address();
+					} else {
+						gi.mPositions  = mesh.mPositionsBuffer ->device_address();
+						gi.mNormals    = mesh.mNormalsBuffer   ->device_address();
+						gi.mTangents   = mesh.mTangentsBuffer  ->device_address();
+						gi.mBitangents = mesh.mBitangentsBuffer->device_address();
+					}
+					gi.mMaterialIndex = static_cast<uint32_t>(mesh.mMaterialIndex);
+					geometryInfos[i].push_back(gi);
+				}
 			}
 		}
+		for (decltype(numFif) i = 0; i < numFif; ++i) {
+			mRtGeometryInfoBuffer[i] = context().create_buffer(memory_usage::device, {}, storage_buffer_meta::create_from_data(geometryInfos[i]));
+			mRtGeometryInfoBuffer[i]->fill(geometryInfos[i].data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+			rdoc::labelBuffer(mRtGeometryInfoBuffer[i]->handle(), "rt_GeometryInfoBuffer", i);
+		}
 
-		// create a buffer holding all material indices
-		mRtMaterialIndexBuffer = context().create_buffer(memory_usage::device, bufferUsage, storage_buffer_meta::create_from_data(materialIndices));
-		mRtMaterialIndexBuffer->fill(materialIndices.data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // FIXME - sync ok?
 
+		// build bottom level acceleration structures, one per meshgroup (compacted)
+		build_static_blases();
 
-		// build bottom level acceleration structures, one per meshgroup
+		// generate a geometry instance for each instance of each mesh group
 		for (auto iMg = 0; iMg < mSceneData.mMeshgroups.size(); iMg++) {
 			auto &mg = mSceneData.mMeshgroups[iMg];
-
-			auto blas = context().create_bottom_level_acceleration_structure({ acceleration_structure_size_requirements::from_buffers(vertex_index_buffer_pair{mg.rayTracingTmp.rtPositionBuffer, mg.rayTracingTmp.rtIndexBuffer}) }, true);
-			blas.enable_shared_ownership();
-			mSceneData.mBLASs.push_back(blas);
-
-			// generate a geometry instance for each instance of the mesh group
 			for (auto &inst_data : mg.perInstanceData) {
-				auto geoInstance = context().create_geometry_instance(blas);
+				geometry_instance geoInstance = {};	// not via create_geometry_instance - the compacted BLASs are no avk objects
+				geoInstance.mAccelerationStructureDeviceAddress = mSceneData.mBLASs[iMg].mDeviceAddress;
 				geoInstance.set_transform_column_major(to_array(inst_data.modelMatrix));
 				geoInstance.set_custom_index(iMg);	// custom index = meshgroup id
 				geoInstance.set_mask(mg.hasTransparency ? RAYTRACING_CULLMASK_TRANSPARENT : RAYTRACING_CULLMASK_OPAQUE);
@@ -1670,18 +2463,13 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				if (mg.isTwoSided)      geoInstance.disable_culling();
 				mSceneData.mGeometryInstances.push_back(std::move(geoInstance));
 				mSceneData.mDebugGeoInstTransforms.push_back(inst_data.modelMatrix);
-			}
 
-			mSceneData.mBLASs.back()->build({ vertex_index_buffer_pair{mg.rayTracingTmp.rtPositionBuffer, mg.rayTracingTmp.rtIndexBuffer} }, {},
-				sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())
-				//avk::sync::with_barriers(
-				//	[posBfr = mg.rayTracingTmp.rtPositionBuffer, idxBfr = mg.rayTracingTmp.rtIndexBuffer](avk::command_buffer cb) {
-				//		cb->set_custom_deleter([lPosBfr = std::move(posBfr), lIdxBfr = std::move(idxBfr)](){});
-				//		gvk::context().main_window()->handle_lifetime(avk::owned(cb));
-				//	},
-				//	{}, {}
-				//)
-			);
+				glm::vec4 p[8];
+				mg.boundingBox_untransformed.getTransformedPointsV4(inst_data.modelMatrix, p);
+				BoundingBox bb;
+				bb.calcFromPoints(8, p);
+				mSceneData.mGeometryInstanceBounds.push_back(bb);
+			}
 		}
 
 		// ... and build BLASs for dynamic objects (but no geo instances yet)
@@ -1691,47 +2479,25 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			for (int iMesh = 0; iMesh < dynObj.mMeshData.size(); ++iMesh) {
 				auto &mesh = dynObj.mMeshData[iMesh];
 
-#if 0
-				// doesn't work - NSight says the corresponding vertex buffer in AS is all zero - WHY???
-
-				mesh.mBLAS = context().create_bottom_level_acceleration_structure({ acceleration_structure_size_requirements::from_buffers(vertex_index_buffer_pair{mesh.mPositionsBuffer, mesh.mIndexBuffer}) }, true);
-				mesh.mBLAS.enable_shared_ownership();
-
-				mesh.mBLAS->build({ vertex_index_buffer_pair{mesh.mPositionsBuffer, mesh.mIndexBuffer} }, {},
-					sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())
-					//avk::sync::with_barriers(
-					//	[posBfr = mesh.mPositionsBuffer, idxBfr = mesh.mIndexBuffer](avk::command_buffer cb) {		// TODO!! : check if deleter is appropriate here! probably not!
-					//		cb->set_custom_deleter([lPosBfr = std::move(posBfr), lIdxBfr = std::move(idxBfr)](){});
-					//		gvk::context().main_window()->handle_lifetime(avk::owned(cb));
-					//	},
-					//	{}, {}
-					//)
-				);
-#else
-
-				// --- debug! this works
-				auto tmpIndexBuffer		= context().create_buffer(memory_usage::device, bufferUsage, index_buffer_meta::create_from_data(mesh.mIndices), read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(mesh.mIndices));
-				auto tmpPositionsBuffer	= context().create_buffer(memory_usage::device, bufferUsage, vertex_buffer_meta::create_from_data(mesh.mPositions).describe_only_member(mesh.mPositions[0], content_description::position), read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(mesh.mPositions));
-				tmpIndexBuffer.enable_shared_ownership();
-				tmpPositionsBuffer.enable_shared_ownership();
-				tmpIndexBuffer		->fill(mesh.mIndices.data(),   0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // FIXME - sync ok?
-				tmpPositionsBuffer	->fill(mesh.mPositions.data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // FIXME - sync ok?
-
-				mesh.mBLAS = context().create_bottom_level_acceleration_structure({ acceleration_structure_size_requirements::from_buffers(vertex_index_buffer_pair{tmpPositionsBuffer, tmpIndexBuffer}) }, true);
-				mesh.mBLAS.enable_shared_ownership();
-
-				mesh.mBLAS->build({ vertex_index_buffer_pair{tmpPositionsBuffer, tmpIndexBuffer} }, {},
-					//sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())
-					avk::sync::with_barriers(
-						[posBfr = tmpPositionsBuffer, idxBfr = tmpIndexBuffer](avk::command_buffer cb) {		// TODO!! : check if deleter is appropriate here! probably not!
-							cb->set_custom_deleter([lPosBfr = std::move(posBfr), lIdxBfr = std::move(idxBfr)](){});
-							gvk::context().main_window()->handle_lifetime(avk::owned(cb));
-						},
-						{}, {}
-					)
-				);
-				// ---
-#endif
+				// note: building directly from mesh.mPositionsBuffer/mesh.mIndexBuffer doesn't work (AS sees all-zero vertices) - these lack the AS-build-input usage
+				// so keep dedicated BLAS input buffers, uploaded once
+				mesh.mBlasIndexBuffer		= context().create_buffer(memory_usage::device, bufferUsage, index_buffer_meta::create_from_data(mesh.mIndices), read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(mesh.mIndices));
+				mesh.mBlasPositionsBuffer	= context().create_buffer(memory_usage::device, bufferUsage, vertex_buffer_meta::create_from_data(mesh.mPositions).describe_only_member(mesh.mPositions[0], content_description::position), read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(mesh.mPositions));
+				mesh.mBlasIndexBuffer		->fill(mesh.mIndices.data(),   0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+				mesh.mBlasPositionsBuffer	->fill(mesh.mPositions.data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+				rdoc::labelBuffer(mesh.mBlasIndexBuffer    ->handle(), "dynObj_BlasIndexBuffer");
+				rdoc::labelBuffer(mesh.mBlasPositionsBuffer->handle(), "dynObj_BlasPositionsBuffer");
+
+				for (auto &p : mesh.mPositions) dynObj.mBoundingRadius = std::max(dynObj.mBoundingRadius, glm::length(p));
+
+				// animated objects get one BLAS per frame in flight, so refitting never touches a BLAS that is still in use
+				auto numBlas = dynObj.mIsAnimated ? context().main_window()->number_of_frames_in_flight() : 1;
+				for (decltype(numBlas) i = 0; i < numBlas; ++i) {
+					mesh.mBLAS[i] = context().create_bottom_level_acceleration_structure({ acceleration_structure_size_requirements::from_buffers(vertex_index_buffer_pair{mesh.mBlasPositionsBuffer, mesh.mBlasIndexBuffer}) }, true);
+					mesh.mBLAS[i].enable_shared_ownership();
+					mesh.mBLAS[i]->build({ vertex_index_buffer_pair{mesh.mBlasPositionsBuffer, mesh.mBlasIndexBuffer} }, {}, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler()));
+				}
+				for (size_t i = numBlas; i < mesh.mBLAS.size(); ++i) mesh.mBLAS[i] = mesh.mBLAS[0];
 			}
 
 			maxGeometryInstancesForDynObjs = std::max(maxGeometryInstancesForDynObjs, dynObj.mParts.size());
@@ -1747,13 +2513,30 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		//	mSceneData.mGeometryInstances.push_back(std::move(geoInstance));
 		//}
 
+		// persistent TLAS instance buffers, one per frame in flight: static instances first (only touched when the reduced TLAS
+		// (de)activates some of them, see write_static_instances), followed by a fixed number of slots for the moving object
+		// (patched in place, see write_mover_instances)
+		mTlasNumStaticInstances = static_cast<uint32_t>(mSceneData.mGeometryInstances.size());
+		mTlasNumMoverSlots      = static_cast<uint32_t>(maxGeometryInstancesForDynObjs);
+		mTlasStaticInstancesGpu = avk::convert_for_gpu_usage(mSceneData.mGeometryInstances);
+		mTlasStaticActive.assign(mTlasNumStaticInstances, 1);
+		auto initialInstancesGpu = mTlasStaticInstancesGpu;
+		initialInstancesGpu.resize(size_t{mTlasNumStaticInstances} + mTlasNumMoverSlots, unused_mover_instance());
+		for (decltype(numFif) i = 0; i < numFif; ++i) {
+			mTlasStaticActiveInBuffer[i].assign(mTlasNumStaticInstances, 1);
+			mTlasInstanceBuffers[i] = context().create_buffer(memory_usage::host_coherent, bufferUsage,
+															  geometry_instance_buffer_meta::create_from_data(initialInstancesGpu),
+															  read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(initialInstancesGpu));
+			mTlasInstanceBuffers[i]->fill(initialInstancesGpu.data(), 0, sync::not_required());
+			rdoc::labelBuffer(mTlasInstanceBuffers[i]->handle(), "rt_TlasInstanceBuffer", i);
+			mTlasPending[i] = tlas_pending::none;
+		}
+
 		// build top level acceleration structure, one per frame
-		mAllGeometryInstances = mSceneData.mGeometryInstances;
-		auto numFif = context().main_window()->number_of_frames_in_flight();
 		for (decltype(numFif) i = 0; i < numFif; ++i) {
-			auto tlas = context().create_top_level_acceleration_structure(static_cast<uint32_t>(mSceneData.mGeometryInstances.size() + maxGeometryInstancesForDynObjs), true);
+			auto tlas = context().create_top_level_acceleration_structure(mTlasNumStaticInstances + mTlasNumMoverSlots, true);
 
-			tlas->build(mSceneData.mGeometryInstances, {}, avk::sync::with_barriers(
+			tlas->build(mTlasInstanceBuffers[i], {}, avk::sync::with_barriers(
 				gvk::context().main_window()->command_buffer_lifetime_handler(),
 				// Sync before building the TLAS:
 				[](avk::command_buffer_t& commandBuffer, avk::pipeline_stage destinationStage, std::optional<avk::read_memory_access> readAccess){
@@ -1774,75 +2557,12 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			mSceneData.mTLASs[i] = std::move(tlas);
 		}
 
-		// create images to render into
-		std::vector<avk::command_buffer> layoutTransitions;
-		auto win = context().main_window();
-		//const auto wdth = win->resolution().x;
-		//const auto hght = win->resolution().y;
-		//const auto frmt = format_from_window_color_buffer(win);
-		const auto wdth = mLoResolution.x;
-		const auto hght = mLoResolution.y;
-		const auto frmt = IMAGE_FORMAT_RAYTRACE;
-		for (decltype(numFif) i = 0; i < numFif; ++i) {
-			auto offscreenImage = context().create_image(wdth, hght, frmt, 1, memory_usage::device, image_usage::general_storage_image);
-			offscreenImage->transition_to_layout({}, sync::with_barriers(win->command_buffer_lifetime_handler()));
-			mRtImageViews[i] = context().create_image_view(owned(offscreenImage));
-			assert((mRtImageViews[i]->create_info().subresourceRange.aspectMask & vk::ImageAspectFlagBits::eColor) == vk::ImageAspectFlagBits::eColor);
-		}
-		{
-			auto dummySegMask = context().create_image(1, 1, TAA_IMAGE_FORMAT_SEGMASK, 1, memory_usage::device, image_usage::general_storage_image);
-			mRtDummySegMask = context().create_image_view(owned(dummySegMask));
-			layoutTransitions.emplace_back(std::move(mRtDummySegMask->get_image().transition_to_layout({}, avk::sync::with_barriers_by_return({}, {})).value()));
-		}
-		std::vector<avk::resource_reference<avk::command_buffer_t>> commandBufferReferences;
-		std::transform(std::begin(layoutTransitions), std::end(layoutTransitions), std::back_inserter(commandBufferReferences), [](avk::command_buffer& cb) { return avk::referenced(*cb); });
-		auto fen = mQueue->submit_with_fence(commandBufferReferences);
-		fen->wait_until_signalled();
-
-
 		// create a halton sequence for sample offsets + a buffer for them
 		auto halton = helpers::halton_2_3<RAYTRACING_MAX_SAMPLES_PER_PIXEL>(glm::vec2(1.f));
 		//for (auto &v : halton) printf("%f %f\n", v.x, v.y);
 		mRtPixelOffsetBuffer = context().create_buffer(memory_usage::device, bufferUsage, storage_buffer_meta::create_from_data(halton));
 		mRtPixelOffsetBuffer->fill(halton.data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // FIXME - sync ok?
 
-		// create animated object normals and normals-offset buffers
-		// first determine max size
-		size_t maxAnimObjNormals = 0;
-		size_t maxAnimObjMeshes  = 0;
-		for (auto &dynObj : mDynObjects) {
-			if (dynObj.mIsAnimated) {
-				size_t cntNrm = 0;
-				for (auto &mesh : dynObj.mMeshData) cntNrm += mesh.mNormals.size();
-				maxAnimObjMeshes  = std::max(maxAnimObjMeshes, dynObj.mMeshData.size());
-				maxAnimObjNormals = std::max(maxAnimObjNormals, cntNrm);
-			}
-		}
-		std::vector<glm::vec3> dummyVec3s(maxAnimObjNormals);
-		std::vector<uint32_t>  dummyNTBOff(maxAnimObjMeshes);
-		for (decltype(numFif) i = 0; i < numFif; ++i) {
-			mRtAnimObjNormalsBuffer       [i] = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(dummyVec3s).set_format<glm::vec3>());
-			mRtAnimObjTangentsBuffer      [i] = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(dummyVec3s).set_format<glm::vec3>());
-			mRtAnimObjBitangentsBuffer    [i] = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(dummyVec3s).set_format<glm::vec3>());
-			mRtAnimObjPositionsBuffer     [i] = context().create_buffer(memory_usage::device, bufferUsage, uniform_texel_buffer_meta::create_from_data(dummyVec3s).set_format<glm::vec3>());
-			mRtAnimObjNTBOffsetBuffer     [i] = context().create_buffer(memory_usage::device, bufferUsage, storage_buffer_meta::create_from_data(dummyNTBOff));
-			mRtAnimObjNormalsBuffer       [i]->fill(dummyVec3s.data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // filling isn't really necessary, is it?
-			mRtAnimObjTangentsBuffer      [i]->fill(dummyVec3s.data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // filling isn't really necessary, is it?
-			mRtAnimObjBitangentsBuffer    [i]->fill(dummyVec3s.data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // filling isn't really necessary, is it?
-			mRtAnimObjPositionsBuffer     [i]->fill(dummyVec3s.data(),  0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // filling isn't really necessary, is it?
-			mRtAnimObjNTBOffsetBuffer     [i]->fill(dummyNTBOff.data(), 0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // filling isn't really necessary, is it?
-			mRtAnimObjNormalsBuffer       [i].enable_shared_ownership();
-			mRtAnimObjTangentsBuffer      [i].enable_shared_ownership();
-			mRtAnimObjBitangentsBuffer    [i].enable_shared_ownership();
-			mRtAnimObjPositionsBuffer     [i].enable_shared_ownership();
-			mRtAnimObjNormalsBufferView   [i] = context().create_buffer_view(shared(mRtAnimObjNormalsBuffer   [i]));
-			mRtAnimObjTangentsBufferView  [i] = context().create_buffer_view(shared(mRtAnimObjTangentsBuffer  [i]));
-			mRtAnimObjBitangentsBufferView[i] = context().create_buffer_view(shared(mRtAnimObjBitangentsBuffer[i]));
-			mRtAnimObjPositionsBufferView [i] = context().create_buffer_view(shared(mRtAnimObjPositionsBuffer [i]));
-			// note: storage buffers with vec3's are bad! that's why we use a uniform_texel_buffer for normals
-		}
-
-
 		// create ray tracing pipeline
 		mPipelineRayTrace = context().create_ray_tracing_pipeline_for(
 			define_shader_table(
@@ -1856,26 +2576,25 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			push_constant_binding_data{shader_type::ray_generation | shader_type::closest_hit | shader_type::any_hit, 0, sizeof(push_constant_data_for_rt)},
 			RAYTRACING_DESCRIPTOR_BINDINGS(0),
 			descriptor_binding(3, 0, mRtImageViews[0]->as_storage_image()),	// when rendering, TASS result image is used
-			descriptor_binding(3, 1, mRtDummySegMask->as_storage_image())	// when rendering, TASS segmask is used
+			descriptor_binding(3, 1, mRtDummySegMask->as_storage_image()),	// when rendering, TASS segmask is used
+			descriptor_binding(3, 2, mRtDummyPixelList->as_storage_buffer())	// when rendering, TASS pixel list is used
 		);
 		//mPipelineRayTrace->print_shader_binding_table_groups();
-
 	}
 
 	void update_top_level_acceleration_structure() {
 		// update acceleration structure because:
-		// - dynamic object has been toggled on/off
-		// - dynamic object has been switched to a different model
-		// - dynamic object has moved
-		// - TODO: animation
-		// - or because we need extend a previous update for the remaining frames in flight
+		// - dynamic object has been toggled on/off						-> rebuild
+		// - dynamic object has been switched to a different model		-> rebuild
+		// - dynamic object has moved									-> update
+		// - (animation: see update_bottom_level_acceleration_structures)
+		// - reduced TLAS: static instances entered/left the ray traced region		-> rebuild
+		// each frame in flight has its own TLAS + instance buffer; a change is recorded for all of them and
+		// carried out for each one when it comes up - only the mover's slots and (de)activated static instances are rewritten
 
 		using namespace avk;
 		using namespace gvk;
 
-		static int64_t updateUntilFrame  = -1;
-		static int64_t rebuildUntilFrame = -1;
-
 		// check if we need to rebuild due to object switch or enable toggle
 		bool needRebuild = false;
 		for (int iDynObj = 0; iDynObj < mDynObjects.size(); ++iDynObj) {
@@ -1888,39 +2607,34 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		// check if we need to update due to object movement
 		bool needUpdate = (mMovingObject.enabled && mDynObjects[mMovingObject.moverId].mMovementMatrix_in_AS != mDynObjects[mMovingObject.moverId].mMovementMatrix_current);
 
-		if (needRebuild) rebuildUntilFrame = context().main_window()->current_frame() + context().main_window()->number_of_frames_in_flight() - 1;
-		if (needUpdate)  updateUntilFrame  = context().main_window()->current_frame() + context().main_window()->number_of_frames_in_flight() - 1;
-		if (context().main_window()->current_frame() > updateUntilFrame && context().main_window()->current_frame() > rebuildUntilFrame) return;
+		if (needRebuild || needUpdate) {
+			// clear all mIsInAccelerationStructure flags
+			for (auto &dynObj : mDynObjects) dynObj.mIsInAccelerationStructure = false;
 
-		auto fif = context().main_window()->in_flight_index_for_frame();
-
-		// clear all mIsInAccelerationStructure flags
-		for (auto &dynObj : mDynObjects) dynObj.mIsInAccelerationStructure = false;
-
-		mAllGeometryInstances = mSceneData.mGeometryInstances;
-
-		if (mMovingObject.enabled) {
-			// add geometry instances for active object
-			auto &dynObj = mDynObjects[mMovingObject.moverId];
-			dynObj.mIsInAccelerationStructure = true;
-			dynObj.mMovementMatrix_in_AS = dynObj.mMovementMatrix_current;
-
-			for (auto &part : dynObj.mParts) {
-				auto tform = dynObj.mIsAnimated ? dynObj.mBaseTransform : dynObj.mBaseTransform * part.mMeshTransform; // don't use the mesh transform for animated models, this is taken care of by bone animation
-				auto &mesh = dynObj.mMeshData[part.mMeshIndex];
-				auto geoInstance = context().create_geometry_instance(mesh.mBLAS);
-				geoInstance.set_transform_column_major(to_array(dynObj.mMovementMatrix_in_AS * tform));
-				geoInstance.set_custom_index(dynObj.mRtCustomIndexBase + part.mMeshIndex);
-				geoInstance.set_mask(RAYTRACING_CULLMASK_OPAQUE);
-				mAllGeometryInstances.push_back(std::move(geoInstance));
+			if (mMovingObject.enabled) {
+				auto &dynObj = mDynObjects[mMovingObject.moverId];
+				dynObj.mIsInAccelerationStructure = true;
+				dynObj.mMovementMatrix_in_AS = dynObj.mMovementMatrix_current;
 			}
+			for (auto &pending : mTlasPending) pending = std::max(pending, needRebuild ? tlas_pending::rebuild : tlas_pending::update);
+		}
 
+		// instances can't be (de)activated by an update
+		if (update_reduced_tlas_selection()) {
+			for (auto &pending : mTlasPending) pending = tlas_pending::rebuild;
 		}
 
+		auto fif = context().main_window()->in_flight_index_for_frame();
+		if (mTlasPending[fif] == tlas_pending::none) return;
+
+		// the instance buffer of this frame in flight is no longer in use (the frame's fence has been waited on)
+		write_static_instances(fif);
+		write_mover_instances(fif);
+
 		// rebuild or update TLAS for the current frame in flight
-		if (context().main_window()->current_frame() <= rebuildUntilFrame) {
+		if (mTlasPending[fif] == tlas_pending::rebuild) {
 			// full rebuild
-			mSceneData.mTLASs[fif]->build(mAllGeometryInstances, {}, avk::sync::with_barriers(
+			mSceneData.mTLASs[fif]->build(mTlasInstanceBuffers[fif], {}, avk::sync::with_barriers(
 				gvk::context().main_window()->command_buffer_lifetime_handler(),
 				// Sync before building the TLAS:
 				[](avk::command_buffer_t& commandBuffer, avk::pipeline_stage destinationStage, std::optional<avk::read_memory_access> readAccess){
@@ -1938,26 +2652,154 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				//   this handler)
 				avk::sync::presets::default_handler_after_operation
 			));
+			mRtBlasStats.numTlasRebuilds++;
 			PRINT_DEBUGMARK("TLAS-Rebuild");
 		} else {
-			// just update existing TLAS
-			mSceneData.mTLASs[fif]->update(mAllGeometryInstances, {}, avk::sync::with_barriers(
-				gvk::context().main_window()->command_buffer_lifetime_handler(),
-				{}, // Nothing to wait for
-				// NOTE: this causes a validation error now - bug in current vulkan sdk (1.2.170.0)? -> see todo.txt
-				// THEREFORE TEMPORARILY REPLACED BY WAIT IDLE - FIXME!!!
-				//[](avk::command_buffer_t& commandBuffer, avk::pipeline_stage srcStage, std::optional<avk::write_memory_access> srcAccess){
-				//	// We want this update to be as efficient/as tight as possible
-				//	commandBuffer.establish_global_memory_barrier_rw(
-				//		srcStage, avk::pipeline_stage::ray_tracing_shaders, // => ray tracing shaders must wait on the building of the acceleration structure
-				//		srcAccess, avk::memory_access::acceleration_structure_read_access // TLAS-update's memory must be made visible to ray tracing shader's caches (so they can read from)
-				//	);
-				//}
-				{} // <- FIXME
-			));
-			context().device().waitIdle(); // <- FIXME
-			PRINT_DEBUGMARK("TLAS-Update");
+			// just update existing TLAS
+			mSceneData.mTLASs[fif]->update(mTlasInstanceBuffers[fif], {}, avk::sync::with_barriers(
+				gvk::context().main_window()->command_buffer_lifetime_handler(),
+				{}, // Nothing to wait for
+				barrier_after_acceleration_structure_update
+			));
+			if (mRtBlas.waitIdleAfterUpdate) context().device().waitIdle();
+			mRtBlasStats.numTlasUpdates++;
+			PRINT_DEBUGMARK("TLAS-Update");
+		}
+		mTlasPending[fif] = tlas_pending::none;
+	}
+
+	static void barrier_after_acceleration_structure_update(avk::command_buffer_t& commandBuffer, avk::pipeline_stage srcStage, std::optional<avk::write_memory_access> srcAccess) {
+		// ray tracing shaders must wait on the TLAS/BLAS update, and its memory must be visible to them
+		// note: uses fixed stages/accesses - forwarding srcStage/srcAccess triggered a validation error (see todo.txt)
+		// all AS updates and the frame's ray tracing are submitted to the same queue, so this global barrier is all the sync needed (no waitIdle)
+		commandBuffer.establish_global_memory_barrier_rw(
+			avk::pipeline_stage::acceleration_structure_build, avk::pipeline_stage::ray_tracing_shaders,
+			avk::memory_access::acceleration_structure_write_access, avk::memory_access::acceleration_structure_read_access
+		);
+	}
+
+	bool update_reduced_tlas_selection() {
+		// reduced TLAS: only static instances which can be hit are active - the ray traced frustum (apex at the camera, as calc_ray in
+		// the ray generation shader; only the four side planes, rays are not cut at the far plane), extruded towards the light by the
+		// shadow ray length; returns true if the selection changed
+		auto &rt = mRtReducedTlas;
+		const auto &bounds = mSceneData.mGeometryInstanceBounds;
+		const size_t n = bounds.size();
+		bool changed = false;
+
+		if (!rt.enabled) {
+			for (auto &a : mTlasStaticActive) if (!a) { a = 1; changed = true; }
+			rt.numActive = n;
+			return changed;
+		}
+
+		const glm::mat4 camTransform = mQuakeCam.global_transformation_matrix();
+		const float aspectRatio = static_cast<float>(mLoResolution.x) / static_cast<float>(mLoResolution.y);
+		const glm::vec3 apex    = glm::vec3(camTransform * glm::vec4(0, 0, 0, 1));
+		const glm::vec3 forward = glm::vec3(camTransform * glm::vec4(0, 0, -1, 0));
+		const glm::vec2 cornerUV[4] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+		glm::vec3 corner[4];
+		for (int i = 0; i < 4; ++i) corner[i] = glm::vec3(camTransform * glm::vec4(cornerUV[i].x * aspectRatio, cornerUV[i].y, -sqrt(3.f), 0));
+		glm::vec4 planes[4];
+		for (int i = 0; i < 4; ++i) {
+			glm::vec3 nrm = glm::normalize(glm::cross(corner[i], corner[(i + 1) % 4]));
+			if (glm::dot(nrm, forward) > 0.f) nrm = -nrm;	// outward facing (as in FrustumCulling)
+			planes[i] = glm::vec4(nrm, -glm::dot(nrm, apex));
+		}
+
+		// a caster at p shadows receivers at p + lightDir * t, so sweep the instance bounds along the light direction
+		const glm::vec3 sweep = mShadowMap.enable ? glm::normalize(mDirLight.dir) * rt.shadowRayLength : glm::vec3(0);
+		size_t numActive = 0;
+		for (size_t i = 0; i < n; ++i) {
+			const glm::vec3 bmin = glm::min(bounds[i].min, bounds[i].min + sweep);
+			const glm::vec3 bmax = glm::max(bounds[i].max, bounds[i].max + sweep);
+			const float grow = rt.margin + (mTlasStaticActive[i] ? rt.hysteresis : 0.f);	// active instances are dropped only a bit further out
+			const bool active = FrustumCulling::PlanesAABBIntersect(planes, 4, bmin - grow, bmax + grow) != FrustumCulling::TestResult::outside;
+			if (active != (mTlasStaticActive[i] != 0)) {
+				mTlasStaticActive[i] = active ? 1 : 0;
+				changed = true;
+			}
+			if (active) numActive++;
+		}
+		rt.numActive = numActive;
+		if (changed) rt.numChanges++;
+		return changed;
+	}
+
+	void write_static_instances(gvk::window::frame_id_t fif) {
+		// patch the static instances whose reduced TLAS state differs from the instance buffer of this frame in flight
+		// (inactive = acceleration structure reference 0, these are skipped by the build)
+		auto &inBuffer = mTlasStaticActiveInBuffer[fif];
+		const size_t elemSize = sizeof(mTlasStaticInstancesGpu[0]);
+		for (size_t i = 0; i < mTlasStaticActive.size(); ++i) {
+			if (inBuffer[i] == mTlasStaticActive[i]) continue;
+			auto inst = mTlasStaticInstancesGpu[i];
+			if (!mTlasStaticActive[i]) inst.accelerationStructureReference = 0;
+			mTlasInstanceBuffers[fif]->fill(&inst, 0, i * elemSize, elemSize, avk::sync::not_required());
+			inBuffer[i] = mTlasStaticActive[i];
+		}
+	}
+
+	static VkAccelerationStructureInstanceKHR unused_mover_instance() {
+		// placeholder for an unused mover slot (the instance count of the TLAS never changes): inactive, like the static instances
+		// deactivated by the reduced TLAS (acceleration structure reference 0) - needs no BLAS, so this also works without static geometry
+		VkAccelerationStructureInstanceKHR inst = {};
+		inst.accelerationStructureReference = 0;
+		inst.mask = 0;
+		return inst;
+	}
+
+	void write_mover_instances(gvk::window::frame_id_t fif) {
+		// patch the moving object's slots in the persistent instance buffer of this frame in flight (referring to the BLASs of this frame in flight)
+		std::vector<avk::geometry_instance> instances;
+		instances.reserve(mTlasNumMoverSlots);
+		if (mMovingObject.enabled) {
+			auto &dynObj = mDynObjects[mMovingObject.moverId];
+			for (auto &part : dynObj.mParts) {
+				auto tform = dynObj.mIsAnimated ? dynObj.mBaseTransform : dynObj.mBaseTransform * part.mMeshTransform; // don't use the mesh transform for animated models, this is taken care of by bone animation
+				auto &mesh = dynObj.mMeshData[part.mMeshIndex];
+				auto geoInstance = gvk::context().create_geometry_instance(mesh.mBLAS[fif]);
+				geoInstance.set_transform_column_major(gvk::to_array(dynObj.mMovementMatrix_in_AS * tform));
+				geoInstance.set_custom_index(dynObj.mRtCustomIndexBase + part.mMeshIndex);
+				geoInstance.set_mask(RAYTRACING_CULLMASK_OPAQUE);
+				instances.push_back(std::move(geoInstance));
+			}
+		}
+		assert(instances.size() <= mTlasNumMoverSlots);
+		if (mTlasNumMoverSlots == 0) return;
+
+		auto gpuData = avk::convert_for_gpu_usage(instances);
+		gpuData.resize(mTlasNumMoverSlots, unused_mover_instance());
+		const size_t elemSize = sizeof(gpuData[0]);
+		mTlasInstanceBuffers[fif]->fill(gpuData.data(), 0, mTlasNumStaticInstances * elemSize, gpuData.size() * elemSize, avk::sync::not_required());
+	}
+
+	bool blas_needs_rebuild(dynamic_object &dynObj, gvk::window::frame_id_t fif) {
+		// refitting keeps the BVH topology of the last full build, so its quality degrades as the pose drifts away from that
+		// -> rebuild every mRtBlas.rebuildInterval frames, or when the bones have moved too far (relative to the object size)
+		auto &pose = dynObj.mBlasRebuildPose[fif];
+		const size_t n = dynObj.mBoneMatrices.size();
+		const glm::mat4 *cur = dynObj.mCurBoneMatrices ? dynObj.mCurBoneMatrices : dynObj.mBoneMatrices.data();
+
+		bool rebuild = pose.size() != n || (mRtBlas.rebuildInterval > 0 && dynObj.mBlasRefitsSinceRebuild[fif] >= mRtBlas.rebuildInterval);
+		if (!rebuild) {
+			float dev = 0.f;
+			for (size_t i = 0; i < n; ++i) {
+				glm::mat4 d = cur[i] - pose[i];
+				float dLin = std::max({ glm::length(glm::vec3(d[0])), glm::length(glm::vec3(d[1])), glm::length(glm::vec3(d[2])) });
+				dev = std::max(dev, glm::length(glm::vec3(d[3])) + dLin * dynObj.mBoundingRadius);
+			}
+			mRtBlasStats.poseDeviation = dev / std::max(dynObj.mBoundingRadius, 1e-6f);
+			rebuild = mRtBlas.maxPoseDeviation > 0.f && mRtBlasStats.poseDeviation > mRtBlas.maxPoseDeviation;
+		}
+
+		if (rebuild) {
+			pose.assign(cur, cur + n);
+			dynObj.mBlasRefitsSinceRebuild[fif] = 0;
+		} else {
+			dynObj.mBlasRefitsSinceRebuild[fif]++;
 		}
+		return rebuild;
 	}
 
 	void update_bottom_level_acceleration_structures() {
@@ -1971,50 +2813,30 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		auto &dynObj = mDynObjects[mMovingObject.moverId];
 		if (!dynObj.mIsAnimated) return;
 
-		vk::BufferUsageFlags bufferUsage = { vk::BufferUsageFlagBits::eShaderDeviceAddressKHR };
-
 		auto fif = context().main_window()->in_flight_index_for_frame();
 
 		const bool alsoUpdateTLAS = true;
 		// seems like updating the BLASs is not enough, if the changed positions leave the initial AABB -> looks cut off (e.g. dragon, dude)
 		// so update the TLASs afterwards too, then it's fine
 
-		// blas index buffer stays the same, but the vertex buffer needs to be changed   TODO: -> compute shader
-		std::vector<glm::vec3> allNewNormals, allNewTangents, allNewBitangents, allNewPositions;
+		// all inputs are persistent: the index buffer was uploaded once, the vertex buffer is the output of the skinning compute pass (already synced by compute_skinning)
+		const bool rebuild = blas_needs_rebuild(dynObj, fif);
 		for (int iMesh = 0; iMesh < dynObj.mMeshData.size(); ++iMesh) {
 			auto &mesh = dynObj.mMeshData[iMesh];
-
-			//auto newPositions = calc_new_mesh_positions_for_testing_only(mesh.mPositions);
-			auto [newPositions, newNormals, newTangents, newBitangents] = calc_new_mesh_positions_and_ntb_for_animated_object(dynObj, iMesh);
-
-			auto tmpIndexBuffer		= context().create_buffer(memory_usage::device, bufferUsage, index_buffer_meta::create_from_data(mesh.mIndices), read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(mesh.mIndices));
-			auto tmpPositionsBuffer	= context().create_buffer(memory_usage::device, bufferUsage, vertex_buffer_meta::create_from_data(newPositions).describe_only_member(newPositions[0], content_description::position), read_only_input_to_acceleration_structure_builds_buffer_meta::create_from_data(newPositions));
-			tmpIndexBuffer.enable_shared_ownership();
-			tmpPositionsBuffer.enable_shared_ownership();
-			tmpIndexBuffer		->fill(mesh.mIndices.data(),   0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // FIXME - sync ok?
-			tmpPositionsBuffer	->fill(newPositions.data(),    0, sync::with_barriers(context().main_window()->command_buffer_lifetime_handler())); // FIXME - sync ok?
-
-			mesh.mBLAS->update({ vertex_index_buffer_pair{tmpPositionsBuffer, tmpIndexBuffer} }, {},
-				avk::sync::with_barriers(
-					[posBfr = tmpPositionsBuffer, idxBfr = tmpIndexBuffer](avk::command_buffer cb) {
-						cb->set_custom_deleter([lPosBfr = std::move(posBfr), lIdxBfr = std::move(idxBfr)](){});
-						gvk::context().main_window()->handle_lifetime(avk::owned(cb));
-					},
-					{}, {}
-				)
-			);
-
-			insert_into(allNewNormals,    newNormals);
-			insert_into(allNewTangents,   newTangents);
-			insert_into(allNewBitangents, newBitangents);
-			insert_into(allNewPositions,  newPositions);
+			auto geometry = vertex_index_buffer_pair{ mesh.mSkinnedPositionsBuffer[fif], mesh.mBlasIndexBuffer };
+			if (rebuild) {
+				mesh.mBLAS[fif]->build ({ geometry }, {}, avk::sync::with_barriers(context().main_window()->command_buffer_lifetime_handler(), {}, {}));
+			} else {
+				mesh.mBLAS[fif]->update({ geometry }, {}, avk::sync::with_barriers(context().main_window()->command_buffer_lifetime_handler(), {}, {}));
+			}
 		}
+		if (rebuild) mRtBlasStats.numRebuilds++; else mRtBlasStats.numRefits++;
 
 		if (alsoUpdateTLAS) {
-			// update TLAS
+			// update TLAS - the instance buffer needs no changes, the mover's slots of this frame in flight already refer to this frame's BLASs
 			// !be sure that at this point the TLAS is built including the current dynObj! -> otherwise may lose device
 			//PRINT_DEBUGMARK("before anim TLAS-Update");
-			mSceneData.mTLASs[fif]->update(mAllGeometryInstances, {}, avk::sync::with_barriers(
+			mSceneData.mTLASs[fif]->update(mTlasInstanceBuffers[fif], {}, avk::sync::with_barriers(
 				gvk::context().main_window()->command_buffer_lifetime_handler(),
 				// Sync before building the TLAS:
 				[](avk::command_buffer_t& commandBuffer, avk::pipeline_stage destinationStage, std::optional<avk::read_memory_access> readAccess) {
@@ -2026,64 +2848,20 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 						avk::memory_access::acceleration_structure_write_access, readAccess
 					);
 				},
-				// NOTE: this causes a validation error now - bug in current vulkan sdk (1.2.170.0)? -> see todo.txt
-				// THEREFORE TEMPORARILY REPLACED BY WAIT IDLE - FIXME!!!
-				//[](avk::command_buffer_t& commandBuffer, avk::pipeline_stage srcStage, std::optional<avk::write_memory_access> srcAccess) {
-				//	// We want this update to be as efficient/as tight as possible
-				//	commandBuffer.establish_global_memory_barrier_rw(
-				//		srcStage, avk::pipeline_stage::ray_tracing_shaders, // => ray tracing shaders must wait on the building of the acceleration structure
-				//		srcAccess, avk::memory_access::acceleration_structure_read_access // TLAS-update's memory must be made visible to ray tracing shader's caches (so they can read from)
-				//	);
-				//}
-				{} // <- FIXME
+				barrier_after_acceleration_structure_update
 			));
-			context().device().waitIdle(); // <- FIXME
+			if (mRtBlas.waitIdleAfterUpdate) context().device().waitIdle();
 			//PRINT_DEBUGMARK("after anim TLAS-Update");
 		} else {
-			context().device().waitIdle(); // FIXME - wait for all BLASs to be rebuilt
-		}
-
-		// update normals- and vertex-count buffers for anim object
-		update_ntb_buffers_for_animated_object(dynObj, allNewNormals, allNewTangents, allNewBitangents, allNewPositions, fif);
-	}
-
-	std::tuple<std::vector<glm::vec3>,std::vector<glm::vec3>,std::vector<glm::vec3>,std::vector<glm::vec3>> calc_new_mesh_positions_and_ntb_for_animated_object(dynamic_object &dynObj, int iMeshIndex) {
-		// returns tuple { positions, normals, tangents, bitangents }
-		// bone matrices have to be calculated already
-		// TODO: do this in a compute shader
-		auto &mesh = dynObj.mMeshData[iMeshIndex];
-		int bonesBaseIndex = iMeshIndex * MAX_BONES;
-		auto &posOrg = dynObj.mMeshData[iMeshIndex].mPositions;
-		auto &nrmOrg = dynObj.mMeshData[iMeshIndex].mNormals;
-		auto &tanOrg = dynObj.mMeshData[iMeshIndex].mTangents;
-		auto &bitOrg = dynObj.mMeshData[iMeshIndex].mBitangents;
-
-		const size_t numVertices = posOrg.size();
-		assert(nrmOrg.size() == numVertices);
-
-		std::vector<glm::vec3> posNew(numVertices), nrmNew(numVertices), tanNew(numVertices), bitNew(numVertices);
-		
-		for (auto i = 0; i < numVertices; ++i) {
-			auto &aBoneIndices = mesh.mBoneIndices[i];
-			auto &aBoneWeights = mesh.mBoneWeights[i];
-			glm::mat4 boneMat =
-				dynObj.mBoneMatrices[bonesBaseIndex + aBoneIndices[0]] * aBoneWeights[0] +
-				dynObj.mBoneMatrices[bonesBaseIndex + aBoneIndices[1]] * aBoneWeights[1] +
-				dynObj.mBoneMatrices[bonesBaseIndex + aBoneIndices[2]] * aBoneWeights[2] +
-				dynObj.mBoneMatrices[bonesBaseIndex + aBoneIndices[3]] * aBoneWeights[3];
-
-			posNew[i] = glm::vec3(boneMat * glm::vec4(posOrg[i], 1.0f));	// TODO: afair there was a problem with storing pos in a vec3 in the original raster code? (.w != 1) dragon?
-
-			//glm::mat3 nrmMatrix = glm::mat3(glm::inverse(glm::transpose(boneMat)));
-			//nrmNew[i] = glm::normalize(nrmMatrix * glm::normalize(nrmOrg[i]));
-
-			glm::mat4 nrmMatrix = glm::inverse(glm::transpose(boneMat));
-			nrmNew[i] = glm::normalize(glm::vec3(nrmMatrix * glm::vec4(glm::normalize(nrmOrg[i]), 0)));
-			tanNew[i] = glm::normalize(glm::vec3(nrmMatrix * glm::vec4(glm::normalize(tanOrg[i]), 0)));
-			bitNew[i] = glm::normalize(glm::vec3(nrmMatrix * glm::vec4(glm::normalize(bitOrg[i]), 0)));
+			// nothing recorded after the BLAS updates -> a separate barrier for the ray tracing shaders
+			auto cmd = context().get_command_pool_for_single_use_command_buffers(*mQueue)->alloc_command_buffer(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+			cmd->begin_recording();
+			barrier_after_acceleration_structure_update(*cmd, avk::pipeline_stage::acceleration_structure_build, avk::memory_access::acceleration_structure_write_access);
+			cmd->end_recording();
+			mQueue->submit(cmd, std::optional<avk::resource_reference<avk::semaphore_t>>{});
+			context().main_window()->handle_lifetime(avk::owned(cmd));
+			if (mRtBlas.waitIdleAfterUpdate) context().device().waitIdle();
 		}
-
-		return std::make_tuple(std::move(posNew), std::move(nrmNew), std::move(tanNew), std::move(bitNew));
 	}
 
 	std::vector<glm::vec3> calc_new_mesh_positions_for_testing_only(std::vector<glm::vec3> &posOrg) {
@@ -2107,27 +2885,6 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		return posNew;
 	}
 
-	void update_ntb_buffers_for_animated_object(dynamic_object &dynObj, std::vector<glm::vec3> &normals, std::vector<glm::vec3> &tangents, std::vector<glm::vec3> &bitangents, std::vector<glm::vec3> &positions, gvk::window::frame_id_t fif) {
-		// normals/tangents/bitangents-offset per mesh
-		uint32_t cnt = 0;
-		std::vector<uint32_t> ntbOff;
-		for (auto &mesh : dynObj.mMeshData) {
-			ntbOff.push_back(cnt);
-			cnt += static_cast<uint32_t>(mesh.mPositions.size());
-		}
-
-		// sanity check		
-		if (normals.size() != cnt || tangents.size() != cnt || bitangents.size() != cnt || positions.size() != cnt) {
-			throw avk::runtime_error("update_normals_buffer_for_animated_object sanity check failed !");
-		}
-
-		mRtAnimObjNormalsBuffer   [fif]->fill(normals.data(),    0, 0, cnt           * sizeof(glm::vec3), avk::sync::with_barriers(gvk::context().main_window()->command_buffer_lifetime_handler()));
-		mRtAnimObjTangentsBuffer  [fif]->fill(tangents.data(),   0, 0, cnt           * sizeof(glm::vec3), avk::sync::with_barriers(gvk::context().main_window()->command_buffer_lifetime_handler()));
-		mRtAnimObjBitangentsBuffer[fif]->fill(bitangents.data(), 0, 0, cnt           * sizeof(glm::vec3), avk::sync::with_barriers(gvk::context().main_window()->command_buffer_lifetime_handler()));
-		mRtAnimObjPositionsBuffer [fif]->fill(positions.data(),  0, 0, cnt           * sizeof(glm::vec3), avk::sync::with_barriers(gvk::context().main_window()->command_buffer_lifetime_handler()));
-		mRtAnimObjNTBOffsetBuffer [fif]->fill(ntbOff.data(),     0, 0, ntbOff.size() * sizeof(uint32_t),  avk::sync::with_barriers(gvk::context().main_window()->command_buffer_lifetime_handler()));
-	}
-
 	void update_acceleration_structures_test() {
 		// just a test for only updating the static scene geometries
 
@@ -2321,10 +3078,8 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				md.mNormalsBuffer			->fill(md.mNormals.data(),     0, avk::sync::with_barriers([this](avk::command_buffer cb){ mStoredCommandBuffers.emplace_back(std::move(cb)); }, {}, {}));
 				md.mTangentsBuffer			->fill(md.mTangents.data(),    0, avk::sync::with_barriers([this](avk::command_buffer cb){ mStoredCommandBuffers.emplace_back(std::move(cb)); }, {}, {}));
 				md.mBitangentsBuffer		->fill(md.mBitangents.data(),  0, avk::sync::with_barriers([this](avk::command_buffer cb){ mStoredCommandBuffers.emplace_back(std::move(cb)); }, {}, {}));
-				if (dynObj.mIsAnimated) {
-					md.mBoneWeightsBuffer	->fill(md.mBoneWeights.data(), 0, avk::sync::with_barriers([this](avk::command_buffer cb){ mStoredCommandBuffers.emplace_back(std::move(cb)); }, {}, {}));
-					md.mBoneIndicesBuffer	->fill(md.mBoneIndices.data(), 0, avk::sync::with_barriers([this](avk::command_buffer cb){ mStoredCommandBuffers.emplace_back(std::move(cb)); }, {}, {}));
-				}
+				md.mBoneWeightsBuffer		->fill(md.mBoneWeights.data(), 0, avk::sync::with_barriers([this](avk::command_buffer cb){ mStoredCommandBuffers.emplace_back(std::move(cb)); }, {}, {}));
+				md.mBoneIndicesBuffer		->fill(md.mBoneIndices.data(), 0, avk::sync::with_barriers([this](avk::command_buffer cb){ mStoredCommandBuffers.emplace_back(std::move(cb)); }, {}, {}));
 			}
 		}
 
@@ -2360,7 +3115,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			from_buffer_binding(4) -> stream_per_vertex<glm::vec3>() -> to_location(4),		// <-- corresponds to vertex shader's aBitangent
 			// Some further settings:
 			cfg::front_face::define_front_faces_to_be_counter_clockwise(),
-			cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+			render_viewport_config(),
 			mRenderpass, 0u, // Use this pipeline for subpass #0 of the specified renderpass
 			//
 			// The following define additional data which we'll pass to the pipeline:
@@ -2380,7 +3135,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			from_buffer_binding(0) -> stream_per_vertex(&helpers::quad_vertex::mPosition)          -> to_location(0),
 			from_buffer_binding(0) -> stream_per_vertex(&helpers::quad_vertex::mTextureCoordinate) -> to_location(1),
 			cfg::front_face::define_front_faces_to_be_clockwise(),
-			cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+			render_viewport_config(),
 			cfg::culling_mode::disabled,
 			cfg::depth_test::disabled(),
 			mRenderpass, 1u, // <-- Use this pipeline for subpass #1 of the specified renderpass
@@ -2428,7 +3183,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				from_buffer_binding(4)->stream_per_vertex<glm::vec3>()->to_location(4),		// <-- corresponds to vertex shader's aBitangent
 				// Some further settings:
 				cfg::front_face::define_front_faces_to_be_counter_clockwise(),
-				cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+				render_viewport_config(),
 				mRenderpass, 0u, // subpass #0
 				get_pipeline_alter_config_function_for_shading_rate(iShadingRatePass == 1),
 				push_constant_binding_data{ shader_type::all, 0, sizeof(push_constant_data_for_dii) }, // We also have to declare that we're going to submit push constants
@@ -2459,7 +3214,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				from_buffer_binding(4)->stream_per_vertex<glm::vec3>()->to_location(4),		// <-- corresponds to vertex shader's aBitangent
 				// Some further settings:
 				cfg::front_face::define_front_faces_to_be_clockwise(),
-				cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+				render_viewport_config(),
 				mRenderpass, 0u, // subpass #0
 				get_pipeline_alter_config_function_for_shading_rate(iShadingRatePass == 1),
 				push_constant_binding_data{ shader_type::all, 0, sizeof(push_constant_data_for_dii) }, // We also have to declare that we're going to submit push constants
@@ -2488,7 +3243,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				from_buffer_binding(4)->stream_per_vertex<glm::vec3>()->to_location(4),		// <-- corresponds to vertex shader's aBitangent
 																								// Some further settings:
 				cfg::front_face::define_front_faces_to_be_clockwise(),
-				cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+				render_viewport_config(),
 				mRenderpass, 0u, // subpass #0
 				get_pipeline_alter_config_function_for_shading_rate(iShadingRatePass == 1),
 				push_constant_binding_data{ shader_type::all, 0, sizeof(push_constant_data_for_dii) }, // We also have to declare that we're going to submit push constants
@@ -2525,10 +3280,9 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				from_buffer_binding(2) -> stream_per_vertex<glm::vec3>() -> to_location(2),		// aNormal
 				from_buffer_binding(3) -> stream_per_vertex<glm::vec3>() -> to_location(3),		// aTangent
 				from_buffer_binding(4) -> stream_per_vertex<glm::vec3>() -> to_location(4),		// aBitangent
-				from_buffer_binding(5) -> stream_per_vertex<glm::vec4>() -> to_location(5),		// aBoneWeights
-				from_buffer_binding(6) -> stream_per_vertex<glm::uvec4>()-> to_location(6),		// aBoneIndices
+				from_buffer_binding(5) -> stream_per_vertex<glm::vec3>() -> to_location(5),		// aPrevPosition
 				cfg::front_face::define_front_faces_to_be_counter_clockwise(),
-				cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+				render_viewport_config(),
 				mRenderpass, 0u, // subpass #0
 				get_pipeline_alter_config_function_for_shading_rate(iShadingRatePass == 1),
 				push_constant_binding_data { shader_type::all, 0, sizeof(push_constant_data_for_dii) },
@@ -2537,12 +3291,42 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				SCENE_DRAW_DESCRIPTOR_BINDINGS(0)
 				SHADOWMAP_DESCRIPTOR_BINDINGS(0)
 				descriptor_binding(1, 0, mMatricesUserInputBuffer[0]),
-				descriptor_binding(1, 1, mLightsourcesBuffer[0]),
-				descriptor_binding(3, 0, mBoneMatricesBuffer[0]),
-				descriptor_binding(3, 1, mBoneMatricesPrevBuffer[0])
+				descriptor_binding(1, 1, mLightsourcesBuffer[0])
 			);
 			if (iShadingRatePass == 0) mPipelineAnimObject = std::move(tmpPipelineAnimObject); else mPipelineVrsAnimObject = std::move(tmpPipelineAnimObject);
 
+			// instanced moving objects, skinned in the vertex shader (per-instance bone palettes)
+			auto tmpPipelineCrowd = context().create_graphics_pipeline_for(
+				vertex_shader("shaders/crowd.vert.spv"),
+				#if FORWARD_RENDERING
+					fragment_shader("shaders/fwd_geometry.frag.spv").set_specialization_constant(SPECCONST_ID_TRANSPARENCY, uint32_t{ SPECCONST_VAL_OPAQUE }), //  opaque pass
+				#else
+					fragment_shader("shaders/blinnphong_and_normal_mapping.frag.spv"),
+				#endif
+				from_buffer_binding(0) -> stream_per_vertex<glm::vec3>()  -> to_location(0),		// aPosition
+				from_buffer_binding(1) -> stream_per_vertex<glm::vec2>()  -> to_location(1),		// aTexCoords
+				from_buffer_binding(2) -> stream_per_vertex<glm::vec3>()  -> to_location(2),		// aNormal
+				from_buffer_binding(3) -> stream_per_vertex<glm::vec3>()  -> to_location(3),		// aTangent
+				from_buffer_binding(4) -> stream_per_vertex<glm::vec3>()  -> to_location(4),		// aBitangent
+				from_buffer_binding(5) -> stream_per_vertex<glm::vec4>()  -> to_location(5),		// aBoneWeights
+				from_buffer_binding(6) -> stream_per_vertex<glm::uvec4>() -> to_location(6),		// aBoneIndices
+				cfg::front_face::define_front_faces_to_be_counter_clockwise(),
+				render_viewport_config(),
+				mRenderpass, 0u, // subpass #0
+				get_pipeline_alter_config_function_for_shading_rate(iShadingRatePass == 1),
+				push_constant_binding_data { shader_type::all, 0, sizeof(push_constant_data_for_dii) },
+				descriptor_binding(0, 0, mMaterialBuffer),
+				descriptor_binding(0, 1, mImageSamplers),
+				SCENE_DRAW_DESCRIPTOR_BINDINGS(0)
+				SHADOWMAP_DESCRIPTOR_BINDINGS(0)
+				descriptor_binding(1, 0, mMatricesUserInputBuffer[0]),
+				descriptor_binding(1, 1, mLightsourcesBuffer[0]),
+				descriptor_binding(3, 0, mCrowdInstancesBuffer[0]->as_storage_buffer()),
+				descriptor_binding(3, 1, mCrowdBonesBuffer[0]->as_storage_buffer()),
+				descriptor_binding(3, 2, mCrowdBonesPrevBuffer[0]->as_storage_buffer())
+			);
+			if (iShadingRatePass == 0) mPipelineCrowd = std::move(tmpPipelineCrowd); else mPipelineVrsCrowd = std::move(tmpPipelineCrowd);
+
 			#if !USE_VARIABLE_RATE_SHADING
 				break;
 			#endif
@@ -2557,7 +3341,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			from_buffer_binding(0) -> stream_per_vertex<glm::vec4>() -> to_location(0),		// <-- aPositionAndId
 			cfg::primitive_topology::points,
 			cfg::depth_write::disabled(),
-			cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+			render_viewport_config(),
 			mRenderpass, subpass,
 			descriptor_binding(1, 0, mMatricesUserInputBuffer[0])
 		);
@@ -2570,7 +3354,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			cfg::front_face::define_front_faces_to_be_clockwise(),
 			cfg::culling_mode::disabled,
 			cfg::depth_test::disabled(),
-			cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+			render_viewport_config(),
 			mRenderpass, subpass,
 			descriptor_binding(0, 0, mTestImageSampler_bilinear),
 			descriptor_binding(0, 1, mTestImages[0]),
@@ -2594,40 +3378,41 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			descriptor_binding(1, 1, mLightsourcesBuffer[0])				// compat
 		);
 
-		mPipelineShadowmapTransparent = context().create_graphics_pipeline_for(
-			vertex_shader("shaders/shadowmap_transparent.vert.spv"),
-			fragment_shader("shaders/shadowmap_transparent.frag.spv"),
-			from_buffer_binding(0) -> stream_per_vertex<glm::vec3>() -> to_location(0),
-			from_buffer_binding(1) -> stream_per_vertex<glm::vec2>() -> to_location(1),		// aTexCoords
+		mPipelineShadowmapCrowd = context().create_graphics_pipeline_for(
+			vertex_shader("shaders/crowd_shadowmap.vert.spv"), // no fragment shader
+			from_buffer_binding(0) -> stream_per_vertex<glm::vec3>()  -> to_location(0),
+			from_buffer_binding(1) -> stream_per_vertex<glm::vec4>()  -> to_location(1),		// aBoneWeights
+			from_buffer_binding(2) -> stream_per_vertex<glm::uvec4>() -> to_location(2),		// aBoneIndices
 			mShadowmapRenderpass,
-			cfg::culling_mode::disabled,	// no backface culling // (for now) TODO
+			cfg::culling_mode::disabled,	// same as mPipelineShadowmapOpaque
+			cfg::front_face::define_front_faces_to_be_counter_clockwise(),
 			cfg::viewport_depth_scissors_config::from_framebuffer(mShadowmapPerCascade[0].mShadowmapFramebuffer[0]),
-			cfg::depth_clamp_bias::dynamic(), // allow dynamic setting of depth bias AND enable it
+			cfg::depth_clamp_bias::dynamic(),
 			push_constant_binding_data { shader_type::all, 0, sizeof(push_constant_data_for_dii) },
 			descriptor_binding(0, 0, mMaterialBuffer),
-			descriptor_binding(0, 1, mImageSamplers),						// need to sample alpha
+			descriptor_binding(0, 1, mImageSamplers),						// compat
 			SCENE_DRAW_DESCRIPTOR_BINDINGS(0)
 			descriptor_binding(1, 0, mMatricesUserInputBuffer[0]),
-			descriptor_binding(1, 1, mLightsourcesBuffer[0])				// compat
+			descriptor_binding(1, 1, mLightsourcesBuffer[0]),				// compat
+			descriptor_binding(3, 0, mCrowdInstancesBuffer[0]->as_storage_buffer()),
+			descriptor_binding(3, 1, mCrowdBonesBuffer[0]->as_storage_buffer())
 		);
 
-		mPipelineShadowmapAnimObject = context().create_graphics_pipeline_for(
-			vertex_shader("shaders/shadowmap_animated.vert.spv"),	// no frag shader
-			from_buffer_binding(0) -> stream_per_vertex<glm::vec3>() -> to_location(0),		// aPosition
-			from_buffer_binding(1) -> stream_per_vertex<glm::vec4>() -> to_location(1),		// aBoneWeights
-			from_buffer_binding(2) -> stream_per_vertex<glm::uvec4>()-> to_location(2),		// aBoneIndices
+		mPipelineShadowmapTransparent = context().create_graphics_pipeline_for(
+			vertex_shader("shaders/shadowmap_transparent.vert.spv"),
+			fragment_shader("shaders/shadowmap_transparent.frag.spv"),
+			from_buffer_binding(0) -> stream_per_vertex<glm::vec3>() -> to_location(0),
+			from_buffer_binding(1) -> stream_per_vertex<glm::vec2>() -> to_location(1),		// aTexCoords
 			mShadowmapRenderpass,
-			cfg::front_face::define_front_faces_to_be_counter_clockwise(),
+			cfg::culling_mode::disabled,	// no backface culling // (for now) TODO
 			cfg::viewport_depth_scissors_config::from_framebuffer(mShadowmapPerCascade[0].mShadowmapFramebuffer[0]),
 			cfg::depth_clamp_bias::dynamic(), // allow dynamic setting of depth bias AND enable it
 			push_constant_binding_data { shader_type::all, 0, sizeof(push_constant_data_for_dii) },
 			descriptor_binding(0, 0, mMaterialBuffer),
-			descriptor_binding(0, 1, mImageSamplers),
+			descriptor_binding(0, 1, mImageSamplers),						// need to sample alpha
 			SCENE_DRAW_DESCRIPTOR_BINDINGS(0)
 			descriptor_binding(1, 0, mMatricesUserInputBuffer[0]),
-			descriptor_binding(1, 1, mLightsourcesBuffer[0]),				// compat
-			descriptor_binding(3, 0, mBoneMatricesBuffer[0]),
-			descriptor_binding(3, 1, mBoneMatricesPrevBuffer[0])			// compat
+			descriptor_binding(1, 1, mLightsourcesBuffer[0])				// compat
 		);
 
 		mPipelineDrawShadowmap = context().create_graphics_pipeline_for(
@@ -2638,7 +3423,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			cfg::front_face::define_front_faces_to_be_clockwise(),
 			cfg::culling_mode::disabled,
 			cfg::depth_test::disabled(),
-			cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+			render_viewport_config(),
 			mRenderpass, subpass,
 			descriptor_binding(1, 0, mMatricesUserInputBuffer[0]),
 			SHADOWMAP_DESCRIPTOR_BINDINGS(0)
@@ -2651,7 +3436,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			cfg::primitive_topology::lines,
 			cfg::culling_mode::disabled,
 			//cfg::depth_test::disabled(),
-			cfg::viewport_depth_scissors_config::from_framebuffer(mFramebuffer[0]),
+			render_viewport_config(),
 			mRenderpass, subpass,
 			descriptor_binding(1, 0, mMatricesUserInputBuffer[0])
 		);
@@ -2662,7 +3447,8 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			compute_shader("shaders/frustum_culling.comp.spv"),
 			descriptor_binding(0, 0, mSceneData.mCullingUniformsBuffer[0]),
 			descriptor_binding(0, 1, mSceneData.mCullingVisibilityBuffer[0]),
-			descriptor_binding(0, 2, mSceneData.mCullingBoundingBoxBuffer)
+			descriptor_binding(0, 2, mSceneData.mCullingBoundingBoxBuffer),
+			descriptor_binding(0, 3, mDepthPyramid.buffers[0]->as_storage_buffer())
 		);
 
 		mPipelineBuildSceneBuffers = context().create_compute_pipeline_for(
@@ -2677,6 +3463,29 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			descriptor_binding(0, 7, mSceneData.mDrawCountBuffer[0]->as_storage_buffer()),
 			push_constant_binding_data{ shader_type::compute, 0, sizeof(BuildSceneBuffersPushConstants) }
 		);
+
+		// pipeline for skinning animated objects (need any animated mesh for the layout)
+		auto itAnimObj = std::find_if(mDynObjects.begin(), mDynObjects.end(), [](const dynamic_object &o) { return o.mIsAnimated; });
+		if (itAnimObj != mDynObjects.end()) {
+			auto &md = itAnimObj->mMeshData[0];
+			mPipelineSkinning = context().create_compute_pipeline_for(
+				compute_shader("shaders/skinning.comp.spv"),
+				descriptor_binding(0, 0, mBoneMatricesBuffer[0]),
+				descriptor_binding(0, 1, mBoneMatricesPrevBuffer[0]),
+				descriptor_binding(1, 0, md.mPositionsBuffer  ->as_storage_buffer()),
+				descriptor_binding(1, 1, md.mNormalsBuffer    ->as_storage_buffer()),
+				descriptor_binding(1, 2, md.mTangentsBuffer   ->as_storage_buffer()),
+				descriptor_binding(1, 3, md.mBitangentsBuffer ->as_storage_buffer()),
+				descriptor_binding(1, 4, md.mBoneWeightsBuffer->as_storage_buffer()),
+				descriptor_binding(1, 5, md.mBoneIndicesBuffer->as_storage_buffer()),
+				descriptor_binding(2, 0, md.mSkinnedPositionsBuffer    [0]->as_storage_buffer()),
+				descriptor_binding(2, 1, md.mSkinnedPrevPositionsBuffer[0]->as_storage_buffer()),
+				descriptor_binding(2, 2, md.mSkinnedNormalsBuffer      [0]->as_storage_buffer()),
+				descriptor_binding(2, 3, md.mSkinnedTangentsBuffer     [0]->as_storage_buffer()),
+				descriptor_binding(2, 4, md.mSkinnedBitangentsBuffer   [0]->as_storage_buffer()),
+				push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constant_data_for_skinning) }
+			);
+		}
 	}
 
 	void print_pipeline_info(avk::graphics_pipeline *pPipe, std::string desc) {
@@ -2692,11 +3501,12 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		print_pipeline_info(&mPipelineFirstPass,				"mPipelineFirstPass");
 		print_pipeline_info(&mPipelineLightingPass,				"mPipelineLightingPass");
 		print_pipeline_info(&mPipelineAnimObject,				"mPipelineAnimObject");
+		print_pipeline_info(&mPipelineCrowd,					"mPipelineCrowd");
 		print_pipeline_info(&mPipelineDrawCamPath,				"mPipelineDrawCamPath");
 		print_pipeline_info(&mPipelineDrawFrustum,				"mPipelineDrawFrustum");
 		print_pipeline_info(&mPipelineDrawShadowmap,			"mPipelineDrawShadowmap");
-		print_pipeline_info(&mPipelineShadowmapAnimObject,		"mPipelineShadowmapAnimObject");
 		print_pipeline_info(&mPipelineShadowmapOpaque,			"mPipelineShadowmapOpaque");
+		print_pipeline_info(&mPipelineShadowmapCrowd,			"mPipelineShadowmapCrowd");
 		print_pipeline_info(&mPipelineShadowmapTransparent,		"mPipelineShadowmapTransparent");
 		print_pipeline_info(&mPipelineTestImage,				"mPipelineTestImage");
 		print_pipeline_info(&mSkyboxPipeline,					"mSkyboxPipeline");
@@ -2731,8 +3541,71 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		);
 	}
 
+	void draw_crowd(avk::command_buffer &cmd, gvk::window::frame_id_t fif, int shadowCascade) {
+		// all instances of each part in one instanced draw; skinning with per-instance bone palettes happens in the vertex shader
+		using namespace avk;
+		bool shadowPass = shadowCascade >= 0;
+		rdoc::beginSection(cmd->handle(), "render crowd");
+
+		auto &pipe = shadowPass ? mPipelineShadowmapCrowd : (mEnableVrs ? mPipelineVrsCrowd : mPipelineCrowd);
+		cmd->bind_pipeline(const_referenced(pipe));
+		if (shadowPass) {
+			cmd->bind_descriptors(pipe->layout(), mCrowdDescriptorCache.get_or_create_descriptor_sets({
+				descriptor_binding(0, 0, mMaterialBuffer),
+				descriptor_binding(0, 1, mImageSamplers),
+				SCENE_DRAW_DESCRIPTOR_BINDINGS(fif)
+				descriptor_binding(1, 0, mMatricesUserInputBuffer[fif]),
+				descriptor_binding(1, 1, mLightsourcesBuffer[fif]),
+				descriptor_binding(3, 0, mCrowdInstancesBuffer[fif]->as_storage_buffer()),
+				descriptor_binding(3, 1, mCrowdBonesBuffer[fif]->as_storage_buffer()),
+				}));
+		} else {
+			cmd->bind_descriptors(pipe->layout(), mCrowdDescriptorCache.get_or_create_descriptor_sets({
+				descriptor_binding(0, 0, mMaterialBuffer),
+				descriptor_binding(0, 1, mImageSamplers),
+				SCENE_DRAW_DESCRIPTOR_BINDINGS(fif)
+				SHADOWMAP_DESCRIPTOR_BINDINGS(fif)
+				descriptor_binding(1, 0, mMatricesUserInputBuffer[fif]),
+				descriptor_binding(1, 1, mLightsourcesBuffer[fif]),
+				descriptor_binding(3, 0, mCrowdInstancesBuffer[fif]->as_storage_buffer()),
+				descriptor_binding(3, 1, mCrowdBonesBuffer[fif]->as_storage_buffer()),
+				descriptor_binding(3, 2, mCrowdBonesPrevBuffer[fif]->as_storage_buffer()),
+				}));
+		}
+
+		push_constant_data_for_dii pushc_dii = {};
+		if (shadowPass) pushc_dii.mShadowMapCascadeToBuild = shadowCascade;
+
+		auto &dynObj = mDynObjects[mMovingObject.moverId];
+		for (auto &part : dynObj.mParts) {
+			auto &md = dynObj.mMeshData[part.mMeshIndex];
+
+			pushc_dii.mDrawType               = -(mMovingObject.moverId + 1);
+			pushc_dii.mMover_baseModelMatrix  = dynObj.mIsAnimated ? dynObj.mBaseTransform : dynObj.mBaseTransform * part.mMeshTransform;
+			pushc_dii.mMover_materialIndex    = md.mMaterialIndex;
+			pushc_dii.mMover_meshIndex        = part.mMeshIndex;
+			cmd->push_constants(pipe->layout(), pushc_dii);
+
+			// avk's draw_indexed has no instance count, so bind and draw directly
+			if (shadowPass) {
+				std::array<vk::Buffer, 3> vbufs = { md.mPositionsBuffer->handle(), md.mBoneWeightsBuffer->handle(), md.mBoneIndicesBuffer->handle() };
+				std::array<vk::DeviceSize, 3> offsets = {};
+				cmd->handle().bindVertexBuffers(0u, static_cast<uint32_t>(vbufs.size()), vbufs.data(), offsets.data());
+			} else {
+				std::array<vk::Buffer, 7> vbufs = { md.mPositionsBuffer->handle(), md.mTexCoordsBuffer->handle(), md.mNormalsBuffer->handle(), md.mTangentsBuffer->handle(), md.mBitangentsBuffer->handle(), md.mBoneWeightsBuffer->handle(), md.mBoneIndicesBuffer->handle() };
+				std::array<vk::DeviceSize, 7> offsets = {};
+				cmd->handle().bindVertexBuffers(0u, static_cast<uint32_t>(vbufs.size()), vbufs.data(), offsets.data());
+			}
+			cmd->handle().bindIndexBuffer(md.mIndexBuffer->handle(), 0, vk::IndexType::eUint32);
+			cmd->handle().drawIndexed(static_cast<uint32_t>(md.mIndices.size()), static_cast<uint32_t>(mCrowd.count), 0u, 0, 0u);
+		}
+
+		rdoc::endSection(cmd->handle());
+	}
+
 	void draw_dynamic_objects(avk::command_buffer &cmd, gvk::window::frame_id_t fif, int shadowCascade = -1) {
 		if (!mMovingObject.enabled) return;
+		if (mCrowd.enabled) { draw_crowd(cmd, fif, shadowCascade); return; }
 
 		bool shadowPass = shadowCascade >= 0;
 
@@ -2742,22 +3615,11 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		if (mDynObjects[mMovingObject.moverId].mIsAnimated) {
 			// animated
 			rdoc::beginSection(cmd->handle(), "render dynamic object (animated)");
-			auto &pipe = shadowPass ? mPipelineShadowmapAnimObject : (mEnableVrs ? mPipelineVrsAnimObject : mPipelineAnimObject);
+			// vertices are already skinned (-> compute_skinning), so the shadow pass can just use the opaque shadow pipeline, which is already bound
+			auto &pipe = shadowPass ? mPipelineShadowmapOpaque : (mEnableVrs ? mPipelineVrsAnimObject : mPipelineAnimObject);
 
-			cmd->bind_pipeline(const_referenced(pipe));
-
-			if (shadowPass) {
-				cmd->bind_descriptors(pipe->layout(), mDescriptorCache.get_or_create_descriptor_sets({
-					descriptor_binding(0, 0, mMaterialBuffer),
-					descriptor_binding(0, 1, mImageSamplers),
-					SCENE_DRAW_DESCRIPTOR_BINDINGS(fif)
-					//SHADOWMAP_DESCRIPTOR_BINDINGS(fif)
-					descriptor_binding(1, 0, mMatricesUserInputBuffer[fif]),
-					descriptor_binding(1, 1, mLightsourcesBuffer[fif]),
-					descriptor_binding(3, 0, mBoneMatricesBuffer[fif]),
-					descriptor_binding(3, 1, mBoneMatricesPrevBuffer[fif]),
-					}));
-			} else {
+			if (!shadowPass) {
+				cmd->bind_pipeline(const_referenced(pipe));
 				cmd->bind_descriptors(pipe->layout(), mDescriptorCache.get_or_create_descriptor_sets({
 					descriptor_binding(0, 0, mMaterialBuffer),
 					descriptor_binding(0, 1, mImageSamplers),
@@ -2765,8 +3627,6 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 					SHADOWMAP_DESCRIPTOR_BINDINGS(fif)
 					descriptor_binding(1, 0, mMatricesUserInputBuffer[fif]),
 					descriptor_binding(1, 1, mLightsourcesBuffer[fif]),
-					descriptor_binding(3, 0, mBoneMatricesBuffer[fif]),
-					descriptor_binding(3, 1, mBoneMatricesPrevBuffer[fif]),
 					}));
 			}
 
@@ -2783,20 +3643,17 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				if (shadowPass) {
 					cmd->draw_indexed(
 						avk::const_referenced(md.mIndexBuffer),
-						avk::const_referenced(md.mPositionsBuffer),
-						avk::const_referenced(md.mBoneWeightsBuffer),
-						avk::const_referenced(md.mBoneIndicesBuffer)
+						avk::const_referenced(md.mSkinnedPositionsBuffer[fif])
 					);
 				} else {
 					cmd->draw_indexed(
 						avk::const_referenced(md.mIndexBuffer),
-						avk::const_referenced(md.mPositionsBuffer),
+						avk::const_referenced(md.mSkinnedPositionsBuffer[fif]),
 						avk::const_referenced(md.mTexCoordsBuffer),
-						avk::const_referenced(md.mNormalsBuffer),
-						avk::const_referenced(md.mTangentsBuffer),
-						avk::const_referenced(md.mBitangentsBuffer),
-						avk::const_referenced(md.mBoneWeightsBuffer),
-						avk::const_referenced(md.mBoneIndicesBuffer)
+						avk::const_referenced(md.mSkinnedNormalsBuffer[fif]),
+						avk::const_referenced(md.mSkinnedTangentsBuffer[fif]),
+						avk::const_referenced(md.mSkinnedBitangentsBuffer[fif]),
+						avk::const_referenced(md.mSkinnedPrevPositionsBuffer[fif])
 					);
 				}
 			}
@@ -2858,12 +3715,14 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 
 			rdoc::beginSection(cmd->handle(), "Frustum culling", fif);
 
-			// do frustum culling
+			// do frustum culling (and occlusion culling against the previous frame's depth pyramid, see update_culling_ubo)
+			const auto prevFif = (fif + cConcurrentFrames - 1) % cConcurrentFrames;
 			cmd->bind_pipeline(const_referenced(mPipelineFrustumCulling));
 			cmd->bind_descriptors(mPipelineFrustumCulling->layout(), mDescriptorCache.get_or_create_descriptor_sets({
 				descriptor_binding(0, 0, mSceneData.mCullingUniformsBuffer[fif]),
 				descriptor_binding(0, 1, mSceneData.mCullingVisibilityBuffer[fif]),
-				descriptor_binding(0, 2, mSceneData.mCullingBoundingBoxBuffer)
+				descriptor_binding(0, 2, mSceneData.mCullingBoundingBoxBuffer),
+				descriptor_binding(0, 3, mDepthPyramid.buffers[prevFif]->as_storage_buffer())
 				}));
 			cmd->handle().dispatch(static_cast<uint32_t>((mSceneData.mNumTotalInstances + GPU_FRUSTUM_CULLING_WORKGROUP_SIZE - 1) / GPU_FRUSTUM_CULLING_WORKGROUP_SIZE), 1u, 1u);
 
@@ -2915,16 +3774,320 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 #endif
 	}
 
+	// linear depth pyramid of this frame (see depth_pyramid.comp), after the geometry pass; also copies the geometry depth range
+	// to the readback buffer (see read_depth_pyramid_range)
+	void compute_depth_pyramid(avk::command_buffer &cmd, gvk::window::frame_id_t fif) {
+		using namespace avk;
+		using namespace gvk;
+
+		auto &dp = mDepthPyramid;
+		dp.built[fif] = false;
+		if (!dp.enabled) return;
+
+		rdoc::beginSection(cmd->handle(), "Depth pyramid", fif);
+		helpers::record_timing_interval_start(cmd->handle(), fmt::format("Depth pyramid {}", fif), vk::PipelineStageFlagBits::eComputeShader);
+
+		// level table for this frame's render resolution, reset the range
+		struct {
+			std::array<glm::uvec4, DEPTH_PYRAMID_MAX_LEVELS> levels;	// offset, stride, width, height
+			glm::uvec4 range;											// min, max (float bits), number of levels, -
+		} header = {};
+		static_assert(sizeof(header) == DEPTH_PYRAMID_HEADER_BYTES, "depth pyramid header mismatch");
+		glm::uvec2 size = mRenderResolution;
+		for (uint32_t l = 0; l < dp.numLevels; ++l) {
+			header.levels[l] = glm::uvec4(dp.levels[l], size);
+			size = glm::max(size / 2u, glm::uvec2(1u));
+		}
+		header.range = glm::uvec4(0x7f7fffffu, 0u, dp.numLevels, 0u);	// FLT_MAX, 0
+
+		// depth attachment -> compute; previous readers of the buffer (culling, TAA) -> header update
+		cmd->establish_global_memory_barrier(
+			pipeline_stage::late_fragment_tests | pipeline_stage::compute_shader, /* -> */ pipeline_stage::compute_shader | pipeline_stage::transfer,
+			memory_access::depth_stencil_attachment_write_access,                 /* -> */ memory_access::shader_buffers_and_images_read_access
+		);
+		cmd->handle().updateBuffer(dp.buffers[fif]->handle(), 0, sizeof(header), &header);
+		cmd->establish_global_memory_barrier(
+			pipeline_stage::transfer,             /* -> */ pipeline_stage::compute_shader,
+			memory_access::transfer_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+		);
+
+		cmd->bind_pipeline(const_referenced(dp.pipeline));
+		cmd->bind_descriptors(dp.pipeline->layout(), mDescriptorCache.get_or_create_descriptor_sets({
+			descriptor_binding(0, 0, mFramebuffer[fif]->image_view_at(1).get()),
+			descriptor_binding(0, 1, dp.buffers[fif]->as_storage_buffer())
+			}));
+		DepthPyramidPushConstants pushc = {};
+		pushc.mCamNearPlane = mQuakeCam.near_plane_distance();
+		pushc.mCamFarPlane  = mQuakeCam.far_plane_distance();
+		for (uint32_t l = 0; l < dp.numLevels; ++l) {
+			pushc.mLevel = l;
+			cmd->push_constants(dp.pipeline->layout(), pushc);
+			cmd->handle().dispatch((header.levels[l].z + DEPTH_PYRAMID_WORKGROUP_SIZE - 1) / DEPTH_PYRAMID_WORKGROUP_SIZE, (header.levels[l].w + DEPTH_PYRAMID_WORKGROUP_SIZE - 1) / DEPTH_PYRAMID_WORKGROUP_SIZE, 1u);
+			cmd->establish_global_memory_barrier(
+				pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::compute_shader | pipeline_stage::transfer,
+				memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_read_access | memory_access::transfer_read_access
+			);
+		}
+
+		// geometry depth range -> host
+		vk::BufferCopy region{ DEPTH_PYRAMID_MAX_LEVELS * sizeof(glm::uvec4), 0, sizeof(glm::uvec4) };
+		cmd->handle().copyBuffer(dp.buffers[fif]->handle(), dp.readback[fif]->handle(), 1, &region);
+		cmd->establish_global_memory_barrier(
+			pipeline_stage::transfer,             /* -> */ pipeline_stage::host,
+			memory_access::transfer_write_access, /* -> */ memory_access::host_read_access
+		);
+
+		helpers::record_timing_interval_end(cmd->handle(), fmt::format("Depth pyramid {}", fif), vk::PipelineStageFlagBits::eComputeShader);
+		rdoc::endSection(cmd->handle());
+
+		dp.built[fif]         = true;
+		dp.readbackValid[fif] = true;
+	}
+
+	// geometry depth range of the pyramid of this frame in flight (from cConcurrentFrames frames ago) -> shadow cascade fitting
+	void read_depth_pyramid_range(gvk::window::frame_id_t fif) {
+		auto &dp = mDepthPyramid;
+		if (dp.readbackValid[fif]) {
+			glm::uvec4 range;
+			dp.readback[fif]->read(&range, 0, avk::sync::not_required());
+			dp.range = (range.x <= range.y) ? glm::vec2(glm::uintBitsToFloat(range.x), glm::uintBitsToFloat(range.y)) : glm::vec2(1.f, 0.f);
+			dp.readbackValid[fif] = false;
+		}
+#if ENABLE_SHADOWMAP
+		glm::vec2 range = (dp.enabled && dp.fitShadowCascades) ? dp.range : glm::vec2(1.f, 0.f);	// min > max: whole camera frustum
+		if (range != mShadowMap.fittedRange) {
+			mShadowMap.fittedRange = range;
+			mShadowMap.shadowMapUtil.set_depth_range(range.x, range.y);
+			if (mShadowMap.autoCalcCascadeEnds) mShadowMap.shadowMapUtil.calc_cascade_ends();
+		}
+#endif
+	}
+
+#if ENABLE_RAYTRACING
+	void build_cpu_ray_tracer() {
+		// static meshgroups only (moving object and crowd are not in the CPU BVH); textures are loaded once more as RGBA8, without mip maps
+		std::vector<CpuRayTracer::Material> materials;
+		std::vector<CpuRayTracer::Texture>  textures;
+		std::unordered_map<std::string, int> textureIds;
+		auto loadTexture = [&](const std::string &filename) -> int {
+			if (filename.empty()) return -1;
+			auto it = textureIds.find(filename);
+			if (it != textureIds.end()) return it->second;
+			int id = -1;
+			int w, h, comp;
+			stbi_set_flip_vertically_on_load(mFlipTexturesInLoader);
+			unsigned char *data = stbi_load(filename.c_str(), &w, &h, &comp, 4);
+			stbi_set_flip_vertically_on_load(false);
+			if (data) {
+				CpuRayTracer::Texture tex;
+				tex.width  = w;
+				tex.height = h;
+				tex.texels.assign(reinterpret_cast<const glm::u8vec4 *>(data), reinterpret_cast<const glm::u8vec4 *>(data) + static_cast<size_t>(w) * h);
+				stbi_image_free(data);
+				id = static_cast<int>(textures.size());
+				textures.push_back(std::move(tex));
+			} else {
+				LOG_WARNING("CPU ray tracer: could not load texture \"" + filename + "\" (using white)");
+			}
+			textureIds[filename] = id;
+			return id;
+		};
+
+		for (auto &mc : mMaterialConfigs) {
+			CpuRayTracer::Material m;
+			m.ambient                 = glm::vec3(mc.mAmbientReflectivity);
+			m.diffuse                 = glm::vec3(mc.mDiffuseReflectivity);
+			m.specular                = glm::vec3(mc.mSpecularReflectivity);
+			m.emissive                = glm::vec3(mc.mEmissiveColor);
+			m.shininess               = mc.mShininess;
+			m.twoSided                = mc.mCustomData[3] > 0.5f;
+			m.diffuseTex              = loadTexture(mc.mDiffuseTex);
+			m.specularTex             = loadTexture(mc.mSpecularTex);
+			m.emissiveTex             = loadTexture(mc.mEmissiveTex);
+			m.diffuseTexOffsetTiling  = mc.mDiffuseTexOffsetTiling;
+			m.specularTexOffsetTiling = mc.mSpecularTexOffsetTiling;
+			m.emissiveTexOffsetTiling = mc.mEmissiveTexOffsetTiling;
+			materials.push_back(m);
+		}
+
+		std::vector<CpuRayTracer::MeshInstance> instances;
+		for (auto &mg : mSceneData.mMeshgroups) {
+			auto &rt = mg.rayTracingTmp;
+			if (rt.rtIndexData.empty()) continue;
+			for (auto &inst : mg.perInstanceData) {
+				CpuRayTracer::MeshInstance mi;
+				mi.indices       = rt.rtIndexData.data();
+				mi.numIndices    = rt.rtIndexData.size();
+				mi.positions     = rt.rtPositionData.data();
+				mi.normals       = rt.rtNormalsData.data();
+				mi.texCoords     = rt.rtTexCoordData.data();
+				mi.transform     = inst.modelMatrix;
+				mi.materialIndex = mg.materialIndex;
+				mi.transparent   = mg.hasTransparency;
+				mi.twoSided      = mg.isTwoSided;
+				instances.push_back(mi);
+			}
+		}
+
+		if (!mCpuRayTracer) mCpuRayTracer = std::make_unique<CpuRayTracer>();
+		mCpuRayTracer->build(instances, std::move(materials), std::move(textures));
+		LOG_INFO("CPU ray tracer: " + std::to_string(mCpuRayTracer->stats().numTriangles) + " triangles, " + std::to_string(mCpuRayTracer->stats().numNodes) + " BVH nodes, built in " + std::to_string(mCpuRayTracer->stats().buildMs) + " ms");
+	}
+
+	void create_cpu_ray_tracing_buffers(glm::uvec2 res) {
+		using namespace avk;
+		using namespace gvk;
+
+		context().device().waitIdle();	// only on first use or a resolution change
+		const size_t numPixels = static_cast<size_t>(res.x) * res.y;
+		for (size_t i = 0; i < mRtCpuResultBuffers.size(); ++i) {
+			mRtCpuResultBuffers[i] = context().create_buffer(memory_usage::host_coherent, {}, storage_buffer_meta::create_from_size(numPixels * sizeof(glm::uvec2)));
+			rdoc::labelBuffer(mRtCpuResultBuffers[i]->handle(), "mRtCpuResultBuffers", i);
+			mRtCpuSegMaskReadback[i] = context().create_buffer(memory_usage::host_coherent, {}, storage_buffer_meta::create_from_size(numPixels * sizeof(uint32_t)));
+			rdoc::labelBuffer(mRtCpuSegMaskReadback[i]->handle(), "mRtCpuSegMaskReadback", i);
+			mRtCpu.segMaskValid[i] = false;
+		}
+		mRtCpu.packed     .assign(numPixels, glm::uvec2(0));
+		mRtCpu.colors     .assign(numPixels, glm::vec4(0));
+		mRtCpu.segMask    .assign(numPixels, 0u);
+		mRtCpu.pixels     .clear();
+		mRtCpu.lastPixels .clear();
+		mRtCpu.bufferSize = res;
+	}
+
+	// ray trace on the CPU (CpuRayTracer), then merge the result on the GPU where the RT pipeline would have written it
+	void do_raytrace_cpu(avk::command_buffer &cmd, gvk::window::frame_id_t fif, bool taaAssist) {
+		using namespace avk;
+		using namespace gvk;
+
+		if (!mCpuRayTracer || !mCpuRayTracer->isBuilt()) build_cpu_ray_tracer();
+
+		avk::buffer *pixelList = taaAssist ? mAntiAliasing.getRayTracePixelList() : nullptr;	// only decides where the result goes; the CPU doesn't see the list
+		auto &taaInput = mAntiAliasing.getRayTraceInputImage()->get();
+		const glm::uvec2 res = taaAssist ? glm::uvec2(taaInput.get_image().width(), taaInput.get_image().height()) : glm::uvec2(mLoResolution);
+		const uint32_t mode  = !taaAssist ? 0u : (pixelList ? 2u : 1u);
+		if (res != mRtCpu.bufferSize) create_cpu_ray_tracing_buffers(res);
+
+		const double t0 = context().get_time();
+
+		// pixels to trace: everything, or the pixels marked in the segmask of the last use of this frame in flight (its fence has been waited on)
+		auto &pixels = mRtCpu.pixels;
+		pixels.clear();
+		if (!taaAssist) {
+			for (uint32_t y = 0; y < res.y; ++y) for (uint32_t x = 0; x < res.x; ++x) pixels.push_back(x | (y << 16));
+		} else if (mRtCpu.segMaskValid[fif]) {
+			mRtCpuSegMaskReadback[fif]->read(mRtCpu.segMask.data(), 0, sync::not_required());
+			for (uint32_t y = 0; y < res.y; ++y) for (uint32_t x = 0; x < res.x; ++x) {
+				if ((mRtCpu.segMask[static_cast<size_t>(y) * res.x + x] & 3) == 2) pixels.push_back(x | (y << 16));
+			}
+		}
+
+		static const auto pixelOffsets = helpers::halton_2_3<RAYTRACING_MAX_SAMPLES_PER_PIXEL>(glm::vec2(1.f));
+		CpuRayTracer::FrameParams params;
+		params.cameraTransform       = mQuakeCam.global_transformation_matrix();
+		params.lightDir              = mDirLight.dir;
+		params.dirLightIntensity     = mDirLight.intensity * mDirLight.boost;
+		params.ambientLightIntensity = mAmbLight.col       * mAmbLight.boost;
+		params.maxRayLength          = glm::distance(mSceneData.mBoundingBox.min, mSceneData.mBoundingBox.max);
+		params.alphaThreshold        = mAlphaThreshold;
+		params.shadows               = mShadowMap.enable;
+		params.shadowsOfTransparent  = mShadowMap.enableForTransparency;
+		params.lightingMode          = mLightingMode;
+		params.numSamples            = mRtSamplesPerPixel;
+		if      (taaAssist && mAntiAliasing.getRayTraceSampleOverride() > 0) params.numSamples = mAntiAliasing.getRayTraceSampleOverride();
+		else if (taaAssist && mAntiAliasing.getRayTraceSampleLimit()    > 0) params.numSamples = std::min(params.numSamples, mAntiAliasing.getRayTraceSampleLimit());
+		params.pixelOffsets          = params.numSamples > 1 ? pixelOffsets.data() : nullptr;
+		glm::vec2 temporalOffsets[2];
+		if (taaAssist && mAntiAliasing.getRayTraceTemporal()) {
+			// temporal ray tracing: sample where the rasterizer did (see rt_test.rgen)
+			temporalOffsets[0] = -mAntiAliasing.getRayTraceJitterNdc() * 0.5f * glm::vec2(res);
+			temporalOffsets[1] = -temporalOffsets[0];
+			params.pixelOffsets = temporalOffsets;
+		}
+
+		const bool debug = taaAssist && mRtDebugSparse;
+		if (debug) {
+			for (auto p : pixels) mRtCpu.colors[static_cast<size_t>(p >> 16) * res.x + (p & 0xffff)] = glm::vec4(1, 1, 0, 1);
+		} else {
+			mCpuRayTracer->render(params, static_cast<int>(res.x), static_cast<int>(res.y), pixels.data(), pixels.size(), mRtCpu.colors.data());
+		}
+
+		// pack as half4; alpha marks the pixels traced this time, so reset the ones from last time
+		for (auto p : mRtCpu.lastPixels) mRtCpu.packed[static_cast<size_t>(p >> 16) * res.x + (p & 0xffff)] = glm::uvec2(0);
+		for (auto p : pixels) {
+			size_t idx = static_cast<size_t>(p >> 16) * res.x + (p & 0xffff);
+			const glm::vec4 &c = mRtCpu.colors[idx];
+			mRtCpu.packed[idx] = glm::uvec2(glm::packHalf2x16(glm::vec2(c.r, c.g)), glm::packHalf2x16(glm::vec2(c.b, c.a)));
+		}
+		std::swap(mRtCpu.lastPixels, pixels);
+		mRtCpuResultBuffers[fif]->fill(mRtCpu.packed.data(), 0, sync::not_required());
+
+		mRtCpu.lastMs     = static_cast<float>((context().get_time() - t0) * 1000.0);
+		mRtCpu.avgMs      = glm::mix(mRtCpu.avgMs, mRtCpu.lastMs, 0.05f);
+		mRtCpu.numPixels  = mRtCpu.lastPixels.size();
+		mRtCpu.raysPerSec = debug ? 0.0 : mCpuRayTracer->stats().numRays / std::max(mCpuRayTracer->stats().traceMs * 0.001, 1e-6);
+
+		// merge on the GPU
+		auto &segMask = taaAssist ? mAntiAliasing.getRayTraceSegMask()->get() : mRtDummySegMask.get();
+		cmd->establish_global_memory_barrier(
+			pipeline_stage::compute_shader | pipeline_stage::transfer,                                    /* -> */ pipeline_stage::compute_shader,
+			memory_access::shader_buffers_and_images_write_access | memory_access::transfer_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+		);
+		cmd->bind_pipeline(const_referenced(mPipelineRtCpuMerge));
+		cmd->bind_descriptors(mPipelineRtCpuMerge->layout(), mDescriptorCache.get_or_create_descriptor_sets({
+			descriptor_binding(0, 0, mRtCpuResultBuffers[fif]->as_storage_buffer()),
+			descriptor_binding(0, 1, mRtImageViews[fif]->as_storage_image()),
+			descriptor_binding(0, 2, taaAssist ? taaInput.as_storage_image() : mRtImageViews[fif]->as_storage_image()),
+			descriptor_binding(0, 3, segMask.as_storage_image()),
+			descriptor_binding(0, 4, mRtCpuSegMaskReadback[fif]->as_storage_buffer())
+			}));
+		push_constant_data_for_rt_cpu_merge pushc;
+		pushc.mResolution = glm::ivec2(res);
+		pushc.mMode       = mode;
+		pushc.pad         = 0;
+		cmd->push_constants(mPipelineRtCpuMerge->layout(), pushc);
+		cmd->handle().dispatch((res.x + 15u) / 16u, (res.y + 15u) / 16u, 1);
+
+		// the callers expect the results of a ray tracing pipeline (ray tracing stages only exist with hardware ray tracing)
+		cmd->establish_global_memory_barrier(
+			pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::compute_shader | pipeline_stage::transfer,
+			memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access | memory_access::transfer_read_access
+		);
+		if (mHardwareRayTracing) {
+			cmd->establish_global_memory_barrier(
+				pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::ray_tracing_shaders,
+				memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+			);
+		}
+		if (taaAssist) {
+			cmd->establish_global_memory_barrier(
+				pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::host,
+				memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::host_read_access
+			);
+			mRtCpu.segMaskValid[fif] = true;
+		}
+	}
+#endif
+
 	void do_raytrace_test(avk::command_buffer &cmd, gvk::window::frame_id_t fif, bool taaAssist) {
 #if ENABLE_RAYTRACING
 		using namespace avk;
 		using namespace gvk;
 
+		if (mRtCpu.enabled || !mHardwareRayTracing) {
+			do_raytrace_cpu(cmd, fif, taaAssist);
+			return;
+		}
+
+		avk::buffer *pixelList = taaAssist ? mAntiAliasing.getRayTracePixelList() : nullptr;	// when set, only trace the listed pixels (indirect)
+		auto &taaInput = mAntiAliasing.getRayTraceInputImage()->get();
+
 		cmd->bind_pipeline(const_referenced(mPipelineRayTrace));
 		cmd->bind_descriptors(mPipelineRayTrace->layout(), mDescriptorCache.get_or_create_descriptor_sets({
 			RAYTRACING_DESCRIPTOR_BINDINGS(fif),
-			descriptor_binding(3, 0, taaAssist ? mAntiAliasing.getRayTraceInputImage()->get().as_storage_image() : mRtImageViews[0]->as_storage_image()),	// when augmenting, TASS result image is used, else this is ignored
-			descriptor_binding(3, 1, taaAssist ? mAntiAliasing.getRayTraceSegMask()   ->get().as_storage_image() : mRtDummySegMask ->as_storage_image())	// when augmenting, TASS segmask is used, else this is ignored
+			descriptor_binding(3, 0, taaAssist ? taaInput.as_storage_image() : mRtImageViews[0]->as_storage_image()),	// when augmenting, TASS result image is used, else this is ignored
+			descriptor_binding(3, 1, taaAssist ? mAntiAliasing.getRayTraceSegMask()   ->get().as_storage_image() : mRtDummySegMask ->as_storage_image()),	// when augmenting, TASS segmask is used, else this is ignored
+			descriptor_binding(3, 2, pixelList ? (*pixelList)->as_storage_buffer() : mRtDummyPixelList->as_storage_buffer())	// when tracing a pixel list, TASS list is used, else this is ignored
 			}));
 		push_constant_data_for_rt pushc;
 		pushc.mCameraTransform			= mQuakeCam.global_transformation_matrix();
@@ -2935,14 +4098,36 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		pushc.mNormalMappingStrength	= mNormalMappingStrength;
 		pushc.mMaxRayLength				= glm::distance(mSceneData.mBoundingBox.min, mSceneData.mBoundingBox.max); // use scene BB diagonal as max ray length
 		pushc.mNumSamples				= mRtSamplesPerPixel;
-		pushc.mAnimObjFirstMeshId		= static_cast<int>(mDynObjects[mMovingObject.moverId].mRtCustomIndexBase);
-		pushc.mAnimObjNumMeshes			= static_cast<int>((mMovingObject.enabled && mDynObjects[mMovingObject.moverId].mIsAnimated) ? mDynObjects[mMovingObject.moverId].mMeshData.size() : 0);
+		if      (taaAssist && mAntiAliasing.getRayTraceSampleOverride() > 0) pushc.mNumSamples = mAntiAliasing.getRayTraceSampleOverride();	// temporal ray tracing, or reference of the TAA error report
+		else if (taaAssist && mAntiAliasing.getRayTraceSampleLimit()    > 0) pushc.mNumSamples = std::min(pushc.mNumSamples, mAntiAliasing.getRayTraceSampleLimit());	// reduced by the TAA ray budget
 		pushc.mDoShadows				= (mShadowMap.enable ? 0x01 : 0x00) | (mShadowMap.enableForTransparency ? 0x02 : 0x00);
 		pushc.mAugmentTAA				= taaAssist ? VK_TRUE : VK_FALSE;
 		pushc.mAugmentTAADebug			= taaAssist && mRtDebugSparse ? VK_TRUE : VK_FALSE;
 		pushc.mApproximateLod			= mRtApproximateLod;
 		pushc.mApproximateLodMaxAnisotropy = mRtApproximateLodMaxAnisotropy;
+		pushc.mResolution				= pixelList ? glm::ivec2(taaInput.get_image().width(), taaInput.get_image().height()) : glm::ivec2(mLoResolution);
+		pushc.mAugmentTAAList			= pixelList ? VK_TRUE : VK_FALSE;
+		pushc.mShadowRayLength			= mRtReducedTlas.enabled ? std::min(mRtReducedTlas.shadowRayLength, pushc.mMaxRayLength) : pushc.mMaxRayLength;	// the reduced TLAS only has casters within that distance
+		pushc.mJitterNdc				= mAntiAliasing.getRayTraceJitterNdc();
+		pushc.mTemporalSampling			= taaAssist && mAntiAliasing.getRayTraceTemporal() ? VK_TRUE : VK_FALSE;
+		pushc.pad0						= 0;
 		cmd->handle().pushConstants(mPipelineRayTrace->layout_handle(), vk::ShaderStageFlagBits::eRaygenKHR | vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eAnyHitKHR, 0, sizeof(pushc), &pushc);
+
+		if (pixelList) {
+			// launch size comes from the list header (written by the TAA compaction pass); set up the sbt regions like trace_rays() does
+			const auto &sbt = mPipelineRayTrace->shader_binding_table();
+			const auto sbtAddress = sbt.mSbtBufferRef.device_address();
+			const auto &rgenInfo = sbt.mSbtGroupsInfo.mRaygenGroupsInfo[0];
+			const auto &missInfo = sbt.mSbtGroupsInfo.mMissGroupsInfo[0];
+			const auto &hitInfo  = sbt.mSbtGroupsInfo.mHitGroupsInfo[0];
+			const vk::StridedDeviceAddressRegionKHR raygen   { sbtAddress + rgenInfo.mByteOffset, sbt.mSbtEntrySize, rgenInfo.mNumBytes };
+			const vk::StridedDeviceAddressRegionKHR raymiss  { sbtAddress + missInfo.mByteOffset, sbt.mSbtEntrySize, missInfo.mNumBytes };
+			const vk::StridedDeviceAddressRegionKHR rayhit   { sbtAddress + hitInfo .mByteOffset, sbt.mSbtEntrySize, hitInfo .mNumBytes };
+			const vk::StridedDeviceAddressRegionKHR callable { 0, 0, 0 };
+			cmd->handle().traceRaysIndirectKHR(&raygen, &raymiss, &rayhit, &callable, (*pixelList)->device_address(), context().dynamic_dispatch());
+			return;
+		}
+
 		cmd->trace_rays(
 			//for_each_pixel(context().main_window()),
 			vk::Extent3D{ mLoResolution.x, mLoResolution.y, 1u },
@@ -2994,6 +4179,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			commandBuffer->begin_render_pass_for_framebuffer(firstPipe->get_renderpass(), mFramebuffer[fif]);
 			commandBuffer->next_subpass();
 			commandBuffer->end_render_pass();
+			compute_depth_pyramid(commandBuffer, fif);	// of the cleared depth, the pyramid is read by TAA and culling regardless
 			blit_image(mRtImageViews[fif]->get_image(), mFramebuffer[fif]->image_view_at(0)->get_image(), sync::with_barriers_into_existing_command_buffer(*commandBuffer));
 			commandBuffer->end_recording();
 			return;
@@ -3067,6 +4253,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		//   pass. After task 2 has been implemented, this is the G-Buffer pass):
 		commandBuffer->bind_pipeline(const_referenced(firstPipe));
 		commandBuffer->begin_render_pass_for_framebuffer(firstPipe->get_renderpass(), mFramebuffer[fif]);
+		set_render_viewport(commandBuffer);	// for all subpasses
 
 		// draw the opaque parts of the scene (in deferred shading: draw transparent parts too, we don't use blending there anyway)
 		pushc_dii.mDrawType = 0;
@@ -3165,6 +4352,8 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		commandBuffer->end_render_pass();
 		rdoc::endSection(commandBuffer->handle());
 
+		compute_depth_pyramid(commandBuffer, fif);
+
 		//if (mDoRayTraceTest) {
 		//	blit_image(mRtImageViews[fif]->get_image(), mFramebuffer[fif]->image_view_at(0)->get_image(), sync::with_barriers_into_existing_command_buffer(*commandBuffer));
 		//}
@@ -3265,6 +4454,8 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 				Text("%.3f ms/mSkyboxCommandBuffer", helpers::get_timing_interval_in_ms(fmt::format("mSkyboxCommandBuffer{} time", inFlightIndex)));
 				Text("%.3f ms/mModelsCommandBuffer", helpers::get_timing_interval_in_ms(fmt::format("mModelsCommandBuffer{} time", inFlightIndex)));
 				Text("%.3f ms/Anti Aliasing", mAntiAliasing.duration());
+				Text("G-buffer %d B/px (full %d, compact %d): %.1f MB/frame", GBUFFER_BYTES_PER_PIXEL, GBUFFER_BYTES_PER_PIXEL_FULL, GBUFFER_BYTES_PER_PIXEL_COMPACT, 2.0 * GBUFFER_BYTES_PER_PIXEL * mLoResolution.x * mLoResolution.y / (1024.0 * 1024.0));
+				HelpMarker("Normal, material id and velocity attachments, written by the geometry pass and read by TAA\n(once each; overdraw and the neighbourhood reads not counted).\nLayout: COMPACT_GBUFFER in shader_cpu_common.h");
 
 				// ac: print camera position
 				glm::vec3 p = mQuakeCam.translation();
@@ -3309,6 +4500,14 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 						SameLine();
 						InputIntW(80, "##desired_fps", &mCapFramerate.desiredFps, 10);
 					}
+					Checkbox("Dynamic resolution", &mDynRes.enabled);
+					HelpMarker("Scale the render resolution to hit the target GPU time of skybox + models + TAA.\nRendered into a sub-rect of the attachments, TAA upsamples to the output resolution.\nOff with TAA disabled, RT test and TAA ray tracing.");
+					if (mDynRes.enabled) {
+						SliderFloatW(100, "target ms##DynRes", &mDynRes.targetMs, 1.f, 50.f, "%.1f");
+						SliderFloatW(100, "min scale##DynRes", &mDynRes.minScale, 0.25f, 1.f, "%.2f");
+						InputIntW(80, "interval##DynRes", &mDynRes.interval, 1, 0);
+						Text("%ux%u (%.0f%%), scaled %.2f ms + TAA %.2f ms", mRenderResolution.x, mRenderResolution.y, mDynRes.scale * 100.f, mDynRes.lastScaledMs, mDynRes.lastFixedMs);
+					}
 #if ENABLE_RAYTRACING
 					Checkbox("Ray trace whole scene", &mDoRayTraceTest);
 					if (InputIntW(80, "RT samples##RtSamples", &mRtSamplesPerPixel)) mRtSamplesPerPixel = glm::clamp(mRtSamplesPerPixel, 1, RAYTRACING_MAX_SAMPLES_PER_PIXEL);
@@ -3316,6 +4515,32 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 					Checkbox("RT approximate Lod", &mRtApproximateLod);
 					SameLine();
 					InputIntW(40, "aniso", &mRtApproximateLodMaxAnisotropy, 0, 0);
+					InputIntW(40, "BLAS rebuild interval", &mRtBlas.rebuildInterval, 0, 0); HelpMarker("Animated objects: BLASs are refitted each frame and fully rebuilt every n frames (0 = only on pose deviation)");
+					SliderFloatW(100, "BLAS max. pose dev.", &mRtBlas.maxPoseDeviation, 0.f, 1.f, "%.2f"); HelpMarker("Rebuild when the bones moved more than this (relative to the object size) since the last rebuild (0 = ignore)");
+					Text("AS update %.2f ms, dev %.2f, refit %llu / rebuild %llu", mRtBlasStats.updateMs, mRtBlasStats.poseDeviation, (unsigned long long)mRtBlasStats.numRefits, (unsigned long long)mRtBlasStats.numRebuilds);
+					Checkbox("AS update: waitIdle", &mRtBlas.waitIdleAfterUpdate); HelpMarker("Old behaviour: stall the device after each AS update. For measuring the CPU/GPU overlap gained without it.");
+					SameLine(); Text("avg: AS %.2f ms, frame %.2f ms", mRtBlasStats.avgUpdateMs, mRtBlasStats.avgFrameMs);
+					Text("TLAS %.3f ms (avg %.3f), update %llu / rebuild %llu", mRtBlasStats.tlasMs, mRtBlasStats.avgTlasMs, (unsigned long long)mRtBlasStats.numTlasUpdates, (unsigned long long)mRtBlasStats.numTlasRebuilds); HelpMarker("CPU time for the TLAS maintenance of the current frame (only the moving object's instances are rewritten)");
+					Checkbox("RT: reduced TLAS", &mRtReducedTlas.enabled); HelpMarker("Only static instances within the ray traced frustum (+ margin), extruded towards the light by the shadow ray length, go into the TLAS. Shadow rays are shortened to that length.");
+					if (mRtReducedTlas.enabled) {
+						PushItemWidth(60);
+						InputFloat("margin##reducedTlas", &mRtReducedTlas.margin, 0.f, 0.f, "%.1f"); SameLine();
+						InputFloat("hyst.##reducedTlas", &mRtReducedTlas.hysteresis, 0.f, 0.f, "%.1f"); SameLine();
+						InputFloat("shadow ray len.##reducedTlas", &mRtReducedTlas.shadowRayLength, 0.f, 0.f, "%.1f");
+						PopItemWidth();
+						Text("TLAS: %zu / %u static instances, %llu changes", mRtReducedTlas.numActive, mTlasNumStaticInstances, (unsigned long long)mRtReducedTlas.numChanges);
+					}
+					if (mHardwareRayTracing) {
+						Checkbox("RT: CPU backend", &mRtCpu.enabled); HelpMarker("Ray trace on the CPU (static scene only, no normal mapping, no texture LOD). TAA augmentation uses the segmask of a previous frame.");
+					} else {
+						Text("RT: CPU backend (no hardware ray tracing)");
+					}
+					if (mRtCpu.enabled) {
+						SameLine();
+						if (Button("rebuild BVH")) build_cpu_ray_tracer();
+						Text("CPU RT %.2f ms (avg %.2f), %zu px, %.2f Mrays/s", mRtCpu.lastMs, mRtCpu.avgMs, mRtCpu.numPixels, mRtCpu.raysPerSec * 1e-6);
+						if (mCpuRayTracer) Text("BVH: %zu tris, %zu nodes, %.0f ms, %d threads", mCpuRayTracer->stats().numTriangles, mCpuRayTracer->stats().numNodes, mCpuRayTracer->stats().buildMs, mCpuRayTracer->numThreads());
+					}
 #endif
 					SliderFloatW(100, "alpha thresh.", &mAlphaThreshold, 0.f, 1.f, "%.3f", ImGuiSliderFlags_Logarithmic); HelpMarker("Consider anything with less alpha completely invisible (even if alpha blending is enabled).");
 					if (Checkbox("alpha blending", &mUseAlphaBlending)) invalidate_command_buffers();
@@ -3434,6 +4659,41 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 						SliderFloatW(120, "anim", &dynObj.mAnimTime, minAnimTime, maxAnimTime);
 						SameLine(); Checkbox("auto##auto anim", &mMovingObject.autoAnimate);
 						SliderFloat("speed##anim speed", &mMovingObject.animSpeed, -2.f, 2.f, "%.1f");
+						Checkbox("baked##baked anim", &mMovingObject.bakedAnimation);
+						SameLine(); PushItemWidth(50); InputFloat("fps##bake fps", &mMovingObject.bakeFps); PopItemWidth();
+						SameLine(); Checkbox("snap##bake snap", &mMovingObject.bakeSnapToFrame);
+						SameLine(); Checkbox("disk##bake cache", &mMovingObject.bakeDiskCache); HelpMarker("Keep baked animations in cache/bonecache (below the working directory).\nThe files are keyed on the model file (path, size, modification time) and the clip.");
+						Checkbox("CPU skinning", &mMovingObject.cpuSkinning);
+						if (mMovingObject.cpuSkinning) { SameLine(); Text("%.2f ms", mCpuSkinningStats.lastMs); }
+						if (Button("benchmark CPU skinning")) {
+							if (mCpuSkinningMoverId != mMovingObject.moverId) prepare_cpu_skinning();
+							auto cur  = dynObj.mCurBoneMatrices  ? dynObj.mCurBoneMatrices  : dynObj.mBoneMatrices.data();
+							auto prev = dynObj.mPrevBoneMatrices ? dynObj.mPrevBoneMatrices : cur;
+							mCpuSkinningStats.benchmark = mCpuSkinning.benchmark(cur, prev, MAX_BONES, 20);
+							mCpuSkinningStats.benchmarkValid = true;
+							auto &b = mCpuSkinningStats.benchmark;
+							printf("CPU skinning benchmark: %zu vertices, original %.3f ms, optimized %.3f ms (%d threads), max error pos %g nrm %g\n", b.numVertices, b.msReference, b.msOptimized, b.numThreads, b.maxPosError, b.maxNrmError);
+						}
+						if (mCpuSkinningStats.benchmarkValid) {
+							auto &b = mCpuSkinningStats.benchmark;
+							Text("orig %.2f ms, new %.2f ms (%d thr)", b.msReference, b.msOptimized, b.numThreads);
+						}
+					}
+					if (Checkbox("crowd", &mCrowd.enabled)) invalidate_command_buffers();
+					SameLine(); PushItemWidth(60); InputInt("##crowd count", &mCrowd.count, 0); PopItemWidth();
+					mCrowd.count = glm::clamp(mCrowd.count, 1, MAX_CROWD_INSTANCES);
+					SameLine(); PushItemWidth(50); InputFloat("spacing##crowd", &mCrowd.spacing); PopItemWidth();
+					SameLine(); Checkbox("phase##crowd", &mCrowd.randomPhase);
+					if (mCrowd.enabled && dynObj.mIsAnimated) { Text("bone palettes %.2f ms", mCrowdStats.paletteMs); }
+					if (Button("measure crowd") && !mCrowdMeasure.active) {
+						mCrowdMeasure.active = true;
+						mCrowdMeasure.stage = mCrowdMeasure.frame = 0;
+						mCrowdMeasure.results.clear();
+						mMovingObject.enabled = true;
+					}
+					if (mCrowdMeasure.active) { SameLine(); Text("%d/%d", mCrowdMeasure.stage + 1, static_cast<int>(mCrowdMeasure.counts.size())); }
+					for (auto &r : mCrowdMeasure.results) {
+						Text("%4d: frame %.2f, GPU %.2f, CPU pal. %.2f ms", r.count, r.frameMs, r.gpuMs, r.paletteMs);
 					}
 					PopID();
 
@@ -3454,6 +4714,14 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 
 					Checkbox("Regen.scene buffers", &mSceneData.mRegeneratePerFrame);
 					Checkbox("Cull view frustum",   &mSceneData.mCullViewFrustum);
+					Checkbox("Depth pyramid",       &mDepthPyramid.enabled); SameLine(); HelpMarker("Min/max linear depth pyramid, built after the geometry pass.\nUsed by TAA (linear depth), occlusion culling and the shadow cascade fitting.");
+					if (mDepthPyramid.enabled) {
+						Text("%.3f ms/depth pyramid", helpers::get_timing_interval_in_ms(fmt::format("Depth pyramid {}", inFlightIndex)));
+						Checkbox("Occlusion culling", &mDepthPyramid.occlusionCulling); SameLine(); HelpMarker("Cull against the previous frame's depth pyramid (main camera only, not with a detached camera).\nObjects that become visible by camera motion or moving occluders show up one frame late.");
+						PushItemWidth(100);
+						SliderFloat("occlusion bias", &mDepthPyramid.occlusionBias, 0.f, 0.1f, "%.3f"); SameLine(); HelpMarker("Relative depth tolerance");
+						PopItemWidth();
+					}
 
 					if (rdoc::active()) {
 						Separator();
@@ -3481,6 +4749,23 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 					if (Checkbox("show frustum", &mShadowMap.drawFrustum)) invalidate_command_buffers();
 
 					Checkbox("restrict to scene", &mShadowMap.shadowMapUtil.restrictLightViewToScene);
+					int nearfarMode = static_cast<int>(mShadowMap.shadowMapUtil.nearfarFitMode);
+					if (Combo("near/far fit", &nearfarMode, "frustum only\0intersect\0intersect+pancake\0")) mShadowMap.shadowMapUtil.nearfarFitMode = static_cast<ShadowMap::NearFarFitMode>(nearfarMode);
+					Checkbox("fit cascades to depth", &mDepthPyramid.fitShadowCascades); SameLine(); HelpMarker("Split the visible depth range (from the depth pyramid, a few frames old) instead of the whole camera frustum.\nThe cascade ends are relative to that range then.");
+					if (mDepthPyramid.fitShadowCascades) {
+						if (mShadowMap.fittedRange.x <= mShadowMap.fittedRange.y) Text("depth range: %.2f .. %.2f", mShadowMap.fittedRange.x, mShadowMap.fittedRange.y);
+						else Text("depth range: camera frustum");
+					}
+					Checkbox("extruded caster culling", &mShadowMap.extrudedCasterCulling); SameLine(); HelpMarker("Cull shadow casters against the camera frustum slice of each cascade, extruded towards the light, instead of the light's ortho box.");
+					Checkbox("caster culling stats", &mShadowMap.collectCullingStats); SameLine(); HelpMarker("Counts are calculated on the CPU (slow!) and are only valid with GPU frustum culling on.");
+					if (mShadowMap.collectCullingStats) {
+						auto &stats = mShadowMap.cullingStats;
+						Text("instances: %zu, camera: %zu", stats.numInstances, stats.numVisible[0]);
+						Text("casters (ortho box -> culled):");
+						for (int i = 0; i < mShadowMap.numCascades; ++i) {
+							Text("  casc %d: %6zu -> %6zu", i, stats.numVisibleOrtho[i + 1], stats.numVisible[i + 1]);
+						}
+					}
 					SliderInt("num cascades", &mShadowMap.desiredNumCascades, 1, SHADOWMAP_MAX_CASCADES);
 					PushItemWidth(40);
 					Text("Casc:");
@@ -3725,6 +5010,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 
 		mHiResolution = wnd->resolution();
 		mLoResolution = mUpsampling ? glm::uvec2(glm::vec2(mHiResolution) / mUpsamplingFactor) : mHiResolution;
+		mRenderResolution = mLoResolution;
 
 		// hide the window, so we can see the scene loading progress
 		GLFWwindow *glfwWin = wnd->handle()->mHandle;
@@ -3740,6 +5026,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		prepare_matrices_ubo();
 		prepare_lightsources_ubo();
 		prepare_framebuffers_and_post_process_images();
+		prepare_depth_pyramid();
 		prepare_skybox();
 		prepare_shadowmap();
 
@@ -3750,6 +5037,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		mDrawCamPathPositionsBuffer = gvk::context().create_buffer(avk::memory_usage::device, {}, avk::vertex_buffer_meta::create_from_element_size(sizeof(glm::vec4), mMaxCamPathPositions).describe_only_member(glm::vec4(0), avk::content_description::position));
 
 		load_and_prepare_scene();
+		prepare_crowd_buffers();
 
 		#if USE_VARIABLE_RATE_SHADING
 			init_variable_rate_shading();
@@ -3765,7 +5053,9 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		// print_pipelines_info();
 
 		#if ENABLE_RAYTRACING
-			init_raytracing();
+			init_raytracing_images();
+			if (mHardwareRayTracing) init_raytracing();
+			else mRtCpu.enabled = true;		// the CPU ray tracer is all there is
 		#endif
 
 		// alloc command buffers for drawing the scene, but don't record them yet
@@ -3811,8 +5101,11 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 #endif
 		}
 
+		mAntiAliasing.register_raytrace_callback(this);	// first: the buffer usage of the pixel lists depends on hardware ray tracing
 		mAntiAliasing.set_source_image_views(mHiResolution, srcColorImages, srcDepthImages, srcUvNrmImages, srcVelocityImages, srcMatIdImages, srcRayTracedImages);
-		mAntiAliasing.register_raytrace_callback(this);
+		std::array<buffer_t*, cConcurrentFrames> srcDepthPyramids;
+		for (decltype(fif) i = 0; i < fif; ++i) srcDepthPyramids[i] = &mDepthPyramid.buffers[i].get();
+		mAntiAliasing.set_depth_pyramid(srcDepthPyramids);
 		current_composition()->add_element(mAntiAliasing);
 
 		init_debug_stuff();
@@ -3850,11 +5143,13 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			std::vector<avk::graphics_pipeline *> gfx_pipes = { &mPipelineFirstPass, &mPipelineLightingPass };
 		#endif
 		gfx_pipes.push_back(&mPipelineAnimObject);
+		gfx_pipes.push_back(&mPipelineCrowd);
 		gfx_pipes.push_back(&mPipelineTestImage);
 		gfx_pipes.push_back(&mPipelineDrawCamPath);
 		#if ENABLE_SHADOWMAP
 			gfx_pipes.push_back(&mPipelineShadowmapOpaque);
 			gfx_pipes.push_back(&mPipelineShadowmapTransparent);
+			gfx_pipes.push_back(&mPipelineShadowmapCrowd);
 		#endif
 
 		for (auto ppipe : gfx_pipes) {
@@ -3862,7 +5157,8 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			mUpdater->on(gvk::shader_files_changed_event(*ppipe)).update(*ppipe);
 		}
 		#if ENABLE_RAYTRACING
-			std::vector<avk::ray_tracing_pipeline *> rtx_pipes = { &mPipelineRayTrace };
+			std::vector<avk::ray_tracing_pipeline *> rtx_pipes;
+			if (mHardwareRayTracing) rtx_pipes.push_back(&mPipelineRayTrace);
 			for (auto ppipe : rtx_pipes) {
 				ppipe->enable_shared_ownership();
 				mUpdater->on(gvk::shader_files_changed_event(*ppipe)).update(*ppipe);
@@ -4119,6 +5415,7 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		
 		// Let Temporal Anti-Aliasing modify the camera's projection matrix:
 		auto* mainWnd = gvk::context().main_window();
+		update_dynamic_resolution();	// before the jitter, which depends on the render resolution
 		auto modifiedProjMat = mAntiAliasing.get_jittered_projection_matrix(mOriginalProjMat, mCurrentJitter, mainWnd->current_frame());
 		mAntiAliasing.save_history_proj_matrix(mOriginalProjMat, mainWnd->current_frame());
 
@@ -4166,6 +5463,9 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		auto mainWnd = gvk::context().main_window();
 		auto inFlightIndex = mainWnd->in_flight_index_for_frame();
 
+		// async compute TAA may still read this frame in flight's depth and material ids as history
+		mAntiAliasing.wait_for_async_resolve(mainWnd->current_frame());
+
 		#if ADDITIONAL_FRAME_SYNC_WITH_FENCES
 			// wait until the frame-fence is signaled
 			if (mModelsCommandBufferFence[inFlightIndex].has_value()) mModelsCommandBufferFence[inFlightIndex]->wait_until_signalled();
@@ -4184,18 +5484,29 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			if (mSceneData.mRegeneratePerFrame) rebuild_scene_buffers(inFlightIndex); // no command buffer invalidation necessary
 		#endif
 
+		read_depth_pyramid_range(inFlightIndex);	// before the shadow map is calculated
+		mAntiAliasing.use_depth_pyramid(mDepthPyramid.enabled);
+
 		update_matrices_and_user_input();
 		update_lightsources();
 		update_bone_matrices();
+		compute_skinning();
+		update_crowd();
 		update_culling_ubo();
 		update_camera_path_draw_buffer();
 
 #if ENABLE_RAYTRACING
 		// after updating bone matrices!
 		// update the ray tracing acceleration structures if necessary
-		if (mDoRayTraceTest || mAntiAliasing.needRayTraceAssist()) {
+		if (mHardwareRayTracing && (mDoRayTraceTest || mAntiAliasing.needRayTraceAssist())) {
+			double tAsStart = gvk::context().get_time();
 			update_top_level_acceleration_structure();		// first! - rebuild TLAS if dynObj was changed!
+			mRtBlasStats.tlasMs    = static_cast<float>((gvk::context().get_time() - tAsStart) * 1000.0);
+			mRtBlasStats.avgTlasMs = glm::mix(mRtBlasStats.avgTlasMs, mRtBlasStats.tlasMs, 0.05f);
 			update_bottom_level_acceleration_structures();	// second! - will only update TLAS due to AABB changes (and that might go away)
+			mRtBlasStats.updateMs = static_cast<float>((gvk::context().get_time() - tAsStart) * 1000.0);
+			mRtBlasStats.avgUpdateMs = glm::mix(mRtBlasStats.avgUpdateMs, mRtBlasStats.updateMs, 0.05f);
+			mRtBlasStats.avgFrameMs  = glm::mix(mRtBlasStats.avgFrameMs, 1000.f / glm::max(ImGui::GetIO().Framerate, 0.01f), 0.05f);
 		}
 #endif
 
@@ -4212,6 +5523,11 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 			}
 		#endif
 
+		// the skybox command buffer is pre-recorded, re-record it when the render resolution has changed (dynamic resolution)
+		if (mSkyboxRecordedResolution[inFlightIndex] != mRenderResolution) {
+			mSkyboxCommandBuffer[inFlightIndex]->prepare_for_reuse();
+			record_skybox_command_buffer(inFlightIndex);
+		}
 		mQueue->submit(mSkyboxCommandBuffer[inFlightIndex], std::optional<avk::resource_reference<avk::semaphore_t>>{});
 
 		#if ADDITIONAL_FRAME_SYNC_WITH_FENCES
@@ -4318,6 +5634,22 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		iniWriteBool	(ini, sec, "mLoadBiasTaaOnly",				mLoadBiasTaaOnly);
 		iniWriteBool	(ini, sec, "mAlwaysUseLod0",				mAlwaysUseLod0);
 		iniWriteFloat	(ini, sec, "mNormalMappingStrength",		mNormalMappingStrength);
+		iniWriteBool	(ini, sec, "mDynRes.enabled",				mDynRes.enabled);
+		iniWriteFloat	(ini, sec, "mDynRes.targetMs",				mDynRes.targetMs);
+		iniWriteFloat	(ini, sec, "mDynRes.minScale",				mDynRes.minScale);
+		iniWriteInt		(ini, sec, "mDynRes.interval",				mDynRes.interval);
+		iniWriteBool	(ini, sec, "mDepthPyramid.enabled",			mDepthPyramid.enabled);
+		iniWriteBool	(ini, sec, "mDepthPyramid.occlusionCulling",	mDepthPyramid.occlusionCulling);
+		iniWriteFloat	(ini, sec, "mDepthPyramid.occlusionBias",	mDepthPyramid.occlusionBias);
+#if ENABLE_RAYTRACING
+		iniWriteInt		(ini, sec, "mRtBlas.rebuildInterval",		mRtBlas.rebuildInterval);
+		iniWriteFloat	(ini, sec, "mRtBlas.maxPoseDeviation",		mRtBlas.maxPoseDeviation);
+		iniWriteBool	(ini, sec, "mRtCpu.enabled",				mRtCpu.enabled);
+		iniWriteBool	(ini, sec, "mRtReducedTlas.enabled",		mRtReducedTlas.enabled);
+		iniWriteFloat	(ini, sec, "mRtReducedTlas.margin",			mRtReducedTlas.margin);
+		iniWriteFloat	(ini, sec, "mRtReducedTlas.hysteresis",		mRtReducedTlas.hysteresis);
+		iniWriteFloat	(ini, sec, "mRtReducedTlas.shadowRayLength",	mRtReducedTlas.shadowRayLength);
+#endif
 
 		sec = "Camera";
 		iniWriteVec3	(ini, sec, "mQuakeCam.translation",			mQuakeCam.translation());
@@ -4347,6 +5679,14 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		iniWriteFloat	(ini, sec, "dynObj.mAnimTime",				mDynObjects[mMovingObject.moverId].mAnimTime);
 		iniWriteBool	(ini, sec, "mMovingObject.autoAnimate",		mMovingObject.autoAnimate);
 		iniWriteFloat	(ini, sec, "mMovingObject.animSpeed",		mMovingObject.animSpeed);
+		iniWriteBool	(ini, sec, "mMovingObject.bakedAnimation",	mMovingObject.bakedAnimation);
+		iniWriteFloat	(ini, sec, "mMovingObject.bakeFps",			mMovingObject.bakeFps);
+		iniWriteBool	(ini, sec, "mMovingObject.bakeSnapToFrame",	mMovingObject.bakeSnapToFrame);
+		iniWriteBool	(ini, sec, "mMovingObject.bakeDiskCache",	mMovingObject.bakeDiskCache);
+		iniWriteBool	(ini, sec, "mCrowd.enabled",				mCrowd.enabled);
+		iniWriteInt		(ini, sec, "mCrowd.count",					mCrowd.count);
+		iniWriteFloat	(ini, sec, "mCrowd.spacing",				mCrowd.spacing);
+		iniWriteBool	(ini, sec, "mCrowd.randomPhase",			mCrowd.randomPhase);
 
 		sec = "Images";
 		iniWriteBool	(ini, sec, "mTestImageSettings.enabled",	mTestImageSettings.enabled);
@@ -4357,6 +5697,9 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		iniWriteBool	(ini, sec, "enable",						mShadowMap.enable);
 		iniWriteBool	(ini, sec, "enableForTransparency",			mShadowMap.enableForTransparency);
 		iniWriteBool	(ini, sec, "restrictLightViewToScene",		mShadowMap.shadowMapUtil.restrictLightViewToScene);
+		iniWriteInt		(ini, sec, "nearfarFitMode",				static_cast<int>(mShadowMap.shadowMapUtil.nearfarFitMode));
+		iniWriteBool	(ini, sec, "extrudedCasterCulling",			mShadowMap.extrudedCasterCulling);
+		iniWriteBool	(ini, sec, "fitCascadesToDepth",			mDepthPyramid.fitShadowCascades);
 		iniWriteFloat	(ini, sec, "bias",							mShadowMap.bias);
 		iniWriteBool	(ini, sec, "autoCalcCascadeEnds",			mShadowMap.autoCalcCascadeEnds);
 		iniWriteInt		(ini, sec, "numCascades",					mShadowMap.numCascades); // ATTN on load!
@@ -4405,6 +5748,23 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		iniReadBool		(ini, sec, "mLoadBiasTaaOnly",				mLoadBiasTaaOnly);
 		iniReadBool		(ini, sec, "mAlwaysUseLod0",				mAlwaysUseLod0);
 		iniReadFloat	(ini, sec, "mNormalMappingStrength",		mNormalMappingStrength);
+		iniReadBool		(ini, sec, "mDynRes.enabled",				mDynRes.enabled);
+		iniReadFloat	(ini, sec, "mDynRes.targetMs",				mDynRes.targetMs);
+		iniReadFloat	(ini, sec, "mDynRes.minScale",				mDynRes.minScale);
+		iniReadInt		(ini, sec, "mDynRes.interval",				mDynRes.interval);
+		iniReadBool		(ini, sec, "mDepthPyramid.enabled",			mDepthPyramid.enabled);
+		iniReadBool		(ini, sec, "mDepthPyramid.occlusionCulling",	mDepthPyramid.occlusionCulling);
+		iniReadFloat	(ini, sec, "mDepthPyramid.occlusionBias",	mDepthPyramid.occlusionBias);
+#if ENABLE_RAYTRACING
+		iniReadInt		(ini, sec, "mRtBlas.rebuildInterval",		mRtBlas.rebuildInterval);
+		iniReadFloat	(ini, sec, "mRtBlas.maxPoseDeviation",		mRtBlas.maxPoseDeviation);
+		iniReadBool		(ini, sec, "mRtCpu.enabled",				mRtCpu.enabled);
+		if (!mHardwareRayTracing) mRtCpu.enabled = true;
+		iniReadBool		(ini, sec, "mRtReducedTlas.enabled",		mRtReducedTlas.enabled);
+		iniReadFloat	(ini, sec, "mRtReducedTlas.margin",			mRtReducedTlas.margin);
+		iniReadFloat	(ini, sec, "mRtReducedTlas.hysteresis",		mRtReducedTlas.hysteresis);
+		iniReadFloat	(ini, sec, "mRtReducedTlas.shadowRayLength",	mRtReducedTlas.shadowRayLength);
+#endif
 
 		sec = "Camera";
 		auto camT = mQuakeCam.translation();
@@ -4436,6 +5796,14 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		iniReadFloat	(ini, sec, "dynObj.mAnimTime",				mDynObjects[mMovingObject.moverId].mAnimTime);
 		iniReadBool		(ini, sec, "mMovingObject.autoAnimate",		mMovingObject.autoAnimate);
 		iniReadFloat	(ini, sec, "mMovingObject.animSpeed",		mMovingObject.animSpeed);
+		iniReadBool		(ini, sec, "mMovingObject.bakedAnimation",	mMovingObject.bakedAnimation);
+		iniReadFloat	(ini, sec, "mMovingObject.bakeFps",			mMovingObject.bakeFps);
+		iniReadBool		(ini, sec, "mMovingObject.bakeSnapToFrame",	mMovingObject.bakeSnapToFrame);
+		iniReadBool		(ini, sec, "mMovingObject.bakeDiskCache",	mMovingObject.bakeDiskCache);
+		iniReadBool		(ini, sec, "mCrowd.enabled",				mCrowd.enabled);
+		iniReadInt		(ini, sec, "mCrowd.count",					mCrowd.count);
+		iniReadFloat	(ini, sec, "mCrowd.spacing",				mCrowd.spacing);
+		iniReadBool		(ini, sec, "mCrowd.randomPhase",			mCrowd.randomPhase);
 
 		sec = "Images";
 		iniReadBool		(ini, sec, "mTestImageSettings.enabled",	mTestImageSettings.enabled);
@@ -4446,6 +5814,11 @@ public: // v== cgb::cg_element overrides which will be invoked by the framework
 		iniReadBool		(ini, sec, "enable",						mShadowMap.enable);
 		iniReadBool		(ini, sec, "enableForTransparency",			mShadowMap.enableForTransparency);
 		iniReadBool		(ini, sec, "restrictLightViewToScene",		mShadowMap.shadowMapUtil.restrictLightViewToScene);
+		int nearfarFitMode = static_cast<int>(mShadowMap.shadowMapUtil.nearfarFitMode);
+		iniReadInt		(ini, sec, "nearfarFitMode",				nearfarFitMode);
+		mShadowMap.shadowMapUtil.nearfarFitMode = static_cast<ShadowMap::NearFarFitMode>(nearfarFitMode);
+		iniReadBool		(ini, sec, "extrudedCasterCulling",			mShadowMap.extrudedCasterCulling);
+		iniReadBool		(ini, sec, "fitCascadesToDepth",			mDepthPyramid.fitShadowCascades);
 		iniReadFloat	(ini, sec, "bias",							mShadowMap.bias);
 		iniReadBool		(ini, sec, "autoCalcCascadeEnds",			mShadowMap.autoCalcCascadeEnds);
 		iniReadInt		(ini, sec, "numCascades",					mShadowMap.desiredNumCascades); // ATTN on load! read to desiredNumCascades
@@ -4514,7 +5887,8 @@ private: // v== Member variables ==v
 
 	// shadowmap
 	avk::renderpass mShadowmapRenderpass;
-	avk::graphics_pipeline mPipelineShadowmapOpaque, mPipelineShadowmapTransparent, mPipelineShadowmapAnimObject, mPipelineDrawShadowmap, mPipelineDrawFrustum;
+	avk::graphics_pipeline mPipelineShadowmapOpaque, mPipelineShadowmapTransparent, mPipelineDrawShadowmap, mPipelineDrawFrustum;
+	avk::graphics_pipeline mPipelineShadowmapCrowd;
 	std::array<avk::command_buffer, cConcurrentFrames> mShadowmapCommandBuffer;
 	struct ShadowMapPerCascadeResources {
 		std::array<avk::framebuffer, cConcurrentFrames> mShadowmapFramebuffer;
@@ -4525,6 +5899,26 @@ private: // v== Member variables ==v
 	// GPU frustum culling
 	avk::compute_pipeline mPipelineFrustumCulling, mPipelineBuildSceneBuffers;
 
+	// linear depth pyramid (depth_pyramid.comp), built after the geometry pass; used by TAA, occlusion culling and the shadow cascade fitting
+	struct {
+		bool      enabled           = true;
+		bool      occlusionCulling  = false;
+		float     occlusionBias     = 0.01f;	// relative depth tolerance
+		bool      fitShadowCascades = false;
+		uint32_t  numLevels = 0;
+		std::array<glm::uvec2, DEPTH_PYRAMID_MAX_LEVELS> levels = {};	// offset, stride (for the full attachment size)
+		std::array<avk::buffer, cConcurrentFrames> buffers;
+		std::array<avk::buffer, cConcurrentFrames> readback;			// geometry depth range
+		std::array<glm::mat4, cConcurrentFrames>   projViewMatrix = {};	// camera the pyramid was built with
+		std::array<bool, cConcurrentFrames>        built = {};
+		std::array<bool, cConcurrentFrames>        readbackValid = {};
+		glm::vec2 range = glm::vec2(1.f, 0.f);		// last geometry depth range read back (min > max: none)
+		avk::compute_pipeline pipeline;
+	} mDepthPyramid;
+
+	// skinning of animated objects
+	avk::compute_pipeline mPipelineSkinning;
+
 	avk::sampler mGenericSamplerNearestNeighbour;
 
 	// Different pipelines used for (deferred) shading:
@@ -4538,6 +5932,7 @@ private: // v== Member variables ==v
 
 	// Common pipelines:
 	avk::graphics_pipeline mPipelineAnimObject;
+	avk::graphics_pipeline mPipelineCrowd;
 	avk::graphics_pipeline mPipelineDrawCamPath;
 	avk::graphics_pipeline mPipelineTestImage;
 
@@ -4546,6 +5941,7 @@ private: // v== Member variables ==v
 	avk::graphics_pipeline mPipelineVrsFwdTransparent;
 	avk::graphics_pipeline mPipelineVrsFwdTransparentNoBlend;
 	avk::graphics_pipeline mPipelineVrsAnimObject;
+	avk::graphics_pipeline mPipelineVrsCrowd;
 	// TODO: VRS - other pipelines, esp. shadowmaps?
 
 	const int mMaxCamPathPositions = 10'000;
@@ -4560,6 +5956,7 @@ private: // v== Member variables ==v
 	//gvk::updater mUpdater;	// handles shader hot reloading, window resizing
 #endif
 
+	std::vector<gvk::material_config> mMaterialConfigs;	// all materials of the scene (index = materialIndex)
 	int mLightingMode = 0; // 0 = typical; 1 = no lights, just diff color;  2 = debug
 	struct { glm::vec3 dir, intensity; float boost; } mDirLight = { {1.f,1.f,1.f}, { 1.f,1.f,1.f }, 1.f }; // this is overwritten with the dir light from the .fscene file
 	struct { glm::vec3 col; float boost; } mAmbLight = { {1.f, 1.f, 1.f}, 0.1f };
@@ -4575,6 +5972,18 @@ private: // v== Member variables ==v
 		int  desiredFps = 60;
 	} mCapFramerate;
 
+	struct {
+		bool  enabled    = false;
+		float targetMs   = 16.6f;	// GPU time of skybox + models + TAA
+		float minScale   = 0.5f;	// per axis
+		int   interval   = 8;		// frames between adjustments (the GPU timings are smoothed over ~10 frames)
+		float damping    = 0.5f;	// fraction of the estimated scale change applied per adjustment
+		float hysteresis = 0.02f;	// ignore smaller scale changes
+		float scale      = 1.f;
+		int   frames     = 0;
+		float lastScaledMs = 0.f, lastFixedMs = 0.f;
+	} mDynRes;
+
 	glm::vec2 mAutoRotateDegrees = glm::vec2(-45, 0);
 	bool mAutoRotate = false;
 	bool mAutoBob = false;
@@ -4603,8 +6012,55 @@ private: // v== Member variables ==v
 		bool      rotContinous = false;
 		bool      autoAnimate = true;
 		float     animSpeed = 1.f;
+		bool      cpuSkinning = false;	// skin on the CPU (CpuSkinning) instead of skinning.comp
+		bool      bakedAnimation = false;	// use pre-sampled bone matrices (-> get_baked_animation)
+		float     bakeFps = 60.f;
+		bool      bakeSnapToFrame = false;	// no interpolation between baked frames (deterministic)
+		bool      bakeDiskCache = true;
 	} mMovingObject;
 
+	// instanced copies of the current mover ("crowd")
+	struct {
+		bool  enabled     = false;
+		int   count       = 10;
+		float spacing     = 2.f;
+		bool  randomPhase = true;	// each instance gets its own animation time offset
+	} mCrowd;
+	struct CrowdInstanceGpuData {	// see CrowdInstanceData in shader_common_main.glsl
+		glm::mat4 mModelMatrix;
+		glm::mat4 mModelMatrixPrev;
+		uint32_t  mBoneBase;
+		uint32_t  pad0, pad1, pad2;
+	};
+	std::array<avk::buffer, cConcurrentFrames> mCrowdInstancesBuffer;
+	std::array<avk::buffer, cConcurrentFrames> mCrowdBonesBuffer;
+	std::array<avk::buffer, cConcurrentFrames> mCrowdBonesPrevBuffer;
+	std::vector<CrowdInstanceGpuData> mCrowdInstances;
+	std::vector<glm::mat4> mCrowdBones, mCrowdBonesPrev;	// [instance * bones-per-instance + mesh * MAX_BONES + bone]
+	std::vector<float> mCrowdPhases;
+	std::pair<int, int> mCrowdBuffersFor = { -1, -1 };		// mover id and count the crowd buffers were made for
+	avk::descriptor_cache mCrowdDescriptorCache;			// for draw_crowd only, recreated with the crowd buffers
+	bool mCrowdFirstFrame = true;
+	struct {
+		float paletteMs = 0.f;
+	} mCrowdStats;
+	struct crowd_measurement_result { int count; float frameMs, gpuMs, paletteMs; };
+	struct {
+		bool   active = false;
+		std::vector<int> counts = { 1, 10, 100, 1000 };
+		int    stage = 0, frame = 0;
+		double tLast = 0.0, sumFrameMs = 0.0, sumGpuMs = 0.0, sumPaletteMs = 0.0;
+		std::vector<crowd_measurement_result> results;
+	} mCrowdMeasure;
+
+	CpuSkinning mCpuSkinning;
+	int mCpuSkinningMoverId = -1;		// mover the CPU skinning meshes are set up for
+	struct {
+		float lastMs = 0.f;
+		bool  benchmarkValid = false;
+		CpuSkinning::BenchmarkResult benchmark;
+	} mCpuSkinningStats;
+
 	struct {
 		bool	enabled = false;
 		int		imageId = 0;
@@ -4660,10 +6116,13 @@ private: // v== Member variables ==v
 
 #if ENABLE_RAYTRACING
 		// raytracing-stuff
-		std::vector<avk::bottom_level_acceleration_structure> mBLASs;					// bottom level acceleration structures (one per object, shared for each TLAS)
+		std::vector<static_blas> mBLASs;												// bottom level acceleration structures (one per meshgroup, compacted, shared for each TLAS)
+		size_t mBlasMemoryUncompacted = 0;												// AS memory of the static BLASs before/after compaction
+		size_t mBlasMemoryCompacted   = 0;
 		std::array<avk::top_level_acceleration_structure, cConcurrentFrames> mTLASs;	// top level acceleration structures, one per frame
 		std::vector<avk::geometry_instance> mGeometryInstances;							// geometry instances for the BLASs of the static geometry
 		std::vector<glm::mat4> mDebugGeoInstTransforms;
+		std::vector<BoundingBox> mGeometryInstanceBounds;								// world space bounds of mGeometryInstances (for the reduced TLAS)
 #endif
 
 		bool mRegeneratePerFrame = true;
@@ -4678,6 +6137,11 @@ private: // v== Member variables ==v
 			printf("Scene stats:  groups:    opaque %5lld, transparent %5lld, total %5lld\n", numGrp[0], numGrp[1], numGrp[0] + numGrp[1]);
 			printf("              instances: opaque %5lld, transparent %5lld, total %5lld\n", numIns[0], numIns[1], numIns[0] + numIns[1]);
 			printf("Scene bounds: min %.2f %.2f %.2f,  max %.2f %.2f %.2f,  diag %.2f\n", mBoundingBox.min.x, mBoundingBox.min.y, mBoundingBox.min.z, mBoundingBox.max.x, mBoundingBox.max.y, mBoundingBox.max.z, glm::distance(mBoundingBox.min, mBoundingBox.max));
+#if ENABLE_RAYTRACING
+			if (mBlasMemoryUncompacted) {
+				printf("Static BLAS:  memory %.2f MB, compacted %.2f MB (%.1f%%)\n", mBlasMemoryUncompacted / (1024.0 * 1024.0), mBlasMemoryCompacted / (1024.0 * 1024.0), 100.0 * mBlasMemoryCompacted / mBlasMemoryUncompacted);
+			}
+#endif
 		}
 	} mSceneData;
 
@@ -4697,6 +6161,8 @@ private: // v== Member variables ==v
 	} mCameraSpline;
 
 	glm::uvec2 mHiResolution, mLoResolution;
+	glm::uvec2 mRenderResolution;		// dynamic resolution: rendered sub-rect of the mLoResolution attachments
+	std::array<glm::uvec2, cConcurrentFrames> mSkyboxRecordedResolution;
 
 	std::array<avk::buffer, cConcurrentFrames> mBoneMatricesBuffer;
 	std::array<avk::buffer, cConcurrentFrames> mBoneMatricesPrevBuffer;
@@ -4724,6 +6190,14 @@ private: // v== Member variables ==v
 		bool enableForTransparency = false;// true;
 		bool show = false;
 		bool drawFrustum = false;
+		bool extrudedCasterCulling = true;	// cull casters against the cascade's cam frustum slice extruded towards the light (instead of the light's ortho box)
+		bool collectCullingStats = false;
+		struct {
+			size_t numInstances;
+			size_t numVisible     [1 + SHADOWMAP_MAX_CASCADES];	// per frustum, as culled by the GPU (#0 = main camera)
+			size_t numVisibleOrtho[1 + SHADOWMAP_MAX_CASCADES];	// per frustum, when culled against the light's ortho box
+		} cullingStats = {};
+		glm::vec2 fittedRange = glm::vec2(1.f, 0.f);	// depth range the cascades are fitted to (min > max: camera frustum), see read_depth_pyramid_range
 		ShadowMap shadowMapUtil;
 	} mShadowMap;
 
@@ -4746,28 +6220,70 @@ private: // v== Member variables ==v
 	} mEffectiveCamera;
 
 #if ENABLE_RAYTRACING
+	bool mHardwareRayTracing = true;												// device has the ray tracing extensions enabled (else: CPU ray tracer only, no AS/RT pipeline)
 	std::array<avk::image_view, cConcurrentFrames> mRtImageViews;					// target images for ray tracing
 	avk::image_view mRtDummySegMask;
+	avk::buffer mRtDummyPixelList;
 	avk::image_view mRtDummyInputImg;
 	avk::ray_tracing_pipeline mPipelineRayTrace;
-	std::vector<avk::buffer_view> mRtIndexBuffersArray;
-	std::vector<avk::buffer_view> mRtTexCoordBuffersArray;
-	std::vector<avk::buffer_view> mRtNormalsBuffersArray;
-	std::vector<avk::buffer_view> mRtTangentsBuffersArray;
-	std::vector<avk::buffer_view> mRtBitangentsBuffersArray;
-	std::vector<avk::buffer_view> mRtPositionsBuffersArray;
-	avk::buffer mRtMaterialIndexBuffer;
+	avk::buffer mRtSceneIndexBuffer;			// geometry of all static meshgroups, concatenated (index + positions buffers are also the BLAS build inputs)
+	avk::buffer mRtScenePositionsBuffer;
+	avk::buffer mRtSceneTexCoordsBuffer;
+	avk::buffer mRtSceneNormalsBuffer;
+	avk::buffer mRtSceneTangentsBuffer;
+	avk::buffer mRtSceneBitangentsBuffer;
+	std::array<avk::buffer, cConcurrentFrames> mRtGeometryInfoBuffer;			// rt_geometry_info per custom index, per frame in flight (animated objects refer to that frame's skinned buffers)
 	avk::buffer mRtPixelOffsetBuffer;
-	std::vector<avk::geometry_instance> mAllGeometryInstances;					// all geometry instances in the current TLAS
-	std::array<avk::buffer, cConcurrentFrames> mRtAnimObjNormalsBuffer;			// one normals buffer for *all* meshes of the current animated object
-	std::array<avk::buffer, cConcurrentFrames> mRtAnimObjTangentsBuffer;		// same for tangents
-	std::array<avk::buffer, cConcurrentFrames> mRtAnimObjBitangentsBuffer;		// same for bitangents
-	std::array<avk::buffer, cConcurrentFrames> mRtAnimObjPositionsBuffer;		// positions for Lod approximation
-	std::array<avk::buffer, cConcurrentFrames> mRtAnimObjNTBOffsetBuffer;		// start index of first normal/tangent/bitangent in above buffer for each mesh of the current animated object
-	std::array<avk::buffer_view, cConcurrentFrames> mRtAnimObjNormalsBufferView;		// for uniform_texel_buffer
-	std::array<avk::buffer_view, cConcurrentFrames> mRtAnimObjTangentsBufferView;		// for uniform_texel_buffer
-	std::array<avk::buffer_view, cConcurrentFrames> mRtAnimObjBitangentsBufferView;		// for uniform_texel_buffer
-	std::array<avk::buffer_view, cConcurrentFrames> mRtAnimObjPositionsBufferView;		// for uniform_texel_buffer
+	enum class tlas_pending { none, update, rebuild };								// ordered by priority
+	std::array<avk::buffer, cConcurrentFrames> mTlasInstanceBuffers;				// persistent (host coherent) TLAS instances per frame in flight: [static instances | mover slots]
+	std::array<tlas_pending, cConcurrentFrames> mTlasPending = {};					// what needs to be done with the TLAS of each frame in flight
+	uint32_t mTlasNumStaticInstances = 0;
+	uint32_t mTlasNumMoverSlots      = 0;											// max. number of parts of any dynamic object
+	std::vector<VkAccelerationStructureInstanceKHR> mTlasStaticInstancesGpu;		// static instances, as written when active
+	std::vector<uint8_t> mTlasStaticActive;											// reduced TLAS: wanted state of each static instance ...
+	std::array<std::vector<uint8_t>, cConcurrentFrames> mTlasStaticActiveInBuffer;	// ... and its state in the instance buffer of each frame in flight
+	struct {
+		bool     enabled         = false;	// only put static instances near the ray traced region into the TLAS
+		float    margin          = 2.f;		// expand the region by this (world units) ...
+		float    hysteresis      = 4.f;		// ... and drop instances only when they are this much further out (fewer rebuilds while the camera moves)
+		float    shadowRayLength = 25.f;	// shadow rays are cut to this length, the region is extruded towards the light by it
+		size_t   numActive       = 0;
+		uint64_t numChanges      = 0;
+	} mRtReducedTlas;
+	struct {
+		int   rebuildInterval   = 60;		// full BLAS rebuild every n frames (per frame in flight); 0 = never
+		float maxPoseDeviation  = 0.25f;	// full BLAS rebuild if the bones moved more than this (relative to object size) since the last rebuild; 0 = ignore
+		bool  waitIdleAfterUpdate = false;	// old behaviour (device-wide stall after each AS update), for comparison only
+	} mRtBlas;
+	struct {
+		float    updateMs      = 0.f;		// CPU time for updating TLAS and BLASs (with waitIdleAfterUpdate: includes waiting for the GPU)
+		float    avgUpdateMs   = 0.f;		// running averages, to compare with/without waitIdleAfterUpdate
+		float    avgFrameMs    = 0.f;
+		float    poseDeviation = 0.f;
+		uint64_t numRefits     = 0;
+		uint64_t numRebuilds   = 0;
+		float    tlasMs        = 0.f;		// CPU time of update_top_level_acceleration_structure (instance patching + recording), and its running average
+		float    avgTlasMs     = 0.f;
+		uint64_t numTlasUpdates  = 0;
+		uint64_t numTlasRebuilds = 0;
+	} mRtBlasStats;
+	struct {
+		bool       enabled    = false;		// ray trace on the CPU (CpuRayTracer) instead of with the ray tracing pipeline
+		float      lastMs     = 0.f;		// CPU time: pixel selection, tracing, packing and upload
+		float      avgMs      = 0.f;
+		double     raysPerSec = 0.0;
+		size_t     numPixels  = 0;
+		glm::uvec2 bufferSize = glm::uvec2(0);
+		std::array<bool, cConcurrentFrames> segMaskValid = {};	// readback of this frame in flight holds a segmask
+		std::vector<uint32_t>   pixels, lastPixels;			// packed x | (y << 16)
+		std::vector<uint32_t>   segMask;
+		std::vector<glm::vec4>  colors;
+		std::vector<glm::uvec2> packed;						// half4, alpha = 1: traced this time
+	} mRtCpu;
+	std::unique_ptr<CpuRayTracer> mCpuRayTracer;										// created (and the BVH built) on first use
+	avk::compute_pipeline mPipelineRtCpuMerge;
+	std::array<avk::buffer, cConcurrentFrames> mRtCpuResultBuffers;					// CPU ray tracing result, per frame in flight
+	std::array<avk::buffer, cConcurrentFrames> mRtCpuSegMaskReadback;				// segmask, as seen by the merge pass, for the next use of this frame in flight
 #endif
 	int mRtSamplesPerPixel = 4;
 	bool mRtDebugSparse = false;
@@ -4815,6 +6331,47 @@ static std::filesystem::path getExecutablePath() {
 	return path;
 }
 
+#if ENABLE_RAYTRACING
+// gvk only picks devices that have all requested extensions, so decide before starting whether to ask for the ray tracing ones:
+// true if every device that the hint may select (all devices, if the hint matches none) has the RT pipeline and acceleration structures
+static bool hardware_ray_tracing_supported(const std::string &deviceHint) {
+	try {
+		vk::ApplicationInfo appInfo("TAA-STAR", 1, nullptr, 0, VK_API_VERSION_1_2);
+		auto instance = vk::createInstanceUnique(vk::InstanceCreateInfo({}, &appInfo));
+		auto devices = instance->enumeratePhysicalDevices();
+
+		auto lower = [](std::string s) { std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); }); return s; };
+		std::vector<vk::PhysicalDevice> candidates;
+		for (auto &dev : devices) {
+			if (deviceHint.empty() || lower(dev.getProperties().deviceName.data()).find(lower(deviceHint)) != std::string::npos) candidates.push_back(dev);
+		}
+		if (candidates.empty()) candidates = devices;
+		if (candidates.empty()) return false;
+
+		const std::vector<const char *> rtExtensions = {
+			VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
+			VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+			VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+			VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
+		};
+		for (auto &dev : candidates) {
+			auto available = dev.enumerateDeviceExtensionProperties();
+			for (auto ext : rtExtensions) {
+				if (std::none_of(available.begin(), available.end(), [ext](const vk::ExtensionProperties &p) { return 0 == strcmp(p.extensionName.data(), ext); })) return false;
+			}
+			auto features = dev.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceRayTracingPipelineFeaturesKHR, vk::PhysicalDeviceAccelerationStructureFeaturesKHR>();
+			if (!features.get<vk::PhysicalDeviceVulkan12Features>().bufferDeviceAddress
+			 || !features.get<vk::PhysicalDeviceRayTracingPipelineFeaturesKHR>().rayTracingPipeline
+			 || !features.get<vk::PhysicalDeviceAccelerationStructureFeaturesKHR>().accelerationStructure) return false;
+		}
+		return true;
+	}
+	catch (vk::SystemError &) {
+		return false;
+	}
+}
+#endif
+
 int main(int argc, char **argv) // <== Starting point ==
 {
 #if SET_WORKING_DIRECTORY
@@ -4852,6 +6409,8 @@ int main(int argc, char **argv) // <== Starting point ==
 		bool vali_GpuAssisted = false;
 		bool vali_BestPractices = false;
 		bool use_vsync = false;
+		bool use_async_compute = false;
+		bool disableHwRayTracing = false;
 		std::string devicehint = "";
 
 		std::string sceneFileName = "";
@@ -4915,6 +6474,11 @@ int main(int argc, char **argv) // <== Starting point ==
 					devicehint = argv[i];
 				} else if (0 == _stricmp(argv[i], "-vsync")) {
 					use_vsync = true;
+				} else if (0 == _stricmp(argv[i], "-asynccompute")) {
+					use_async_compute = true;
+				} else if (0 == _stricmp(argv[i], "-nohwrt")) {
+					disableHwRayTracing = true;
+					LOG_INFO("Hardware ray tracing disabled via command line parameter.");
 				} else {
 					badCmd = true;
 					break;
@@ -4947,6 +6511,8 @@ int main(int argc, char **argv) // <== Starting point ==
 				"-noblend               use alpha testing for transparent parts\n"
 				"-nomip                 disable mip-map generation for loaded textures\n"
 				"-vsync                 enable vsync (cap frames/sec to monitor refresh rate)\n"
+				"-asynccompute          use a separate compute queue for TAA and post processing (if the device has one)\n"
+				"-nohwrt                don't use hardware ray tracing, trace on the CPU instead\n"
 				"-hidewindow            hide render window while scene loading is in progress\n"
 				"-capture <numFrames>   capture the first <numFrames> with RenderDoc (only when started FROM RenderDoc)\n"
 				"--                     terminate argument list, everything after is ignored\n"
@@ -4973,9 +6539,15 @@ int main(int argc, char **argv) // <== Starting point ==
 		auto& singleQueue = gvk::context().create_queue({}, avk::queue_selection_preference::versatile_queue, mainWnd);
 		mainWnd->add_queue_family_ownership(singleQueue);
 		mainWnd->set_present_queue(singleQueue);
+
+		// whether this is actually a separate queue is only known once the device exists (see taa::initialize)
+		avk::queue* computeQueue = nullptr;
+		if (use_async_compute) {
+			computeQueue = &gvk::context().create_queue(vk::QueueFlagBits::eCompute, avk::queue_selection_preference::specialized_queue);
+		}
 		
 		// Create an instance of our main avk::element which contains all the functionality:
-		auto chewbacca = wookiee(singleQueue);
+		auto chewbacca = wookiee(singleQueue, computeQueue);
 		// Create another element for drawing the UI with ImGui
 		auto ui = gvk::imgui_manager(singleQueue);
 
@@ -5024,14 +6596,19 @@ int main(int argc, char **argv) // <== Starting point ==
 		for (auto ext : rdoc::required_device_extensions()) dev_extensions.add_extension(ext);
 
 #if ENABLE_RAYTRACING
-		// add extensions necessary for raytracing
-		dev_extensions
-			.add_extension(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME)
-			.add_extension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)
-			.add_extension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
-			.add_extension(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME)
-			.add_extension(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME)
-			.add_extension(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME);
+		// add extensions necessary for raytracing - without them, only the CPU ray tracer is available
+		const bool hwRayTracing = !disableHwRayTracing && hardware_ray_tracing_supported(devicehint);
+		if (!hwRayTracing && !disableHwRayTracing) LOG_WARNING("No hardware ray tracing support, falling back to the CPU ray tracer");
+		chewbacca.mHardwareRayTracing = hwRayTracing;
+		if (hwRayTracing) {
+			dev_extensions
+				.add_extension(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME)
+				.add_extension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)
+				.add_extension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
+				.add_extension(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME)
+				.add_extension(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME)
+				.add_extension(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME);
+		}
 #endif
 
 #if USE_VARIABLE_RATE_SHADING
@@ -5050,22 +6627,25 @@ int main(int argc, char **argv) // <== Starting point ==
 			[](vk::PhysicalDeviceFeatures& pdf) {
 				pdf.independentBlend  = VK_TRUE;	// request independent blending
 				pdf.multiDrawIndirect = VK_TRUE;	// request support for multiple draw indirect
+				pdf.shaderStorageImageExtendedFormats = VK_TRUE;	// r16ui material ids (compact G-buffer) as storage image in taa.comp
 			},
 			[](vk::PhysicalDeviceVulkan11Features& pdf) {
 				pdf.shaderDrawParameters = VK_TRUE;	// this is needed to use gl_DrawID (aka DrawIndex) in shaders
 			},
-			[](vk::PhysicalDeviceVulkan12Features& pdf) {
+			[&](vk::PhysicalDeviceVulkan12Features& pdf) {
 				pdf.drawIndirectCount = VK_TRUE;	// needed for vkCmdDrawIndexedIndirectCount
+				pdf.shaderFloat16 = gvk::context().physical_device().getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>()
+					.get<vk::PhysicalDeviceVulkan12Features>().shaderFloat16;	// half precision TAA kernel (taa_fp16.comp), only if supported
 #if ENABLE_RAYTRACING
-				pdf.setBufferDeviceAddress(VK_TRUE);
+				pdf.setBufferDeviceAddress(hwRayTracing ? VK_TRUE : VK_FALSE);
 #endif
 			},
 #if ENABLE_RAYTRACING
-			[](vk::PhysicalDeviceRayTracingPipelineFeaturesKHR& rtpf) {
-				rtpf.setRayTracingPipeline(VK_TRUE);
+			[&](vk::PhysicalDeviceRayTracingPipelineFeaturesKHR& rtpf) {
+				rtpf.setRayTracingPipeline(hwRayTracing ? VK_TRUE : VK_FALSE);
 			},
-			[](vk::PhysicalDeviceAccelerationStructureFeaturesKHR& asf) {
-				asf.setAccelerationStructure(VK_TRUE);
+			[&](vk::PhysicalDeviceAccelerationStructureFeaturesKHR& asf) {
+				asf.setAccelerationStructure(hwRayTracing ? VK_TRUE : VK_FALSE);
 			},
 #endif
 			gvk::physical_device_selection_hint(devicehint)
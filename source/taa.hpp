@@ -12,6 +12,9 @@
 #include "shader_cpu_common.h"
 #include "RayTraceCallback.h"
 
+#include <future>
+#include <unordered_map>
+
 // FidelityFX-CAS
 #include <stdint.h>
 #define A_CPU 1
@@ -77,9 +80,19 @@ class taa : public gvk::invokee
 	};
 	static_assert(sizeof(Parameters) % 16 == 0, "Parameters struct is not padded"); // very crude check for padding to 16-bytes
 
-	//struct push_constants_for_taa {		// Note to self: be careful about alignment, esp. with vec#!
-	//	// moved everything to uniforms buffer
-	//};
+	struct push_constants_for_taa {		// Note to self: be careful about alignment, esp. with vec#!
+		// (everything else is in the uniforms buffer)
+		glm::ivec2 offset		= { 0, 0 };	// first pixel of this dispatch
+		int        endX			= 0;		// pixels at x >= endX are done by another dispatch
+		int        paramsIdx	= -1;		// parameter set for the whole dispatch; -1: by split screen position
+		// fused resolve only (see fused_resolve_mode):
+		int        fusedSplitX	= -1;		// split screen line; -1: none
+		float      fusedSharpen	= 0.f;		// as push_constants_for_sharpener
+		int        tileList		= -1;		// tile classification: first list entry of this indirect dispatch; -1: direct dispatch
+		int        pad			= 0;
+		varAU4(casConst0);					// as push_constants_for_cas
+		varAU4(casConst1);
+	};
 
 	struct push_constants_for_sharpener {
 		float sharpeningFactor	= 1.f;
@@ -98,6 +111,41 @@ class taa : public gvk::invokee
 		float     pad1, pad2, pad3;
 	};
 
+	struct push_constants_for_rt_pixel_list {
+		uint32_t pass			= 2;	// 0: priority histogram, 1: find budget cutoff, 2: trim and compact
+		uint32_t pixelBudget	= 0;
+		uint32_t demoteTo		= 1;	// segmask value for marked pixels over budget (1: FXAA, 0: TAA)
+		uint32_t pad;
+	};
+
+	struct push_constants_for_rt_temporal {
+		float    blendWeight	= 0.1f;
+		int      splitX			= -1;	// -1: no split screen
+		uint32_t toneMap		= 0;	// bit 0: primary params use luma tone mapping, bit 1: secondary params
+		uint32_t mode			= 0;	// bit 0: blend into history, bit 1: sum up errors against the reference, bit 2: store as reference
+	};
+
+	struct push_constants_for_fp16_check {
+		float threshold = 2.f / 255.f;	// max. abs. difference of a channel
+		float pad1 = 0.f, pad2 = 0.f, pad3 = 0.f;
+	};
+
+	struct push_constants_for_tile_classify {
+		glm::ivec2 offset			= { 0, 0 };		// as push_constants_for_taa of the classified dispatch
+		int        endX				= 0;
+		int        pixelsPerGroup	= 16;			// 14: fused resolve with overlapping workgroups
+		glm::ivec2 inputSize		= { 0, 0 };		// as mInputSize/mPrevInputSize in uniforms_for_taa
+		glm::ivec2 prevInputSize	= { 0, 0 };
+		glm::ivec2 outputSize		= { 0, 0 };
+		float      staticThreshold	= 0.01f;		// max. motion in a static tile, in output pixels
+		float      edgeThreshold	= 0.1f;			// fraction of edge pixels for an edge tile
+		float      camNearPlane		= 0.f;
+		float      camFarPlane		= 0.f;
+		uint32_t   dispatchIdx		= 0;			// < TAA_TILE_MAX_DISPATCHES
+		uint32_t   maxTiles			= 0;			// list capacity per dispatch and class
+		VkBool32   viewChanged		= VK_FALSE;		// background pixels count as moving
+	};
+
 	struct push_constants_for_postprocess {	// !ATTN to alignment!
 		glm::ivec4 zoomSrcLTWH	= { 960 - 10, 540 - 10, 20, 20 };
 		glm::ivec4 zoomDstLTWH	= { 1920 - 200 - 10, 10, 200, 200 };
@@ -125,14 +173,24 @@ class taa : public gvk::invokee
 		float		mCamNearPlane;
 		float		mCamFarPlane;
 
-		float pad1;
+		VkBool32	mRayTraceTemporal			= VK_FALSE;		// ray traced pixels accumulate ray traced samples in the history
+		VkBool32	mUseTile					= VK_TRUE;		// load the neighbourhoods into a shared memory tile per workgroup
+
+		float		pad1;
+		glm::ivec2	mInputSize;			// dynamic resolution: rendered sub-rect of the input images, this frame
+		glm::ivec2	mPrevInputSize;		// ... and previous frame
+		glm::vec2	mInputUvScale;		// mInputSize / input image size
+		VkBool32	mUseDepthPyramid			= VK_FALSE;		// linear depth from the depth pyramid (see set_depth_pyramid)
+		float		pad2, pad3, pad4;
 	};
 	static_assert(sizeof(uniforms_for_taa) % 16 == 0, "uniforms_for_taa struct is not padded"); // very crude check for padding to 16-bytes
 
 public:
-	taa(avk::queue* aQueue)
+	// aComputeQueue: optional queue for the asynchronous TAA/post processing chain (see mUseAsyncCompute)
+	taa(avk::queue* aQueue, avk::queue* aComputeQueue = nullptr)
 		: invokee("Temporal Anti-Aliasing Post Processing Effect")
 		, mQueue{ aQueue }
+		, mComputeQueue{ aComputeQueue }
 	{ }
 
 	// Execute after all previous post-processing effects:
@@ -149,40 +207,38 @@ public:
 	// Compute an offset for the projection matrix based on the given frame-id
 	glm::vec2 get_jitter_offset_for_frame(gvk::window::frame_id_t aFrameId, std::vector<glm::vec2> *copyPatternDst = nullptr, size_t *outNumSamples = nullptr) const
 	{
-		//const static auto sResolution = gvk::context().main_window()->resolution();
-		assert(mInputResolution.x);
-		const static auto sResolution = mInputResolution;
-		const static auto sPxSizeNDC = glm::vec2(2.0f / static_cast<float>(sResolution.x), 2.0f / static_cast<float>(sResolution.y));
+		// the patterns are in pixel units; the pixel size depends on the render resolution of that frame (dynamic resolution)
+		assert(mRenderResolutions[aFrameId % CF].x);
+		const auto pxSizeNDC = glm::vec2(2.0f) / glm::vec2(mRenderResolutions[aFrameId % CF]);
 
 		// Prepare some different distributions:
 		const static auto sCircularQuadSampleOffsets = avk::make_array<glm::vec2>(
-			sPxSizeNDC * glm::vec2(-0.25f, -0.25f),
-			sPxSizeNDC * glm::vec2(0.25f, -0.25f),
-			sPxSizeNDC * glm::vec2(0.25f, 0.25f),
-			sPxSizeNDC * glm::vec2(-0.25f, 0.25f)
+			glm::vec2(-0.25f, -0.25f),
+			glm::vec2(0.25f, -0.25f),
+			glm::vec2(0.25f, 0.25f),
+			glm::vec2(-0.25f, 0.25f)
 			);
 		const static auto sUniform4HelixSampleOffsets = avk::make_array<glm::vec2>(
-			sPxSizeNDC * glm::vec2(-0.25f, -0.25f),
-			sPxSizeNDC * glm::vec2(0.25f, 0.25f),
-			sPxSizeNDC * glm::vec2(0.25f, -0.25f),
-			sPxSizeNDC * glm::vec2(-0.25f, 0.25f)
+			glm::vec2(-0.25f, -0.25f),
+			glm::vec2(0.25f, 0.25f),
+			glm::vec2(0.25f, -0.25f),
+			glm::vec2(-0.25f, 0.25f)
 			);
-		const static auto sHalton23x8SampleOffsets  = helpers::halton_2_3<8> (sPxSizeNDC);
-		const static auto sHalton23x16SampleOffsets = helpers::halton_2_3<16>(sPxSizeNDC);
+		const static auto sHalton23x8SampleOffsets  = helpers::halton_2_3<8> (glm::vec2(1.f));
+		const static auto sHalton23x16SampleOffsets = helpers::halton_2_3<16>(glm::vec2(1.f));
 
 		const float eighth = 1.f / 8.f;
 		const static auto sRegular16SampleOffsets = avk::make_array<glm::vec2>(	// just for testing
-			sPxSizeNDC * glm::vec2(-3.f*eighth, -3.f*eighth), sPxSizeNDC * glm::vec2(-1.f*eighth, -3.f*eighth), sPxSizeNDC * glm::vec2( 1.f*eighth, -3.f*eighth), sPxSizeNDC * glm::vec2( 3.f*eighth, -3.f*eighth),
-			sPxSizeNDC * glm::vec2(-3.f*eighth, -1.f*eighth), sPxSizeNDC * glm::vec2(-1.f*eighth, -1.f*eighth), sPxSizeNDC * glm::vec2( 1.f*eighth, -1.f*eighth), sPxSizeNDC * glm::vec2( 3.f*eighth, -1.f*eighth),
-			sPxSizeNDC * glm::vec2(-3.f*eighth,  1.f*eighth), sPxSizeNDC * glm::vec2(-1.f*eighth,  1.f*eighth), sPxSizeNDC * glm::vec2( 1.f*eighth,  1.f*eighth), sPxSizeNDC * glm::vec2( 3.f*eighth,  1.f*eighth),
-			sPxSizeNDC * glm::vec2(-3.f*eighth,  3.f*eighth), sPxSizeNDC * glm::vec2(-1.f*eighth,  3.f*eighth), sPxSizeNDC * glm::vec2( 1.f*eighth,  3.f*eighth), sPxSizeNDC * glm::vec2( 3.f*eighth,  3.f*eighth)
+			glm::vec2(-3.f*eighth, -3.f*eighth), glm::vec2(-1.f*eighth, -3.f*eighth), glm::vec2( 1.f*eighth, -3.f*eighth), glm::vec2( 3.f*eighth, -3.f*eighth),
+			glm::vec2(-3.f*eighth, -1.f*eighth), glm::vec2(-1.f*eighth, -1.f*eighth), glm::vec2( 1.f*eighth, -1.f*eighth), glm::vec2( 3.f*eighth, -1.f*eighth),
+			glm::vec2(-3.f*eighth,  1.f*eighth), glm::vec2(-1.f*eighth,  1.f*eighth), glm::vec2( 1.f*eighth,  1.f*eighth), glm::vec2( 3.f*eighth,  1.f*eighth),
+			glm::vec2(-3.f*eighth,  3.f*eighth), glm::vec2(-1.f*eighth,  3.f*eighth), glm::vec2( 1.f*eighth,  3.f*eighth), glm::vec2( 3.f*eighth,  3.f*eighth)
 			);
 
 
 		// Select a specific distribution:
 		const glm::vec2* sampleOffsetValues = nullptr;
 		size_t numSampleOffsets = 0;
-		glm::vec2 scaleBy = glm::vec2(1);
 		switch (mSampleDistribution) {
 		case 0:
 			sampleOffsetValues = sCircularQuadSampleOffsets.data();
@@ -207,20 +263,18 @@ public:
 		case 5:
 			sampleOffsetValues = mDebugSampleOffsets.data();
 			numSampleOffsets = mDebugSampleOffsets.size();
-			scaleBy = sPxSizeNDC;
 			break;
 		}
 
 		if (copyPatternDst) {
-			copyPatternDst->resize(numSampleOffsets);
-			for (auto i = 0; i < numSampleOffsets; ++i) copyPatternDst->at(i) = sampleOffsetValues[i] * scaleBy / sPxSizeNDC;
+			copyPatternDst->assign(sampleOffsetValues, sampleOffsetValues + numSampleOffsets);
 		}
 
 		if (mJitterSlowMotion > 1) aFrameId /= mJitterSlowMotion;
 		if (mFixedJitterIndex >= 0) aFrameId = mFixedJitterIndex;
 
 
-		auto pos = sampleOffsetValues[aFrameId % numSampleOffsets] * scaleBy;
+		auto pos = sampleOffsetValues[aFrameId % numSampleOffsets] * pxSizeNDC;
 
 		if (mJitterRotateDegrees != 0.f) {
 			float s = sin(glm::radians(mJitterRotateDegrees));
@@ -239,6 +293,13 @@ public:
 		mHistoryProjMatrices[inFlightIndex] = aProjMatrix;
 	}
 
+	// Dynamic resolution: the scene is rendered into the top left aResolution pixels of the input images (at most their size).
+	// Must be set before the jittered projection matrix of this frame is requested.
+	void set_render_resolution(glm::uvec2 aResolution, gvk::window::frame_id_t aFrameId)
+	{
+		mRenderResolutions[aFrameId % CF] = glm::clamp(aResolution, glm::uvec2(1), mInputResolution);
+	}
+
 	// Applies a translation to the given matrix and returns the result
 	glm::mat4 get_jittered_projection_matrix(glm::mat4 aProjMatrix, glm::vec2 &out_xyOffset, gvk::window::frame_id_t aFrameId) const
 	{
@@ -271,6 +332,7 @@ public:
 	{
 		std::vector<avk::command_buffer> layoutTransitions;
 
+		wait_for_taa_variant_builds();	// they use the resources (re)created here
 		mSampler = gvk::context().create_sampler(avk::filter_mode::bilinear, avk::border_handling_mode::clamp_to_edge, 0);	// ac: changed from clamp_to_border to clamp_to_edge
 		mSampler.enable_shared_ownership();
 
@@ -339,9 +401,63 @@ public:
 			rdoc::labelImage(mSegmentationImages[i]->get_image().handle(), "taa.mSegmentationImages", i);
 			layoutTransitions.emplace_back(std::move(mSegmentationImages[i]->get_image().transition_to_layout({}, avk::sync::with_barriers_by_return({}, {})).value()));
 
+			// list of pixels to ray trace; header is a VkTraceRaysIndirectCommandKHR, followed by one packed coordinate per pixel (worst case: all pixels)
+			// (its device address is only needed for traceRaysIndirectKHR - bufferDeviceAddress is not enabled without hardware ray tracing)
+			vk::BufferUsageFlags pixelListUsage = vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst;
+			if (mRayTraceCallback && mRayTraceCallback->hasHardwareRayTracing()) pixelListUsage |= vk::BufferUsageFlagBits::eShaderDeviceAddressKHR;
+			mRayTracePixelLists[i] = gvk::context().create_buffer(avk::memory_usage::device, pixelListUsage,
+				avk::storage_buffer_meta::create_from_size(sizeof(glm::uvec4) + size_t(w) * size_t(h) * sizeof(uint32_t)));
+			rdoc::labelBuffer(mRayTracePixelLists[i]->handle(), "taa.mRayTracePixelLists", i);
+
+			// priority histogram and cutoff for the ray budget, plus a small host-visible copy of the stats
+			mRayTraceBudgetBuffers[i] = gvk::context().create_buffer(avk::memory_usage::device, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+				avk::storage_buffer_meta::create_from_size((TAA_RT_BUDGET_NUM_BUCKETS + 4) * sizeof(uint32_t)));
+			rdoc::labelBuffer(mRayTraceBudgetBuffers[i]->handle(), "taa.mRayTraceBudgetBuffers", i);
+			mRayTraceBudgetReadback[i] = gvk::context().create_buffer(avk::memory_usage::host_coherent, vk::BufferUsageFlagBits::eTransferDst,
+				avk::generic_buffer_meta::create_from_size(8 * sizeof(uint32_t)));
+			mRayTraceBudget.statsValid[i] = false;
+
+			// per workgroup error sums for the temporal ray tracing report (see rt_temporal.comp)
+			mRayTraceErrorSums[i] = gvk::context().create_buffer(avk::memory_usage::host_coherent, {},
+				avk::storage_buffer_meta::create_from_size(size_t((w + 15u) / 16u) * size_t((h + 15u) / 16u) * sizeof(glm::vec4)));
+			rdoc::labelBuffer(mRayTraceErrorSums[i]->handle(), "taa.mRayTraceErrorSums", i);
+			mRayTraceTemporal.errorValid[i] = false;
+
+			// tile classification: indirect dispatch headers, followed by the tile lists (worst case: all tiles in one class, 14x14 pixel tiles)
+			mTileClassMaxTiles = ((w + 13u) / 14u) * ((h + 13u) / 14u);
+			mTileClassBuffers[i] = gvk::context().create_buffer(avk::memory_usage::device,
+				vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+				avk::storage_buffer_meta::create_from_size((TAA_TILE_HEADER_UINTS + size_t(TAA_TILE_MAX_DISPATCHES * TAA_TILE_NUM_CLASSES) * mTileClassMaxTiles) * sizeof(uint32_t)));
+			rdoc::labelBuffer(mTileClassBuffers[i]->handle(), "taa.mTileClassBuffers", i);
+			mTileClassReadback[i] = gvk::context().create_buffer(avk::memory_usage::host_coherent, vk::BufferUsageFlagBits::eTransferDst,
+				avk::generic_buffer_meta::create_from_size(TAA_TILE_HEADER_UINTS * sizeof(uint32_t)));
+			mTileClassStatsValid[i] = false;
+
+			// per workgroup difference sums of the fp16 validation (see taa_fp16_check.comp)
+			mFp16CheckSums[i] = gvk::context().create_buffer(avk::memory_usage::host_coherent, {},
+				avk::storage_buffer_meta::create_from_size(size_t((w + 15u) / 16u) * size_t((h + 15u) / 16u) * sizeof(glm::vec4)));
+			rdoc::labelBuffer(mFp16CheckSums[i]->handle(), "taa.mFp16CheckSums", i);
+			mFp16Check.valid[i] = false;
+
 			mInputResolution = glm::uvec2(mSrcColor[0]->get_image().width(), mSrcColor[0]->get_image().height());
 			mOutputResolution = targetResolution;
 		}
+		mRenderResolutions.fill(mInputResolution);
+
+		// reference for the temporal ray tracing report, only one (it is only compared against with a static camera)
+		mRayTraceReference = gvk::context().create_image_view(
+			gvk::context().create_image(targetResolution.x, targetResolution.y, TAA_IMAGE_FORMAT_RGB, 1, avk::memory_usage::device, avk::image_usage::general_storage_image)
+		);
+		rdoc::labelImage(mRayTraceReference->get_image().handle(), "taa.mRayTraceReference");
+		layoutTransitions.emplace_back(std::move(mRayTraceReference->get_image().transition_to_layout({}, avk::sync::with_barriers_by_return({}, {})).value()));
+		mRayTraceTemporal.referenceValid = false;
+
+		// fp16 validation: history output of the fp32 kernel, compared against the one of the fp16 kernel
+		mFp16CheckImage = gvk::context().create_image_view(
+			gvk::context().create_image(targetResolution.x, targetResolution.y, TAA_IMAGE_FORMAT_RGB, 1, avk::memory_usage::device, avk::image_usage::general_storage_image)
+		);
+		rdoc::labelImage(mFp16CheckImage->get_image().handle(), "taa.mFp16CheckImage");
+		layoutTransitions.emplace_back(std::move(mFp16CheckImage->get_image().transition_to_layout({}, avk::sync::with_barriers_by_return({}, {})).value()));
 
 		std::vector<avk::resource_reference<avk::command_buffer_t>> commandBufferReferences;
 		std::transform(std::begin(layoutTransitions), std::end(layoutTransitions), std::back_inserter(commandBufferReferences), [](avk::command_buffer& cb) { return avk::referenced(*cb); });
@@ -359,10 +475,24 @@ public:
 		mPostProcessPushConstants.zoomDstLTWH = { w - dZoomDst - dZoomBrd, dZoomBrd, dZoomDst, dZoomDst };
 	}
 
+	// before set_source_image_views (see mRayTracePixelLists)
 	void register_raytrace_callback(RayTraceCallback *callback) {
 		mRayTraceCallback = callback;
 	}
 
+	// stage that writes the ray traced pixels: the RT pipeline, or the compute merge of the CPU ray tracer when the device has no ray tracing
+	avk::pipeline_stage ray_trace_stage() const {
+		return (mRayTraceCallback && mRayTraceCallback->hasHardwareRayTracing()) ? avk::pipeline_stage::ray_tracing_shaders : avk::pipeline_stage::compute_shader;
+	}
+
+	// linear depth pyramid of each frame in flight (depth_pyramid.comp, built after the geometry pass, level 0 = the depth input),
+	// used instead of linearizing the depth input while enabled; must be set before initialize()
+	void set_depth_pyramid(std::array<avk::buffer_t*, CF>& aDepthPyramidBuffers) {
+		wait_for_taa_variant_builds();
+		mSrcDepthPyramid = aDepthPyramidBuffers;
+	}
+	void use_depth_pyramid(bool aEnable) { mDepthPyramidEnabled = aEnable; }
+
 	// Return the result of the GPU timer query:
 	float duration()
 	{
@@ -496,6 +626,47 @@ public:
 						if (Checkbox("debug##debug sparse tracing", &debugMode) && mRayTraceCallback) mRayTraceCallback->setRayTraceAugmentTaaDebug(debugMode);
 						HelpMarker("Show areas to be sparsely traced instead of actually ray tracing them");
 						if (InputIntW(80, "RT samples##RtSamples", &numSamples) && mRayTraceCallback) mRayTraceCallback->setNumRayTraceSamples(numSamples);
+						Checkbox("compacted pixel list", &mRayTracePixelList);
+						HelpMarker("Collect the marked pixels into a list and ray trace only those (indirect trace rays),\nthe TAA result is kept in place for all other pixels.\nOff: launch rays for the full screen and copy the TAA result for unmarked pixels.");
+						if (mRayTracePixelList) {
+							auto &rb = mRayTraceBudget;
+							Checkbox("ray budget", &rb.enabled);
+							HelpMarker("Limit the rays per frame: marked pixels are prioritized (disocclusions first, then by segmentation score),\nthe samples per pixel are reduced first, then the lowest priority pixels are dropped.");
+							if (rb.enabled) {
+								ComboW(100, "##budget mode", &rb.mode, "max. rays\0time (ms)\0");
+								SameLine();
+								if (rb.mode == 0) InputIntW  (100, "rays##budget rays", &rb.maxRays);
+								else              InputFloatW(60,  "ms##budget ms",     &rb.targetMs, 0.f, 0.f, "%.2f");
+								if (rb.mode == 1) { InputIntW(100, "max. rays##budget max rays", &rb.maxRays); }
+								Checkbox("dropped pixels -> FXAA", &rb.fallbackFxaa); HelpMarker("Off: dropped pixels keep the TAA result");
+								Text("marked %u, traced %u, spp %d", rb.markedPixels, rb.tracedPixels, rb.spp);
+								Text("%.2f ms, %.0f rays/ms", rb.lastMs, rb.raysPerMs);
+							}
+						}
+						auto &rtt = mRayTraceTemporal;
+						Checkbox("temporal", &rtt.enabled);
+						HelpMarker("Ray trace 1 or 2 samples per pixel at the current TAA jitter offset and accumulate them in the TAA history,\ninstead of supersampling every frame (RT samples is ignored then).");
+						if (rtt.enabled) {
+							static int sppIdx;
+							sppIdx = glm::clamp(rtt.samples, 1, 2) - 1;
+							SameLine(); ComboW(60, "spp##rt temporal spp", &sppIdx, "1\0" "2\0");
+							rtt.samples = sppIdx + 1;
+							SliderFloatW(80, "blend weight##rt temporal", &rtt.blendWeight, 0.01f, 1.f, "%.2f");
+						}
+						Checkbox("error report", &rtt.measure);
+						HelpMarker("Compare the ray traced pixels against a reference (traced once with max. samples per pixel).\nKeep the camera still! Capture a reference, then switch between modes; a new row is started whenever the mode changes.");
+						if (rtt.measure) {
+							SameLine(); if (Button("capture reference")) rtt.captureRequested = true;
+							SameLine(); if (Button("clear##rt report")) rtt.report.clear();
+							if (!rtt.referenceValid) Text("no reference yet");
+							for (auto &row : rtt.report) {
+								const double rays = row.rays / std::max(row.frames, 1);
+								const double mse  = row.mse  / std::max(row.frames, 1);
+								Text("%s %dspp%s: %.0f rays/frame, RMSE %.4f (%.1f dB), %d frames",
+									row.temporal ? "temporal" : "supersampled", row.spp, row.temporal ? fmt::format(" w={:.2f}", row.blendWeight).c_str() : "",
+									rays, std::sqrt(mse), mse > 0.0 ? 10.0 * std::log10(1.0 / mse) : 99.0, row.frames);
+							}
+						}
 
 						Text("Segmentation:");
 						static bool flgOut, flgDis, flgNrm, flgDpt, flgMId, flgLum, flgCnt, flgAll, flgFxD, flgFxA;
@@ -616,6 +787,82 @@ public:
 
 						}
 
+						if (CollapsingHeader("Performance")) {
+							Checkbox("neighbourhood tile", &mUseNeighbourhoodTile);
+							HelpMarker("Load color, luminance, depth, normals and material ids of each 16x16 workgroup (plus 1 pixel apron)\ninto shared memory once, instead of fetching them for every neighbouring pixel.\nNot used with upsampling, and not for the workgroups on the split screen line.");
+							{
+								auto &b = mNbhBench;
+								int nbhMode = static_cast<int>(mNeighbourhoodMode);
+								if (Combo("neighbourhood min/max", &nbhMode, "LDS tile\0subgroup\0naive\0") && !b.running) {
+									mNeighbourhoodMode = (nbhMode != TAA_NBH_SUBGROUP || mSubgroupShuffleSupported) ? static_cast<uint32_t>(nbhMode) : TAA_NBH_LDS;
+								}
+								HelpMarker("How taa.comp gets the 3x3 min/max and moments of the color neighbourhood (pipelines are built in the background):\nLDS tile: from the shared memory tile (needs \"neighbourhood tile\").\nsubgroup: the 3x3 is separated into rows; the row partials are exchanged with subgroup shuffles, the pixels of a\nsubgroup cover a 8 x (subgroup size / 8) block. Uses the tile at the block borders (and if the subgroup size does not fit).\nnaive: 9 texture fetches per pixel.\nThe benchmark runs each mode for a few frames and compares the TAA pass times.");
+								if (!mSubgroupShuffleSupported) { SameLine(); TextDisabled("(no subgroup shuffle)"); }
+								if (Button("benchmark neighbourhood modes") && !b.running) start_nbh_bench();
+								if (b.running) {
+									SameLine(); Text("%s %d/%d", b.mode == TAA_NBH_LDS ? "LDS" : (b.mode == TAA_NBH_SUBGROUP ? "subgroup" : "naive"), b.frames, kNbhBenchWarmup + kNbhBenchFrames);
+								} else if (b.done) {
+									Text("LDS %.3f ms, subgroup %.3f ms, naive %.3f ms", b.ms[TAA_NBH_LDS], b.ms[TAA_NBH_SUBGROUP], b.ms[TAA_NBH_NAIVE]);
+								}
+							}
+							auto inFlightIndex = gvk::context().main_window()->in_flight_index_for_frame();
+							Checkbox("specialized pipelines", &mUseTaaVariants);
+							HelpMarker("Compile taa.comp variants with YCoCg, variance clipping, shaped neighbourhood, interpolation,\nvelocity sampling, anti-ghosting, ray trace augmentation and debug output as specialization constants,\nso the unused paths (and the debug image writes) are removed.\nVariants are built in the background when a setting changes, the generic pipeline is used meanwhile.\nSplit screen: one dispatch per half.");
+							Text("TAA pass %.3f ms @ %ux%u", helpers::get_timing_interval_in_ms(fmt::format("TAA pass {}", inFlightIndex)), mOutputResolution.x, mOutputResolution.y);
+							if (mUseTaaVariants) Text("variants: %d built, %d building", static_cast<int>(mTaaVariants.size()), static_cast<int>(mTaaVariantBuilds.size()));
+							Checkbox("fused resolve", &mUseFusedResolve);
+							HelpMarker("Do sharpening and post processing in the TAA pass and write the final image directly,\ninstead of separate passes over the TAA result. Not with FXAA/ray trace augmentation, debug views or zoom.\nWith sharpening, workgroups overlap by one pixel (16x16 invocations for 14x14 pixels).\nCompare \"TAA\" (whole chain) with this on and off.");
+							if (mUseFusedResolve) {
+								// per pixel, each of the separate passes reads and writes an rgba16f image
+								const int passes = (mSharpener ? 1 : 0) + (mPostProcessEnabled ? 1 : 0);
+								const float mb   = passes * 16.f * mOutputResolution.x * mOutputResolution.y / (1024.f * 1024.f);
+								if (mFusedResolveActive) Text("fused: %d dispatches/barriers, ~%.1f MB/frame less%s", passes, mb, (mSharpener ? ", +31% TAA invocations" : ""));
+								else                     Text("fused: not active");
+							}
+							Checkbox("tile classification", &mUseTileClasses);
+							HelpMarker("Classify the TAA workgroup tiles (taa_classify.comp) as static, moving, disoccluded or edge-heavy,\nand dispatch taa.comp indirectly per class. Static tiles (motion below the threshold in the tile and its apron,\nno background while the camera moves) use a cheaper kernel: bilinear history and center velocity,\nwhich is nearly the same for them.\nThe saving is estimated from the per-tile times of the static and the full kernel.");
+							if (mUseTileClasses) {
+								SliderFloat("static tile max. motion (px)", &mTileStaticThreshold, 0.f, 0.1f, "%.3f");
+								SliderFloat("edge tile min. edge pixels", &mTileEdgeThreshold, 0.f, 1.f, "%.2f");
+								if (mTileClassesActive) {
+									const auto &n = mTileClassCounts;
+									Text("tiles: %u static, %u moving, %u disocc., %u edge", n[TAA_TILE_STATIC], n[TAA_TILE_MOVING], n[TAA_TILE_DISOCCLUDED], n[TAA_TILE_EDGE]);
+									const uint32_t nFull   = n[TAA_TILE_MOVING] + n[TAA_TILE_DISOCCLUDED] + n[TAA_TILE_EDGE];
+									const float    msStatic = helpers::get_timing_interval_in_ms(fmt::format("TAA static {}", inFlightIndex));
+									const float    msFull   = helpers::get_timing_interval_in_ms(fmt::format("TAA full {}", inFlightIndex));
+									if (n[TAA_TILE_STATIC] && nFull) {
+										const float perStatic = msStatic / n[TAA_TILE_STATIC], perFull = msFull / nFull;
+										Text("per 1000 tiles: static %.3f ms, full %.3f ms", perStatic * 1000.f, perFull * 1000.f);
+										Text("saved ~%.3f ms", n[TAA_TILE_STATIC] * (perFull - perStatic));
+									}
+								} else {
+									Text("tile classification: not active");
+								}
+							}
+							if (mFp16Supported) {
+								if (Checkbox("fp16 arithmetic", &mUseFp16) && mUseFp16) start_fp16_check();
+								HelpMarker("Use taa_fp16.comp: the color math (color conversion, clipping, bicubic weights, luma weights) in half precision,\nuv/reprojection math in fp32. Pipelines are built in the background like the variants.\nThe check resolves a few frames with both kernels and compares the history outputs;\nfp16 is switched off if too many pixels differ by more than the threshold.");
+								if (mUseFp16) {
+									auto &chk = mFp16Check;
+									SliderFloat("fp16 max. difference", &chk.threshold, 0.f, 0.05f, "%.4f");
+									if (Button("check fp16 against fp32")) start_fp16_check();
+									if (chk.running) {
+										SameLine(); Text(mFp16Active ? "checking... %d/%d" : "waiting for the pipelines %d/%d", chk.frames, kFp16CheckFrames);
+									} else if (chk.done) {
+										TextColored(chk.passed ? ImVec4(0.f, 1.f, 0.f, 1.f) : ImVec4(1.f, 0.f, 0.f, 1.f), chk.passed ? "passed" : "failed");
+										SameLine(); Text("mean %.5f, max %.4f, %.3f%% above", chk.sumDiff / chk.compared, chk.maxDiff, 100.0 * chk.failed / chk.compared);
+										Text("fp16 %.3f ms, fp32 %.3f ms (%+.1f%%)", chk.ms16, chk.ms32, chk.ms32 > 0.f ? 100.f * (chk.ms16 / chk.ms32 - 1.f) : 0.f);
+									}
+								}
+							} else {
+								TextDisabled("fp16 arithmetic: not supported by the device");
+							}
+							if (mComputeQueue) {
+								if (Checkbox("async compute", &mUseAsyncCompute)) mResetHistory = true;
+								HelpMarker("Run TAA and the post processing chain on the separate compute queue (-asynccompute), so it can overlap\nwith the G-buffer and shadow passes of the next frame. The result is blitted to the backbuffer on the graphics queue.\nNot used with ray trace augmentation.");
+							}
+						}
+
 						Checkbox("Reset history at any change", &mResetHistoryOnChange);
 					}
 
@@ -637,13 +884,247 @@ public:
 	void init_updater() {
 		LOG_DEBUG("TAA: initing updater");
 		mUpdater.emplace();
-		std::vector<avk::compute_pipeline *> comp_pipes = { &mTaaPipeline, &mSharpenerPipeline, &mCasPipeline, &mPostProcessPipeline, &mPrepareFxaaPipeline, &mFxaaPipeline };
+		std::vector<avk::compute_pipeline *> comp_pipes = { &mTaaPipeline, &mSharpenerPipeline, &mCasPipeline, &mPostProcessPipeline, &mPrepareFxaaPipeline, &mFxaaPipeline, &mRayTracePixelListPipeline, &mRayTraceTemporalPipeline, &mTileClassifyPipeline, &mFp16CheckPipeline };
 		for (auto ppipe : comp_pipes) {
 			ppipe->enable_shared_ownership();
 			mUpdater->on(gvk::shader_files_changed_event(*ppipe)).update(*ppipe);
 		}
 	}
 
+	// the resources create_taa_pipeline describes its layout with, taken on the render thread: background builds (get_taa_variant)
+	// must not read the members, which set_source_image_views/set_depth_pyramid may reassign meanwhile
+	struct taa_pipeline_bindings {
+		avk::sampler       sampler;		// shared ownership
+		avk::image_view_t *srcColor, *srcDepth, *srcVelocity, *srcMatId, *srcUvNrm;
+		avk::image_view_t *result, *debug, *history, *segMask, *postProcess;
+		avk::buffer_t     *tileClasses, *depthPyramid, *uniforms;
+	};
+
+	taa_pipeline_bindings snapshot_taa_pipeline_bindings() {
+		return {
+			mSampler,
+			mSrcColor[0], mSrcDepth[0], mSrcVelocity[0], mSrcMatId[0], mSrcUvNrm[0],
+			&*mResultImages[0], &*mDebugImages[0], &*mHistoryImages[0], &*mSegmentationImages[0], &*mPostProcessImages[0],
+			&*mTileClassBuffers[0], mSrcDepthPyramid[0], &*mUniformsBuffer[0]
+		};
+	}
+
+	// taa.comp pipeline; variant = 0: generic, else the settings compiled in as specialization constant (see taa_variant_key);
+	// TAA_VARIANT_FP16 selects the taa_fp16.comp module, TAA_NBH_SUBGROUP the ..._subgroup.comp modules
+	static avk::compute_pipeline create_taa_pipeline(uint32_t variant, const taa_pipeline_bindings &b) {
+		using namespace avk;
+		using namespace gvk;
+
+		const bool fp16     = (variant & TAA_VARIANT_FP16) != 0;
+		const bool subgroup = ((variant >> TAA_VARIANT_NBH_SHIFT) & 0x3u) == TAA_NBH_SUBGROUP;
+		const char *shaderFile = subgroup ? (fp16 ? "shaders/taa_fp16_subgroup.comp.spv" : "shaders/taa_subgroup.comp.spv")
+		                                  : (fp16 ? "shaders/taa_fp16.comp.spv"          : "shaders/taa.comp.spv");
+		return context().create_compute_pipeline_for(
+			compute_shader(shaderFile).set_specialization_constant(SPECCONST_ID_TAA_VARIANT, variant),
+			descriptor_binding(0,  0, b.sampler),
+			descriptor_binding(0,  1, *b.srcColor),
+			descriptor_binding(0,  2, *b.srcDepth),
+			descriptor_binding(0,  3, *b.result),
+			descriptor_binding(0,  4, *b.srcDepth),
+			descriptor_binding(0,  5, b.result->as_storage_image()),		// output for screen
+			descriptor_binding(0,  6, b.debug->as_storage_image()),
+			descriptor_binding(0,  7, *b.srcVelocity),
+			descriptor_binding(0,  8, b.history->as_storage_image()),	// output for history
+			descriptor_binding(0,  9, b.segMask->as_storage_image()),
+			descriptor_binding(0, 10, b.srcMatId->as_storage_image()),
+			descriptor_binding(0, 11, b.srcMatId->as_storage_image()),
+			descriptor_binding(0, 12, b.segMask->as_storage_image()),
+			descriptor_binding(0, 13, *b.srcUvNrm),
+			descriptor_binding(0, 14, b.postProcess->as_storage_image()),	// output for screen, fused resolve
+			descriptor_binding(0, 15, b.tileClasses->as_storage_buffer()),
+			descriptor_binding(0, 16, b.depthPyramid->as_storage_buffer()),
+			descriptor_binding(1,  0, *b.uniforms),
+			push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constants_for_taa) }
+		);
+	}
+
+	// the settings which select a taa.comp pipeline variant (see TAA_VARIANT_* in shader_cpu_common.h)
+	static uint32_t taa_variant_key(const Parameters &param) {
+		uint32_t key = TAA_VARIANT_SPECIALIZED;
+		if (param.mUseYCoCg)				key |= TAA_VARIANT_YCOCG;
+		if (param.mVarianceClipping)		key |= TAA_VARIANT_VARIANCE_CLIP;
+		if (param.mShapedNeighbourhood)		key |= TAA_VARIANT_SHAPED_NBH;
+		if (param.mDynamicAntiGhosting)		key |= TAA_VARIANT_DYN_ANTIGHOST;
+		if (param.mRayTraceAugment)			key |= TAA_VARIANT_RT_AUGMENT;
+		if (param.mDebugToScreenOutput)		key |= TAA_VARIANT_DEBUG;
+		key |= (static_cast<uint32_t>(param.mInterpolationMode)  & 0x3u) << TAA_VARIANT_INTERP_SHIFT;
+		key |= (static_cast<uint32_t>(param.mVelocitySampleMode) & 0x3u) << TAA_VARIANT_VELSAMPLE_SHIFT;
+		key |= (static_cast<uint32_t>(param.mDebugMode)          & 0xfu) << TAA_VARIANT_DEBUGMODE_SHIFT;
+		return key;
+	}
+
+	// half precision arithmetic in taa_fp16.comp (shaderFloat16; main.cpp enables the feature if the device has it)
+	static bool fp16_supported() {
+		auto features = gvk::context().physical_device().getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		return features.get<vk::PhysicalDeviceVulkan12Features>().shaderFloat16 == VK_TRUE;
+	}
+
+	// subgroup neighbourhood (taa_subgroup.comp): needs shuffles in compute shaders (core in Vulkan 1.1, but optional)
+	static bool subgroup_shuffle_supported() {
+		auto props = gvk::context().physical_device().getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>();
+		const auto &sg = props.get<vk::PhysicalDeviceSubgroupProperties>();
+		return (sg.supportedStages & vk::ShaderStageFlagBits::eCompute) && (sg.supportedOperations & vk::SubgroupFeatureFlagBits::eShuffle);
+	}
+
+	// neighbourhood benchmark: run each TAA_NBH_* mode for a while and average the "TAA pass" timings, then restore the mode
+	void start_nbh_bench() {
+		auto &b = mNbhBench;
+		b.savedMode = mNeighbourhoodMode;
+		b.mode      = TAA_NBH_LDS;
+		b.frames    = 0;
+		b.running   = true;
+		b.done      = false;
+		b.sum.fill(0.0);
+		b.count.fill(0);
+		b.ms.fill(-1.f);
+		mNeighbourhoodMode = b.mode;
+	}
+
+	// neighbourhood benchmark: once per frame, before the dispatches are planned; frames count only while the mode under test is
+	// active (its pipelines are built in the background), the first kNbhBenchWarmup of them are skipped (the timings are smoothed)
+	void update_nbh_bench(size_t inFlightIndex) {
+		auto &b = mNbhBench;
+		if (!b.running) return;
+		if (mNeighbourhoodMode == b.mode) {
+			if (mNbhActiveMode != b.mode) return;
+			if (++b.frames > kNbhBenchWarmup) {
+				b.sum[b.mode] += helpers::get_timing_interval_in_ms(fmt::format("TAA pass {}", inFlightIndex));
+				b.count[b.mode]++;
+			}
+			if (b.frames < kNbhBenchWarmup + kNbhBenchFrames) return;
+			b.ms[b.mode] = static_cast<float>(b.sum[b.mode] / b.count[b.mode]);
+		}	// else: the mode was switched off (pipeline build failed), skip it
+
+		b.frames = 0;
+		do { b.mode++; } while (b.mode == TAA_NBH_SUBGROUP && !mSubgroupShuffleSupported);
+		if (b.mode <= TAA_NBH_NAIVE) {
+			mNeighbourhoodMode = b.mode;
+			return;
+		}
+		b.running = false;
+		b.done    = true;
+		mNeighbourhoodMode = b.savedMode;
+		LOG_INFO(fmt::format("TAA neighbourhood benchmark (TAA pass, {}x{}): LDS tile {:.3f} ms, subgroup {:.3f} ms, naive {:.3f} ms",
+			mOutputResolution.x, mOutputResolution.y, b.ms[TAA_NBH_LDS], b.ms[TAA_NBH_SUBGROUP], b.ms[TAA_NBH_NAIVE]));
+	}
+
+	// fp16 validation: (re)start the check, it runs while the fp16 kernel is active
+	void start_fp16_check() {
+		auto &chk = mFp16Check;
+		chk.running = true;
+		chk.done    = false;
+		chk.frames  = 0;
+		chk.sumDiff = chk.failed = chk.compared = 0.0;
+		chk.maxDiff = 0.f;
+	}
+
+	// fp16 validation: add the difference sums of this frame in flight (read back when it comes around again) to the running check;
+	// after kFp16CheckFrames frames, fp16 is switched off if too many pixels differ from the fp32 kernel by more than the threshold
+	void read_fp16_check(size_t inFlightIndex) {
+		auto &chk = mFp16Check;
+		if (!chk.valid[inFlightIndex]) return;
+		chk.valid[inFlightIndex] = false;
+
+		const size_t numGroups = size_t((mOutputResolution.x + 15u) / 16u) * size_t((mOutputResolution.y + 15u) / 16u);
+		std::vector<glm::vec4> sums(numGroups);
+		mFp16CheckSums[inFlightIndex]->read(sums.data(), 0, avk::sync::not_required());
+		for (auto &v : sums) { chk.sumDiff += v.x; chk.maxDiff = std::max(chk.maxDiff, v.y); chk.failed += v.z; chk.compared += v.w; }
+		chk.ms16 = helpers::get_timing_interval_in_ms(fmt::format("TAA fp16 {}", inFlightIndex));
+		chk.ms32 = helpers::get_timing_interval_in_ms(fmt::format("TAA fp32 {}", inFlightIndex));
+
+		if (++chk.frames < kFp16CheckFrames || chk.compared <= 0.0) return;
+		chk.running = false;
+		chk.done    = true;
+		chk.passed  = chk.failed / chk.compared <= kFp16CheckMaxFailed;
+		const auto summary = fmt::format("mean diff {:.5f}, max {:.4f}, {:.3f}% of the pixels above {:.4f}; fp16 {:.3f} ms, fp32 {:.3f} ms",
+			chk.sumDiff / chk.compared, chk.maxDiff, 100.0 * chk.failed / chk.compared, chk.threshold, chk.ms16, chk.ms32);
+		if (chk.passed) {
+			LOG_INFO("TAA fp16 check passed: " + summary);
+		} else {
+			LOG_WARNING("TAA fp16 check failed, using the fp32 kernel: " + summary);
+			mUseFp16 = false;
+		}
+	}
+
+	// per class tile counts of the classification in this frame in flight, read back when it comes around again
+	void read_tile_class_stats(size_t inFlightIndex) {
+		if (!mTileClassStatsValid[inFlightIndex]) return;
+		std::array<glm::uvec4, TAA_TILE_HEADER_UINTS / 4> header;
+		mTileClassReadback[inFlightIndex]->read(header.data(), 0, avk::sync::not_required());
+		mTileClassCounts.fill(0u);
+		for (uint32_t d = 0; d < TAA_TILE_MAX_DISPATCHES; ++d) {
+			for (uint32_t c = 0; c < TAA_TILE_NUM_CLASSES; ++c) mTileClassCounts[c] += header[d * TAA_TILE_NUM_CLASSES + c].x;
+		}
+		mTileClassStatsValid[inFlightIndex] = false;
+	}
+
+	// fused resolve (FUSED in taa.comp): TAA_FUSED_* for this frame; off if the chain needs the TAA result as an image
+	uint32_t fused_resolve_mode() {
+		if (!mUseFusedResolve || needRayTraceAssist()) return TAA_FUSED_OFF;	// FXAA and the ray trace passes
+		if (mParameters[0].mDebugToScreenOutput || (mSplitScreen && mParameters[1].mDebugToScreenOutput)) return TAA_FUSED_OFF;
+		if (mPostProcessEnabled && mPostProcessPushConstants.zoom) return TAA_FUSED_OFF;	// zoom reads other pixels
+		if (!mSharpener && !mPostProcessEnabled) return TAA_FUSED_OFF;	// nothing to fuse
+		if (!mSharpener) return TAA_FUSED_COPY;
+		return (mSharpener == 1) ? TAA_FUSED_SHARPEN : TAA_FUSED_CAS;
+	}
+
+	// specialized taa.comp pipeline for a variant key; nullptr while it is being built in the background (use the generic mTaaPipeline then)
+	avk::compute_pipeline * get_taa_variant(uint32_t key) {
+		auto it = mTaaVariants.find(key);
+		if (it != mTaaVariants.end()) return &it->second;
+		if (mTaaVariantBuilds.find(key) == mTaaVariantBuilds.end()) {
+			mTaaVariantBuilds[key] = { mTaaVariantGeneration, std::async(std::launch::async, [key, b = snapshot_taa_pipeline_bindings()]() { return create_taa_pipeline(key, b); }) };
+		}
+		return nullptr;
+	}
+
+	// before the resources in taa_pipeline_bindings are replaced: the snapshots of running builds point to them
+	void wait_for_taa_variant_builds() {
+		for (auto &b : mTaaVariantBuilds) b.second.future.wait();
+	}
+
+	// once per frame: collect finished variant builds, drop the variants after a shader reload, destroy retired ones
+	void update_taa_variants() {
+		const auto frame = gvk::context().main_window()->current_frame();
+
+		// shader hot reload (the updater replaced mTaaPipeline): the variants were built from the old shader
+		if (mTaaPipeline->handle() != mTaaVariantsBuiltFor) {
+			for (auto &v : mTaaVariants) mTaaVariantsRetired.emplace_back(std::move(v.second), frame);
+			mTaaVariants.clear();
+			mTaaVariantsBuiltFor = mTaaPipeline->handle();
+			mTaaVariantGeneration++;
+		}
+
+		for (auto it = mTaaVariantBuilds.begin(); it != mTaaVariantBuilds.end(); ) {
+			if (it->second.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) { ++it; continue; }
+			try {
+				auto pipe = it->second.future.get();
+				if (it->second.generation == mTaaVariantGeneration) mTaaVariants.emplace(it->first, std::move(pipe));
+			}
+			catch (std::exception &e) {
+				if (((it->first >> TAA_VARIANT_NBH_SHIFT) & 0x3u) == TAA_NBH_SUBGROUP) {
+					LOG_WARNING(fmt::format("TAA: building subgroup pipeline variant {:#06x} failed ({}), using the LDS tile", it->first, e.what()));
+					mNeighbourhoodMode = TAA_NBH_LDS;
+				} else if (it->first & TAA_VARIANT_FP16) {
+					LOG_WARNING(fmt::format("TAA: building fp16 pipeline variant {:#06x} failed ({}), using fp32", it->first, e.what()));
+					mUseFp16 = false;
+				} else {
+					LOG_WARNING(fmt::format("TAA: building pipeline variant {:#06x} failed ({}), using the generic pipeline", it->first, e.what()));
+					mUseTaaVariants = false;
+				}
+			}
+			it = mTaaVariantBuilds.erase(it);
+		}
+
+		// retired variants may still be used by frames in flight
+		mTaaVariantsRetired.erase(std::remove_if(mTaaVariantsRetired.begin(), mTaaVariantsRetired.end(), [frame](const auto &r) { return frame > r.second + static_cast<gvk::window::frame_id_t>(CF); }), mTaaVariantsRetired.end());
+	}
+
 	// Create all the compute pipelines used for the post processing effect(s),
 	// prepare some command buffers with pipeline barriers to synchronize with subsequent commands,
 	// create a new ImGui window that allows to enable/disable anti-aliasing, and to modify parameters:
@@ -661,25 +1142,23 @@ public:
 			mUniformsBuffer[i] = context().create_buffer(memory_usage::host_coherent, {}, uniform_buffer_meta::create_from_size(sizeof(uniforms_for_taa)));
 		}
 
-		mTaaPipeline = context().create_compute_pipeline_for(
-			compute_shader("shaders/taa.comp.spv"),
-			descriptor_binding(0,  0, mSampler),
-			descriptor_binding(0,  1, *mSrcColor[0]),
-			descriptor_binding(0,  2, *mSrcDepth[0]),
-			descriptor_binding(0,  3, *mResultImages[0]),
-			descriptor_binding(0,  4, *mSrcDepth[0]),
-			descriptor_binding(0,  5, mResultImages[0]->as_storage_image()),		// output for screen
-			descriptor_binding(0,  6, mDebugImages[0]->as_storage_image()),
-			descriptor_binding(0,  7, *mSrcVelocity[0]),
-			descriptor_binding(0,  8, mHistoryImages[0]->as_storage_image()),	// output for history
-			descriptor_binding(0,  9, mSegmentationImages[0]->as_storage_image()),
-			descriptor_binding(0, 10, (mSrcMatId[0])->as_storage_image()),
-			descriptor_binding(0, 11, (mSrcMatId[0])->as_storage_image()),
-			descriptor_binding(0, 12, mSegmentationImages[0]->as_storage_image()),
-			descriptor_binding(0, 13, *mSrcUvNrm[0]),
-			descriptor_binding(1,  0, mUniformsBuffer[0])
-			//push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constants_for_taa) }
-		);
+		mTaaPipeline = create_taa_pipeline(0, snapshot_taa_pipeline_bindings());
+		mTaaVariantsBuiltFor = mTaaPipeline->handle();
+
+		// the queues are only assigned with the device, so this cannot be checked in the constructor
+		if (mComputeQueue && mComputeQueue->family_index() == mQueue->family_index() && mComputeQueue->queue_index() == mQueue->queue_index()) {
+			LOG_WARNING("-asynccompute: no separate compute queue available, TAA stays on the graphics queue");
+			mComputeQueue = nullptr;
+		}
+		if (mComputeQueue) {
+			auto device = context().device();
+			for (size_t i = 0; i < CF; ++i) {
+				mInputsReadySemaphores[i] = device.createSemaphoreUnique({});
+				mResolveDoneSemaphores[i] = device.createSemaphoreUnique({});
+				mResolveFences[i]         = device.createFenceUnique({ vk::FenceCreateFlagBits::eSignaled });
+			}
+			LOG_INFO(fmt::format("TAA async compute: graphics queue family {}, compute queue family {}", mQueue->family_index(), mComputeQueue->family_index()));
+		}
 
 
 		mSharpenerPipeline = context().create_compute_pipeline_for(
@@ -710,6 +1189,45 @@ public:
 			push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constants_for_fxaa) }
 		);
 
+		mRayTracePixelListPipeline = context().create_compute_pipeline_for(
+			compute_shader("shaders/rt_pixel_list.comp.spv"),
+			descriptor_binding(0, 0, mSegmentationImages[0]->as_storage_image()),
+			descriptor_binding(0, 1, mRayTracePixelLists[0]->as_storage_buffer()),
+			descriptor_binding(0, 2, mRayTraceBudgetBuffers[0]->as_storage_buffer()),
+			push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constants_for_rt_pixel_list) }
+		);
+
+		mTileClassifyPipeline = context().create_compute_pipeline_for(
+			compute_shader("shaders/taa_classify.comp.spv"),
+			descriptor_binding(0, 0, *mSrcVelocity[0]),
+			descriptor_binding(0, 1, *mSrcDepth[0]),
+			descriptor_binding(0, 2, mSrcMatId[0]->as_storage_image()),
+			descriptor_binding(0, 3, mSrcMatId[0]->as_storage_image()),
+			descriptor_binding(0, 4, mSegmentationImages[0]->as_storage_image()),
+			descriptor_binding(0, 5, mTileClassBuffers[0]->as_storage_buffer()),
+			push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constants_for_tile_classify) }
+		);
+
+		mFp16Supported = fp16_supported();
+		mSubgroupShuffleSupported = subgroup_shuffle_supported();
+		mFp16CheckPipeline = context().create_compute_pipeline_for(
+			compute_shader("shaders/taa_fp16_check.comp.spv"),
+			descriptor_binding(0, 0, mHistoryImages[0]->as_storage_image()),
+			descriptor_binding(0, 1, mFp16CheckImage->as_storage_image()),
+			descriptor_binding(0, 2, mFp16CheckSums[0]->as_storage_buffer()),
+			push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constants_for_fp16_check) }
+		);
+
+		mRayTraceTemporalPipeline = context().create_compute_pipeline_for(
+			compute_shader("shaders/rt_temporal.comp.spv"),
+			descriptor_binding(0, 0, mSegmentationImages[0]->as_storage_image()),
+			descriptor_binding(0, 1, mResultImages[0]->as_storage_image()),
+			descriptor_binding(0, 2, mHistoryImages[0]->as_storage_image()),
+			descriptor_binding(0, 3, mRayTraceReference->as_storage_image()),
+			descriptor_binding(0, 4, mRayTraceErrorSums[0]->as_storage_buffer()),
+			push_constant_binding_data{ shader_type::compute, 0, sizeof(push_constants_for_rt_temporal) }
+		);
+
 		mPostProcessPipeline = context().create_compute_pipeline_for(
 			compute_shader("shaders/post_process.comp.spv"),
 			descriptor_binding(0, 1, *mResultImages[0]),
@@ -942,7 +1460,13 @@ public:
 		}
 		mTaaUniforms.mJitterNdc  = glm::vec4(jitter.x, jitter.y, 0.f, 0.f);
 		mTaaUniforms.mSinTime    = glm::sin(glm::vec4(.125f, .25f, .5f, 1.f) * static_cast<float>(glfwGetTime()));
-		mTaaUniforms.mUpsampling = mUpsampling;
+		// dynamic resolution: the history is kept when the render resolution changes, it is always at the output resolution
+		const auto renderRes     = mRenderResolutions[context().main_window()->current_frame() % CF];
+		const auto prevRenderRes = mRenderResolutions[(context().main_window()->current_frame() + CF - 1) % CF];
+		mTaaUniforms.mInputSize      = glm::ivec2(renderRes);
+		mTaaUniforms.mPrevInputSize  = glm::ivec2(prevRenderRes);
+		mTaaUniforms.mInputUvScale   = glm::vec2(renderRes) / glm::vec2(mInputResolution);
+		mTaaUniforms.mUpsampling = (renderRes != mOutputResolution);
 		mTaaUniforms.splitScreen = mSplitScreen;
 		mTaaUniforms.splitX      = mSplitX;
 		mTaaUniforms.mBypassHistoryUpdate = bypassHistUpdate;
@@ -950,6 +1474,15 @@ public:
 		mTaaUniforms.mCamNearPlane = quakeCamera->near_plane_distance();
 		mTaaUniforms.mCamFarPlane  = quakeCamera->far_plane_distance();
 
+		// temporal ray tracing is off for the frame which captures the reference of the error report (that one is supersampled)
+		mRayTraceTemporal.referenceThisFrame = mRayTraceTemporal.captureRequested && needRayTraceAssist();
+		mRayTraceTemporal.captureRequested   = false;
+		mTaaUniforms.mUseTile          = mUseNeighbourhoodTile;
+		update_taa_variants();
+		// same in the debug mode of the sparse ray tracing: marked pixels are only painted, so their history would keep the unrectified reprojection
+		const bool rtDebug = mRayTraceCallback && mRayTraceCallback->getRayTraceAugmentTaaDebug();
+		mTaaUniforms.mRayTraceTemporal = (mRayTraceTemporal.enabled && needRayTraceAssist() && !mRayTraceTemporal.referenceThisFrame && !rtDebug) ? VK_TRUE : VK_FALSE;
+
 		mFxaaPushConstants.fxaaQualityRcpFrame = 1.f / glm::vec2(mOutputResolution);	// {x_} = 1.0/screenWidthInPixels, {_y} = 1.0/screenHeightInPixels
 
 		mPostProcessPushConstants.splitX = mSplitScreen ? mSplitX : -1;
@@ -964,12 +1497,129 @@ public:
 			mSharpenerPushConstants.sharpeningFactor = mSharpenFactor;
 			CasSetup(mCasPushConstants.const0, mCasPushConstants.const1, mSharpenFactor, AF1(mOutputResolution.x), AF1(mOutputResolution.y), AF1(mOutputResolution.x), AF1(mOutputResolution.y));
 		}
+		mTaaPushConstants.fusedSplitX  = (mPostProcessEnabled && mSplitScreen) ? mSplitX : -1;
+		mTaaPushConstants.fusedSharpen = mSharpenFactor;
+		memcpy(mTaaPushConstants.casConst0, mCasPushConstants.const0, sizeof(mTaaPushConstants.casConst0));
+		memcpy(mTaaPushConstants.casConst1, mCasPushConstants.const1, sizeof(mTaaPushConstants.casConst1));
 
 		mResetHistory = false;
 		for (int i = 0; i < 2; ++i) oldParams[i] = mParameters[i];
 		oldParamsValid = true;
 	}
 
+	// ray budget controller: derive this frame's pixel budget and samples per pixel from the stats of the
+	// last frame which used the same in-flight index (its fence has been waited on, so the readback is valid)
+	void update_ray_budget(size_t inFlightIndex) {
+		auto &rb = mRayTraceBudget;
+		const int userSpp = mRayTraceCallback ? std::max(1, mRayTraceCallback->getNumRayTraceSamples()) : 1;
+
+		if (rb.statsValid[inFlightIndex]) {
+			uint32_t stats[8];
+			mRayTraceBudgetReadback[inFlightIndex]->read(stats, 0, avk::sync::not_required());
+			rb.markedPixels = stats[0];
+			rb.tracedPixels = stats[4];
+			rb.lastMs = helpers::get_timing_interval_in_ms(fmt::format("TAA RT {}", inFlightIndex));	// already averaged
+			rb.avgRays = rb.avgRays * 0.9f + static_cast<float>(rb.tracedPixels) * static_cast<float>(rb.sppUsed[inFlightIndex]) * 0.1f;
+			if (rb.lastMs > 0.01f && rb.avgRays > 0.f) rb.raysPerMs = rb.avgRays / rb.lastMs;
+		}
+
+		const float maxRays = static_cast<float>(std::max(1, rb.maxRays));
+		float rayBudget = maxRays;
+		if (rb.mode == 1 && rb.raysPerMs > 0.f) rayBudget = std::min(maxRays, rb.targetMs * rb.raysPerMs);
+		rayBudget = std::max(rayBudget, 1024.f);
+
+		// reduce samples per pixel first, then drop the lowest priority pixels
+		rb.spp = glm::clamp(static_cast<int>(rayBudget / static_cast<float>(std::max(rb.markedPixels, 1u))), 1, userSpp);
+		rb.pixelBudget = static_cast<uint32_t>(rayBudget / static_cast<float>(rb.spp));
+		rb.sppUsed[inFlightIndex] = rb.spp;
+	}
+
+	// samples per ray traced pixel of this frame (as used by the ray tracer, see getRayTraceSampleOverride/getRayTraceSampleLimit)
+	int ray_trace_samples_this_frame() {
+		const int forced = getRayTraceSampleOverride();
+		if (forced > 0) return forced;
+		const int spp = mRayTraceCallback ? std::max(1, mRayTraceCallback->getNumRayTraceSamples()) : 1;
+		return getRayTraceSampleLimit() > 0 ? std::min(spp, getRayTraceSampleLimit()) : spp;
+	}
+
+	// temporal ray tracing: blend the ray traced samples into the history (rt_temporal.comp);
+	// the same pass stores the reference of the error report, or sums up the errors against it
+	void record_ray_trace_temporal(avk::command_buffer &cmdbfr, size_t inFlightIndex, avk::image_view_t &rtResult) {
+		using namespace avk;
+		using namespace gvk;
+
+		auto &rt = mRayTraceTemporal;
+		const bool debug   = mRayTraceCallback->getRayTraceAugmentTaaDebug();	// only marks the pixels, nothing to accumulate
+		const bool blend   = (mTaaUniforms.mRayTraceTemporal != VK_FALSE) && !debug;
+		const bool measure = rt.measure && rt.referenceValid && !rt.referenceThisFrame && !debug;
+		if (!blend && !measure && !rt.referenceThisFrame) return;
+
+		push_constants_for_rt_temporal pushc;
+		pushc.blendWeight = rt.blendWeight;
+		pushc.splitX      = mSplitScreen ? mSplitX : -1;
+		pushc.toneMap     = (mParameters[0].mToneMapLumaKaris ? 1u : 0u) | (mParameters[1].mToneMapLumaKaris ? 2u : 0u);
+		pushc.mode        = (blend ? 1u : 0u) | (measure ? 2u : 0u) | (rt.referenceThisFrame ? 4u : 0u);
+
+		cmdbfr->establish_global_memory_barrier(
+			pipeline_stage::compute_shader | ray_trace_stage(),                   /* -> */ pipeline_stage::compute_shader,
+			memory_access::shader_buffers_and_images_write_access,                /* -> */ memory_access::shader_buffers_and_images_any_access
+		);
+		cmdbfr->bind_pipeline(const_referenced(mRayTraceTemporalPipeline));
+		cmdbfr->bind_descriptors(mRayTraceTemporalPipeline->layout(), mDescriptorCache.get_or_create_descriptor_sets({
+			descriptor_binding(0, 0, mSegmentationImages[inFlightIndex]->as_storage_image()),
+			descriptor_binding(0, 1, rtResult.as_storage_image()),
+			descriptor_binding(0, 2, mHistoryImages[inFlightIndex]->as_storage_image()),
+			descriptor_binding(0, 3, mRayTraceReference->as_storage_image()),
+			descriptor_binding(0, 4, mRayTraceErrorSums[inFlightIndex]->as_storage_buffer())
+			}));
+		cmdbfr->push_constants(mRayTraceTemporalPipeline->layout(), pushc);
+		cmdbfr->handle().dispatch((rtResult.get_image().width() + 15u) / 16u, (rtResult.get_image().height() + 15u) / 16u, 1);
+
+		cmdbfr->establish_global_memory_barrier(
+			pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::compute_shader,
+			memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+		);
+		if (measure) {
+			cmdbfr->establish_global_memory_barrier(
+				pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::host,
+				memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::host_read_access
+			);
+			rt.errorValid[inFlightIndex]    = true;
+			rt.errorSpp[inFlightIndex]      = ray_trace_samples_this_frame();
+			rt.errorTemporal[inFlightIndex] = blend;
+		}
+		if (rt.referenceThisFrame) {
+			rt.referenceValid = true;
+			rt.report.clear();
+		}
+	}
+
+	// rays-vs-error report: read back the error sums of the last frame which used the same in-flight index (its fence has been waited on),
+	// and add them to the report row of the current configuration (a new row is started when the configuration changes)
+	void update_ray_trace_report(size_t inFlightIndex) {
+		auto &rt = mRayTraceTemporal;
+		if (!rt.errorValid[inFlightIndex]) return;
+		rt.errorValid[inFlightIndex] = false;
+
+		const size_t numGroups = size_t((mOutputResolution.x + 15u) / 16u) * size_t((mOutputResolution.y + 15u) / 16u);
+		std::vector<glm::vec4> sums(numGroups);
+		mRayTraceErrorSums[inFlightIndex]->read(sums.data(), 0, avk::sync::not_required());
+		double sqErr = 0.0, compared = 0.0, traced = 0.0;
+		for (auto &v : sums) { sqErr += v.x; compared += v.y; traced += v.z; }
+		if (compared <= 0.0) return;
+
+		const bool  temporal = rt.errorTemporal[inFlightIndex];
+		const int   spp      = rt.errorSpp[inFlightIndex];
+		const float weight   = temporal ? rt.blendWeight : 1.f;
+		if (rt.report.empty() || rt.report.back().temporal != temporal || rt.report.back().spp != spp || rt.report.back().blendWeight != weight) {
+			rt.report.push_back({ temporal, spp, weight });
+		}
+		auto &row = rt.report.back();
+		row.rays     += traced * spp;
+		row.mse      += sqErr / compared;
+		row.frames   += 1;
+	}
+
 	// Create a new command buffer every frame, record instructions into it, and submit it to the graphics queue:
 	void render() override
 	{
@@ -980,21 +1630,42 @@ public:
 		auto inFlightIndex = mainWnd->in_flight_index_for_frame();
 		auto inFlightLastIndex = (inFlightIndex + CF - 1) % CF;
 
-		auto& commandPool = context().get_command_pool_for_single_use_command_buffers(*mQueue);
+		static bool isVeryFirstFrame = true;
+
+		// async compute: record the TAA/post processing chain for the compute queue, the blit to the backbuffer is submitted separately (submit_async)
+		// (not with ray trace augmentation, that needs the graphics queue in between)
+		const bool asyncCompute      = mTaaEnabled && !isVeryFirstFrame && mUseAsyncCompute && mComputeQueue && !needRayTraceAssist();
+		const bool transferOwnership = asyncCompute && mComputeQueue->family_index() != mQueue->family_index();
+		const auto timingStage       = asyncCompute ? vk::PipelineStageFlagBits::eAllCommands : vk::PipelineStageFlagBits::eAllGraphics;
+		image_view_t* pResolvedImageView = nullptr;
+
+		// only the current inputs and the result change queue family ownership; the history, the segmentation masks and the previous
+		// depth/material ids stay with the family that wrote them - their content is undefined for the other one, so start over
+		const uint32_t resolveQueueFamily = asyncCompute ? mComputeQueue->family_index() : mQueue->family_index();
+		const bool queueFamilySwitched    = mLastResolveQueueFamily != resolveQueueFamily && mLastResolveQueueFamily != ~0u;
+		mLastResolveQueueFamily = resolveQueueFamily;
+
+		auto& commandPool = context().get_command_pool_for_single_use_command_buffers(asyncCompute ? *mComputeQueue : *mQueue);
 		auto cmdbfr = commandPool->alloc_command_buffer(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 		cmdbfr->begin_recording();
 		rdoc::beginSection(cmdbfr->handle(), "TAA pass");
 
+		if (transferOwnership) {
+			// acquire the current inputs, released by the graphics queue in submit_async
+			cmdbfr->handle().pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, input_ownership_barriers(inFlightIndex, false));
+		}
+
 		// ---------------------- If Anti-Aliasing is enabled perform the following actions --------------------------
-		static bool isVeryFirstFrame = true;
 		if (mTaaEnabled && !isVeryFirstFrame) {	// history is invalid for the very first frame
 
 			// fill in matrices to uniforms UBO
 			mTaaUniforms.mInverseViewProjMatrix = glm::inverse(mHistoryProjMatrices[inFlightIndex] * mHistoryViewMatrices[inFlightIndex]);
 			mTaaUniforms.mHistoryViewProjMatrix = mHistoryProjMatrices[inFlightLastIndex] * mHistoryViewMatrices[inFlightLastIndex];
+			mTaaUniforms.mUseDepthPyramid       = (mDepthPyramidEnabled && !transferOwnership) ? VK_TRUE : VK_FALSE;	// the buffer is not transferred to the compute queue family
+			if (queueFamilySwitched) mTaaUniforms.mResetHistory = VK_TRUE;
 			mUniformsBuffer[inFlightIndex]->fill(&mTaaUniforms, 0, sync::not_required()); // sync is done with establish_global_memory_barrier below
 
-			helpers::record_timing_interval_start(cmdbfr->handle(), fmt::format("TAA {}", inFlightIndex));
+			helpers::record_timing_interval_start(cmdbfr->handle(), fmt::format("TAA {}", inFlightIndex), timingStage);
 
 			cmdbfr->establish_global_memory_barrier(
 				pipeline_stage::transfer,             /* -> */ pipeline_stage::compute_shader,
@@ -1005,38 +1676,310 @@ public:
 			static_assert(CF > 1);
 
 			// Apply Temporal Anti-Aliasing:
-			cmdbfr->bind_pipeline(const_referenced(mTaaPipeline));
-			cmdbfr->bind_descriptors(mTaaPipeline->layout(), mDescriptorCache.get_or_create_descriptor_sets({
-				descriptor_binding(0,  0, mSampler),
-				descriptor_binding(0,  1, *mSrcColor[inFlightIndex]),								// -> shader: uCurrentFrame
-				descriptor_binding(0,  2, *mSrcDepth[inFlightIndex]),								// -> shader: uCurrentDepth
-				descriptor_binding(0,  3, *mHistoryImages[inFlightLastIndex]),						// -> shader: uHistoryFrame
-				descriptor_binding(0,  4, *mSrcDepth[inFlightLastIndex]),							// -> shader: uHistoryDepth
-				descriptor_binding(0,  5, mResultImages[inFlightIndex]->as_storage_image()),		// -> shader: uResultScreen
-				descriptor_binding(0,  6, mDebugImages[inFlightIndex]->as_storage_image()),			// -> shader: uDebug
-				descriptor_binding(0,  7, *mSrcVelocity[inFlightIndex]),							// -> shader: uCurrentVelocity
-				descriptor_binding(0,  8, mHistoryImages[inFlightIndex]->as_storage_image()),		// -> shader: uResultHistory
-				descriptor_binding(0,  9, mSegmentationImages[inFlightIndex]->as_storage_image()),	// -> shader: uSegMask
-				descriptor_binding(0, 10, (mSrcMatId[inFlightIndex])->as_storage_image()),			// -> shader: uCurrentMaterial
-				descriptor_binding(0, 11, (mSrcMatId[inFlightLastIndex])->as_storage_image()),		// -> shader: uPreviousMaterial
-				descriptor_binding(0, 12, mSegmentationImages[inFlightLastIndex]->as_storage_image()),	// -> shader: uPreviousSegMask
-				descriptor_binding(0, 13, *mSrcUvNrm[inFlightIndex]),								// -> shader: uCurrentUvNrm
-				descriptor_binding(1,  0, mUniformsBuffer[inFlightIndex])
-				}));
-			//cmdbfr->push_constants(mTaaPipeline->layout(), mTaaPushConstants);
-			cmdbfr->handle().dispatch((mResultImages[inFlightIndex]->get_image().width() + 15u) / 16u, (mResultImages[inFlightIndex]->get_image().height() + 15u) / 16u, 1);
-
-			image_view_t* pLastProducedImageView_t = &mResultImages[inFlightIndex].get();
+			const int taaWidth  = static_cast<int>(mResultImages[inFlightIndex]->get_image().width());
+			const int taaHeight = static_cast<int>(mResultImages[inFlightIndex]->get_image().height());
+			avk::image_view *taaHistoryTarget = &mHistoryImages[inFlightIndex];	// fp16 validation: mFp16CheckImage for the fp32 kernel
+
+			// tileList >= 0: indirect dispatch of that tile classification list (dispatch index * TAA_TILE_NUM_CLASSES + class)
+			auto dispatchTaa = [&](avk::compute_pipeline &pipe, int x0, int x1, int paramsIdx, int pixelsPerGroup, int tileList) {
+				if (x1 <= x0) return;
+				cmdbfr->bind_pipeline(const_referenced(pipe));
+				cmdbfr->bind_descriptors(pipe->layout(), mDescriptorCache.get_or_create_descriptor_sets({
+					descriptor_binding(0,  0, mSampler),
+					descriptor_binding(0,  1, *mSrcColor[inFlightIndex]),								// -> shader: uCurrentFrame
+					descriptor_binding(0,  2, *mSrcDepth[inFlightIndex]),								// -> shader: uCurrentDepth
+					descriptor_binding(0,  3, *mHistoryImages[inFlightLastIndex]),						// -> shader: uHistoryFrame
+					descriptor_binding(0,  4, *mSrcDepth[inFlightLastIndex]),							// -> shader: uHistoryDepth
+					descriptor_binding(0,  5, mResultImages[inFlightIndex]->as_storage_image()),		// -> shader: uResultScreen
+					descriptor_binding(0,  6, mDebugImages[inFlightIndex]->as_storage_image()),			// -> shader: uDebug
+					descriptor_binding(0,  7, *mSrcVelocity[inFlightIndex]),							// -> shader: uCurrentVelocity
+					descriptor_binding(0,  8, (*taaHistoryTarget)->as_storage_image()),				// -> shader: uResultHistory
+					descriptor_binding(0,  9, mSegmentationImages[inFlightIndex]->as_storage_image()),	// -> shader: uSegMask
+					descriptor_binding(0, 10, (mSrcMatId[inFlightIndex])->as_storage_image()),			// -> shader: uCurrentMaterial
+					descriptor_binding(0, 11, (mSrcMatId[inFlightLastIndex])->as_storage_image()),		// -> shader: uPreviousMaterial
+					descriptor_binding(0, 12, mSegmentationImages[inFlightLastIndex]->as_storage_image()),	// -> shader: uPreviousSegMask
+					descriptor_binding(0, 13, *mSrcUvNrm[inFlightIndex]),								// -> shader: uCurrentUvNrm
+					descriptor_binding(0, 14, mPostProcessImages[inFlightIndex]->as_storage_image()),	// -> shader: uFusedOutput
+					descriptor_binding(0, 15, mTileClassBuffers[inFlightIndex]->as_storage_buffer()),	// -> shader: uTileClasses
+					descriptor_binding(0, 16, mSrcDepthPyramid[inFlightIndex]->as_storage_buffer()),	// -> shader: uDepthPyramid
+					descriptor_binding(1,  0, mUniformsBuffer[inFlightIndex])
+					}));
+				mTaaPushConstants.offset    = glm::ivec2(x0, 0);
+				mTaaPushConstants.endX      = x1;
+				mTaaPushConstants.paramsIdx = paramsIdx;
+				mTaaPushConstants.tileList  = (tileList >= 0) ? tileList * static_cast<int>(mTileClassMaxTiles) : -1;
+				cmdbfr->push_constants(pipe->layout(), mTaaPushConstants);
+				if (tileList >= 0) {
+					cmdbfr->handle().dispatchIndirect(mTileClassBuffers[inFlightIndex]->handle(), static_cast<vk::DeviceSize>(tileList) * sizeof(glm::uvec4));
+				} else {
+					const uint32_t n = static_cast<uint32_t>(pixelsPerGroup);
+					cmdbfr->handle().dispatch((static_cast<uint32_t>(x1 - x0) + n - 1) / n, (static_cast<uint32_t>(taaHeight) + n - 1) / n, 1);
+				}
+			};
+
+			// the dispatches and their pipelines; extraBits != 0: the fused resolve, fp16 and/or neighbourhood mode pipelines, which are built in
+			// the background like the variants - returns false while one of them is not ready (the separate passes/fp32/LDS are used meanwhile)
+			struct taa_dispatch { avk::compute_pipeline *pipe; uint32_t key; int x0, x1, paramsIdx; };
+			std::vector<taa_dispatch> taaDispatches;
+			auto planTaa = [&](uint32_t extraBits) {
+				taaDispatches.clear();
+				if (mUseTaaVariants) {
+					// one dispatch per parameter set (split screen: left and right half), with its specialized pipeline once that is built
+					const int splitEnd = mSplitScreen ? glm::clamp(mSplitX + 1, 0, taaWidth) : taaWidth;
+					for (int i = 0; i < (mSplitScreen ? 2 : 1); ++i) {
+						avk::compute_pipeline *variant = get_taa_variant(taa_variant_key(mParameters[i]) | extraBits);
+						if (!variant && extraBits) return false;
+						taaDispatches.push_back({ variant ? variant : &mTaaPipeline, variant ? (taa_variant_key(mParameters[i]) | extraBits) : 0u, i == 0 ? 0 : splitEnd, i == 0 ? splitEnd : taaWidth, i });
+					}
+				} else {
+					avk::compute_pipeline *pipe = extraBits ? get_taa_variant(extraBits) : &mTaaPipeline;
+					if (!pipe) return false;
+					taaDispatches.push_back({ pipe, extraBits, 0, taaWidth, -1 });
+				}
+				return true;
+			};
+			update_nbh_bench(inFlightIndex);
+			const uint32_t fusedMode = fused_resolve_mode();
+			const uint32_t fp16Bits  = (mUseFp16 && mFp16Supported) ? TAA_VARIANT_FP16 : 0u;
+			const uint32_t nbhMode   = (mNeighbourhoodMode == TAA_NBH_SUBGROUP && !mSubgroupShuffleSupported) ? TAA_NBH_LDS : mNeighbourhoodMode;
+			const uint32_t nbhBits   = nbhMode << TAA_VARIANT_NBH_SHIFT;
+			mFusedResolveActive = (fusedMode != TAA_FUSED_OFF) && planTaa((fusedMode << TAA_VARIANT_FUSED_SHIFT) | fp16Bits | nbhBits);
+			mFp16Active         = fp16Bits && (mFusedResolveActive || planTaa(fp16Bits | nbhBits));
+			const bool nbhActive = nbhBits && (mFusedResolveActive || mFp16Active || planTaa(nbhBits));
+			if (!mFusedResolveActive && !mFp16Active && !nbhActive) planTaa(0u);
+			mNbhActiveMode = nbhActive ? nbhMode : TAA_NBH_LDS;
+			// with sharpening, the fused workgroups overlap (see FUSED_OVERLAP in taa.comp)
+			const int pixelsPerGroup = (mFusedResolveActive && fusedMode != TAA_FUSED_COPY) ? 14 : 16;
+
+			// tile classification (taa_classify.comp): static tiles use the TAA_VARIANT_STATIC_TILE pipeline of their dispatch (specialized:
+			// interpolation and velocity sampling bits cleared, they are fixed for static tiles), once that is built
+			read_tile_class_stats(inFlightIndex);
+			read_fp16_check(inFlightIndex);
+			std::vector<avk::compute_pipeline *> staticPipes;
+			bool classify = mUseTileClasses;
+			for (auto &d : taaDispatches) {
+				if (!classify) break;
+				uint32_t staticKey = d.key | TAA_VARIANT_STATIC_TILE;
+				if (d.key & TAA_VARIANT_SPECIALIZED) staticKey &= ~((0x3u << TAA_VARIANT_INTERP_SHIFT) | (0x3u << TAA_VARIANT_VELSAMPLE_SHIFT));
+				staticPipes.push_back(get_taa_variant(staticKey));
+				if (!staticPipes.back()) classify = false;
+			}
+			mTileClassesActive = classify;
+
+			helpers::record_timing_interval_start(cmdbfr->handle(), fmt::format("TAA pass {}", inFlightIndex), timingStage);
+			if (classify) {
+				auto &tileBuffer = mTileClassBuffers[inFlightIndex];
+
+				std::array<glm::uvec4, TAA_TILE_HEADER_UINTS / 4> tileHeader;
+				tileHeader.fill(glm::uvec4(0u, 1u, 1u, 0u));	// groups x (= count), y, z, pad
+				cmdbfr->handle().updateBuffer(tileBuffer->handle(), 0, sizeof(tileHeader), tileHeader.data());
+				cmdbfr->establish_global_memory_barrier(
+					pipeline_stage::transfer,             /* -> */ pipeline_stage::compute_shader,
+					memory_access::transfer_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+				);
+
+				cmdbfr->bind_pipeline(const_referenced(mTileClassifyPipeline));
+				cmdbfr->bind_descriptors(mTileClassifyPipeline->layout(), mDescriptorCache.get_or_create_descriptor_sets({
+					descriptor_binding(0, 0, *mSrcVelocity[inFlightIndex]),
+					descriptor_binding(0, 1, *mSrcDepth[inFlightIndex]),
+					descriptor_binding(0, 2, mSrcMatId[inFlightIndex]->as_storage_image()),
+					descriptor_binding(0, 3, mSrcMatId[inFlightLastIndex]->as_storage_image()),
+					descriptor_binding(0, 4, mSegmentationImages[inFlightLastIndex]->as_storage_image()),
+					descriptor_binding(0, 5, tileBuffer->as_storage_buffer())
+					}));
+				auto &pc = mTileClassifyPushConstants;
+				pc.pixelsPerGroup  = pixelsPerGroup;
+				pc.inputSize       = mTaaUniforms.mInputSize;
+				pc.prevInputSize   = mTaaUniforms.mPrevInputSize;
+				pc.outputSize      = glm::ivec2(taaWidth, taaHeight);
+				pc.staticThreshold = mTileStaticThreshold;
+				pc.edgeThreshold   = mTileEdgeThreshold;
+				pc.camNearPlane    = mTaaUniforms.mCamNearPlane;
+				pc.camFarPlane     = mTaaUniforms.mCamFarPlane;
+				pc.maxTiles        = mTileClassMaxTiles;
+				pc.viewChanged     = (mHistoryViewMatrices[inFlightIndex] != mHistoryViewMatrices[inFlightLastIndex]) ? VK_TRUE : VK_FALSE;
+				for (size_t i = 0; i < taaDispatches.size(); ++i) {
+					auto &d = taaDispatches[i];
+					if (d.x1 <= d.x0) continue;
+					pc.offset      = glm::ivec2(d.x0, 0);
+					pc.endX        = d.x1;
+					pc.dispatchIdx = static_cast<uint32_t>(i);
+					cmdbfr->push_constants(mTileClassifyPipeline->layout(), pc);
+					const uint32_t n = static_cast<uint32_t>(pixelsPerGroup);
+					cmdbfr->handle().dispatch((static_cast<uint32_t>(d.x1 - d.x0) + n - 1) / n, (static_cast<uint32_t>(taaHeight) + n - 1) / n, 1);
+				}
+
+				cmdbfr->establish_global_memory_barrier(
+					pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::draw_indirect | pipeline_stage::compute_shader | pipeline_stage::transfer,
+					memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::indirect_command_data_read_access | memory_access::shader_buffers_and_images_any_access | memory_access::transfer_read_access
+				);
+
+				// tile counts for the report, read back when this in-flight index comes around again
+				const vk::BufferCopy region{ 0, 0, TAA_TILE_HEADER_UINTS * sizeof(uint32_t) };
+				cmdbfr->handle().copyBuffer(tileBuffer->handle(), mTileClassReadback[inFlightIndex]->handle(), 1, &region);
+				cmdbfr->establish_global_memory_barrier(
+					pipeline_stage::transfer,             /* -> */ pipeline_stage::host,
+					memory_access::transfer_write_access, /* -> */ memory_access::host_read_access
+				);
+				mTileClassStatsValid[inFlightIndex] = true;
+
+				// one indirect dispatch per class and TAA dispatch; static tiles and the others are timed separately for the saving estimate
+				for (uint32_t c = 0; c < TAA_TILE_NUM_CLASSES; ++c) {
+					if (c == TAA_TILE_STATIC) helpers::record_timing_interval_start(cmdbfr->handle(), fmt::format("TAA static {}", inFlightIndex), timingStage);
+					if (c == TAA_TILE_MOVING) helpers::record_timing_interval_start(cmdbfr->handle(), fmt::format("TAA full {}", inFlightIndex), timingStage);
+					for (size_t i = 0; i < taaDispatches.size(); ++i) {
+						auto &d = taaDispatches[i];
+						dispatchTaa(c == TAA_TILE_STATIC ? *staticPipes[i] : *d.pipe, d.x0, d.x1, d.paramsIdx, pixelsPerGroup, static_cast<int>(i * TAA_TILE_NUM_CLASSES + c));
+					}
+					if (c == TAA_TILE_STATIC) helpers::record_timing_interval_end(cmdbfr->handle(), fmt::format("TAA static {}", inFlightIndex), timingStage);
+				}
+				helpers::record_timing_interval_end(cmdbfr->handle(), fmt::format("TAA full {}", inFlightIndex), timingStage);
+			} else {
+				for (auto &d : taaDispatches) {
+					dispatchTaa(*d.pipe, d.x0, d.x1, d.paramsIdx, pixelsPerGroup, -1);
+				}
+			}
+			helpers::record_timing_interval_end(cmdbfr->handle(), fmt::format("TAA pass {}", inFlightIndex), timingStage);
+
+			// fp16 validation: resolve the frame again with the fp16 and the fp32 kernel (direct dispatches without fused resolve, so both do
+			// the same work and can be timed), the fp32 history goes to mFp16CheckImage and is compared by taa_fp16_check.comp
+			if (mFp16Active && mFp16Check.running && !mFp16Check.valid[inFlightIndex]) {
+				std::vector<std::pair<avk::compute_pipeline *, avk::compute_pipeline *>> checkPipes;
+				for (auto &d : taaDispatches) {
+					const uint32_t key16 = d.key & ~((0x3u << TAA_VARIANT_FUSED_SHIFT) | TAA_VARIANT_STATIC_TILE);
+					const uint32_t key32 = key16 & ~TAA_VARIANT_FP16;
+					checkPipes.emplace_back(get_taa_variant(key16), key32 ? get_taa_variant(key32) : &mTaaPipeline);
+				}
+				const bool ready = std::all_of(checkPipes.begin(), checkPipes.end(), [](const auto &p) { return p.first && p.second; });
+				if (ready) {
+					auto barrier = [&]() {
+						cmdbfr->establish_global_memory_barrier(
+							pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::compute_shader,
+							memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+						);
+					};
+					for (int run = 0; run < 2; ++run) {
+						const auto timingName = (run == 0) ? fmt::format("TAA fp16 {}", inFlightIndex) : fmt::format("TAA fp32 {}", inFlightIndex);
+						taaHistoryTarget = (run == 0) ? &mHistoryImages[inFlightIndex] : &mFp16CheckImage;
+						barrier();
+						helpers::record_timing_interval_start(cmdbfr->handle(), timingName, timingStage);
+						for (size_t i = 0; i < taaDispatches.size(); ++i) {
+							auto &d = taaDispatches[i];
+							dispatchTaa(run == 0 ? *checkPipes[i].first : *checkPipes[i].second, d.x0, d.x1, d.paramsIdx, 16, -1);
+						}
+						helpers::record_timing_interval_end(cmdbfr->handle(), timingName, timingStage);
+					}
+					taaHistoryTarget = &mHistoryImages[inFlightIndex];
+					barrier();
+
+					cmdbfr->bind_pipeline(const_referenced(mFp16CheckPipeline));
+					cmdbfr->bind_descriptors(mFp16CheckPipeline->layout(), mDescriptorCache.get_or_create_descriptor_sets({
+						descriptor_binding(0, 0, mHistoryImages[inFlightIndex]->as_storage_image()),
+						descriptor_binding(0, 1, mFp16CheckImage->as_storage_image()),
+						descriptor_binding(0, 2, mFp16CheckSums[inFlightIndex]->as_storage_buffer())
+						}));
+					push_constants_for_fp16_check checkPushc;
+					checkPushc.threshold = mFp16Check.threshold;
+					cmdbfr->push_constants(mFp16CheckPipeline->layout(), checkPushc);
+					cmdbfr->handle().dispatch((static_cast<uint32_t>(taaWidth) + 15u) / 16u, (static_cast<uint32_t>(taaHeight) + 15u) / 16u, 1);
+					barrier();
+					cmdbfr->establish_global_memory_barrier(
+						pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::host,
+						memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::host_read_access
+					);
+					mFp16Check.valid[inFlightIndex] = true;
+				}
+			}
+
+			// fused resolve: sharpening and post processing are done, the final image is mPostProcessImages
+			image_view_t* pLastProducedImageView_t = mFusedResolveActive ? &mPostProcessImages[inFlightIndex].get() : &mResultImages[inFlightIndex].get();
 			int nextTempImageIndex = 0;
 
 			#if ENABLE_RAYTRACING
 				if (needRayTraceAssist()) {
 					// sparse ray trace pixels marked for RTX in segmask
 					// callback main
-					if (mRayTraceCallback) {
+					if (mRayTraceCallback && mRayTracePixelList) {
+						const bool useBudget = mRayTraceBudget.enabled;
+						if (useBudget) update_ray_budget(inFlightIndex);
+						auto &budgetBuffer = mRayTraceBudgetBuffers[inFlightIndex];
+
+						// compact the marked pixels into a list, used for an indirect trace rays call
+						const uint32_t listHeader[4]   = { 0u, 1u, 1u, 0u };			// width (=count), height, depth, pad
+						const uint32_t budgetHeader[4] = { 0u, 0u, 0xffffffffu, 0u };	// marked count, cutoff, admit at cutoff (= all), counter at cutoff
+						cmdbfr->handle().updateBuffer(mRayTracePixelLists[inFlightIndex]->handle(), 0, sizeof(listHeader), listHeader);
+						cmdbfr->handle().updateBuffer(budgetBuffer->handle(), TAA_RT_BUDGET_NUM_BUCKETS * sizeof(uint32_t), sizeof(budgetHeader), budgetHeader);
+						if (useBudget) cmdbfr->handle().fillBuffer(budgetBuffer->handle(), 0, TAA_RT_BUDGET_NUM_BUCKETS * sizeof(uint32_t), 0u);
+						cmdbfr->establish_global_memory_barrier(
+							pipeline_stage::compute_shader | pipeline_stage::transfer,                                    /* -> */ pipeline_stage::compute_shader,
+							memory_access::shader_buffers_and_images_write_access | memory_access::transfer_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+						);
+
+						cmdbfr->bind_pipeline(const_referenced(mRayTracePixelListPipeline));
+						cmdbfr->bind_descriptors(mRayTracePixelListPipeline->layout(), mDescriptorCache.get_or_create_descriptor_sets({
+							descriptor_binding(0, 0, mSegmentationImages[inFlightIndex]->as_storage_image()),
+							descriptor_binding(0, 1, mRayTracePixelLists[inFlightIndex]->as_storage_buffer()),
+							descriptor_binding(0, 2, budgetBuffer->as_storage_buffer())
+							}));
+						const uint32_t groupsX = (mSegmentationImages[inFlightIndex]->get_image().width()  + 15u) / 16u;
+						const uint32_t groupsY = (mSegmentationImages[inFlightIndex]->get_image().height() + 15u) / 16u;
+						push_constants_for_rt_pixel_list listPushc;
+						listPushc.pixelBudget = mRayTraceBudget.pixelBudget;
+						listPushc.demoteTo    = mRayTraceBudget.fallbackFxaa ? 1u : 0u;
+						if (useBudget) {
+							// priority histogram, then find the cutoff (single workgroup)
+							listPushc.pass = 0;
+							cmdbfr->push_constants(mRayTracePixelListPipeline->layout(), listPushc);
+							cmdbfr->handle().dispatch(groupsX, groupsY, 1);
+							cmdbfr->establish_global_memory_barrier(
+								pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::compute_shader,
+								memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+							);
+							listPushc.pass = 1;
+							cmdbfr->push_constants(mRayTracePixelListPipeline->layout(), listPushc);
+							cmdbfr->handle().dispatch(1, 1, 1);
+							cmdbfr->establish_global_memory_barrier(
+								pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::compute_shader,
+								memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
+							);
+						}
+						listPushc.pass = 2;
+						cmdbfr->push_constants(mRayTracePixelListPipeline->layout(), listPushc);
+						cmdbfr->handle().dispatch(groupsX, groupsY, 1);
+
+						cmdbfr->establish_global_memory_barrier(
+							pipeline_stage::compute_shader,                        /* -> */ ray_trace_stage() | pipeline_stage::draw_indirect | pipeline_stage::transfer,
+							memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access | memory_access::indirect_command_data_read_access | memory_access::transfer_read_access
+						);
+
+						if (useBudget) {
+							// stats for the budget controller, read back when this in-flight index comes around again
+							const std::array<vk::BufferCopy, 2> regions = {
+								vk::BufferCopy{ TAA_RT_BUDGET_NUM_BUCKETS * sizeof(uint32_t), 0,                    4 * sizeof(uint32_t) },	// marked count, cutoff, ...
+								vk::BufferCopy{ 0,                                            4 * sizeof(uint32_t), 4 * sizeof(uint32_t) }	// list header
+							};
+							cmdbfr->handle().copyBuffer(budgetBuffer->handle(), mRayTraceBudgetReadback[inFlightIndex]->handle(), 1, &regions[0]);
+							cmdbfr->handle().copyBuffer(mRayTracePixelLists[inFlightIndex]->handle(), mRayTraceBudgetReadback[inFlightIndex]->handle(), 1, &regions[1]);
+							cmdbfr->establish_global_memory_barrier(
+								pipeline_stage::transfer,             /* -> */ pipeline_stage::host,
+								memory_access::transfer_write_access, /* -> */ memory_access::host_read_access
+							);
+							mRayTraceBudget.statsValid[inFlightIndex] = true;
+						}
+
+						// ray traced pixels are written directly into the result image, all others keep the TAA result
+						helpers::record_timing_interval_start(cmdbfr->handle(), fmt::format("TAA RT {}", inFlightIndex));
+						mRayTraceCallback->ray_trace_callback(cmdbfr);
+						helpers::record_timing_interval_end(cmdbfr->handle(), fmt::format("TAA RT {}", inFlightIndex));
+
+						cmdbfr->establish_global_memory_barrier(
+							ray_trace_stage(),                                      /* -> */ pipeline_stage::compute_shader,
+							memory_access::shader_buffers_and_images_write_access,  /* -> */ memory_access::shader_buffers_and_images_any_access
+						);
+					} else if (mRayTraceCallback) {
 						#if BETTER_RAYTRACE_SYNC
 							cmdbfr->establish_global_memory_barrier(
-								pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::ray_tracing_shaders,
+								pipeline_stage::compute_shader,                        /* -> */ ray_trace_stage(),
 								memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_read_access
 							);
 						#else
@@ -1047,7 +1990,7 @@ public:
 
 						#if BETTER_RAYTRACE_SYNC
 							cmdbfr->establish_global_memory_barrier(
-								pipeline_stage::ray_tracing_shaders,                    /* -> */ pipeline_stage::compute_shader,
+								ray_trace_stage(),                                      /* -> */ pipeline_stage::compute_shader,
 								memory_access::shader_buffers_and_images_write_access,  /* -> */ memory_access::shader_buffers_and_images_any_access
 							);
 						#else
@@ -1058,7 +2001,13 @@ public:
 						pLastProducedImageView_t = mSrcRayTraced[inFlightIndex];
 					}
 
-					if (((mParameters[0].mRayTraceAugmentFlags & TAA_RTFLAG_FXA) != 0) || (mSplitScreen && ((mParameters[1].mRayTraceAugmentFlags & TAA_RTFLAG_FXA) != 0))) {
+					if (mRayTraceCallback) {
+						update_ray_trace_report(inFlightIndex);
+						record_ray_trace_temporal(cmdbfr, inFlightIndex, *pLastProducedImageView_t);
+					}
+
+					const bool budgetFallbackFxaa = mRayTracePixelList && mRayTraceBudget.enabled && mRayTraceBudget.fallbackFxaa;
+					if (((mParameters[0].mRayTraceAugmentFlags & TAA_RTFLAG_FXA) != 0) || (mSplitScreen && ((mParameters[1].mRayTraceAugmentFlags & TAA_RTFLAG_FXA) != 0)) || budgetFallbackFxaa) {
 						// antialias pixels marked for FXAA in segmask
 
 						int tmpA = nextTempImageIndex;		// prepare pass renders result -> *ping*
@@ -1108,7 +2057,7 @@ public:
 				}
 			#endif
 
-			if (mSharpener) {
+			if (mSharpener && !mFusedResolveActive) {
 				cmdbfr->establish_global_memory_barrier(
 					pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::compute_shader,
 					memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::shader_buffers_and_images_any_access
@@ -1138,7 +2087,7 @@ public:
 				nextTempImageIndex ^= 1;
 			}
 
-			if (mPostProcessEnabled) {
+			if (mPostProcessEnabled && !mFusedResolveActive) {
 				// post-processing
 
 				cmdbfr->establish_global_memory_barrier(
@@ -1158,17 +2107,28 @@ public:
 				pLastProducedImageView_t = &mPostProcessImages[inFlightIndex].get();
 			}
 
-			auto &image_to_show = pLastProducedImageView_t->get_image();
+			if (asyncCompute) {
+				helpers::record_timing_interval_end(cmdbfr->handle(), fmt::format("TAA {}", inFlightIndex), timingStage);
 
-			// TODO: is this barrier needed?
-			cmdbfr->establish_global_memory_barrier(
-				pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::transfer,
-				memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::transfer_read_access
-			);
+				if (transferOwnership) {
+					// release the result to the graphics queue family, for the blit in submit_async
+					auto barrier = ownership_barrier(*pLastProducedImageView_t, vk::AccessFlagBits::eShaderWrite, {}, vk::ImageLayout::eGeneral, mComputeQueue->family_index(), mQueue->family_index());
+					cmdbfr->handle().pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, barrier);
+				}
+				pResolvedImageView = pLastProducedImageView_t;
+			} else {
+				auto &image_to_show = pLastProducedImageView_t->get_image();
 
-			blit_image(image_to_show, mainWnd->backbuffer_at_index(inFlightIndex)->image_at(0), sync::with_barriers_into_existing_command_buffer(*cmdbfr));
+				// TODO: is this barrier needed?
+				cmdbfr->establish_global_memory_barrier(
+					pipeline_stage::compute_shader,                        /* -> */ pipeline_stage::transfer,
+					memory_access::shader_buffers_and_images_write_access, /* -> */ memory_access::transfer_read_access
+				);
+
+				blit_image(image_to_show, mainWnd->backbuffer_at_index(inFlightIndex)->image_at(0), sync::with_barriers_into_existing_command_buffer(*cmdbfr));
 
-			helpers::record_timing_interval_end(cmdbfr->handle(), fmt::format("TAA {}", inFlightIndex));
+				helpers::record_timing_interval_end(cmdbfr->handle(), fmt::format("TAA {}", inFlightIndex));
+			}
 		}
 		// -------------------------- If Anti-Aliasing is disabled, do nothing but blit/copy ------------------------------
 		else {
@@ -1186,11 +2146,102 @@ public:
 		// Only after the swapchain image has become available, we may start rendering into it.
 		auto imageAvailableSemaphore = mainWnd->consume_current_image_available_semaphore();
 
+		if (asyncCompute) {
+			submit_async(std::move(cmdbfr), *pResolvedImageView, imageAvailableSemaphore->handle(), inFlightIndex, transferOwnership);
+			return;
+		}
+
 		// Submit the draw call and take care of the command buffer's lifetime:
 		mQueue->submit(cmdbfr, imageAvailableSemaphore);
 		mainWnd->handle_lifetime(std::move(cmdbfr));
 	}
 
+	// async compute: wait (on the CPU) until the resolve that reads the G-buffer of this frame in flight as history is done;
+	// call before rendering into the G-buffer of the frame aFrameId
+	void wait_for_async_resolve(gvk::window::frame_id_t aFrameId)
+	{
+		if (!mComputeQueue) return;
+		// the resolve of frame aFrameId - CF + 1 uses the depth and material ids of aFrameId's frame in flight as history
+		auto fence = mResolveFences[(aFrameId + 1) % CF].get();
+		auto result = gvk::context().device().waitForFences(1u, &fence, VK_TRUE, UINT64_MAX);
+		if (result != vk::Result::eSuccess) {
+			LOG_WARNING(fmt::format("TAA async compute: waiting for the resolve fence failed ({})", vk::to_string(result)));
+		}
+	}
+
+	// queue family ownership transfer of an image; recorded once as release (source queue) and once as acquire (destination queue)
+	static vk::ImageMemoryBarrier ownership_barrier(avk::image_view_t &aView, vk::AccessFlags aSrcAccess, vk::AccessFlags aDstAccess, vk::ImageLayout aLayout, uint32_t aSrcFamily, uint32_t aDstFamily)
+	{
+		auto &image = aView.get_image();
+		auto aspect = avk::is_depth_format(image.config().format) ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+		return vk::ImageMemoryBarrier{ aSrcAccess, aDstAccess, aLayout, aLayout, aSrcFamily, aDstFamily, image.handle(), vk::ImageSubresourceRange{ aspect, 0u, 1u, 0u, 1u } };
+	}
+
+	// the G-buffer inputs of the current frame, graphics -> compute queue family
+	// (the previous frame's depth and material ids stay with the compute queue; when the graphics queue renders into them again, they are cleared anyway)
+	std::vector<vk::ImageMemoryBarrier> input_ownership_barriers(size_t aInFlightIndex, bool aRelease)
+	{
+		const vk::AccessFlags srcAccess = aRelease ? (vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite) : vk::AccessFlags{};
+		const vk::AccessFlags dstAccess = aRelease ? vk::AccessFlags{} : vk::AccessFlags{ vk::AccessFlagBits::eShaderRead };
+		std::vector<vk::ImageMemoryBarrier> barriers;
+		for (auto *view : { mSrcColor[aInFlightIndex], mSrcDepth[aInFlightIndex], mSrcUvNrm[aInFlightIndex], mSrcVelocity[aInFlightIndex], mSrcMatId[aInFlightIndex] }) {
+			barriers.push_back(ownership_barrier(*view, srcAccess, dstAccess, view->get_image().target_layout(), mQueue->family_index(), mComputeQueue->family_index()));
+		}
+		return barriers;
+	}
+
+	// async compute submission of one frame:
+	// graphics: (release the inputs) -> signal inputs ready; compute: wait, resolve, (release the result) -> signal resolve done + fence;
+	// graphics: wait for resolve done and the swap chain image, (acquire the result,) blit it into the backbuffer
+	void submit_async(avk::command_buffer aResolveCmdbfr, avk::image_view_t &aResolved, vk::Semaphore aImageAvailable, size_t aInFlightIndex, bool aTransferOwnership)
+	{
+		using namespace avk;
+		using namespace gvk;
+
+		auto* mainWnd = context().main_window();
+		auto& graphicsPool = context().get_command_pool_for_single_use_command_buffers(*mQueue);
+
+		auto releaseCmdbfr = graphicsPool->alloc_command_buffer(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+		releaseCmdbfr->begin_recording();
+		if (aTransferOwnership) {
+			releaseCmdbfr->handle().pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, input_ownership_barriers(aInFlightIndex, true));
+		}
+		releaseCmdbfr->end_recording();
+
+		auto blitCmdbfr = graphicsPool->alloc_command_buffer(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+		blitCmdbfr->begin_recording();
+		rdoc::beginSection(blitCmdbfr->handle(), "TAA blit");
+		if (aTransferOwnership) {
+			auto barrier = ownership_barrier(aResolved, {}, vk::AccessFlagBits::eTransferRead, vk::ImageLayout::eGeneral, mComputeQueue->family_index(), mQueue->family_index());
+			blitCmdbfr->handle().pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
+		}
+		blit_image(aResolved.get_image(), mainWnd->backbuffer_at_index(aInFlightIndex)->image_at(0), sync::with_barriers_into_existing_command_buffer(*blitCmdbfr));
+		rdoc::endSection(blitCmdbfr->handle());
+		blitCmdbfr->end_recording();
+
+		auto inputsReady = mInputsReadySemaphores[aInFlightIndex].get();
+		auto resolveDone = mResolveDoneSemaphores[aInFlightIndex].get();
+		auto fence       = mResolveFences[aInFlightIndex].get();
+		context().device().resetFences(fence);	// waited for in wait_for_async_resolve, CF - 1 frames ago
+
+		auto releaseHandle = releaseCmdbfr->handle();
+		mQueue->handle().submit(vk::SubmitInfo{ 0u, nullptr, nullptr, 1u, &releaseHandle, 1u, &inputsReady }, nullptr);
+
+		auto resolveHandle = aResolveCmdbfr->handle();
+		vk::PipelineStageFlags resolveWaitStage = vk::PipelineStageFlagBits::eComputeShader;
+		mComputeQueue->handle().submit(vk::SubmitInfo{ 1u, &inputsReady, &resolveWaitStage, 1u, &resolveHandle, 1u, &resolveDone }, fence);
+
+		auto blitHandle = blitCmdbfr->handle();
+		std::array<vk::Semaphore, 2> blitWaitSemaphores = { resolveDone, aImageAvailable };
+		std::array<vk::PipelineStageFlags, 2> blitWaitStages = { vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer };
+		mQueue->handle().submit(vk::SubmitInfo{ 2u, blitWaitSemaphores.data(), blitWaitStages.data(), 1u, &blitHandle, 0u, nullptr }, nullptr);
+
+		// the graphics queue waits for the compute queue before the frame ends, so the frame's lifetime covers all three
+		mainWnd->handle_lifetime(std::move(releaseCmdbfr));
+		mainWnd->handle_lifetime(std::move(aResolveCmdbfr));
+		mainWnd->handle_lifetime(std::move(blitCmdbfr));
+	}
+
 	void finalize() override
 	{
 	}
@@ -1249,6 +2300,25 @@ public:
 		iniWriteInt		(ini, sec, "mJitterSlowMotion",				mJitterSlowMotion);
 		iniWriteFloat	(ini, sec, "mJitterRotateDegrees",			mJitterRotateDegrees);
 		iniWriteBool	(ini, sec, "mResetHistoryOnChange",			mResetHistoryOnChange);
+		iniWriteBool	(ini, sec, "mUseNeighbourhoodTile",			mUseNeighbourhoodTile);
+		iniWriteInt		(ini, sec, "mNeighbourhoodMode",			static_cast<int>(mNeighbourhoodMode));
+		iniWriteBool	(ini, sec, "mUseTaaVariants",				mUseTaaVariants);
+		iniWriteBool	(ini, sec, "mUseFusedResolve",				mUseFusedResolve);
+		iniWriteBool	(ini, sec, "mUseTileClasses",				mUseTileClasses);
+		iniWriteFloat	(ini, sec, "mTileStaticThreshold",			mTileStaticThreshold);
+		iniWriteFloat	(ini, sec, "mTileEdgeThreshold",			mTileEdgeThreshold);
+		iniWriteBool	(ini, sec, "mUseFp16",						mUseFp16);
+		iniWriteFloat	(ini, sec, "mFp16CheckThreshold",			mFp16Check.threshold);
+		iniWriteBool	(ini, sec, "mUseAsyncCompute",				mUseAsyncCompute);
+		iniWriteBool	(ini, sec, "mRayTracePixelList",			mRayTracePixelList);
+		iniWriteBool	(ini, sec, "mRayTraceBudget.enabled",		mRayTraceBudget.enabled);
+		iniWriteInt		(ini, sec, "mRayTraceBudget.mode",			mRayTraceBudget.mode);
+		iniWriteInt		(ini, sec, "mRayTraceBudget.maxRays",		mRayTraceBudget.maxRays);
+		iniWriteFloat	(ini, sec, "mRayTraceBudget.targetMs",		mRayTraceBudget.targetMs);
+		iniWriteBool	(ini, sec, "mRayTraceBudget.fallbackFxaa",	mRayTraceBudget.fallbackFxaa);
+		iniWriteBool	(ini, sec, "mRayTraceTemporal.enabled",		mRayTraceTemporal.enabled);
+		iniWriteInt		(ini, sec, "mRayTraceTemporal.samples",		mRayTraceTemporal.samples);
+		iniWriteFloat	(ini, sec, "mRayTraceTemporal.blendWeight",	mRayTraceTemporal.blendWeight);
 
 		iniWriteInt		(ini, sec, "mDebugSampleOffsets.size",		static_cast<int>(mDebugSampleOffsets.size()));
 		for (int i = 0; i < static_cast<int>(mDebugSampleOffsets.size()); ++i) {
@@ -1321,6 +2391,30 @@ public:
 		iniReadInt		(ini, sec, "mJitterSlowMotion",				mJitterSlowMotion);
 		iniReadFloat	(ini, sec, "mJitterRotateDegrees",			mJitterRotateDegrees);
 		iniReadBool		(ini, sec, "mResetHistoryOnChange",			mResetHistoryOnChange);
+		iniReadBool		(ini, sec, "mUseNeighbourhoodTile",			mUseNeighbourhoodTile);
+		{
+			int nbhMode = static_cast<int>(mNeighbourhoodMode);
+			iniReadInt	(ini, sec, "mNeighbourhoodMode",			nbhMode);
+			mNeighbourhoodMode = static_cast<uint32_t>(glm::clamp(nbhMode, 0, static_cast<int>(TAA_NBH_NAIVE)));
+		}
+		iniReadBool		(ini, sec, "mUseTaaVariants",				mUseTaaVariants);
+		iniReadBool		(ini, sec, "mUseFusedResolve",				mUseFusedResolve);
+		iniReadBool		(ini, sec, "mUseTileClasses",				mUseTileClasses);
+		iniReadFloat	(ini, sec, "mTileStaticThreshold",			mTileStaticThreshold);
+		iniReadFloat	(ini, sec, "mTileEdgeThreshold",			mTileEdgeThreshold);
+		iniReadBool		(ini, sec, "mUseFp16",						mUseFp16);
+		iniReadFloat	(ini, sec, "mFp16CheckThreshold",			mFp16Check.threshold);
+		if (mUseFp16) start_fp16_check();
+		iniReadBool		(ini, sec, "mUseAsyncCompute",				mUseAsyncCompute);
+		iniReadBool		(ini, sec, "mRayTracePixelList",			mRayTracePixelList);
+		iniReadBool		(ini, sec, "mRayTraceBudget.enabled",		mRayTraceBudget.enabled);
+		iniReadInt		(ini, sec, "mRayTraceBudget.mode",			mRayTraceBudget.mode);
+		iniReadInt		(ini, sec, "mRayTraceBudget.maxRays",		mRayTraceBudget.maxRays);
+		iniReadFloat	(ini, sec, "mRayTraceBudget.targetMs",		mRayTraceBudget.targetMs);
+		iniReadBool		(ini, sec, "mRayTraceBudget.fallbackFxaa",	mRayTraceBudget.fallbackFxaa);
+		iniReadBool		(ini, sec, "mRayTraceTemporal.enabled",		mRayTraceTemporal.enabled);
+		iniReadInt		(ini, sec, "mRayTraceTemporal.samples",		mRayTraceTemporal.samples);
+		iniReadFloat	(ini, sec, "mRayTraceTemporal.blendWeight",	mRayTraceTemporal.blendWeight);
 
 		int nSamples = 0;
 		iniReadInt		(ini, sec, "mDebugSampleOffsets.size",		nSamples);
@@ -1340,6 +2434,16 @@ public:
 
 	avk::image_view * getRayTraceSegMask()    { return &(mSegmentationImages[gvk::context().main_window()->in_flight_index_for_frame()]); }
 	avk::image_view * getRayTraceInputImage() { return &(mResultImages      [gvk::context().main_window()->in_flight_index_for_frame()]); }
+	avk::buffer     * getRayTracePixelList()  { return mRayTracePixelList ? &(mRayTracePixelLists[gvk::context().main_window()->in_flight_index_for_frame()]) : nullptr; }	// nullptr: trace full screen
+	int getRayTraceSampleLimit() { return (mRayTracePixelList && mRayTraceBudget.enabled) ? mRayTraceBudget.spp : 0; }	// 0: no limit
+
+	// temporal ray tracing: sample at the current TAA jitter offset instead of the supersampling offsets (the samples are accumulated in the history)
+	bool      getRayTraceTemporal()  { return mTaaUniforms.mRayTraceTemporal != VK_FALSE; }
+	glm::vec2 getRayTraceJitterNdc() { return glm::vec2(mTaaUniforms.mJitterNdc); }
+	int getRayTraceSampleOverride() {	// 0: use the ray tracer's setting
+		if (mRayTraceTemporal.referenceThisFrame) return RAYTRACING_MAX_SAMPLES_PER_PIXEL;
+		return getRayTraceTemporal() ? glm::clamp(mRayTraceTemporal.samples, 1, 2) : 0;
+	}
 
 	bool needRayTraceAssist() { return mParameters[0].mRayTraceAugment || (mSplitScreen && mParameters[1].mRayTraceAugment); }
 
@@ -1347,6 +2451,14 @@ private:
 	avk::queue* mQueue;
 	avk::descriptor_cache mDescriptorCache;
 
+	// async compute (only if a separate compute queue was given)
+	avk::queue* mComputeQueue = nullptr;
+	bool mUseAsyncCompute = true;
+	uint32_t mLastResolveQueueFamily = ~0u;						// queue family of the last TAA pass; history is reset when it changes
+	std::array<vk::UniqueSemaphore, CF> mInputsReadySemaphores;	// graphics -> compute: G-buffer of the frame is done
+	std::array<vk::UniqueSemaphore, CF> mResolveDoneSemaphores;	// compute -> graphics: result is ready for the blit
+	std::array<vk::UniqueFence, CF>     mResolveFences;				// for wait_for_async_resolve
+
 	// Settings, which can be modified via ImGui:
 	bool mTaaEnabled = true;
 	bool mPostProcessEnabled = true;
@@ -1360,6 +2472,8 @@ private:
 	std::array<avk::image_view_t*, CF> mSrcVelocity;
 	std::array<avk::image_view_t*, CF> mSrcMatId;
 	std::array<avk::image_view_t*, CF> mSrcRayTraced;
+	std::array<avk::buffer_t*, CF> mSrcDepthPyramid = {};
+	bool mDepthPyramidEnabled = false;
 	// Destination images per frame in flight:
 	std::array<avk::image_view, CF> mResultImages;
 	std::array<avk::image_view, CF> mTempImages[2];
@@ -1367,6 +2481,15 @@ private:
 	std::array<avk::image_view, CF> mPostProcessImages;
 	std::array<avk::image_view, CF> mHistoryImages;			// use a separate history buffer for now, makes life easier..
 	std::array<avk::image_view, CF> mSegmentationImages;
+	std::array<avk::buffer, CF>     mRayTracePixelLists;		// compacted list of pixels to ray trace
+	std::array<avk::buffer, CF>     mRayTraceBudgetBuffers;		// priority histogram and cutoff for the ray budget
+	std::array<avk::buffer, CF>     mRayTraceBudgetReadback;	// host-visible copy of the budget stats
+	std::array<avk::buffer, CF>     mRayTraceErrorSums;			// host-visible, per workgroup error sums of the temporal ray tracing report
+	std::array<avk::buffer, CF>     mTileClassBuffers;			// tile classification: indirect dispatch headers and tile lists
+	std::array<avk::buffer, CF>     mTileClassReadback;			// host-visible copy of the headers (tile counts)
+	std::array<avk::buffer, CF>     mFp16CheckSums;				// host-visible, per workgroup difference sums of the fp16 validation
+	avk::image_view                 mFp16CheckImage;			// fp16 validation: history output of the fp32 kernel
+	avk::image_view                 mRayTraceReference;			// supersampled ray traced pixels, reference for the report
 
 	// combined image-samplers for temp images
 	std::array<avk::image_sampler, CF> mTempImageSamplers[2];
@@ -1381,10 +2504,22 @@ private:
 	// Prepared command buffers to synchronize subsequent commands
 	std::array<avk::command_buffer, CF> mSyncAfterCommandBuffers;
 
-	avk::compute_pipeline mTaaPipeline;
-	//push_constants_for_taa mTaaPushConstants;
+	avk::compute_pipeline mTaaPipeline;			// generic variant
+	push_constants_for_taa mTaaPushConstants;
 	uniforms_for_taa mTaaUniforms;
 
+	// specialized taa.comp pipelines, by variant key (see taa_variant_key)
+	struct taa_variant_build {
+		uint32_t generation;
+		std::future<avk::compute_pipeline> future;
+	};
+	bool mUseTaaVariants = true;
+	std::unordered_map<uint32_t, avk::compute_pipeline> mTaaVariants;
+	std::unordered_map<uint32_t, taa_variant_build>     mTaaVariantBuilds;
+	std::vector<std::pair<avk::compute_pipeline, gvk::window::frame_id_t>> mTaaVariantsRetired;
+	VkPipeline mTaaVariantsBuiltFor = VK_NULL_HANDLE;	// mTaaPipeline handle the variants belong to (changes on shader hot reload)
+	uint32_t   mTaaVariantGeneration = 0;
+
 	avk::compute_pipeline mPostProcessPipeline;
 	push_constants_for_postprocess mPostProcessPushConstants;
 
@@ -1398,6 +2533,57 @@ private:
 	avk::compute_pipeline mFxaaPipeline;
 	push_constants_for_fxaa mFxaaPushConstants;
 
+	avk::compute_pipeline mRayTracePixelListPipeline;
+	bool mRayTracePixelList = true;	// ray trace only a compacted list of pixels (indirect) instead of the full screen
+
+	// per-frame ray budget (requires the pixel list)
+	struct {
+		bool  enabled      = false;
+		int   mode         = 0;			// 0: fixed number of rays, 1: target time (ms, from GPU timestamps)
+		int   maxRays      = 250000;	// budget for mode 0, upper limit for mode 1
+		float targetMs     = 2.f;
+		bool  fallbackFxaa = true;		// pixels over budget: FXAA (else keep TAA result)
+
+		// controller state
+		uint32_t pixelBudget  = 0;
+		int      spp          = 1;
+		uint32_t markedPixels = 0;
+		uint32_t tracedPixels = 0;
+		float    lastMs       = 0.f;
+		float    avgRays      = 0.f;
+		float    raysPerMs    = 0.f;
+		std::array<int,  CF> sppUsed    = {};
+		std::array<bool, CF> statsValid = {};
+	} mRayTraceBudget;
+
+	avk::compute_pipeline mRayTraceTemporalPipeline;
+
+	// temporal ray tracing: marked pixels take 1 or 2 samples at the TAA jitter offset and accumulate them in the history,
+	// instead of supersampling every frame (todo.txt: "merge ray traced pixels back into TAA history buffer?")
+	struct {
+		bool  enabled     = false;
+		int   samples     = 1;			// 1: at the jitter offset, 2: also at the point-mirrored offset
+		float blendWeight = 0.1f;		// weight of the new ray traced sample in the history
+
+		// rays-vs-error report: reference = one frame traced with RAYTRACING_MAX_SAMPLES_PER_PIXEL (static camera!)
+		bool  measure            = false;
+		bool  captureRequested   = false;
+		bool  referenceThisFrame = false;
+		bool  referenceValid     = false;
+		struct report_row {
+			bool   temporal;
+			int    spp;
+			float  blendWeight;
+			double rays   = 0.0;		// sums over frames
+			double mse    = 0.0;
+			int    frames = 0;
+		};
+		std::vector<report_row> report;
+		std::array<bool, CF> errorValid    = {};
+		std::array<int,  CF> errorSpp      = {};
+		std::array<bool, CF> errorTemporal = {};
+	} mRayTraceTemporal;
+
 	Parameters mParameters[2];
 
 	// jitter debugging
@@ -1414,11 +2600,62 @@ private:
 	bool mUpsampling = false;
 	glm::uvec2 mInputResolution  = {};	// lo res
 	glm::uvec2 mOutputResolution = {};	// hi res
+	std::array<glm::uvec2, CF> mRenderResolutions = {};	// dynamic resolution: rendered sub-rect of the input images, per frame in flight
 
 	int mSharpener = 0; // 0=off 1=simple 2=FidelityFX-CAS
 	float mSharpenFactor = 0.5f;
 
 	bool mResetHistoryOnChange = true; // reset history when any parameter has changed?
+	bool mUseNeighbourhoodTile = true; // taa.comp: shared memory tile for the neighbourhood fetches
+	uint32_t mNeighbourhoodMode = TAA_NBH_LDS; // taa.comp: neighbourhood min/max and moments (TAA_NBH_*)
+	uint32_t mNbhActiveMode = TAA_NBH_LDS; // last frame (while the pipelines are built: LDS)
+	bool mSubgroupShuffleSupported = false;
+
+	// neighbourhood benchmark (see update_nbh_bench)
+	static constexpr int kNbhBenchWarmup = 30;
+	static constexpr int kNbhBenchFrames = 120;
+	struct {
+		bool     running   = false;
+		bool     done      = false;
+		uint32_t mode      = TAA_NBH_LDS;
+		uint32_t savedMode = TAA_NBH_LDS;
+		int      frames    = 0;
+		std::array<double, 3> sum   = {};
+		std::array<int, 3>    count = {};
+		std::array<float, 3>  ms    = {};	// -1: not measured
+	} mNbhBench;
+	bool mUseFusedResolve = true; // taa.comp: sharpening and post processing in the TAA pass, if possible (see fused_resolve_mode)
+	bool mFusedResolveActive = false; // last frame
+
+	// tile classification (see taa_classify.comp)
+	bool  mUseTileClasses      = true;
+	float mTileStaticThreshold = 0.01f;	// max. motion in a static tile, in output pixels
+	float mTileEdgeThreshold   = 0.1f;	// fraction of edge pixels for an edge tile
+	bool  mTileClassesActive   = false;	// last frame
+	uint32_t mTileClassMaxTiles = 0;	// list capacity per dispatch and class
+	std::array<uint32_t, TAA_TILE_NUM_CLASSES> mTileClassCounts = {};
+	std::array<bool, CF> mTileClassStatsValid = {};
+	avk::compute_pipeline mTileClassifyPipeline;
+	push_constants_for_tile_classify mTileClassifyPushConstants;
+
+	// half precision kernel (taa_fp16.comp) and its validation against the fp32 kernel (see read_fp16_check)
+	static constexpr int    kFp16CheckFrames    = 32;
+	static constexpr double kFp16CheckMaxFailed = 0.001;	// fraction of the pixels
+	bool mUseFp16       = true;
+	bool mFp16Supported = false;
+	bool mFp16Active    = false;	// last frame
+	struct {
+		float  threshold = 2.f / 255.f;
+		bool   running   = true;	// check on first use
+		bool   done      = false;
+		bool   passed    = false;
+		int    frames    = 0;
+		double sumDiff = 0.0, failed = 0.0, compared = 0.0;
+		float  maxDiff = 0.f;
+		float  ms16 = 0.f, ms32 = 0.f;
+		std::array<bool, CF> valid = {};
+	} mFp16Check;
+	avk::compute_pipeline mFp16CheckPipeline;
 	float mLastResetHistoryTime = 0.f;
 
 	std::vector<glm::vec2> mDebugSampleOffsets = { {0.f, 0.f} };